@@ -0,0 +1,191 @@
+// =============================================================================
+// EdoBench.h
+// Minimal timing and allocation counting harness for the EdoCore benchmarks
+// =============================================================================
+
+#ifndef EDOCORE_EDOBENCH_H
+#define EDOCORE_EDOBENCH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define EDO_BENCH_ROUNDS 5 // Timed rounds per benchmark case, the fastest of which is reported
+
+namespace Edo {
+    namespace Bench {
+        extern std::atomic<size_t> g_allocCount; //!< Number of calls to the global operator new
+        extern std::atomic<size_t> g_allocBytes; //!< Number of bytes requested from the global operator new
+        extern volatile size_t g_sink; //!< Results are folded into this to keep the optimizer from removing work
+
+        /*!
+         * \brief
+         * Result of a single benchmark case
+         */
+        struct EdoBenchResult {
+            double nsPerOp; //!< Average wall time per call in nanoseconds
+            double allocsPerOp; //!< Average number of heap allocations per call
+            double bytesPerOp; //!< Average number of heap bytes requested per call
+        };
+
+        /*!
+         * \brief
+         * A benchmark case as recorded for the machine readable report
+         */
+        struct EdoBenchRecord {
+            std::string section; //!< Title of the section the case ran in
+            std::string name; //!< Name of the case
+            EdoBenchResult result; //!< Measured cost
+        };
+
+        /*!
+         * \brief
+         * State shared by the benchmark cases of one run
+         */
+        struct EdoBenchState {
+            std::string section; //!< Title of the current section
+            std::string filter; //!< Only sections whose title contains this are run, all of them if empty
+            bool selected = true; //!< Whether the current section matches the filter
+            std::vector<EdoBenchRecord> records; //!< Every case run so far
+        };
+
+        inline EdoBenchState &State() {
+            static EdoBenchState state;
+            return state;
+        }
+
+        /*!
+         * \brief
+         * Starts a new section of benchmark cases and prints its title, unless it is filtered out
+         * \return
+         * False if the section is filtered out, in which case its setup can be skipped as well
+         */
+        inline bool Section(const std::string &title) {
+            EdoBenchState &state = State();
+            state.section = title;
+            state.selected = state.filter.empty() || title.find(state.filter) != std::string::npos;
+
+            if (state.selected)
+                printf("== %s ==\n", title.c_str());
+
+            return state.selected;
+        }
+
+        /*!
+         * \brief
+         * Runs \a func \a iterations times (after a single warm-up call) and prints the per-call cost of the fastest
+         * of EDO_BENCH_ROUNDS rounds. Cases of a section that is filtered out are skipped and return zeroes
+         * \param name
+         * Name of the benchmark case
+         * \param iterations
+         * Number of timed calls
+         * \param func
+         * Callable performing one operation
+         */
+        template<typename F>
+        EdoBenchResult Run(const char *name, size_t iterations, F func) {
+            EdoBenchResult result = {0.0, 0.0, 0.0};
+
+            if (!State().selected)
+                return result;
+
+            func();
+
+            // The calls are timed in rounds and the fastest round is reported, which keeps a busy machine from
+            // showing up as a regression
+            size_t rounds = iterations >= EDO_BENCH_ROUNDS ? EDO_BENCH_ROUNDS : 1;
+            size_t perRound = iterations / rounds;
+            size_t allocs = g_allocCount.load();
+            size_t bytes = g_allocBytes.load();
+
+            for (size_t round = 0; round < rounds; ++round) {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+                for (size_t i = 0; i < perRound; ++i)
+                    func();
+
+                std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+                double nsPerOp = std::chrono::duration<double, std::nano>(stop - start).count() / perRound;
+
+                if (round == 0 || nsPerOp < result.nsPerOp)
+                    result.nsPerOp = nsPerOp;
+            }
+
+            result.allocsPerOp = (double) (g_allocCount.load() - allocs) / (rounds * perRound);
+            result.bytesPerOp = (double) (g_allocBytes.load() - bytes) / (rounds * perRound);
+
+            printf("%-56s %12.2f ns/op %8.2f allocs/op %10.1f B/op\n", name, result.nsPerOp, result.allocsPerOp,
+                   result.bytesPerOp);
+
+            EdoBenchRecord record;
+            record.section = State().section;
+            record.name = name;
+            record.result = result;
+            State().records.push_back(record);
+
+            return result;
+        }
+
+        /*!
+         * \brief
+         * Prints the throughput of a benchmark case that processed \a bytes per call
+         */
+        inline void Throughput(const EdoBenchResult &result, double bytes) {
+            if (State().selected)
+                printf("%-56s %12.2f GB/s\n", "  throughput", bytes / result.nsPerOp);
+        }
+
+        // Write a string as a JSON string literal
+        inline void WriteJsonString(FILE *file, const std::string &str) {
+            fputc('"', file);
+
+            for (char c : str) {
+                if (c == '"' || c == '\\')
+                    fprintf(file, "\\%c", c);
+                else if ((unsigned char) c < 0x20)
+                    fprintf(file, "\\u%04x", (unsigned) c);
+                else
+                    fputc(c, file);
+            }
+
+            fputc('"', file);
+        }
+
+        /*!
+         * \brief
+         * Writes every recorded case to \a path as JSON, so runs can be compared by a script to catch regressions
+         * \note
+         * The file holds an object with a "benchmarks" array of {section, name, ns_per_op, allocs_per_op,
+         * bytes_per_op} entries
+         * \return
+         * False if the file could not be written
+         */
+        inline bool WriteJson(const char *path) {
+            FILE *file = fopen(path, "w");
+
+            if (file == nullptr)
+                return false;
+
+            const std::vector<EdoBenchRecord> &records = State().records;
+            fprintf(file, "{\n  \"benchmarks\": [");
+
+            for (size_t i = 0; i < records.size(); ++i) {
+                fprintf(file, "%s\n    {\"section\": ", i ? "," : "");
+                WriteJsonString(file, records[i].section);
+                fprintf(file, ", \"name\": ");
+                WriteJsonString(file, records[i].name);
+                fprintf(file, ", \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f, \"bytes_per_op\": %.1f}",
+                        records[i].result.nsPerOp, records[i].result.allocsPerOp, records[i].result.bytesPerOp);
+            }
+
+            fprintf(file, "\n  ]\n}\n");
+            return fclose(file) == 0;
+        }
+    } // Namespace Bench
+} // Namespace Edo
+
+#endif // EDOCORE_EDOBENCH_H
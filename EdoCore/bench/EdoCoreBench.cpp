@@ -0,0 +1,1486 @@
+// =============================================================================
+// EdoCoreBench.cpp
+// Benchmarks for the EdoCore string types
+// =============================================================================
+
+#include "EdoBench.h"
+#include "Edo.h"
+#include "Types/EdoMultiSearch.h"
+#include "Types/EdoRope.h"
+#include "Types/EdoStringBuilder.h"
+#include "Types/EdoSharedString.h"
+#include "Types/EdoStringSearch.h"
+#include "Types/EdoStringTable.h"
+#include "Types/EdoUtf.h"
+#include "Types/EdoUtf8String.h"
+#include "Utils/EdoCpu.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <thread>
+#include <unordered_map>
+
+using namespace Edo::Types;
+using namespace Edo::Utils;
+using namespace Edo::Bench;
+
+std::atomic<size_t> Edo::Bench::g_allocCount(0);
+std::atomic<size_t> Edo::Bench::g_allocBytes(0);
+volatile size_t Edo::Bench::g_sink = 0;
+
+///////////////////////////////////////////////
+// Allocation counting
+///////////////////////////////////////////////
+// Every replaceable form is defined, so that each new pairs with a delete of this file. The counting malloc/free
+// pair sits behind functions GCC does not inline, which otherwise reports the free() in operator delete as
+// mismatched with a new expression (-Wmismatched-new-delete)
+#if defined(_MSC_VER)
+#define EDO_BENCH_NOINLINE __declspec(noinline)
+#else
+#define EDO_BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+static EDO_BENCH_NOINLINE void *CountedAlloc(size_t size) noexcept {
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+static EDO_BENCH_NOINLINE void CountedFree(void *p) noexcept {
+    free(p);
+}
+
+void *operator new(size_t size) {
+    if (void *p = CountedAlloc(size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return CountedAlloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return CountedAlloc(size);
+}
+
+void operator delete(void *p) noexcept {
+    CountedFree(p);
+}
+
+void operator delete[](void *p) noexcept {
+    CountedFree(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    CountedFree(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    CountedFree(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+    CountedFree(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+    CountedFree(p);
+}
+
+///////////////////////////////////////////////
+// Corpus
+///////////////////////////////////////////////
+// Typical short UI and log strings, mostly ASCII
+static const char *const s_corpus[] = {
+        "OK",
+        "Cancel",
+        "Options",
+        "Player joined the game",
+        "Loading assets/textures/terrain_01.dds",
+        "[Info] Renderer initialised in 12 ms >> EdoRenderer.cpp:118",
+        "Caf\xC3\xA9 au lait",
+        "The quick brown fox jumps over the lazy dog while the log keeps on scrolling by",
+};
+
+static const size_t s_corpusSize = sizeof(s_corpus) / sizeof(s_corpus[0]);
+
+///////////////////////////////////////////////
+// EdoUtf8String vs EdoString storage
+///////////////////////////////////////////////
+template<typename StringType>
+static void Footprint(const char *name) {
+    const size_t count = 4096;
+    vector<StringType> strings;
+    strings.reserve(count);
+
+    size_t bytes = g_allocBytes.load();
+
+    for (size_t i = 0; i < count; ++i)
+        strings.push_back(StringType(s_corpus[i % s_corpusSize]));
+
+    double perString = (double) (sizeof(StringType) * count + g_allocBytes.load() - bytes) / count;
+    printf("%-56s %12.1f B/string (sizeof %u)\n", name, perString, (unsigned) sizeof(StringType));
+}
+
+static void BenchUtf8Storage() {
+    if (!Section("EdoUtf8String vs EdoString"))
+        return;
+
+    Footprint<EdoString>("footprint EdoString");
+    Footprint<EdoUtf8String>("footprint EdoUtf8String");
+
+    const char *line = s_corpus[5];
+
+    Run("construct const char* EdoString", 1000000, [&] {
+        EdoString str(line);
+        g_sink += str.Size();
+    });
+
+    Run("construct const utf8* EdoString", 1000000, [&] {
+        EdoString str((const utf8 *) line);
+        g_sink += str.Size();
+    });
+
+    Run("construct const char* EdoUtf8String", 1000000, [&] {
+        EdoUtf8String str(line);
+        g_sink += str.Size();
+    });
+
+    EdoString longStr;
+    EdoUtf8String longUtf8;
+
+    for (size_t i = 0; i < 256; ++i) {
+        longStr += (const utf8 *) s_corpus[i % s_corpusSize];
+        longUtf8 += s_corpus[i % s_corpusSize];
+    }
+
+    // Writing through operator[] marks the encoding stale, so every call encodes the whole string again
+    EdoBenchResult result = Run("c_str() EdoString (8 KiB, after an edit)", 20000, [&] {
+        longStr[0] = longStr[0];
+        g_sink += (size_t) longStr.c_str()[0];
+    });
+    Throughput(result, longUtf8.ByteSize());
+
+    Run("c_str() EdoString (8 KiB, unchanged)", 20000, [&] {
+        g_sink += (size_t) longStr.c_str()[0];
+    });
+
+    // As when a string is logged or streamed many times between edits: only the first call encodes
+    Run("c_str() EdoString (8 KiB, 16 calls per edit)", 20000, [&] {
+        longStr[0] = longStr[0];
+
+        for (size_t i = 0; i < 16; ++i)
+            g_sink += (size_t) longStr.c_str()[i];
+    });
+
+    // No encoding takes place here, so this is constant time regardless of the length
+    Run("c_str() EdoUtf8String (8 KiB)", 20000, [&] {
+        g_sink += (size_t) longUtf8.c_str()[0];
+    });
+
+    Run("operator[] EdoString (8 KiB, strided)", 20000, [&] {
+        for (size_t i = 0; i < longStr.Size(); i += 97)
+            g_sink += longStr[i];
+    });
+
+    Run("operator[] EdoUtf8String (8 KiB, strided)", 20000, [&] {
+        for (size_t i = 0; i < longUtf8.Size(); i += 97)
+            g_sink += longUtf8[i];
+    });
+
+    Run("Find(utf32) EdoString (8 KiB)", 20000, [&] {
+        g_sink += longStr.Find((utf32) '~');
+    });
+
+    Run("Find(utf32) EdoUtf8String (8 KiB)", 20000, [&] {
+        g_sink += longUtf8.Find((utf32) '~');
+    });
+}
+
+///////////////////////////////////////////////
+// EdoString object layout
+///////////////////////////////////////////////
+static void BenchLayout() {
+    if (!Section("EdoString layout"))
+        return;
+
+    printf("%-56s %12u bytes\n", "sizeof(EdoString)", (unsigned) sizeof(EdoString));
+    printf("%-56s %12u code points\n", "quick-buffer capacity", (unsigned) EdoString().Capacity());
+
+    vector<EdoString> corpus;
+
+    for (size_t i = 0; i < 1024; ++i)
+        corpus.push_back(EdoString(s_corpus[i % s_corpusSize]) + ToString(i));
+
+    Run("construct short (quick-buffer)", 1000000, [&] {
+        EdoString str("OK");
+        g_sink += str.Size();
+    });
+
+    EdoString shortStr("OK");
+
+    Run("copy short (quick-buffer)", 1000000, [&] {
+        EdoString str(shortStr);
+        g_sink += str.Size();
+    });
+
+    Run("copy medium (heap)", 1000000, [&] {
+        EdoString str(corpus[3]);
+        g_sink += str.Size();
+    });
+
+    Run("Compare equal medium", 1000000, [&] {
+        g_sink += corpus[3].Compare(corpus[3 + s_corpusSize]);
+    });
+
+    Run("c_str() medium (unchanged)", 1000000, [&] {
+        g_sink += (size_t) corpus[5].c_str()[0];
+    });
+
+    Run("vector<EdoString> linear scan (1024)", 10000, [&] {
+        size_t total = 0;
+
+        for (const EdoString &str : corpus)
+            total += str.Size();
+
+        g_sink += total;
+    });
+
+    Run("vector<EdoString> build + sort (1024)", 200, [&] {
+        vector<EdoString> strings(corpus);
+        std::sort(strings.begin(), strings.end());
+        g_sink += strings.front().Size();
+    });
+
+    std::map<EdoString, size_t> map;
+
+    for (size_t i = 0; i < corpus.size(); ++i)
+        map[corpus[i]] = i;
+
+    Run("map<EdoString> find (1024 entries)", 100000, [&] {
+        g_sink += map.find(corpus[g_sink % corpus.size()])->second;
+    });
+}
+
+///////////////////////////////////////////////
+// Move semantics and concatenation chains
+///////////////////////////////////////////////
+static void BenchMoveSemantics() {
+    if (!Section("EdoString move semantics"))
+        return;
+
+    EdoString type("Info");
+    EdoString message(s_corpus[7]);
+    EdoString file("EdoRenderer.cpp");
+    EdoString medium(s_corpus[5]);
+
+    // Same shape as the chain in EdoTextLog::Write
+    Run("log line chain (8 terms)", 1000000, [&] {
+        EdoString msg = "[" + type + "] " + message + " >> " + file + ":" + ToString(118);
+        g_sink += msg.Size();
+    });
+
+    // Heap allocations of an N-term chain, which only grow with the number of buffer doublings
+    EdoString part("term ");
+
+    for (size_t terms = 4; terms <= 256; terms *= 4) {
+        char name[64];
+        sprintf(name, "chain of %u EdoString terms", (unsigned) terms);
+
+        Run(name, 20000, [&] {
+            EdoString result = part + part;
+
+            for (size_t i = 2; i < terms; ++i)
+                result = std::move(result) + part;
+
+            g_sink += result.Size();
+        });
+    }
+
+    Run("move construct (heap)", 1000000, [&] {
+        EdoString source(medium);
+        EdoString moved(std::move(source));
+        g_sink += moved.Size();
+    });
+
+    Run("copy construct (heap)", 1000000, [&] {
+        EdoString source(medium);
+        EdoString copied(source);
+        g_sink += copied.Size();
+    });
+
+    Run("Swap (heap and quick-buffer)", 1000000, [&] {
+        EdoString shortStr("OK");
+        shortStr.Swap(medium);
+        medium.Swap(shortStr);
+        g_sink += medium.Size();
+    });
+}
+
+///////////////////////////////////////////////
+// EdoStringBuilder
+///////////////////////////////////////////////
+static void BenchBuilder() {
+    if (!Section("EdoStringBuilder"))
+        return;
+
+    EdoString type("Info");
+    EdoString message(s_corpus[7]);
+    EdoString file("EdoRenderer.cpp");
+    EdoString line("118");
+    std::string detail("renderer");
+
+    Run("log line operator+ (10 mixed pieces)", 1000000, [&] {
+        EdoString msg = "[" + type + "] " + message + " (" + detail + ") >> " + file + (utf32) ':' + line;
+        g_sink += msg.Size();
+    });
+
+    Run("log line EdoStringBuilder (10 mixed pieces)", 1000000, [&] {
+        EdoString msg = (EdoStringBuilder() << "[" << type << "] " << message << " (" << detail << ") >> " << file
+                                            << ':' << line).ToString();
+        g_sink += msg.Size();
+    });
+
+    Run("log line EdoStringBuilder (wide TEXT pieces)", 1000000, [&] {
+        EdoString msg = (EdoStringBuilder() << L"[" << type << L"] " << message << L" >> " << file << L":"
+                                            << line).ToString();
+        g_sink += msg.Size();
+    });
+
+    Run("EdoStringBuilder 32 pieces", 200000, [&] {
+        EdoStringBuilder builder;
+
+        for (size_t i = 0; i < 32; ++i)
+            builder << message << ", ";
+
+        g_sink += builder.ToString().Size();
+    });
+}
+
+///////////////////////////////////////////////
+// Allocators and growth policies
+///////////////////////////////////////////////
+// Bump allocator standing in for a per-frame arena, memory is only reclaimed by Reset()
+class BenchArenaAllocator : public EdoStringAllocator {
+public:
+    explicit BenchArenaAllocator(size_t size) : d_memory(size), d_used(0) {}
+
+    void *Allocate(size_t bytes) override {
+        bytes = (bytes + 15) & ~(size_t) 15;
+
+        if (d_used + bytes > d_memory.size())
+            throw std::bad_alloc();
+
+        void *p = &d_memory[d_used];
+        d_used += bytes;
+        return p;
+    }
+
+    void Deallocate(void *, size_t) override {}
+
+    void Reset() { d_used = 0; }
+
+private:
+    vector<unsigned char> d_memory;
+    size_t d_used;
+};
+
+static void BenchAppendWorkloads(const char *policyName) {
+    char name[96];
+
+    sprintf(name, "PushBack 4096 code points (%s)", policyName);
+    Run(name, 2000, [&] {
+        EdoString str;
+
+        for (utf32 cp = 0; cp < 4096; ++cp)
+            str.PushBack('a' + cp % 26);
+
+        g_sink += str.Size();
+    });
+
+    sprintf(name, "Append(1, cp) 4096 code points (%s)", policyName);
+    Run(name, 2000, [&] {
+        EdoString str;
+
+        for (utf32 cp = 0; cp < 4096; ++cp)
+            str.Append(1, 'a' + cp % 26);
+
+        g_sink += str.Size();
+    });
+
+    sprintf(name, "Append 256 log lines (%s)", policyName);
+    Run(name, 2000, [&] {
+        EdoString str;
+
+        for (size_t i = 0; i < 256; ++i)
+            str += s_corpus[i % s_corpusSize];
+
+        g_sink += str.Size();
+    });
+}
+
+static void BenchAllocators() {
+    if (!Section("EdoString allocators and growth policies"))
+        return;
+
+    EdoStringHeapAllocator exact(EdoStringAllocator::GrowExact);
+    EdoStringHeapAllocator oneAndHalf(EdoStringAllocator::GrowOneAndHalf);
+    EdoStringHeapAllocator twice(EdoStringAllocator::GrowDouble);
+
+    {
+        EdoStringAllocatorScope scope(exact);
+        BenchAppendWorkloads("exact");
+    }
+    {
+        EdoStringAllocatorScope scope(oneAndHalf);
+        BenchAppendWorkloads("1.5x");
+    }
+    {
+        EdoStringAllocatorScope scope(twice);
+        BenchAppendWorkloads("2x");
+    }
+
+    BenchArenaAllocator arena(1 << 20);
+    EdoStringAllocatorScope scope(arena);
+
+    Run("Append 256 log lines (2x, arena)", 2000, [&] {
+        {
+            EdoString str;
+
+            for (size_t i = 0; i < 256; ++i)
+                str += s_corpus[i % s_corpusSize];
+
+            g_sink += str.Size();
+        }
+
+        arena.Reset();
+    });
+}
+
+///////////////////////////////////////////////
+// utf32 -> utf8 encoding
+///////////////////////////////////////////////
+// Scalar reference, the per code point loop EdoString used before the kernels
+static size_t EncodeUtf8Reference(const utf32 *src, size_t len, utf8 *dest) {
+    utf8 *start = dest;
+
+    for (size_t i = 0; i < len; ++i) {
+        utf32 cp = src[i];
+
+        if (cp < 0x80) {
+            *dest++ = (utf8) cp;
+        } else if (cp < 0x0800) {
+            *dest++ = (utf8) ((cp >> 6) | 0xC0);
+            *dest++ = (utf8) ((cp & 0x3F) | 0x80);
+        } else if (cp < 0x10000) {
+            *dest++ = (utf8) ((cp >> 12) | 0xE0);
+            *dest++ = (utf8) (((cp >> 6) & 0x3F) | 0x80);
+            *dest++ = (utf8) ((cp & 0x3F) | 0x80);
+        } else {
+            *dest++ = (utf8) ((cp >> 18) | 0xF0);
+            *dest++ = (utf8) (((cp >> 12) & 0x3F) | 0x80);
+            *dest++ = (utf8) (((cp >> 6) & 0x3F) | 0x80);
+            *dest++ = (utf8) ((cp & 0x3F) | 0x80);
+        }
+    }
+
+    return dest - start;
+}
+
+static const char *const s_simdNames[] = {"scalar", "sse2", "sse4.1", "avx2"};
+
+static void BenchEncodeCorpus(const char *corpusName, const vector<utf32> &text) {
+    const size_t bytes = text.size() * sizeof(utf32);
+    vector<utf8> dest(text.size() * 4);
+    char name[96];
+
+    sprintf(name, "encode %s reference loop", corpusName);
+    Throughput(Run(name, 200, [&] {
+        g_sink += EncodeUtf8Reference(text.data(), text.size(), dest.data());
+    }), bytes);
+
+    for (int level = SimdScalar; level <= SimdAvx2; ++level) {
+        SetSimdLevel((EdoSimdLevel) level);
+
+        if (GetSimdLevel() != level)
+            continue;
+
+        sprintf(name, "EncodeUtf8 %s (%s)", corpusName, s_simdNames[level]);
+        Throughput(Run(name, 200, [&] {
+            g_sink += EncodeUtf8(text.data(), text.size(), dest.data(), dest.size());
+        }), bytes);
+
+        sprintf(name, "Utf8LengthOf %s (%s)", corpusName, s_simdNames[level]);
+        Throughput(Run(name, 200, [&] {
+            g_sink += Utf8LengthOf(text.data(), text.size());
+        }), bytes);
+    }
+
+    SetSimdLevel(SimdAvx2);
+}
+
+static void BenchEncode() {
+    if (!Section("utf32 -> utf8 encoding (64Ki code points)"))
+        return;
+
+    const size_t count = 64 * 1024;
+    vector<utf32> ascii, latin, cjk;
+
+    for (size_t i = 0; i < count; ++i) {
+        const char *line = s_corpus[(i / 64) % s_corpusSize];
+        utf32 cp = (utf8) line[i % strlen(line)];
+
+        ascii.push_back(cp & 0x7F);
+        latin.push_back((i % 8 == 0) ? 0xE9 : cp & 0x7F);
+        cjk.push_back(0x4E00 + (utf32) (i % 0x5000));
+    }
+
+    BenchEncodeCorpus("ascii", ascii);
+    BenchEncodeCorpus("latin-1 (1 in 8)", latin);
+    BenchEncodeCorpus("cjk", cjk);
+
+    EdoString str;
+
+    for (size_t i = 0; i < count; ++i)
+        str.PushBack(ascii[i]);
+
+    Throughput(Run("EdoString::c_str() ascii", 200, [&] {
+        g_sink += (size_t) str.c_str()[0];
+    }), count * sizeof(utf32));
+}
+
+///////////////////////////////////////////////
+// utf8 -> utf32 decoding
+///////////////////////////////////////////////
+// Scalar reference, the two passes EdoString used before the decoder: count the code points, then decode without
+// any validation
+static size_t DecodeUtf8Reference(const utf8 *src, size_t len, utf32 *dest) {
+    size_t count = 0;
+
+    for (size_t i = 0; i < len; ++count) {
+        utf8 cu = src[i];
+        i += (cu < 0x80) ? 1 : (cu < 0xE0) ? 2 : (cu < 0xF0) ? 3 : 4;
+    }
+
+    for (size_t i = 0; i < len;) {
+        utf8 cu = src[i++];
+        utf32 cp;
+
+        if (cu < 0x80) {
+            cp = cu;
+        } else if (cu < 0xE0) {
+            cp = ((cu & 0x1F) << 6) | (src[i++] & 0x3F);
+        } else if (cu < 0xF0) {
+            cp = ((cu & 0x0F) << 12) | ((src[i] & 0x3F) << 6) | (src[i + 1] & 0x3F);
+            i += 2;
+        } else {
+            cp = ((cu & 0x07) << 18) | ((src[i] & 0x3F) << 12) | ((src[i + 1] & 0x3F) << 6) | (src[i + 2] & 0x3F);
+            i += 3;
+        }
+
+        *dest++ = cp;
+    }
+
+    return count;
+}
+
+static void BenchDecodeCorpus(const char *corpusName, const vector<utf32> &text) {
+    vector<utf8> encoded(text.size() * 4);
+    encoded.resize(EncodeUtf8(text.data(), text.size(), encoded.data(), encoded.size()));
+
+    const size_t bytes = encoded.size();
+    vector<utf32> dest(bytes);
+    char name[96];
+
+    sprintf(name, "decode %s reference (2 passes)", corpusName);
+    Throughput(Run(name, 200, [&] {
+        g_sink += DecodeUtf8Reference(encoded.data(), bytes, dest.data());
+    }), bytes);
+
+    for (int level = SimdScalar; level <= SimdAvx2; ++level) {
+        SetSimdLevel((EdoSimdLevel) level);
+
+        if (GetSimdLevel() != level)
+            continue;
+
+        sprintf(name, "DecodeUtf8 %s (%s)", corpusName, s_simdNames[level]);
+        Throughput(Run(name, 200, [&] {
+            g_sink += DecodeUtf8(encoded.data(), bytes, dest.data());
+        }), bytes);
+    }
+
+    SetSimdLevel(SimdAvx2);
+
+    sprintf(name, "EdoString(utf8, len) %s", corpusName);
+    Throughput(Run(name, 200, [&] {
+        EdoString str(encoded.data(), bytes);
+        g_sink += str.Size();
+    }), bytes);
+}
+
+static void BenchDecode() {
+    if (!Section("utf8 -> utf32 decoding (64Ki code points, GB/s of utf8 input)"))
+        return;
+
+    const size_t count = 64 * 1024;
+    vector<utf32> ascii, latin, cjk, mixed;
+
+    for (size_t i = 0; i < count; ++i) {
+        const char *line = s_corpus[(i / 64) % s_corpusSize];
+        utf32 cp = (utf8) line[i % strlen(line)];
+
+        ascii.push_back(cp & 0x7F);
+        latin.push_back((i % 8 == 0) ? 0xE9 : cp & 0x7F);
+        cjk.push_back(0x4E00 + (utf32) (i % 0x5000));
+        mixed.push_back((i % 16 == 0) ? 0x1F600 + (utf32) (i % 64) : (i % 3 == 0) ? 0x4E00 + (utf32) i % 0x5000 : cp & 0x7F);
+    }
+
+    BenchDecodeCorpus("ascii", ascii);
+    BenchDecodeCorpus("latin-1 (1 in 8)", latin);
+    BenchDecodeCorpus("cjk", cjk);
+    BenchDecodeCorpus("mixed + emoji", mixed);
+}
+
+///////////////////////////////////////////////
+// utf8 validation and counting
+///////////////////////////////////////////////
+// Scalar reference, the loop EdoString::EncodedSize(const utf8 *, len) used to count code points: one step per lead
+static size_t CountCodePointsReference(const utf8 *buf, size_t len) {
+    size_t count = 0;
+
+    while (len--) {
+        utf8 tcp = *buf++;
+        size_t size = (tcp < 0x80) ? 0 : (tcp < 0xE0) ? 1 : (tcp < 0xF0) ? 2 : 3;
+
+        ++count;
+        buf += size;
+
+        if (len >= size)
+            len -= size;
+        else
+            break;
+    }
+
+    return count;
+}
+
+static void BenchValidateCorpus(const char *corpusName, const vector<utf32> &text) {
+    vector<utf8> encoded(text.size() * 4);
+    encoded.resize(EncodeUtf8(text.data(), text.size(), encoded.data(), encoded.size()));
+
+    const size_t bytes = encoded.size();
+    vector<utf32> dest(bytes);
+    char name[96];
+
+    sprintf(name, "count %s reference loop", corpusName);
+    Throughput(Run(name, 200, [&] {
+        g_sink += CountCodePointsReference(encoded.data(), bytes);
+    }), bytes);
+
+    for (int level = SimdScalar; level <= SimdAvx2; ++level) {
+        SetSimdLevel((EdoSimdLevel) level);
+
+        if (GetSimdLevel() != level)
+            continue;
+
+        sprintf(name, "ValidateUtf8 %s (%s)", corpusName, s_simdNames[level]);
+        Throughput(Run(name, 200, [&] {
+            g_sink += ValidateUtf8(encoded.data(), bytes);
+        }), bytes);
+
+        sprintf(name, "CountCodePoints %s (%s)", corpusName, s_simdNames[level]);
+        Throughput(Run(name, 200, [&] {
+            g_sink += CountCodePoints(encoded.data(), bytes);
+        }), bytes);
+    }
+
+    SetSimdLevel(SimdAvx2);
+
+    // What validation cost before: decoding into a scratch buffer and checking the error offset
+    sprintf(name, "DecodeUtf8 as a validator %s", corpusName);
+    Throughput(Run(name, 200, [&] {
+        size_t error;
+        g_sink += DecodeUtf8(encoded.data(), bytes, dest.data(), Utf8Replace, &error) + (error == UTF_NO_ERROR);
+    }), bytes);
+}
+
+static void BenchValidate() {
+    if (!Section("utf8 validation and counting (64Ki code points, GB/s of utf8 input)"))
+        return;
+
+    const size_t count = 64 * 1024;
+    vector<utf32> ascii, latin, cjk, mixed;
+
+    for (size_t i = 0; i < count; ++i) {
+        const char *line = s_corpus[(i / 64) % s_corpusSize];
+        utf32 cp = (utf8) line[i % strlen(line)];
+
+        ascii.push_back(cp & 0x7F);
+        latin.push_back((i % 8 == 0) ? 0xE9 : cp & 0x7F);
+        cjk.push_back(0x4E00 + (utf32) (i % 0x5000));
+        mixed.push_back((i % 16 == 0) ? 0x1F600 + (utf32) (i % 64) : (i % 3 == 0) ? 0x4E00 + (utf32) i % 0x5000 : cp & 0x7F);
+    }
+
+    BenchValidateCorpus("ascii", ascii);
+    BenchValidateCorpus("latin-1 (1 in 8)", latin);
+    BenchValidateCorpus("cjk", cjk);
+    BenchValidateCorpus("mixed + emoji", mixed);
+}
+
+///////////////////////////////////////////////
+// utf32 <-> utf16
+///////////////////////////////////////////////
+// Scalar reference, the loop EdoString::ToUtf16() used before the kernels: one append per code unit, no pre-sizing
+static size_t EncodeUtf16Reference(const utf32 *src, size_t len, std::wstring &target) {
+    target.clear();
+
+    for (size_t i = 0; i < len; ++i) {
+        utf32 cp = src[i];
+
+        if (cp < 0x10000) {
+            target.append(1, (wchar_t) cp);
+        } else {
+            cp -= 0x10000;
+            target.append(1, (wchar_t) ((cp >> 10) + 0xD800));
+            target.append(1, (wchar_t) ((cp & 0x3FF) + 0xDC00));
+        }
+    }
+
+    return target.size();
+}
+
+static void BenchUtf16Corpus(const char *corpusName, const vector<utf32> &text) {
+    const size_t bytes = text.size() * sizeof(utf32);
+    vector<utf16> encoded(text.size() * 2);
+    encoded.resize(EncodeUtf16(text.data(), text.size(), encoded.data(), encoded.size()));
+
+    vector<utf32> decoded(encoded.size());
+    std::wstring wide;
+    EdoString str(EdoStringView(text.data(), text.size()));
+    char name[96];
+
+    sprintf(name, "encode %s reference loop (std::wstring)", corpusName);
+    Throughput(Run(name, 200, [&] {
+        g_sink += EncodeUtf16Reference(text.data(), text.size(), wide);
+    }), bytes);
+
+    for (int level = SimdScalar; level <= SimdAvx2; ++level) {
+        SetSimdLevel((EdoSimdLevel) level);
+
+        if (GetSimdLevel() != level || level == SimdSse41)
+            continue;
+
+        sprintf(name, "EncodeUtf16 %s (%s)", corpusName, s_simdNames[level]);
+        Throughput(Run(name, 200, [&] {
+            g_sink += EncodeUtf16(text.data(), text.size(), encoded.data(), encoded.size());
+        }), bytes);
+
+        sprintf(name, "DecodeUtf16 %s (%s)", corpusName, s_simdNames[level]);
+        Throughput(Run(name, 200, [&] {
+            g_sink += DecodeUtf16(encoded.data(), encoded.size(), decoded.data());
+        }), bytes);
+    }
+
+    SetSimdLevel(SimdAvx2);
+
+    sprintf(name, "EdoString::ToUtf16() %s", corpusName);
+    Throughput(Run(name, 200, [&] {
+        g_sink += str.ToUtf16().size();
+    }), bytes);
+
+    sprintf(name, "EdoString::FromUtf16() %s", corpusName);
+    Throughput(Run(name, 200, [&] {
+        g_sink += EdoString::FromUtf16(encoded.data(), encoded.size()).Length();
+    }), bytes);
+}
+
+static void BenchUtf16() {
+    if (!Section("utf32 <-> utf16 transcoding (64Ki code points, GB/s of utf32)"))
+        return;
+
+    const size_t count = 64 * 1024;
+    vector<utf32> ascii, cjk, mixed;
+
+    for (size_t i = 0; i < count; ++i) {
+        const char *line = s_corpus[(i / 64) % s_corpusSize];
+        utf32 cp = (utf8) line[i % strlen(line)];
+
+        ascii.push_back(cp & 0x7F);
+        cjk.push_back(0x4E00 + (utf32) (i % 0x5000));
+        mixed.push_back((i % 16 == 0) ? 0x1F600 + (utf32) (i % 64) : (i % 3 == 0) ? 0x4E00 + (utf32) i % 0x5000 : cp & 0x7F);
+    }
+
+    BenchUtf16Corpus("ascii", ascii);
+    BenchUtf16Corpus("cjk", cjk);
+    BenchUtf16Corpus("mixed + emoji", mixed);
+}
+
+///////////////////////////////////////////////
+// Code point search
+///////////////////////////////////////////////
+// Scalar references, the loops EdoString used before the kernels: one code point at a time, and for sets a scan of
+// the set per code point
+static size_t FindReference(const EdoString &str, utf32 code_point) {
+    const utf32 *pt = str.ptr();
+
+    for (size_t idx = 0; idx < str.Length(); ++idx) {
+        if (pt[idx] == code_point)
+            return idx;
+    }
+
+    return EdoString::npos;
+}
+
+static size_t FindFirstOfReference(const EdoString &str, const char *chars, size_t chars_len) {
+    const utf32 *pt = str.ptr();
+
+    for (size_t idx = 0; idx < str.Length(); ++idx) {
+        for (size_t c = 0; c < chars_len; ++c) {
+            if (pt[idx] == (utf8) chars[c])
+                return idx;
+        }
+    }
+
+    return EdoString::npos;
+}
+
+static void BenchFindLength(size_t length) {
+    static const char whitespace[] = " \t\r\n";
+    static const char punctuation[] = "!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+    // Text without a match until the last code point, so every search covers the whole string
+    EdoString text, padded, cjk;
+
+    for (size_t i = 0; i + 1 < length; ++i) {
+        const char *line = s_corpus[(i / 64) % s_corpusSize];
+        utf32 cp = (utf8) line[i % strlen(line)];
+
+        text.PushBack(isalnum((int) cp) ? cp : 'x');
+        padded.PushBack(i < length / 2 ? ' ' : 'x');
+        cjk.PushBack(0x4E00 + (utf32) (i % 0x5000));
+    }
+
+    text.PushBack('!');
+    padded.PushBack('x');
+    cjk.PushBack(0x3002);
+
+    const size_t iterations = 2000000 / length + 100;
+    const EdoCodePointSet punctuationSet(punctuation, sizeof(punctuation) - 1);
+    char name[96];
+
+    sprintf(name, "Find(utf32) len %zu reference loop", length);
+    Run(name, iterations, [&] { g_sink += FindReference(text, '!'); });
+
+    sprintf(name, "FindFirstOf(\" \\t\\r\\n\") len %zu reference loop", length);
+    Run(name, iterations, [&] { g_sink += FindFirstOfReference(text, whitespace, 4); });
+
+    sprintf(name, "FindFirstOf(punctuation) len %zu reference loop", length);
+    Run(name, iterations, [&] { g_sink += FindFirstOfReference(text, punctuation, sizeof(punctuation) - 1); });
+
+    for (int level = SimdScalar; level <= SimdAvx2; ++level) {
+        SetSimdLevel((EdoSimdLevel) level);
+
+        if (GetSimdLevel() != level)
+            continue;
+
+        sprintf(name, "Find(utf32) len %zu (%s)", length, s_simdNames[level]);
+        Run(name, iterations, [&] { g_sink += text.Find('!'); });
+
+        sprintf(name, "RFind(utf32) cjk len %zu (%s)", length, s_simdNames[level]);
+        Run(name, iterations, [&] { g_sink += cjk.RFind(0x4E00); });
+
+        sprintf(name, "FindFirstOf(\" \\t\\r\\n\") len %zu (%s)", length, s_simdNames[level]);
+        Run(name, iterations, [&] { g_sink += text.FindFirstOf(whitespace); });
+
+        sprintf(name, "FindFirstNotOf(\" \\t\\r\\n\") len %zu (%s)", length, s_simdNames[level]);
+        Run(name, iterations, [&] { g_sink += padded.FindFirstNotOf(whitespace); });
+    }
+
+    SetSimdLevel(SimdAvx2);
+
+    sprintf(name, "FindFirstOf(punctuation) len %zu", length);
+    Run(name, iterations, [&] { g_sink += text.FindFirstOf(punctuation); });
+
+    sprintf(name, "FindFirstOf(prebuilt set) len %zu", length);
+    Run(name, iterations, [&] { g_sink += text.FindFirstOf(punctuationSet); });
+
+    sprintf(name, "FindLastNotOf(prebuilt set) len %zu", length);
+    Run(name, iterations, [&] { g_sink += text.FindLastNotOf(punctuationSet); });
+}
+
+static void BenchFind() {
+    if (!Section("Code point search (match at the far end)"))
+        return;
+
+    BenchFindLength(16);
+    BenchFindLength(64);
+    BenchFindLength(256);
+    BenchFindLength(4096);
+}
+
+///////////////////////////////////////////////
+// Substring search
+///////////////////////////////////////////////
+// Scalar reference, what EdoString::Find did before: compare the needle at every position
+static size_t FindSubstringReference(const EdoString &str, const EdoString &needle) {
+    const utf32 *pt = str.ptr();
+    const utf32 *nd = needle.ptr();
+
+    for (size_t idx = 0; idx + needle.Length() <= str.Length(); ++idx) {
+        if (std::equal(nd, nd + needle.Length(), pt + idx))
+            return idx;
+    }
+
+    return EdoString::npos;
+}
+
+static void BenchSubstringCase(const char *caseName, const EdoString &text, const EdoString &needle) {
+    const size_t iterations = 50;
+    char name[96];
+
+    sprintf(name, "%s reference loop", caseName);
+    Run(name, iterations, [&] { g_sink += FindSubstringReference(text, needle); });
+
+    for (int level = SimdScalar; level <= SimdAvx2; ++level) {
+        SetSimdLevel((EdoSimdLevel) level);
+
+        if (GetSimdLevel() != level)
+            continue;
+
+        sprintf(name, "%s Find (%s)", caseName, s_simdNames[level]);
+        Run(name, iterations, [&] { g_sink += text.Find(needle); });
+    }
+
+    SetSimdLevel(SimdAvx2);
+
+    // The needle sits at the far end, so searching backwards from the end finds the last line instead
+    sprintf(name, "%s RFind", caseName);
+    Run(name, iterations, [&] { g_sink += text.RFind(needle, text.Length() / 2); });
+}
+
+static void BenchSubstring() {
+    if (!Section("Substring search (64Ki code point haystack, match at the far end)"))
+        return;
+
+    const size_t count = 64 * 1024;
+    EdoString log, repetitive;
+
+    while (log.Length() < count) {
+        for (size_t line = 0; line < s_corpusSize && log.Length() < count; ++line) {
+            log += s_corpus[line];
+            log += "\n";
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i)
+        repetitive.PushBack('a');
+
+    EdoString word("Warning");
+    EdoString phrase("Shader cache rebuilt");
+    EdoString sentence("[Warn] Shader cache rebuilt after driver update >> EdoRenderer.cpp:207");
+    EdoString periodic;
+
+    // First and last code point match everywhere, so the prefilter gives up and Two-Way takes over
+    for (size_t i = 0; i < 32; ++i)
+        periodic.PushBack(i == 15 ? 'b' : 'a');
+
+    log += sentence;
+    repetitive += periodic;
+
+    BenchSubstringCase("log, 7 code point needle", log, word);
+    BenchSubstringCase("log, 20 code point needle", log, phrase);
+    BenchSubstringCase("log, 72 code point needle", log, sentence);
+    BenchSubstringCase("'aaa...', needle 'a' x 15 + 'b' + 'a' x 16", repetitive, periodic);
+
+    // Many short haystacks, one needle
+    vector<EdoString> lines;
+
+    for (size_t i = 0; i < 1024; ++i)
+        lines.push_back(EdoString(s_corpus[i % s_corpusSize]));
+
+    const EdoStringSearcher searcher("lazy dog", 8);
+
+    Run("1024 lines, Find(\"lazy dog\")", 200, [&] {
+        for (const EdoString &line : lines)
+            g_sink += line.Find("lazy dog");
+    });
+
+    Run("1024 lines, Find(EdoStringSearcher)", 200, [&] {
+        for (const EdoString &line : lines)
+            g_sink += line.Find(searcher);
+    });
+}
+
+//////////////////////////////////////////////
+// Multi-pattern search
+//////////////////////////////////////////////
+static void BenchMultiSearch() {
+    if (!Section("Multi-pattern search (256 keywords, 64Ki code point log)"))
+        return;
+
+    const size_t count = 64 * 1024;
+    EdoString log;
+
+    while (log.Length() < count) {
+        for (size_t line = 0; line < s_corpusSize && log.Length() < count; ++line) {
+            log += s_corpus[line];
+            log += "\n";
+        }
+    }
+
+    const std::string logUtf8(log.c_str());
+
+    // A few words that do occur in the log, padded with asset names that mostly do not
+    vector<EdoString> keywords = {EdoString("lazy dog"), EdoString("Renderer"), EdoString("joined"),
+                                  EdoString((const utf8 *) "Caf\xC3\xA9", 5), EdoString("terrain_01")};
+
+    for (size_t i = keywords.size(); i < 256; ++i)
+        keywords.push_back(EdoString("asset_") + ToString(i));
+
+    vector<EdoStringView> views(keywords.begin(), keywords.end());
+    const EdoMultiSearcher searcher(views.data(), views.size());
+    const EdoMultiSearcher ignoreCase(views.data(), views.size(), CaseInsensitive);
+
+    printf("%-56s %zu states, %zu B table\n", "automaton", searcher.StateCount(), searcher.TableBytes());
+
+    auto count_match = [](const EdoMultiMatch &match) {
+        g_sink += match.end;
+        return true;
+    };
+
+    // Every case reports bytes of utf8 text, so their throughput compares directly
+    Throughput(Run("256 x EdoString::Find loop", 5, [&] {
+        for (const EdoString &keyword : keywords)
+            for (size_t pos = log.Find(keyword); pos != EdoString::npos; pos = log.Find(keyword, pos + 1))
+                g_sink += pos;
+    }), logUtf8.size());
+
+    Throughput(Run("FindAll (utf32)", 50, [&] { searcher.FindAll(log, count_match); }), logUtf8.size());
+
+    Throughput(Run("FindAll (utf8)", 50, [&] {
+        searcher.FindAll((const utf8 *) logUtf8.data(), logUtf8.size(), count_match);
+    }), logUtf8.size());
+
+    Throughput(Run("FindAll (utf8, case insensitive)", 50, [&] {
+        ignoreCase.FindAll((const utf8 *) logUtf8.data(), logUtf8.size(), count_match);
+    }), logUtf8.size());
+
+    Throughput(Run("Stream (utf8, 4 KiB chunks)", 50, [&] {
+        EdoMultiSearcher::Stream stream(searcher);
+
+        for (size_t at = 0; at < logUtf8.size(); at += 4096) {
+            size_t len = std::min<size_t>(4096, logUtf8.size() - at);
+            stream.Feed((const utf8 *) logUtf8.data() + at, len, count_match);
+        }
+
+        stream.Finish(count_match);
+    }), logUtf8.size());
+
+    Run("Build automaton (256 keywords)", 50, [&] {
+        EdoMultiSearcher built(views.data(), views.size());
+        g_sink += built.StateCount();
+    });
+}
+
+//////////////////////////////////////////////
+// Hashing and keyed lookups
+//////////////////////////////////////////////
+template<typename Map>
+static void BenchLookups(const char *name, const vector<EdoString> &keys, const vector<EdoString> &queries) {
+    Map map;
+
+    for (size_t i = 0; i < keys.size(); ++i)
+        map[keys[i]] = (int) i;
+
+    Run(name, 200, [&] {
+        for (const EdoString &query : queries)
+            g_sink += map.find(query)->second;
+    });
+}
+
+static void BenchKeySet(const char *setName, const vector<EdoString> &keys) {
+    char name[96];
+
+    // Lookups use equal strings rather than the keys themselves, as they would when parsing input
+    vector<EdoString> queries(keys.begin(), keys.end());
+    vector<EdoString> cachedQueries(keys.begin(), keys.end());
+
+    for (EdoString &query : cachedQueries)
+        query.SetHashCaching(true);
+
+    sprintf(name, "%s, Hash()", setName);
+    Run(name, 200, [&] {
+        for (const EdoString &query : queries)
+            g_sink += query.Hash();
+    });
+
+    sprintf(name, "%s, std::map", setName);
+    BenchLookups<std::map<EdoString, int>>(name, keys, queries);
+
+    sprintf(name, "%s, std::map (EdoStringFastLessCompare)", setName);
+    BenchLookups<std::map<EdoString, int, EdoStringFastLessCompare>>(name, keys, queries);
+
+    sprintf(name, "%s, std::unordered_map", setName);
+    BenchLookups<std::unordered_map<EdoString, int>>(name, keys, queries);
+
+    sprintf(name, "%s, std::unordered_map (cached hash)", setName);
+    BenchLookups<std::unordered_map<EdoString, int>>(name, keys, cachedQueries);
+}
+
+static void BenchHashing() {
+    if (!Section("Keyed lookups (1024 keys, all of them looked up once per op)"))
+        return;
+
+    vector<EdoString> identifiers, paths;
+    char key[128];
+
+    for (size_t i = 0; i < 1024; ++i) {
+        sprintf(key, "Entity_%zu", i * 7919 % 100000);
+        identifiers.push_back(EdoString(key));
+
+        sprintf(key, "Assets/Textures/Environment/Terrain/Ground_%04zu_Albedo.dds", i);
+        paths.push_back(EdoString(key));
+    }
+
+    BenchKeySet("identifiers (~11 cp)", identifiers);
+    BenchKeySet("asset paths (~55 cp)", paths);
+
+    const vector<char> block(4096, 'x');
+    EdoBenchResult result = Run("HashBytes, 4096 bytes", 20000, [&] { g_sink += HashBytes(block.data(), block.size()); });
+    Throughput(result, (double) block.size());
+}
+
+//////////////////////////////////////////////
+// Interning
+//////////////////////////////////////////////
+static void BenchInterning() {
+    if (!Section("Interned identifiers (1024 asset names, all of them per op)"))
+        return;
+
+    vector<EdoString> names, probes;
+    vector<std::string> utf8Names;
+    char name[128];
+
+    for (size_t i = 0; i < 1024; ++i) {
+        sprintf(name, "Assets/Meshes/Props/Crate_%04zu.mesh", i);
+        names.push_back(EdoString(name));
+        probes.push_back(EdoString(name));
+        utf8Names.push_back(name);
+    }
+
+    EdoStringTable table;
+    vector<EdoStringId> ids(names.size()), probeIds(names.size());
+
+    Run("InternAll (new table)", 20, [&] {
+        EdoStringTable fresh;
+        fresh.InternAll(names.data(), names.size(), ids.data());
+    });
+
+    table.InternAll(names.data(), names.size(), ids.data());
+
+    for (size_t i = 0; i < probes.size(); ++i)
+        probeIds[i] = table.Intern(probes[i]);
+
+    // Equal names, the way a lookup by name compares them
+    Run("EdoString == (equal names)", 2000, [&] {
+        for (size_t i = 0; i < names.size(); ++i)
+            g_sink += names[i] == probes[i];
+    });
+
+    Run("EdoString::Compare (equal names)", 2000, [&] {
+        for (size_t i = 0; i < names.size(); ++i)
+            g_sink += names[i].Compare(probes[i]);
+    });
+
+    Run("EdoStringId == (equal names)", 2000, [&] {
+        for (size_t i = 0; i < ids.size(); ++i)
+            g_sink += ids[i] == probeIds[i];
+    });
+
+    Run("Intern(EdoString), already interned", 200, [&] {
+        for (const EdoString &probe : probes)
+            g_sink += table.Intern(probe).Value();
+    });
+
+    Run("Intern(utf8), already interned", 200, [&] {
+        for (const std::string &probe : utf8Names)
+            g_sink += table.Intern((const utf8 *) probe.data(), probe.size()).Value();
+    });
+
+    Run("Utf8(id)", 2000, [&] {
+        for (EdoStringId id : ids)
+            g_sink += (size_t) table.Utf8(id)[0];
+    });
+
+    Run("EdoString::c_str()", 200, [&] {
+        for (const EdoString &probe : probes)
+            g_sink += (size_t) probe.c_str()[0];
+    });
+
+    EdoStringTableStats stats = table.Stats();
+    printf("%-56s %zu strings, %zu B text, %zu B entries, %zu B index, %zu B total\n", "table memory", stats.count,
+           stats.textBytes, stats.entryBytes, stats.indexBytes, stats.TotalBytes());
+}
+
+//////////////////////////////////////////////
+// Views
+//////////////////////////////////////////////
+static void BenchViews() {
+    if (!Section("Slicing with EdoStringView (1024 log lines, all of them per op)"))
+        return;
+
+    vector<EdoString> lines;
+
+    for (size_t i = 0; i < 1024; ++i)
+        lines.push_back(EdoString(s_corpus[i % s_corpusSize]));
+
+    const EdoString prefix("[Warn]");
+
+    Run("prefix check, Substr().Compare()", 200, [&] {
+        for (const EdoString &line : lines)
+            g_sink += line.Substr(0, prefix.Length()).Compare(prefix) == 0;
+    });
+
+    Run("prefix check, StartsWith(view)", 200, [&] {
+        for (const EdoString &line : lines)
+            g_sink += line.StartsWith(prefix);
+    });
+
+    // Splitting every line into words
+    Run("split on ' ', Substr()", 50, [&] {
+        for (const EdoString &line : lines) {
+            for (size_t start = 0, end; start < line.Length(); start = end + 1) {
+                end = line.Find((utf32) ' ', start);
+
+                if (end == EdoString::npos)
+                    end = line.Length();
+
+                EdoString word = line.Substr(start, end - start);
+                g_sink += word.Length();
+            }
+        }
+    });
+
+    Run("split on ' ', View()", 50, [&] {
+        for (const EdoString &line : lines) {
+            for (size_t start = 0, end; start < line.Length(); start = end + 1) {
+                end = line.Find((utf32) ' ', start);
+
+                if (end == EdoString::npos)
+                    end = line.Length();
+
+                EdoStringView word = line.View(start, end - start);
+                g_sink += word.Length();
+            }
+        }
+    });
+}
+
+//////////////////////////////////////////////
+// Shared strings
+//////////////////////////////////////////////
+static void BenchShared() {
+    if (!Section("Handing one value to 256 holders, each reading it as utf8"))
+        return;
+
+    // A localised sentence, well past the quick-buffer
+    const EdoString text(s_corpus[7]);
+    const EdoSharedString shared(text);
+    vector<EdoString> copies(256);
+    vector<EdoSharedString> sharedCopies(256);
+
+    Run("EdoString copies + c_str()", 200, [&] {
+        for (EdoString &copy : copies) {
+            copy = text;
+            g_sink += (size_t) copy.c_str()[0];
+        }
+    });
+
+    Run("EdoSharedString copies + c_str()", 200, [&] {
+        for (EdoSharedString &copy : sharedCopies) {
+            copy = shared;
+            g_sink += (size_t) copy.c_str()[0];
+        }
+    });
+
+    // Fresh holders each time, as when objects are created from a config
+    Run("construct 256 EdoString copies", 200, [&] {
+        vector<EdoString> holders(copies.size(), text);
+        g_sink += holders.size();
+    });
+
+    Run("construct 256 EdoSharedString copies", 200, [&] {
+        vector<EdoSharedString> holders(sharedCopies.size(), shared);
+        g_sink += holders.size();
+    });
+}
+
+static void BenchConcurrentReads() {
+    if (!Section("Reading one EdoString from 8 threads (1000 reads each per op)"))
+        return;
+
+    // Each op edits the string and lets every thread race to encode and hash it again. The same race is checked
+    // for correctness by EdoStringStress, which ctest runs
+    EdoString text(s_corpus[7]);
+    text.SetHashCaching(true);
+
+    Run("c_str() + Hash() after an edit", 100, [&] {
+        text[0] = text[0];
+
+        const EdoString &shared = text;
+        vector<std::thread> threads;
+        size_t totals[8] = {};
+
+        for (size_t t = 0; t < 8; ++t) {
+            threads.emplace_back([&shared, &totals, t] {
+                for (size_t i = 0; i < 1000; ++i)
+                    totals[t] += (size_t) shared.c_str()[i % 8] + shared.Hash();
+            });
+        }
+
+        for (size_t t = 0; t < 8; ++t) {
+            threads[t].join();
+            g_sink += totals[t];
+        }
+    });
+}
+
+static void BenchRope() {
+    if (!Section("Editing a 4 MB buffer (1M code points): 64 keystrokes and 64 deletes at random positions"))
+        return;
+
+    EdoString text;
+
+    while (text.Length() < 1024 * 1024)
+        text += s_corpus[7];
+
+    text.Resize(1024 * 1024);
+
+    // The same positions for both containers, from a fixed xorshift sequence
+    vector<size_t> positions(128);
+    uint32_t state = 0x9E3779B9u;
+
+    for (size_t &pos : positions) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        pos = state % (text.Length() - 1);
+    }
+
+    EdoString str(text);
+    EdoRope rope(text.View());
+    const utf32 key = 'x';
+    const EdoStringView keystroke(&key, 1);
+
+    Run("EdoString Insert + Erase", 20, [&] {
+        for (size_t i = 0; i < positions.size(); i += 2) {
+            str.Insert(positions[i], keystroke);
+            str.Erase(positions[i + 1], 1);
+        }
+    });
+
+    Run("EdoRope Insert + Erase", 20, [&] {
+        for (size_t i = 0; i < positions.size(); i += 2) {
+            rope.Insert(positions[i], keystroke);
+            rope.Erase(positions[i + 1], 1);
+        }
+    });
+
+    // Undo history: the whole buffer is kept before every edit
+    vector<EdoString> strUndo;
+    vector<EdoRope> ropeUndo;
+
+    Run("EdoString copy per edit (undo)", 5, [&] {
+        strUndo.clear();
+
+        for (size_t i = 0; i < positions.size(); i += 2) {
+            strUndo.push_back(str);
+            str.Insert(positions[i], keystroke);
+        }
+
+        str.Erase(0, positions.size() / 2);
+    });
+
+    Run("EdoRope Snapshot per edit (undo)", 5, [&] {
+        ropeUndo.clear();
+
+        for (size_t i = 0; i < positions.size(); i += 2) {
+            ropeUndo.push_back(rope.Snapshot());
+            rope.Insert(positions[i], keystroke);
+        }
+
+        rope.Erase(0, positions.size() / 2);
+    });
+
+    // A needle that is not in the buffer, so the whole of it is scanned
+    const EdoString needle("search term missing from the buffer");
+
+    Run("EdoString Find (full scan)", 20, [&] {
+        g_sink += str.Find(needle.View());
+    });
+
+    Run("EdoRope Find (full scan)", 20, [&] {
+        g_sink += rope.Find(needle.View());
+    });
+
+    Run("EdoRope ToString", 20, [&] {
+        g_sink += rope.ToString().Length();
+    });
+}
+
+// Defined in EdoStringSuite.cpp
+void BenchStringSuite();
+
+static int Usage(const char *program) {
+    fprintf(stderr, "usage: %s [--filter <section text>] [--json <file>]\n", program);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    const char *jsonPath = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            State().filter = argv[++i];
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+            return Usage(argv[0]);
+    }
+
+    BenchLayout();
+    BenchMoveSemantics();
+    BenchBuilder();
+    BenchAllocators();
+    BenchEncode();
+    BenchDecode();
+    BenchValidate();
+    BenchUtf16();
+    BenchFind();
+    BenchSubstring();
+    BenchMultiSearch();
+    BenchHashing();
+    BenchInterning();
+    BenchViews();
+    BenchShared();
+    BenchConcurrentReads();
+    BenchRope();
+    BenchUtf8Storage();
+    BenchStringSuite();
+
+    if (jsonPath != nullptr && !WriteJson(jsonPath)) {
+        fprintf(stderr, "could not write %s\n", jsonPath);
+        return 1;
+    }
+
+    return 0;
+}
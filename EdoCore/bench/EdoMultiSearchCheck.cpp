@@ -0,0 +1,253 @@
+// =============================================================================
+// EdoMultiSearchCheck.cpp
+// Checks EdoMultiSearcher against a naive search: overlapping matches, case folding and stream chunk boundaries
+// =============================================================================
+
+#include "Edo.h"
+#include "Types/EdoMultiSearch.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#define EDO_MULTI_ROUNDS 300 // Random pattern sets, each searched in several texts
+#define EDO_MULTI_TEXTS 8 // Texts searched with each pattern set
+
+using namespace Edo::Types;
+
+static size_t s_failures = 0;
+static std::mt19937 s_random(25);
+
+// Letters whose two cases the searcher folds, as (upper, lower) pairs: ASCII, Latin-1, both parities of Latin
+// Extended-A, Greek, Cyrillic and fullwidth Latin
+static const utf32 s_casePairs[][2] = {{'A', 'a'}, {'B', 'b'}, {0xC9, 0xE9}, {0x100, 0x101}, {0x139, 0x13A},
+                                       {0x391, 0x3B1}, {0x410, 0x430}, {0xFF21, 0xFF41}};
+
+// Code points without case, of every utf8 length
+static const utf32 s_neutral[] = {'-', 0x4E2D, 0x1F600};
+
+static void Check(bool ok, const char *what, size_t round) {
+    if (!ok && s_failures++ < 20)
+        fprintf(stderr, "failed in round %zu: %s\n", round, what);
+}
+
+static size_t Below(size_t bound) {
+    return s_random() % bound;
+}
+
+// Lower case form of the letters above, the code point itself otherwise
+static utf32 Fold(utf32 cp) {
+    for (const utf32 *pair : s_casePairs)
+        if (cp == pair[0])
+            return pair[1];
+
+    return cp;
+}
+
+// Random code points, mostly cased letters so that patterns overlap and nest
+static std::vector<utf32> RandomCodePoints(size_t len) {
+    std::vector<utf32> text(len);
+
+    for (utf32 &cp : text) {
+        const size_t pick = Below(20);
+        cp = pick < 3 ? s_neutral[pick] : s_casePairs[pick % 8][pick % 2];
+    }
+
+    return text;
+}
+
+typedef std::tuple<size_t, size_t, size_t> Match; // (end, pattern, start), in the order matches are compared
+
+// Every occurrence of every pattern, in code points, or in utf8 code units when 'offsets' maps code point indices
+// to them
+static std::vector<Match> NaiveMatches(const std::vector<std::vector<utf32>> &patterns, const std::vector<utf32> &text,
+                                       bool fold, const std::vector<size_t> *offsets) {
+    std::vector<Match> matches;
+
+    for (size_t p = 0; p < patterns.size(); ++p) {
+        const std::vector<utf32> &pattern = patterns[p];
+
+        if (pattern.empty() || pattern.size() > text.size())
+            continue;
+
+        for (size_t at = 0; at + pattern.size() <= text.size(); ++at) {
+            size_t n = 0;
+
+            while (n < pattern.size() &&
+                   (fold ? Fold(text[at + n]) == Fold(pattern[n]) : text[at + n] == pattern[n]))
+                ++n;
+
+            if (n == pattern.size()) {
+                const size_t end = at + pattern.size();
+                matches.emplace_back(offsets ? (*offsets)[end] : end, p, offsets ? (*offsets)[at] : at);
+            }
+        }
+    }
+
+    std::sort(matches.begin(), matches.end());
+    return matches;
+}
+
+// Collects reported matches, checking that they come in the order of their end positions
+struct Collector {
+    std::vector<Match> matches;
+    bool ordered = true;
+
+    bool operator()(const EdoMultiMatch &match) {
+        if (!matches.empty() && std::get<0>(matches.back()) > match.end)
+            ordered = false;
+
+        matches.emplace_back(match.end, match.pattern, match.start);
+        return true;
+    }
+
+    std::vector<Match> Sorted() const {
+        std::vector<Match> sorted = matches;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted;
+    }
+};
+
+static void CheckRound(size_t round, EdoCaseMode mode) {
+    const bool fold = mode == CaseInsensitive;
+    std::vector<std::vector<utf32>> patterns;
+
+    // A few dozen short patterns, some of them empty, duplicated, or suffixes of others
+    for (size_t count = 1 + Below(40); count > 0; --count) {
+        if (!patterns.empty() && Below(6) == 0) {
+            const std::vector<utf32> &other = patterns[Below(patterns.size())];
+            patterns.emplace_back(other.begin() + (other.empty() ? 0 : Below(other.size())), other.end());
+        } else {
+            patterns.push_back(RandomCodePoints(Below(6)));
+        }
+    }
+
+    std::vector<EdoStringView> views;
+
+    for (const std::vector<utf32> &pattern : patterns)
+        views.emplace_back(pattern.data(), pattern.size());
+
+    const EdoMultiSearcher searcher(views.data(), views.size(), mode);
+    Check(searcher.PatternCount() == patterns.size() && searcher.CaseMode() == mode, "searcher properties", round);
+
+    for (size_t t = 0; t < EDO_MULTI_TEXTS; ++t) {
+        const std::vector<utf32> text = RandomCodePoints(Below(300));
+        const EdoStringView textView(text.data(), text.size());
+
+        // utf32 text, whole
+        const std::vector<Match> expected = NaiveMatches(patterns, text, fold, nullptr);
+        Collector whole;
+        searcher.FindAll(textView, std::ref(whole));
+        Check(whole.ordered, "utf32 matches are not in the order of their ends", round);
+        Check(whole.Sorted() == expected, "utf32 matches differ from the naive search", round);
+
+        EdoMultiMatch first;
+        const bool found = searcher.FindFirst(textView, first);
+        Check(found == !expected.empty() && searcher.Contains(textView) == found, "FindFirst() or Contains()", round);
+
+        if (found && !expected.empty()) {
+            // The match ending first, the longest of those ending there
+            const size_t end = std::get<0>(expected.front());
+            size_t start = end;
+
+            for (const Match &match : expected)
+                if (std::get<0>(match) == end)
+                    start = std::min(start, std::get<2>(match));
+
+            Check(first.end == end && first.start == start, "FindFirst() is not the first and longest match", round);
+        }
+
+        // utf8 text, with positions in code units
+        std::vector<utf8> encoded(text.size() * 4 + 1);
+        std::vector<size_t> offsets(1, 0);
+
+        for (utf32 cp : text)
+            offsets.push_back(offsets.back() + EncodeUtf8(&cp, 1, encoded.data() + offsets.back(), 4));
+
+        encoded.resize(offsets.back());
+        const std::vector<Match> expectedUtf8 = NaiveMatches(patterns, text, fold, &offsets);
+        Collector wholeUtf8;
+        searcher.FindAll(encoded.data(), encoded.size(), std::ref(wholeUtf8));
+        Check(wholeUtf8.Sorted() == expectedUtf8, "utf8 matches differ from the naive search", round);
+
+        // Streams cut at random places, including inside utf8 sequences, find the same matches
+        EdoMultiSearcher::Stream stream(searcher);
+        EdoMultiSearcher::Stream stream8(searcher);
+        Collector streamed;
+        Collector streamed8;
+
+        for (size_t at = 0; at < text.size();) {
+            const size_t len = std::min(text.size() - at, 1 + Below(12));
+            stream.Feed(EdoStringView(text.data() + at, len), std::ref(streamed));
+            at += len;
+        }
+
+        for (size_t at = 0; at < encoded.size();) {
+            const size_t len = std::min(encoded.size() - at, 1 + Below(12));
+            stream8.Feed(encoded.data() + at, len, std::ref(streamed8));
+            at += len;
+        }
+
+        stream8.Finish(std::ref(streamed8));
+        Check(streamed.matches == whole.matches && stream.Position() == text.size(),
+              "a utf32 stream differs from the whole text", round);
+        Check(streamed8.matches == wholeUtf8.matches && stream8.Position() == encoded.size(),
+              "a utf8 stream differs from the whole text", round);
+
+        // Malformed code units anywhere, searched whole and streamed one code unit at a time
+        std::vector<utf8> damaged = encoded;
+
+        for (size_t n = Below(4); n > 0 && !damaged.empty(); --n)
+            damaged[Below(damaged.size())] = (utf8) (0x80 + Below(0x78));
+
+        Collector damagedWhole;
+        Collector damagedStream;
+        EdoMultiSearcher::Stream bytes(searcher);
+        searcher.FindAll(damaged.data(), damaged.size(), std::ref(damagedWhole));
+
+        for (utf8 unit : damaged)
+            bytes.Feed(&unit, 1, std::ref(damagedStream));
+
+        bytes.Finish(std::ref(damagedStream));
+        Check(damagedStream.matches == damagedWhole.matches, "a stream of malformed utf8 differs from the whole text",
+              round);
+    }
+}
+
+// Stopping from the callback ends the search, and empty patterns never match
+static void CheckEdges() {
+    const EdoString aa("aa");
+    const EdoString empty;
+    const EdoMultiSearcher searcher({EdoStringView(aa), EdoStringView(empty)});
+    const EdoString text("aaaaaa");
+    size_t calls = 0;
+
+    const bool completed = searcher.FindAll(text, [&](const EdoMultiMatch &) { return ++calls < 2; });
+    Check(!completed && calls == 2, "returning false does not stop the search", 0);
+
+    calls = 0;
+    searcher.FindAll(text, [&](const EdoMultiMatch &match) {
+        calls += match.pattern == 1 ? 100 : 1;
+        return true;
+    });
+    Check(calls == 5, "overlapping matches of \"aa\" in \"aaaaaa\", or the empty pattern matches", 0);
+}
+
+int main() {
+    for (size_t round = 0; round < EDO_MULTI_ROUNDS; ++round)
+        CheckRound(round, (round & 1) ? CaseInsensitive : CaseSensitive);
+
+    CheckEdges();
+
+    if (s_failures != 0) {
+        fprintf(stderr, "EdoMultiSearchCheck: %zu checks failed\n", s_failures);
+        return 1;
+    }
+
+    printf("EdoMultiSearchCheck: %d pattern sets x %d texts match the naive search, whole and streamed\n",
+           EDO_MULTI_ROUNDS, EDO_MULTI_TEXTS);
+    return 0;
+}
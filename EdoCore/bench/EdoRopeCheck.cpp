@@ -0,0 +1,215 @@
+// =============================================================================
+// EdoRopeCheck.cpp
+// Checks random EdoRope edits, snapshots, and searches across leaf boundaries against an EdoString model
+// =============================================================================
+
+#include "Edo.h"
+#include "Types/EdoRope.h"
+#include "Types/EdoStringSearch.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#define EDO_ROPE_EDITS 4000 // Random edits applied to the rope and the model
+#define EDO_ROPE_SNAPSHOT_EVERY 250 // Edits between two snapshots
+
+using namespace Edo::Types;
+
+static size_t s_failures = 0;
+static std::mt19937 s_random(14);
+
+static void Check(bool ok, const char *what, size_t step) {
+    if (!ok && s_failures++ < 20)
+        fprintf(stderr, "failed at step %zu: %s\n", step, what);
+}
+
+static size_t Below(size_t bound) {
+    return bound == 0 ? 0 : s_random() % bound;
+}
+
+// Random text over a small alphabet, so that searches find plenty of partial matches. Lengths go past a leaf
+static EdoString RandomText(size_t maxLen) {
+    static const utf32 s_alphabet[] = {'a', 'b', 'a', 'c', 0x4E2D, 0x1F600};
+    EdoString text;
+
+    for (size_t len = Below(maxLen + 1); len > 0; --len)
+        text.Append(1, s_alphabet[Below(sizeof(s_alphabet) / sizeof(s_alphabet[0]))]);
+
+    return text;
+}
+
+// Full comparison of a rope with its model: value, length, indexing, iteration and chunks
+static void CheckSame(const EdoRope &rope, const EdoString &model, size_t step) {
+    Check(rope.Length() == model.Length() && rope.Empty() == model.Empty(), "length differs from the model", step);
+    Check(rope.ToString() == model, "value differs from the model", step);
+
+    for (size_t n = 0; n < 8 && !model.Empty(); ++n) {
+        const size_t idx = Below(model.Length());
+        Check(rope[idx] == model[idx] && rope.At(idx) == model[idx], "indexing differs from the model", step);
+    }
+
+    size_t idx = 0;
+
+    for (EdoRope::const_iterator iter = rope.Begin(); iter != rope.End() && idx < model.Length(); ++iter, ++idx) {
+        if (*iter != model[idx]) {
+            Check(false, "iteration differs from the model", step);
+            break;
+        }
+    }
+
+    size_t chunked = 0;
+    rope.ForEachChunk([&](EdoStringView chunk) {
+        Check(chunk.Length() <= STR_ROPE_LEAF_SIZE && chunk == model.View(chunked, chunk.Length()),
+              "a chunk differs from the model", step);
+        chunked += chunk.Length();
+    });
+    Check(chunked == model.Length(), "the chunks do not cover the rope", step);
+}
+
+// Random inserts, erases, replaces, appends and rope splices, with snapshots taken along the way that must keep the
+// value they had when taken
+static void CheckEdits() {
+    EdoRope rope;
+    EdoString model;
+    std::vector<std::pair<EdoRope, EdoString>> snapshots;
+
+    for (size_t step = 0; step < EDO_ROPE_EDITS; ++step) {
+        const size_t idx = Below(model.Length() + 1);
+        const EdoString text = RandomText(step % 16 == 0 ? 1500 : 40);
+
+        // Keep the rope a few thousand code points long, so it has many leaves without growing unbounded
+        switch (model.Length() > 8000 ? 2 : Below(6)) {
+            case 0:
+                rope.Insert(idx, text);
+                model.Insert(idx, text);
+                break;
+            case 1:
+                rope.Append(text);
+                model.Append(text);
+                break;
+            case 2:
+                if (idx < model.Length()) {
+                    // The rope clamps the count to the end, the model is only given counts that fit
+                    const size_t len = Below(600);
+                    rope.Erase(idx, len);
+                    model.Erase(idx, std::min(len, model.Length() - idx));
+                }
+                break;
+            case 3:
+                if (idx < model.Length()) {
+                    const size_t len = Below(300);
+                    rope.Replace(idx, len, text);
+                    model.Replace(idx, std::min(len, model.Length() - idx), text);
+                }
+                break;
+            case 4: {
+                // Splice a part of the rope back into itself
+                const size_t from = Below(model.Length() + 1);
+                const size_t len = Below(1200);
+                const EdoRope part = rope.SubRope(from, len);
+                Check(part.ToString() == model.Substr(from, len), "SubRope() differs from the model", step);
+
+                rope.Insert(idx, part);
+                model.Insert(idx, model.Substr(from, len));
+                break;
+            }
+            default: {
+                rope += text;
+                model += text;
+                break;
+            }
+        }
+
+        CheckSame(rope, model, step);
+
+        if (step % EDO_ROPE_SNAPSHOT_EVERY == 0)
+            snapshots.emplace_back(rope.Snapshot(), model);
+    }
+
+    for (size_t n = 0; n < snapshots.size(); ++n)
+        CheckSame(snapshots[n].first, snapshots[n].second, n * EDO_ROPE_SNAPSHOT_EVERY);
+
+    // Out of range edits throw, as they do for EdoString
+    bool threw = false;
+
+    try {
+        rope.Erase(rope.Length());
+    } catch (std::out_of_range &) {
+        threw = true;
+    }
+
+    Check(threw, "Erase() past the end does not throw", EDO_ROPE_EDITS);
+}
+
+// Needles cut out around every leaf boundary, searched from positions on both sides of it
+static void CheckSearches() {
+    EdoRope rope;
+
+    // Small appends leave leaves of uneven sizes
+    for (size_t n = 0; n < 60; ++n)
+        rope.Append(RandomText(n % 7 == 0 ? 1100 : 90));
+
+    const EdoString model = rope.ToString();
+    std::vector<size_t> boundaries;
+    size_t start = 0;
+
+    rope.ForEachChunk([&](EdoStringView chunk) {
+        start += chunk.Length();
+        boundaries.push_back(start);
+    });
+
+    Check(boundaries.size() > 4, "the search rope has too few leaves", 0);
+
+    for (size_t boundary : boundaries) {
+        for (size_t before = 0; before <= 12; before += 3) {
+            for (size_t len = 1; len <= 20; len += 6) {
+                if (before > boundary || boundary - before + len > model.Length())
+                    continue;
+
+                const EdoString needle = model.Substr(boundary - before, len);
+                const EdoStringSearcher searcher(needle.ptr(), needle.Length());
+                const size_t from[] = {0, boundary - before, boundary > 40 ? boundary - 40 : 0, boundary + 1};
+
+                for (size_t idx : from) {
+                    if (idx > model.Length())
+                        continue;
+
+                    Check(rope.Find(needle, idx) == model.Find(needle, idx), "Find() differs from EdoString", idx);
+                    Check(rope.RFind(needle, idx) == model.RFind(needle, idx), "RFind() differs from EdoString", idx);
+                    Check(rope.Find(searcher, idx) == model.Find(needle, idx),
+                          "Find() with a searcher differs from EdoString", idx);
+                    Check(rope.RFind(searcher, idx) == model.RFind(needle, idx),
+                          "RFind() with a searcher differs from EdoString", idx);
+                    Check(rope.Find(needle[0], idx) == model.Find(needle[0], idx),
+                          "Find() of a code point differs from EdoString", idx);
+                    Check(rope.RFind(needle[len - 1], idx) == model.RFind(needle[len - 1], idx),
+                          "RFind() of a code point differs from EdoString", idx);
+                }
+
+                Check(rope.RFind(needle) == model.RFind(needle), "RFind() from the end differs from EdoString",
+                      boundary);
+            }
+        }
+    }
+
+    const EdoString missing(1, 'z');
+    Check(rope.Find(missing) == EdoRope::npos && rope.RFind(missing) == EdoRope::npos, "a missing needle is found", 0);
+    Check(rope.Find(EdoString(), 7) == 7, "an empty needle is not found where the search starts", 0);
+}
+
+int main() {
+    CheckEdits();
+    CheckSearches();
+
+    if (s_failures != 0) {
+        fprintf(stderr, "EdoRopeCheck: %zu checks failed\n", s_failures);
+        return 1;
+    }
+
+    printf("EdoRopeCheck: %d edits and the searches across leaf boundaries match EdoString\n", EDO_ROPE_EDITS);
+    return 0;
+}
@@ -0,0 +1,153 @@
+// =============================================================================
+// EdoSharedStringCheck.cpp
+// Checks the reference count of EdoSharedString, and the utf8 encoding and hash its copies share across threads
+// =============================================================================
+
+#include "Edo.h"
+#include "Types/EdoSharedString.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define EDO_SHARED_THREADS 8 // Threads copying and encoding one shared string in each round
+#define EDO_SHARED_ROUNDS 200 // Fresh strings raced on
+#define EDO_SHARED_COPIES 100 // Copies each thread makes per round
+
+using namespace Edo::Types;
+
+static std::atomic<size_t> s_failures(0);
+
+static void Check(bool ok, const char *what) {
+    if (!ok && s_failures.fetch_add(1) < 20)
+        fprintf(stderr, "failed: %s\n", what);
+}
+
+// Copies, moves, assignments and swaps keep the count equal to the number of holders
+static void CheckRefCount() {
+    EdoSharedString empty;
+    Check(empty.UseCount() == 0 && empty.Empty() && empty.c_str()[0] == 0 && empty.Utf8Length() == 0,
+          "the empty string");
+
+    EdoSharedString first(EdoString("a value held by several objects"));
+    Check(first.UseCount() == 1, "a new string is not held once");
+
+    {
+        EdoSharedString second(first);
+        EdoSharedString third;
+        third = second;
+        Check(first.UseCount() == 3 && second.SharesWith(first) && third.SharesWith(first), "copies do not share");
+
+        EdoSharedString moved(std::move(third));
+        Check(first.UseCount() == 3 && third.UseCount() == 0 && third.Empty(), "a move changes the count");
+
+        moved = moved;
+        Check(first.UseCount() == 3, "self assignment changes the count");
+
+        EdoSharedString other(EdoString("another value"));
+        other.Swap(moved);
+        Check(first.UseCount() == 3 && moved.UseCount() == 1 && other.SharesWith(first), "a swap changes the count");
+
+        other = EdoSharedString();
+        Check(first.UseCount() == 2, "assigning over a holder does not drop its reference");
+    }
+
+    Check(first.UseCount() == 1, "destroyed copies keep their reference");
+
+    // Equal values built separately are equal without sharing
+    EdoSharedString separate(EdoString("a value held by several objects"));
+    Check(separate == first && !separate.SharesWith(first) && separate.Hash() == first.Hash(), "separate equal values");
+    Check(first.Hash() == EdoString("a value held by several objects").Hash(), "Hash() differs from EdoString");
+}
+
+// Well-formed utf8 is kept as the shared encoding, malformed utf8 is decoded like the EdoString constructor does
+static void CheckUtf8() {
+    const char *text = "caf\xC3\xA9 \xE4\xB8\xAD \xF0\x9F\x98\x80";
+    EdoSharedString shared((const utf8 *) text);
+    EdoSharedString copy(shared);
+
+    Check(strcmp(shared.c_str(), text) == 0 && shared.Utf8Length() == strlen(text), "encoding of utf8 data");
+    Check(copy.c_str() == shared.c_str(), "copies do not share the encoding");
+    Check(shared.ToString() == EdoString((const utf8 *) text), "code points of utf8 data");
+
+    const utf8 malformed[] = {'a', 0xE4, 0xB8, 'b'};
+    EdoSharedString bad(malformed, sizeof(malformed));
+    Check(bad.ToString() == EdoString(malformed, sizeof(malformed)) && bad.Length() == 3,
+          "malformed utf8 is not decoded like EdoString");
+    Check(strcmp(bad.c_str(), "a\xEF\xBF\xBD" "b") == 0, "the encoding of malformed utf8 is not rebuilt");
+
+    // The encoding stays valid for as long as one copy lives
+    const char *encoded;
+    EdoSharedString survivor;
+
+    {
+        EdoSharedString owner(EdoString((const utf8 *) text));
+        survivor = owner;
+        encoded = owner.c_str();
+    }
+
+    Check(strcmp(encoded, text) == 0 && survivor.c_str() == encoded, "the encoding dies with the first holder");
+}
+
+// Threads copy a fresh string and race to build its encoding and hash: all must see the same pointer, the right
+// bytes, and the count must come back to one
+static void CheckThreads() {
+    for (size_t round = 0; round < EDO_SHARED_ROUNDS; ++round) {
+        std::string expected = "round " + std::to_string(round) + " \xE2\x82\xAC";
+        expected.append(round % 97, 'x');
+
+        const EdoSharedString shared(EdoString((const utf8 *) expected.c_str()));
+        const size_t hash = EdoString((const utf8 *) expected.c_str()).Hash();
+        std::vector<const char *> pointers(EDO_SHARED_THREADS);
+        std::atomic<size_t> ready(0);
+        std::vector<std::thread> threads;
+
+        for (size_t t = 0; t < EDO_SHARED_THREADS; ++t) {
+            threads.emplace_back([&, t] {
+                ready.fetch_add(1);
+
+                while (ready.load() != EDO_SHARED_THREADS)
+                    std::this_thread::yield();
+
+                std::vector<EdoSharedString> copies;
+
+                for (size_t i = 0; i < EDO_SHARED_COPIES; ++i) {
+                    copies.push_back(shared);
+                    const char *utf8 = copies.back().c_str();
+
+                    if (strcmp(utf8, expected.c_str()) != 0 || copies.back().Hash() != hash)
+                        Check(false, "a thread saw the wrong encoding or hash");
+
+                    pointers[t] = utf8;
+                }
+            });
+        }
+
+        for (std::thread &thread : threads)
+            thread.join();
+
+        for (const char *pointer : pointers)
+            Check(pointer == shared.c_str(), "threads built separate encodings");
+
+        Check(shared.UseCount() == 1, "the count does not come back to one after the threads");
+    }
+}
+
+int main() {
+    CheckRefCount();
+    CheckUtf8();
+    CheckThreads();
+
+    if (s_failures.load() != 0) {
+        fprintf(stderr, "EdoSharedStringCheck: %zu checks failed\n", s_failures.load());
+        return 1;
+    }
+
+    printf("EdoSharedStringCheck: %d rounds of %d threads x %d copies, all sharing one encoding\n", EDO_SHARED_ROUNDS,
+           EDO_SHARED_THREADS, EDO_SHARED_COPIES);
+    return 0;
+}
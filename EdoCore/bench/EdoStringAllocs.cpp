@@ -0,0 +1,240 @@
+// =============================================================================
+// EdoStringAllocs.cpp
+// Checks the exact number of heap allocations of EdoString concatenation chains, moves and Append(EdoString&&)
+// =============================================================================
+
+#include "Edo.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+using namespace Edo::Types;
+
+static size_t s_allocCount = 0;
+static size_t s_failures = 0;
+
+///////////////////////////////////////////////
+// Allocation counting
+///////////////////////////////////////////////
+// Same scheme as EdoCoreBench: every replaceable form is defined, and the counting malloc/free pair sits behind
+// functions GCC does not inline (-Wmismatched-new-delete)
+#if defined(_MSC_VER)
+#define EDO_ALLOCS_NOINLINE __declspec(noinline)
+#else
+#define EDO_ALLOCS_NOINLINE __attribute__((noinline))
+#endif
+
+static EDO_ALLOCS_NOINLINE void *CountedAlloc(size_t size) noexcept {
+    ++s_allocCount;
+    return malloc(size ? size : 1);
+}
+
+static EDO_ALLOCS_NOINLINE void CountedFree(void *p) noexcept {
+    free(p);
+}
+
+void *operator new(size_t size) {
+    if (void *p = CountedAlloc(size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return CountedAlloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return CountedAlloc(size);
+}
+
+void operator delete(void *p) noexcept {
+    CountedFree(p);
+}
+
+void operator delete[](void *p) noexcept {
+    CountedFree(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    CountedFree(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    CountedFree(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+    CountedFree(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+    CountedFree(p);
+}
+
+///////////////////////////////////////////////
+// Checks
+///////////////////////////////////////////////
+//! Heap allocator that counts the blocks taken from it, to tell which allocator a buffer came from
+class CountingAllocator : public EdoStringHeapAllocator {
+public:
+    void *Allocate(size_t bytes) override {
+        ++d_blocks;
+        return EdoStringHeapAllocator::Allocate(bytes);
+    }
+
+    size_t d_blocks = 0; //!< Blocks handed out so far
+};
+
+static void Check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "failed: %s\n", what);
+        ++s_failures;
+    }
+}
+
+// Allocations made by 'body'
+template<typename Body>
+static size_t CountAllocs(Body body) {
+    const size_t before = s_allocCount;
+    body();
+    return s_allocCount - before;
+}
+
+// An N term chain of lvalues builds the first sum into a new buffer, then appends to that temporary, whose reserve
+// doubles whenever it runs out: 10, 20, 40, ... code points of "term " take one allocation per doubling
+static void CheckChains() {
+    const EdoString part("term ");
+    static const size_t s_terms[][2] = {{2, 1}, {4, 2}, {16, 4}, {64, 6}, {256, 8}};
+
+    for (const size_t *terms : s_terms) {
+        EdoString result;
+        const size_t allocs = CountAllocs([&] {
+            result = part + part;
+
+            for (size_t i = 2; i < terms[0]; ++i)
+                result = std::move(result) + part;
+        });
+
+        char what[96];
+        snprintf(what, sizeof(what), "chain of %u terms takes %u allocations, not %u", (unsigned) terms[0],
+                 (unsigned) terms[1], (unsigned) allocs);
+        Check(allocs == terms[1] && result.Length() == 5 * terms[0], what);
+    }
+
+    // The shape of the chain in EdoTextLog::Write: the temporary of the first sum carries every later term. It leaves
+    // the quick-buffer when the message is appended, and doubles once
+    const EdoString type("Info");
+    const EdoString message("Renderer initialised in 12 ms");
+    const EdoString file("EdoRenderer.cpp");
+    EdoString line;
+
+    Check(CountAllocs([&] { line = "[" + type + "] " + message + " >> " + file + ":" + "118"; }) == 2,
+          "log line chain takes 2 allocations");
+    Check(line == "[Info] Renderer initialised in 12 ms >> EdoRenderer.cpp:118", "log line chain value");
+}
+
+// Moves never allocate, whether the string is on the heap or in the quick-buffer
+static void CheckMoves() {
+    EdoString heap("a string long enough for the heap");
+    EdoString quick("short");
+
+    Check(CountAllocs([&] {
+        EdoString first(std::move(heap));
+        EdoString second(std::move(first));
+        EdoString third;
+        third = std::move(second);
+        heap = std::move(third);
+
+        EdoString small(std::move(quick));
+        quick = std::move(small);
+    }) == 0, "move construction and assignment allocate");
+
+    Check(heap == "a string long enough for the heap" && quick == "short", "moved values");
+}
+
+static void CheckAppendMove() {
+    const EdoString tail("a temporary on the heap, with room to spare");
+
+    // Empty target: the buffer of the temporary is taken over
+    {
+        EdoString target;
+        EdoString temp(tail);
+        Check(CountAllocs([&] { target.Append(std::move(temp)); }) == 0, "append to an empty string allocates");
+        Check(target == tail, "append to an empty string value");
+    }
+
+    // The temporary has the larger buffer and room for the target in front of its data
+    {
+        EdoString target("prefix ");
+        EdoString temp(tail);
+        temp.Reserve(200);
+        Check(CountAllocs([&] { target += std::move(temp); }) == 0, "append into the larger temporary allocates");
+        Check(target == "prefix " + tail, "append into the larger temporary value");
+    }
+
+    // The target keeps its hash caching setting, and the cached hash is the one of the new value
+    {
+        EdoString target("hash cached prefix, on the heap already");
+        target.SetHashCaching(true);
+        const size_t before = target.Hash();
+
+        EdoString temp(tail);
+        temp.Reserve(200);
+        target.Append(std::move(temp));
+
+        Check(target.IsHashCaching(), "append of a temporary turns hash caching off");
+        Check(target.Hash() != before && target.Hash() == EdoString(target).Hash(), "stale cached hash after append");
+    }
+
+    {
+        EdoString target;
+        target.SetHashCaching(true);
+        EdoString temp(tail);
+        target.Append(std::move(temp));
+        Check(target.IsHashCaching(), "append of a temporary to an empty string turns hash caching off");
+    }
+
+    // A temporary from another allocator is copied into a buffer of the target's allocator
+    {
+        CountingAllocator scoped;
+        CountingAllocator other;
+        EdoString temp;
+
+        {
+            EdoStringAllocatorScope scope(other);
+            temp = tail;
+        }
+
+        EdoStringAllocatorScope scope(scoped);
+        EdoString target;
+        target.Append(std::move(temp));
+
+        Check(&target.GetAllocator() == &scoped && scoped.d_blocks == 1 && other.d_blocks == 1,
+              "append of a temporary takes a buffer from another allocator");
+        Check(target == tail, "append from another allocator value");
+    }
+}
+
+int main() {
+    // The default allocator is created on first use, which would count against the first check
+    EdoStringAllocator::GetDefault();
+
+    CheckChains();
+    CheckMoves();
+    CheckAppendMove();
+
+    if (s_failures != 0) {
+        fprintf(stderr, "EdoStringAllocs: %zu checks failed\n", s_failures);
+        return 1;
+    }
+
+    printf("EdoStringAllocs: chains, moves and appends of temporaries allocate as expected\n");
+    return 0;
+}
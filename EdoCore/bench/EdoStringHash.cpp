@@ -0,0 +1,141 @@
+// =============================================================================
+// EdoStringHash.cpp
+// Checks that the cached Hash() of an EdoString follows every kind of modification
+// =============================================================================
+
+#include "Edo.h"
+#include "Types/EdoHash.h"
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace Edo::Types;
+
+static size_t s_failures = 0;
+
+//! A modification, and its name for the report
+struct Mutation {
+    const char *name;
+    std::function<void(EdoString &)> apply;
+    bool keepsSetting; //!< False when the hash caching setting comes from the other string (see SetHashCaching())
+};
+
+static size_t Reference(const EdoString &str) {
+    return (size_t) HashBytes(str.ptr(), str.Length() * sizeof(utf32));
+}
+
+static void Check(bool ok, const char *what, const char *start) {
+    if (!ok && s_failures++ < 20)
+        fprintf(stderr, "%s, starting from \"%s\"\n", what, start);
+}
+
+// Every way of changing the value, through the EdoString interface and through non-const access to the data
+static std::vector<Mutation> Mutations() {
+    const EdoString other("a different value, long enough for the heap");
+
+    return {
+            {"Append", [](EdoString &s) { s.Append(std::string("x")); }, true},
+            {"Append(EdoString&&)", [](EdoString &s) { s.Append(EdoString("appended from a temporary")); }, true},
+            {"operator+=", [](EdoString &s) { s += (utf32) 0x4E2D; }, true},
+            {"PushBack", [](EdoString &s) { s.PushBack('y'); }, true},
+            {"Insert", [](EdoString &s) { s.Insert(0, "front "); }, true},
+            {"Erase", [](EdoString &s) { s.Erase(0, 1); }, true},
+            {"Replace", [](EdoString &s) { s.Replace(0, 2, "zz"); }, true},
+            {"ReplaceAll", [](EdoString &s) { s.ReplaceAll('e', 'E'); }, true},
+            {"Resize up", [](EdoString &s) { s.Resize(s.Length() + 3, '!'); }, true},
+            {"Resize down", [](EdoString &s) { s.Resize(s.Length() / 2); }, true},
+            {"Assign", [other](EdoString &s) { s.Assign(other); }, true},
+            {"copy assignment", [other](EdoString &s) { s = other; }, false},
+            {"move assignment", [other](EdoString &s) { s = EdoString(other); }, false},
+            {"Swap", [other](EdoString &s) {
+                EdoString temp(other);
+                temp.Append(std::string(" swapped"));
+                s.Swap(temp);
+            }, false},
+            {"Clear", [](EdoString &s) { s.Clear(); }, true},
+            {"operator[]", [](EdoString &s) { s[0] = 'Q'; }, true},
+            {"At", [](EdoString &s) { s.At(s.Length() - 1) = 'R'; }, true},
+            {"ptr", [](EdoString &s) { s.ptr()[0] ^= 1; }, true},
+            {"Begin", [](EdoString &s) { *s.Begin() = 'S'; }, true},
+            {"Reserve", [](EdoString &s) { s.Reserve(s.Length() * 4 + 64); s[0] = 'T'; }, true},
+            {"Trim", [](EdoString &s) { s.Reserve(); s[0] = 'U'; }, true},
+    };
+}
+
+// Apply each mutation to a string that has its hash cached, then compare Hash() with a fresh computation
+static void CheckMutations(const char *start) {
+    for (const Mutation &mutation : Mutations()) {
+        EdoString str(start);
+        str.SetHashCaching(true);
+
+        str.Hash(); // Stores the hash in the heap buffer
+        str.c_str(); // And a utf8 encoding, which must not get in the way
+        mutation.apply(str);
+
+        char what[128];
+        snprintf(what, sizeof(what), "Hash() after %s is stale", mutation.name);
+        Check(str.Hash() == Reference(str), what, start);
+
+        snprintf(what, sizeof(what), "hash caching off after %s", mutation.name);
+        Check(str.IsHashCaching() || !mutation.keepsSetting, what, start);
+
+        // Hashing again returns the cached value, which must still be right
+        snprintf(what, sizeof(what), "second Hash() after %s differs", mutation.name);
+        Check(str.Hash() == Reference(str), what, start);
+    }
+}
+
+// Equal strings hash alike, whatever their caching setting, allocator or history
+static void CheckEquality() {
+    EdoStringHeapAllocator allocator;
+    EdoString plain("the same value in different strings");
+    EdoString cached(plain);
+    cached.SetHashCaching(true);
+
+    EdoString scoped;
+    {
+        EdoStringAllocatorScope scope(allocator);
+        scoped = EdoString("the same value in different ");
+        scoped += "strings";
+    }
+
+    EdoString edited("THE same value in different strings, with a tail");
+    edited.Replace(0, 3, "the");
+    edited.Erase(edited.Find(','), EdoString::npos);
+
+    const char *start = "equal";
+    Check(cached.Hash() == plain.Hash() && cached.Hash() == Reference(plain), "caching changes the hash", start);
+    Check(scoped.Hash() == plain.Hash(), "the allocator changes the hash", start);
+    Check(edited == plain && edited.Hash() == plain.Hash(), "an edited string hashes differently", start);
+    Check(std::hash<EdoString>()(cached) == plain.Hash(), "std::hash differs from Hash()", start);
+
+    // Turning caching off and on again must not bring back a value cached before an edit made meanwhile
+    cached.Hash();
+    cached.SetHashCaching(false);
+    cached[0] = 'T';
+    cached.SetHashCaching(true);
+    Check(cached.Hash() == Reference(cached), "a value cached under an earlier setting comes back", start);
+
+    // Copies carry the setting, not the cached value of another buffer
+    EdoString copy(cached);
+    copy[1] = 'H';
+    Check(copy.IsHashCaching() && copy.Hash() == Reference(copy) && cached.Hash() == Reference(cached),
+          "copies share a cached hash", start);
+}
+
+int main() {
+    CheckMutations("a string long enough to live on the heap");
+    CheckMutations("quick"); // Never caches, but Hash() must still follow
+    CheckEquality();
+
+    if (s_failures != 0) {
+        fprintf(stderr, "EdoStringHash: %zu checks failed\n", s_failures);
+        return 1;
+    }
+
+    printf("EdoStringHash: %zu modifications keep Hash() up to date\n", Mutations().size());
+    return 0;
+}
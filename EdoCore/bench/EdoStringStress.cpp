@@ -0,0 +1,107 @@
+// =============================================================================
+// EdoStringStress.cpp
+// Races threads on the const member functions of one EdoString, to be run under EDO_SANITIZER=thread
+// =============================================================================
+
+#include "Edo.h"
+#include "Types/EdoUtf.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define EDO_STRESS_THREADS 8 // Readers racing on the string in each round
+#define EDO_STRESS_READS 200 // Calls each reader makes per round
+
+using namespace Edo::Types;
+
+// Lengths on both sides of the quick-buffer and of the heap reserve, so rounds publish a first encoding, reuse the
+// stale buffer in place, and replace it with a larger one
+static const size_t s_lengths[] = {0, 1, 7, 8, 31, 64, 3, 200, 1000, 5, 4096, 9};
+
+// Code points of every utf8 length, so the encoding sizes differ from the string sizes
+static const utf32 s_codePoints[] = {'a', 'Z', 0xE9, 0x3B1, 0x4E2D, 0x1F600};
+
+// Build the text of a round, and its expected utf8 encoding
+static void MakeRound(size_t round, EdoString &text, std::string &expected) {
+    const size_t len = s_lengths[round % (sizeof(s_lengths) / sizeof(s_lengths[0]))];
+    std::vector<utf32> code_points(len);
+
+    for (size_t i = 0; i < len; ++i)
+        code_points[i] = s_codePoints[(round + i * 7) % (sizeof(s_codePoints) / sizeof(s_codePoints[0]))];
+
+    // Edit the string in place rather than assigning a new one, so its utf8 encoding goes stale and is rebuilt
+    text.Erase(0, text.Length());
+
+    for (utf32 cp : code_points)
+        text.Append(1, cp);
+
+    expected.resize(len * 4);
+    expected.resize(EncodeUtf8(code_points.data(), len, (utf8 *) &expected[0], expected.size()));
+}
+
+static int Usage(const char *program) {
+    fprintf(stderr, "usage: %s [--rounds <count>]\n", program);
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    size_t rounds = 500;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc)
+            rounds = strtoul(argv[++i], nullptr, 10);
+        else
+            return Usage(argv[0]);
+    }
+
+    EdoString text;
+    std::string expected;
+    std::atomic<size_t> failures(0);
+
+    for (size_t round = 0; round < rounds; ++round) {
+        // Hash caching puts a second lazily published value next to the encoding on every other round
+        text.SetHashCaching((round & 1) != 0);
+        MakeRound(round, text, expected);
+
+        const EdoString &shared = text;
+        const size_t hash = EdoString(text).Hash();
+        std::atomic<size_t> ready(0);
+        std::vector<std::thread> readers;
+
+        for (size_t t = 0; t < EDO_STRESS_THREADS; ++t) {
+            readers.emplace_back([&] {
+                // Start together, so the first c_str() calls of the round race to build the encoding
+                ready.fetch_add(1);
+
+                while (ready.load() != EDO_STRESS_THREADS)
+                    std::this_thread::yield();
+
+                for (size_t i = 0; i < EDO_STRESS_READS; ++i) {
+                    const char *utf8 = shared.c_str();
+
+                    if (strlen(utf8) != expected.size() || memcmp(utf8, expected.data(), expected.size()) != 0 ||
+                        shared.Hash() != hash)
+                        failures.fetch_add(1);
+                }
+            });
+        }
+
+        for (std::thread &reader : readers)
+            reader.join();
+    }
+
+    if (failures.load() != 0) {
+        fprintf(stderr, "EdoStringStress: %zu reads out of %zu saw the wrong encoding or hash\n", failures.load(),
+                rounds * EDO_STRESS_THREADS * EDO_STRESS_READS);
+        return 1;
+    }
+
+    printf("EdoStringStress: %zu rounds of %d threads x %d reads, all consistent\n", rounds, EDO_STRESS_THREADS,
+           EDO_STRESS_READS);
+    return 0;
+}
@@ -0,0 +1,669 @@
+// =============================================================================
+// EdoStringSuite.cpp
+// EdoString against std::string and std::u32string, over ASCII, Latin-1, CJK and emoji text
+// =============================================================================
+
+#include "EdoBench.h"
+#include "Types/EdoFormat.h"
+#include "Types/EdoString.h"
+#include "Types/EdoUtf.h"
+
+#include <cmath>
+#include <codecvt>
+#include <cstdio>
+#include <cstdlib>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Edo::Types;
+using namespace Edo::Bench;
+
+#define SUITE_TEXT_LENGTH 256 // Code points per test string, a paragraph well past the quick-buffer
+#define SUITE_PIECE_LENGTH 16 // Code points per piece appended or inserted
+#define SUITE_ITERATIONS 20000 // Timed calls per case
+
+namespace {
+    ///////////////////////////////////////////////
+    // Corpora
+    ///////////////////////////////////////////////
+    struct SuiteCorpus {
+        const char *name; //!< Name used in the section titles
+        const char *seed; //!< utf8 text repeated to SUITE_TEXT_LENGTH code points
+    };
+
+    const SuiteCorpus s_corpora[] = {
+            {"ascii",  "The quick brown fox jumps over the lazy dog while the log keeps on scrolling by. "},
+            {"latin1", "\xC3\x87" "a co\xC3\xBBte tr\xC3\xA8s cher \xC3\xA0 l'h\xC3\xB4tel, o\xC3\xB9 l'\xC3\xA9t\xC3\xA9 "
+                       "dure d\xC3\xA9j\xC3\xA0. Gr\xC3\xB6\xC3\x9F" "e: 12 \xC2\xB5m \xC2\xB1 3\xC2\xB0. "},
+            {"cjk",    "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE3\x83\x86\xE3\x82\xAD\xE3\x82\xB9\xE3\x83\x88"
+                       "\xE3\x82\x92\xE5\x87\xA6\xE7\x90\x86\xE3\x81\x99\xE3\x82\x8B\xE3\x80\x82\xE4\xB8\xAD\xE6\x96\x87"
+                       "\xE6\x96\x87\xE6\x9C\xAC\xE5\xA4\x84\xE7\x90\x86\xE6\xB5\x8B\xE8\xAF\x95\xE3\x80\x82\xED\x95\x9C"
+                       "\xEA\xB5\xAD\xEC\x96\xB4 \xED\x85\x8D\xEC\x8A\xA4\xED\x8A\xB8\xEB\x8F\x84 \xED\x8F\xAC\xED\x95\xA8"
+                       "\xED\x95\xA9\xEB\x8B\x88\xEB\x8B\xA4\xE3\x80\x82"},
+            {"emoji",  "Ready \xF0\x9F\x9A\x80 ship it \xF0\x9F\x8E\x89 \xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD nice "
+                       "\xF0\x9F\x98\x80 bugfix \xF0\x9F\x90\x9B done \xE2\x9C\x85 "},
+    };
+
+    //! One corpus in every form the cases start from
+    struct SuiteText {
+        EdoString str; //!< The text as an EdoString
+        std::string encoded; //!< utf8 encoding, what std::string holds
+        std::u32string codePoints; //!< Code points, what std::u32string holds
+        std::string latin1; //!< One char per code point, empty if the text is not all Latin-1
+        std::wstring wide; //!< One wchar_t per code point, as EdoString(std::wstring) reads it
+
+        explicit SuiteText(const char *seed) {
+            const EdoString piece(reinterpret_cast<const utf8 *>(seed));
+
+            while (str.Length() < SUITE_TEXT_LENGTH)
+                str += piece;
+
+            str.Resize(SUITE_TEXT_LENGTH);
+
+            encoded = str.c_str();
+            codePoints.assign(str.ptr(), str.ptr() + str.Length());
+            wide.assign(str.ptr(), str.ptr() + str.Length());
+
+            bool isLatin1 = true;
+
+            for (utf32 cp : codePoints)
+                isLatin1 = isLatin1 && cp <= 0xFF;
+
+            if (isLatin1)
+                latin1.assign(str.ptr(), str.ptr() + str.Length());
+        }
+
+        // Return the offset in 'encoded' of code point 'idx'
+        size_t ByteOffset(size_t idx) const { return Utf8LengthOf(str.ptr(), idx); }
+    };
+
+    template<typename F>
+    void Case(const char *op, const char *impl, F func) {
+        std::string name = std::string(op) + " / " + impl;
+        Run(name.c_str(), SUITE_ITERATIONS, func);
+    }
+
+    ///////////////////////////////////////////////
+    // Cases
+    ///////////////////////////////////////////////
+    void BenchConstruction(const SuiteText &text) {
+        const utf8 *utf8Str = reinterpret_cast<const utf8 *>(text.encoded.c_str());
+        const size_t utf8Len = text.encoded.size();
+
+        Case("construct from utf8", "EdoString", [&] {
+            EdoString str(utf8Str);
+            g_sink += str.Length();
+        });
+
+        Case("construct from utf8", "std::string", [&] {
+            std::string str(text.encoded.c_str());
+            g_sink += str.size();
+        });
+
+        Case("construct from utf8 + length", "EdoString", [&] {
+            EdoString str(utf8Str, utf8Len);
+            g_sink += str.Length();
+        });
+
+        Case("construct from utf8 + length", "std::string", [&] {
+            std::string str(text.encoded.data(), utf8Len);
+            g_sink += str.size();
+        });
+
+        Case("construct from utf32", "EdoString", [&] {
+            EdoString str(EdoStringView(text.str.ptr(), text.str.Length()));
+            g_sink += str.Length();
+        });
+
+        Case("construct from utf32", "std::u32string", [&] {
+            std::u32string str(text.codePoints.c_str());
+            g_sink += str.size();
+        });
+
+        if (!text.latin1.empty()) {
+            Case("construct from char* (Latin-1)", "EdoString", [&] {
+                EdoString str(text.latin1.c_str());
+                g_sink += str.Length();
+            });
+
+            Case("construct from char* (Latin-1)", "std::string", [&] {
+                std::string str(text.latin1.c_str());
+                g_sink += str.size();
+            });
+
+            Case("construct from std::string (Latin-1)", "EdoString", [&] {
+                EdoString str(text.latin1);
+                g_sink += str.Length();
+            });
+        }
+
+        Case("construct from std::wstring", "EdoString", [&] {
+            EdoString str(text.wide);
+            g_sink += str.Length();
+        });
+
+        Case("construct from std::wstring", "std::wstring", [&] {
+            std::wstring str(text.wide);
+            g_sink += str.size();
+        });
+
+        Case("copy", "EdoString", [&] {
+            EdoString str(text.str);
+            g_sink += str.Length();
+        });
+
+        Case("copy", "std::string", [&] {
+            std::string str(text.encoded);
+            g_sink += str.size();
+        });
+
+        Case("copy", "std::u32string", [&] {
+            std::u32string str(text.codePoints);
+            g_sink += str.size();
+        });
+    }
+
+    void BenchEncoding(const SuiteText &text) {
+        EdoString str(text.str);
+        std::string encoded(text.encoded);
+
+        Case("c_str", "EdoString", [&] {
+            g_sink += (size_t) str.c_str()[0];
+        });
+
+        Case("c_str", "std::string", [&] {
+            g_sink += (size_t) encoded.c_str()[0];
+        });
+
+        // Editors and loggers change a string and read it back
+        Case("c_str after an edit", "EdoString", [&] {
+            str[0] = str[0];
+            g_sink += (size_t) str.c_str()[0];
+        });
+
+        Case("c_str after an edit", "std::string", [&] {
+            encoded[0] = encoded[0];
+            g_sink += (size_t) encoded.c_str()[0];
+        });
+
+        // std::wstring_convert is the standard library's utf8 -> utf16 conversion
+        std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> converter;
+
+        Case("ToUtf16", "EdoString", [&] {
+            g_sink += str.ToUtf16(false).size();
+        });
+
+        Case("ToUtf16", "std::wstring_convert", [&] {
+            g_sink += converter.from_bytes(encoded).size();
+        });
+    }
+
+    void BenchComparison(const SuiteText &text) {
+        const EdoString str(text.str), same(text.str);
+        EdoString last(text.str);
+        last[last.Length() - 1] = '#';
+
+        const std::string encoded(text.encoded), sameEncoded(text.encoded);
+        std::string lastEncoded(text.encoded);
+        lastEncoded.back() = '#';
+
+        const std::u32string codePoints(text.codePoints), sameCodePoints(text.codePoints);
+        std::u32string lastCodePoints(text.codePoints);
+        lastCodePoints.back() = '#';
+
+        Case("Compare (equal)", "EdoString", [&] {
+            g_sink += (size_t) str.Compare(same);
+        });
+
+        Case("Compare (equal)", "std::string", [&] {
+            g_sink += (size_t) encoded.compare(sameEncoded);
+        });
+
+        Case("Compare (equal)", "std::u32string", [&] {
+            g_sink += (size_t) codePoints.compare(sameCodePoints);
+        });
+
+        Case("operator== (last differs)", "EdoString", [&] {
+            g_sink += str == last;
+        });
+
+        Case("operator== (last differs)", "std::string", [&] {
+            g_sink += encoded == lastEncoded;
+        });
+
+        Case("operator== (last differs)", "std::u32string", [&] {
+            g_sink += codePoints == lastCodePoints;
+        });
+    }
+
+    void BenchSearching(const SuiteText &text) {
+        const EdoString &str = text.str;
+        const size_t tail = SUITE_TEXT_LENGTH - 8;
+
+        // Needles of 8 code points taken from either end, so the match is as far as it gets
+        const EdoString endNeedle(str, tail), startNeedle(str, 0, 8);
+        const std::string endNeedleEncoded(text.encoded, text.ByteOffset(tail));
+        const std::string startNeedleEncoded(text.encoded, 0, text.ByteOffset(8));
+        const std::u32string endNeedleCodePoints(text.codePoints, tail), startNeedleCodePoints(text.codePoints, 0, 8);
+
+        // Code points that are in none of the corpora
+        const EdoString set("{}<>|");
+        const std::string setEncoded("{}<>|");
+        const std::u32string setCodePoints(U"{}<>|");
+
+        Case("Find code point (absent)", "EdoString", [&] {
+            g_sink += str.Find((utf32) 1);
+        });
+
+        Case("Find code point (absent)", "std::string", [&] {
+            g_sink += text.encoded.find('\x01');
+        });
+
+        Case("Find code point (absent)", "std::u32string", [&] {
+            g_sink += text.codePoints.find(U'\x01');
+        });
+
+        Case("Find substring (at the end)", "EdoString", [&] {
+            g_sink += str.Find(endNeedle);
+        });
+
+        Case("Find substring (at the end)", "std::string", [&] {
+            g_sink += text.encoded.find(endNeedleEncoded);
+        });
+
+        Case("Find substring (at the end)", "std::u32string", [&] {
+            g_sink += text.codePoints.find(endNeedleCodePoints);
+        });
+
+        Case("RFind substring (at the start)", "EdoString", [&] {
+            g_sink += str.RFind(startNeedle);
+        });
+
+        Case("RFind substring (at the start)", "std::string", [&] {
+            g_sink += text.encoded.rfind(startNeedleEncoded);
+        });
+
+        Case("RFind substring (at the start)", "std::u32string", [&] {
+            g_sink += text.codePoints.rfind(startNeedleCodePoints);
+        });
+
+        Case("FindFirstOf (absent set)", "EdoString", [&] {
+            g_sink += str.FindFirstOf(set);
+        });
+
+        Case("FindFirstOf (absent set)", "std::string", [&] {
+            g_sink += text.encoded.find_first_of(setEncoded);
+        });
+
+        Case("FindFirstOf (absent set)", "std::u32string", [&] {
+            g_sink += text.codePoints.find_first_of(setCodePoints);
+        });
+    }
+
+    void BenchSplitting(const SuiteText &text) {
+        const EdoString &str = text.str;
+        const EdoCodePointSet separators(" ,.", 3);
+
+        Case("Split on ' ' (lazy views)", "EdoString", [&] {
+            for (EdoStringView field : str.Split(' '))
+                g_sink += field.Length();
+        });
+
+        Case("Split on ' ' (Find + Substr)", "EdoString", [&] {
+            size_t start = 0;
+
+            for (size_t pos = str.Find(' '); pos != EdoString::npos; pos = str.Find(' ', start)) {
+                g_sink += str.Substr(start, pos - start).Length();
+                start = pos + 1;
+            }
+
+            g_sink += str.Substr(start).Length();
+        });
+
+        Case("Split on ' ' (find + substr)", "std::string", [&] {
+            size_t start = 0;
+
+            for (size_t pos = text.encoded.find(' '); pos != std::string::npos; pos = text.encoded.find(' ', start)) {
+                g_sink += text.encoded.substr(start, pos - start).size();
+                start = pos + 1;
+            }
+
+            g_sink += text.encoded.substr(start).size();
+        });
+
+        Case("Split on \" ,.\" skipping empty fields", "EdoString", [&] {
+            for (EdoStringView field : str.Split(separators, SplitSkipEmpty))
+                g_sink += field.Length();
+        });
+
+        Case("Tokenize on spaces", "EdoString", [&] {
+            for (EdoStringView token : str.Tokenize([](utf32 cp) { return cp == ' '; }))
+                g_sink += token.Length();
+        });
+    }
+
+    void BenchReplacing(const SuiteText &text) {
+        const EdoString space(" "), wideSpace("  "), spaceEsc("\\ "), quote("\""), quoteEsc("\\\""), slash("\\"),
+                slashEsc("\\\\");
+
+        Case("Replace every ' ' with two (ReplaceAll)", "EdoString", [&] {
+            EdoString str(text.str);
+            str.ReplaceAll(space, wideSpace);
+            g_sink += str.Length();
+        });
+
+        Case("Replace every ' ' with two (Find + Replace)", "EdoString", [&] {
+            EdoString str(text.str);
+
+            for (size_t pos = str.Find(' '); pos != EdoString::npos; pos = str.Find(' ', pos + 2))
+                str.Replace(pos, 1, wideSpace);
+
+            g_sink += str.Length();
+        });
+
+        Case("Replace every ' ' with two (find + replace)", "std::string", [&] {
+            std::string str(text.encoded);
+
+            for (size_t pos = str.find(' '); pos != std::string::npos; pos = str.find(' ', pos + 2))
+                str.replace(pos, 1, "  ");
+
+            g_sink += str.size();
+        });
+
+        Case("Escape quotes, slashes and spaces (ReplaceAll batch)", "EdoString", [&] {
+            EdoString str(text.str);
+            str.ReplaceAll({{quote, quoteEsc}, {slash, slashEsc}, {space, spaceEsc}});
+            g_sink += str.Length();
+        });
+    }
+
+    void BenchBuilding(const SuiteText &text) {
+        const size_t pieceCount = SUITE_TEXT_LENGTH / SUITE_PIECE_LENGTH;
+        std::vector<EdoString> pieces;
+        std::vector<std::string> piecesEncoded;
+        std::vector<std::u32string> piecesCodePoints;
+
+        for (size_t i = 0; i < pieceCount; ++i) {
+            size_t idx = i * SUITE_PIECE_LENGTH;
+            size_t from = text.ByteOffset(idx), to = text.ByteOffset(idx + SUITE_PIECE_LENGTH);
+
+            pieces.push_back(text.str.Substr(idx, SUITE_PIECE_LENGTH));
+            piecesEncoded.push_back(text.encoded.substr(from, to - from));
+            piecesCodePoints.push_back(text.codePoints.substr(idx, SUITE_PIECE_LENGTH));
+        }
+
+        Case("Append 16 pieces", "EdoString", [&] {
+            EdoString str;
+
+            for (const EdoString &piece : pieces)
+                str += piece;
+
+            g_sink += str.Length();
+        });
+
+        Case("Append 16 pieces", "std::string", [&] {
+            std::string str;
+
+            for (const std::string &piece : piecesEncoded)
+                str += piece;
+
+            g_sink += str.size();
+        });
+
+        Case("Append 16 pieces", "std::u32string", [&] {
+            std::u32string str;
+
+            for (const std::u32string &piece : piecesCodePoints)
+                str += piece;
+
+            g_sink += str.size();
+        });
+
+        const size_t half = SUITE_TEXT_LENGTH / 2, halfBytes = text.ByteOffset(half);
+        const EdoString head(text.str, 0, half), tail(text.str, half);
+        const std::string headEncoded(text.encoded, 0, halfBytes), tailEncoded(text.encoded, halfBytes);
+        const std::u32string headCodePoints(text.codePoints, 0, half), tailCodePoints(text.codePoints, half);
+
+        Case("operator+ (two halves)", "EdoString", [&] {
+            g_sink += (head + tail).Length();
+        });
+
+        Case("operator+ (two halves)", "std::string", [&] {
+            g_sink += (headEncoded + tailEncoded).size();
+        });
+
+        Case("operator+ (two halves)", "std::u32string", [&] {
+            g_sink += (headCodePoints + tailCodePoints).size();
+        });
+
+        // A piece goes in at the middle and comes out again, so the strings keep their size
+        EdoString str(text.str);
+        std::string encoded(text.encoded);
+        std::u32string codePoints(text.codePoints);
+
+        Case("Insert + Erase (middle)", "EdoString", [&] {
+            str.Insert(half, pieces[0]);
+            str.Erase(half, SUITE_PIECE_LENGTH);
+        });
+
+        Case("Insert + Erase (middle)", "std::string", [&] {
+            encoded.insert(halfBytes, piecesEncoded[0]);
+            encoded.erase(halfBytes, piecesEncoded[0].size());
+        });
+
+        Case("Insert + Erase (middle)", "std::u32string", [&] {
+            codePoints.insert(half, piecesCodePoints[0]);
+            codePoints.erase(half, SUITE_PIECE_LENGTH);
+        });
+
+        const size_t quarter = SUITE_TEXT_LENGTH / 4;
+        const size_t quarterBytes = text.ByteOffset(quarter);
+        const size_t middleBytes = text.ByteOffset(quarter + half) - quarterBytes;
+
+        Case("Substr (middle half)", "EdoString", [&] {
+            g_sink += text.str.Substr(quarter, half).Length();
+        });
+
+        Case("Substr (middle half)", "std::string", [&] {
+            g_sink += text.encoded.substr(quarterBytes, middleBytes).size();
+        });
+
+        Case("Substr (middle half)", "std::u32string", [&] {
+            g_sink += text.codePoints.substr(quarter, half).size();
+        });
+    }
+
+    void BenchNumbers() {
+        if (!Section("EdoString suite: numbers (one of 64 values per op)"))
+            return;
+
+        // Values of every magnitude, taken in turn so no call sees the same input twice in a row
+        int ints[64];
+        double doubles[64];
+        std::vector<std::string> intTexts, doubleTexts;
+        std::vector<EdoString> intStrs, doubleStrs;
+        uint64_t seed = 0x9E3779B97F4A7C15ULL;
+
+        for (size_t i = 0; i < 64; ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            ints[i] = (int) (seed >> 33) >> (i % 31);
+            doubles[i] = (double) (seed >> 11) / (double) (1ULL << 53) * pow(10.0, (double) (i % 24) - 8);
+
+            intTexts.push_back(std::to_string(ints[i]));
+            char buff[32];
+            snprintf(buff, sizeof(buff), "%.17g", doubles[i]);
+            doubleTexts.push_back(buff);
+            intStrs.push_back(EdoString(intTexts.back().c_str()));
+            doubleStrs.push_back(EdoString(doubleTexts.back().c_str()));
+        }
+
+        size_t next = 0;
+        char buff[64];
+
+        Case("ToString(int)", "EdoString", [&] {
+            g_sink += ToString(ints[++next & 63]).Length();
+        });
+
+        Case("ToString(int)", "std::to_string", [&] {
+            g_sink += std::to_string(ints[++next & 63]).size();
+        });
+
+        Case("ToString(int)", "std::ostringstream", [&] {
+            std::ostringstream stream;
+            stream << ints[++next & 63];
+            g_sink += stream.str().size();
+        });
+
+        Case("int into a buffer", "FormatNumber", [&] {
+            g_sink += FormatNumber(ints[++next & 63], buff);
+        });
+
+        Case("int into a buffer", "snprintf", [&] {
+            g_sink += snprintf(buff, sizeof(buff), "%d", ints[++next & 63]);
+        });
+
+        // std::to_string and the default stream precision do not round trip, "%.17g" does but is not the shortest
+        Case("ToString(double)", "EdoString", [&] {
+            g_sink += ToString(doubles[++next & 63]).Length();
+        });
+
+        Case("ToString(double)", "std::to_string", [&] {
+            g_sink += std::to_string(doubles[++next & 63]).size();
+        });
+
+        Case("ToString(double)", "std::ostringstream", [&] {
+            std::ostringstream stream;
+            stream.precision(17);
+            stream << doubles[++next & 63];
+            g_sink += stream.str().size();
+        });
+
+        Case("double into a buffer", "FormatNumber", [&] {
+            g_sink += FormatNumber(doubles[++next & 63], buff);
+        });
+
+        Case("double into a buffer", "snprintf %.17g", [&] {
+            g_sink += snprintf(buff, sizeof(buff), "%.17g", doubles[++next & 63]);
+        });
+
+        Case("Parse<int>", "EdoString", [&] {
+            g_sink += (size_t) Parse<int>(intStrs[++next & 63]);
+        });
+
+        Case("Parse<int>", "strtol", [&] {
+            g_sink += (size_t) strtol(intTexts[++next & 63].c_str(), nullptr, 10);
+        });
+
+        Case("Parse<int>", "std::istringstream", [&] {
+            std::istringstream stream(intTexts[++next & 63]);
+            int value = 0;
+            stream >> value;
+            g_sink += (size_t) value;
+        });
+
+        Case("Parse<double>", "EdoString", [&] {
+            g_sink += (size_t) Parse<double>(doubleStrs[++next & 63]);
+        });
+
+        Case("Parse<double>", "strtod", [&] {
+            g_sink += (size_t) strtod(doubleTexts[++next & 63].c_str(), nullptr);
+        });
+
+        Case("Parse<double>", "std::istringstream", [&] {
+            std::istringstream stream(doubleTexts[++next & 63]);
+            double value = 0;
+            stream >> value;
+            g_sink += (size_t) value;
+        });
+    }
+
+    void BenchFormatting() {
+        if (!Section("EdoString suite: formatting a log line (one of 64 values per op)"))
+            return;
+
+        const EdoString name("LoadTexture");
+        const std::string stdName("LoadTexture");
+        double elapsed[64];
+        int counts[64];
+        uint64_t seed = 0x2545F4914F6CDD1DULL;
+
+        for (size_t i = 0; i < 64; ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            elapsed[i] = (double) (seed >> 11) / (double) (1ULL << 53) * 250.0;
+            counts[i] = (int) (seed >> 40);
+        }
+
+        size_t next = 0;
+        char buff[128];
+        EdoString line;
+
+        Case("\"{} took {:.3f} ms\"", "EDO_FORMAT", [&] {
+            g_sink += EDO_FORMAT("{} took {:.3f} ms", name, elapsed[++next & 63]).Length();
+        });
+
+        Case("\"{} took {:.3f} ms\"", "operator+ and ToString", [&] {
+            g_sink += (name + " took " + ToString(elapsed[++next & 63]) + " ms").Length();
+        });
+
+        Case("\"{} took {:.3f} ms\"", "std::ostringstream", [&] {
+            std::ostringstream stream;
+            stream.setf(std::ios::fixed);
+            stream.precision(3);
+            stream << stdName << " took " << elapsed[++next & 63] << " ms";
+            g_sink += stream.str().size();
+        });
+
+        Case("\"{} took {:.3f} ms\"", "snprintf", [&] {
+            g_sink += snprintf(buff, sizeof(buff), "%s took %.3f ms", stdName.c_str(), elapsed[++next & 63]);
+        });
+
+        // Shortest digits and plain integers, the common case in logs, stay clear of snprintf
+        Case("\"[{:>12}] {} items, {} ms\"", "EDO_FORMAT", [&] {
+            next = (next + 1) & 63;
+            g_sink += EDO_FORMAT("[{:>12}] {} items, {} ms", name, counts[next], elapsed[next]).Length();
+        });
+
+        Case("\"[{:>12}] {} items, {} ms\"", "snprintf", [&] {
+            next = (next + 1) & 63;
+            g_sink += snprintf(buff, sizeof(buff), "[%12s] %d items, %.17g ms", stdName.c_str(), counts[next],
+                               elapsed[next]);
+        });
+
+        // Resize(0) keeps the capacity, where Clear() gives it back
+        Case("Append to a reused line", "FormatTo", [&] {
+            line.Resize(0);
+            next = (next + 1) & 63;
+            FormatTo(line, "[{:>12}] {} items, {} ms", name, counts[next], elapsed[next]);
+            g_sink += line.Length();
+        });
+    }
+}
+
+/*!
+ * \brief
+ * Runs every EdoString case over each corpus, next to the std::string and std::u32string equivalents
+ */
+void BenchStringSuite() {
+    for (const SuiteCorpus &corpus : s_corpora) {
+        std::string title = std::string("EdoString suite: ") + corpus.name + " (" +
+                            std::to_string(SUITE_TEXT_LENGTH) + " code points)";
+
+        if (!Section(title))
+            continue;
+
+        const SuiteText text(corpus.seed);
+
+        BenchConstruction(text);
+        BenchEncoding(text);
+        BenchComparison(text);
+        BenchSearching(text);
+        BenchSplitting(text);
+        BenchReplacing(text);
+        BenchBuilding(text);
+    }
+
+    BenchNumbers();
+    BenchFormatting();
+}
@@ -0,0 +1,196 @@
+// =============================================================================
+// EdoStringTableCheck.cpp
+// Races threads interning and looking up strings in one EdoStringTable, and checks the ids they get
+// =============================================================================
+
+#include "Edo.h"
+#include "Types/EdoStringTable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define EDO_TABLE_STRINGS 20000 // Distinct strings, enough to rebuild the index and fill several entry chunks
+#define EDO_TABLE_WRITERS 4 // Threads interning every string, each in its own order
+#define EDO_TABLE_READERS 4 // Threads looking the strings up while they are being interned
+
+using namespace Edo::Types;
+
+static std::atomic<size_t> s_failures(0);
+
+static void Check(bool ok, const char *what) {
+    if (!ok && s_failures.fetch_add(1) < 20)
+        fprintf(stderr, "failed: %s\n", what);
+}
+
+// The n-th test string, in utf8: mostly ASCII names, every third one with a two and a four code unit character
+static std::string MakeName(size_t n) {
+    std::string name = (n % 3 == 0) ? "caf\xC3\xA9/\xF0\x9F\x98\x80/" : "asset/";
+    return name + std::to_string(n);
+}
+
+// The table starts out with the empty string only, and every way of naming it gives id 0
+static void CheckEmpty() {
+    EdoStringTable table;
+    EdoStringId id = EdoStringId::FromValue(7);
+
+    Check(table.Size() == 1, "a new table is not holding just the empty string");
+    Check(table.Find(EdoString(), id) && id.Value() == 0, "the empty string is not found with id 0");
+    Check(table.Find((const utf8 *) "", 0, id) && id.Value() == 0, "the empty utf8 string is not found with id 0");
+    Check(table.Intern(EdoString()).Value() == 0, "interning the empty string does not give id 0");
+    Check(table.Intern((const utf8 *) "", 0).Value() == 0, "interning the empty utf8 string does not give id 0");
+    Check(EdoStringId().Empty() && EdoStringId(EdoString()).Empty(), "EdoStringId of the empty string");
+    Check(table.String(EdoStringId()).Empty() && table.Utf8(EdoStringId())[0] == 0 &&
+          table.Utf8Length(EdoStringId()) == 0, "the string of id 0 is not empty");
+    Check(!table.Find(EdoString("missing"), id), "a string never interned is found");
+    Check(table.Size() == 1, "lookups of the empty string add entries");
+}
+
+// Writers intern every string in their own order, readers look them up meanwhile. All of them must agree on the id
+// of each string, and ids must be dense and distinct
+static void CheckConcurrent() {
+    EdoStringTable table;
+    std::vector<std::string> names(EDO_TABLE_STRINGS);
+
+    for (size_t n = 0; n < names.size(); ++n)
+        names[n] = MakeName(n);
+
+    std::vector<std::vector<uint32_t>> writerIds(EDO_TABLE_WRITERS, std::vector<uint32_t>(names.size()));
+    std::vector<std::vector<uint32_t>> readerIds(EDO_TABLE_READERS, std::vector<uint32_t>(names.size(), 0));
+    std::atomic<size_t> ready(0);
+    std::vector<std::thread> threads;
+
+    auto start = [&ready] {
+        ready.fetch_add(1);
+
+        while (ready.load() != EDO_TABLE_WRITERS + EDO_TABLE_READERS)
+            std::this_thread::yield();
+    };
+
+    for (size_t w = 0; w < EDO_TABLE_WRITERS; ++w) {
+        threads.emplace_back([&, w] {
+            std::vector<size_t> order(names.size());
+
+            for (size_t n = 0; n < order.size(); ++n)
+                order[n] = n;
+
+            std::shuffle(order.begin(), order.end(), std::mt19937((unsigned) w));
+            start();
+
+            // Half of the writers intern EdoString objects, the other half utf8 data
+            for (size_t n : order) {
+                if (w % 2 == 0)
+                    writerIds[w][n] = table.Intern(EdoString((const utf8 *) names[n].c_str())).Value();
+                else
+                    writerIds[w][n] = table.Intern((const utf8 *) names[n].data(), names[n].size()).Value();
+            }
+        });
+    }
+
+    for (size_t r = 0; r < EDO_TABLE_READERS; ++r) {
+        threads.emplace_back([&, r] {
+            start();
+
+            for (size_t pass = 0; pass < 3; ++pass) {
+                for (size_t n = 0; n < names.size(); ++n) {
+                    EdoStringId id;
+
+                    if (table.Find((const utf8 *) names[n].data(), names[n].size(), id)) {
+                        // Once found, the string behind the id has to be complete
+                        if (strcmp((const char *) table.Utf8(id), names[n].c_str()) != 0)
+                            Check(false, "a concurrent Find() returned an id whose string is not there yet");
+
+                        readerIds[r][n] = id.Value();
+                    }
+                }
+            }
+        });
+    }
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    std::vector<bool> seen(names.size() + 1, false);
+
+    for (size_t n = 0; n < names.size(); ++n) {
+        const uint32_t id = writerIds[0][n];
+
+        for (size_t w = 1; w < EDO_TABLE_WRITERS; ++w)
+            Check(writerIds[w][n] == id, "two writers got different ids for one string");
+
+        for (size_t r = 0; r < EDO_TABLE_READERS; ++r)
+            Check(readerIds[r][n] == 0 || readerIds[r][n] == id, "a reader found a different id than the writers");
+
+        Check(id != 0 && id <= names.size() && !seen[id], "ids are not dense and distinct");
+
+        if (id != 0 && id <= names.size())
+            seen[id] = true;
+
+        EdoStringId found;
+        Check(table.Find(EdoString((const utf8 *) names[n].c_str()), found) && found.Value() == id,
+              "Find() after the race disagrees with Intern()");
+        Check(table.String(found) == EdoString((const utf8 *) names[n].c_str()) &&
+              table.Utf8Length(found) == names[n].size(), "the string of an id is not the interned one");
+    }
+
+    Check(table.Size() == names.size() + 1, "the table holds more entries than distinct strings");
+}
+
+// InternAll, malformed utf8 and the global table behind EdoStringId
+static void CheckOther() {
+    EdoStringTable table;
+    std::vector<EdoString> strs;
+    std::vector<std::string> names;
+
+    for (size_t n = 0; n < 3000; ++n) {
+        names.push_back(MakeName(n % 2000)); // The second 1000 repeat earlier ones
+        strs.push_back(EdoString((const utf8 *) names.back().c_str()));
+    }
+
+    std::vector<EdoStringId> ids(strs.size());
+    table.InternAll(strs.data(), strs.size(), ids.data());
+
+    for (size_t n = 0; n < strs.size(); ++n)
+        Check(table.Intern(strs[n]) == ids[n] && (n < 2000 || ids[n] == ids[n - 2000]),
+              "InternAll() disagrees with Intern()");
+
+    std::vector<const utf8 *> utf8Strs;
+
+    for (const std::string &name : names)
+        utf8Strs.push_back((const utf8 *) name.c_str());
+
+    std::vector<EdoStringId> utf8Ids(utf8Strs.size());
+    table.InternAll(utf8Strs.data(), utf8Strs.size(), utf8Ids.data());
+    Check(utf8Ids == ids && table.Size() == 2001, "InternAll() of utf8 data disagrees with InternAll() of EdoString");
+
+    // Malformed sequences are interned the way the EdoString constructor decodes them
+    const utf8 malformed[] = {'a', 0xC3, 'b', 0xF0, 0x9F};
+    const EdoStringId bad = table.Intern(malformed, sizeof(malformed));
+    Check(bad == table.Intern(EdoString(malformed, sizeof(malformed))), "malformed utf8 is not decoded like EdoString");
+    Check(table.String(bad) == EdoString((const utf8 *) "a\xEF\xBF\xBD" "b\xEF\xBF\xBD"),
+          "malformed utf8 is not replaced with U+FFFD");
+
+    const EdoStringId global(EdoString("EdoStringTableCheck"));
+    Check(global == EdoStringId((const utf8 *) "EdoStringTableCheck") && global.String() == "EdoStringTableCheck" &&
+          strcmp((const char *) global.c_str(), "EdoStringTableCheck") == 0, "EdoStringId and the global table");
+}
+
+int main() {
+    CheckEmpty();
+    CheckConcurrent();
+    CheckOther();
+
+    if (s_failures.load() != 0) {
+        fprintf(stderr, "EdoStringTableCheck: %zu checks failed\n", s_failures.load());
+        return 1;
+    }
+
+    printf("EdoStringTableCheck: %d strings interned by %d writers while %d readers looked them up, all consistent\n",
+           EDO_TABLE_STRINGS, EDO_TABLE_WRITERS, EDO_TABLE_READERS);
+    return 0;
+}
@@ -0,0 +1,218 @@
+// =============================================================================
+// EdoUtf8Corpus.cpp
+// Checks the utf8 validation, counting and decoding kernels against a corpus of malformed sequences
+// =============================================================================
+
+#include "Types/EdoUtf.h"
+#include "Utils/EdoCpu.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define EDO_CORPUS_PADDING 80 // Code units of padding around a case, past the 64 code unit blocks of the kernels
+#define EDO_CORPUS_MIXES 2000 // Random concatenations of cases checked at each level
+
+using namespace Edo::Types;
+using namespace Edo::Utils;
+
+static const char *s_simdNames[] = {"scalar", "SSE2", "SSE4.1", "AVX2"};
+
+//! A line of the corpus
+struct CorpusCase {
+    std::vector<utf8> data; //!< The code units
+    size_t errorOffset; //!< Offset of the first malformed code unit, or UTF_NO_ERROR
+    size_t decodedLength; //!< Code points produced with the Utf8Replace policy
+    int line; //!< Line of the corpus file, for the report
+};
+
+static std::vector<CorpusCase> s_cases;
+static size_t s_failures = 0;
+
+// Read the corpus: comments start with '#', other lines hold the error offset (or "ok"), the decoded length and
+// the code units in hex
+static bool LoadCorpus(const char *path) {
+    FILE *file = fopen(path, "r");
+
+    if (!file)
+        return false;
+
+    char text[1024];
+
+    for (int line = 1; fgets(text, sizeof(text), file); ++line) {
+        if (char *comment = strchr(text, '#'))
+            *comment = 0;
+
+        char *pos = text;
+        char *end;
+        CorpusCase entry;
+        entry.line = line;
+
+        while (*pos == ' ' || *pos == '\t')
+            ++pos;
+
+        if (*pos == '\n' || *pos == '\r' || *pos == 0)
+            continue;
+
+        if (strncmp(pos, "ok", 2) == 0) {
+            entry.errorOffset = UTF_NO_ERROR;
+            pos += 2;
+        } else {
+            entry.errorOffset = strtoul(pos, &end, 10);
+            pos = end;
+        }
+
+        entry.decodedLength = strtoul(pos, &end, 10);
+
+        for (pos = end;; pos = end) {
+            unsigned long unit = strtoul(pos, &end, 16);
+
+            if (end == pos)
+                break;
+
+            entry.data.push_back((utf8) unit);
+        }
+
+        s_cases.push_back(entry);
+    }
+
+    fclose(file);
+    return true;
+}
+
+static void Fail(const CorpusCase &entry, const char *what, size_t prefix, EdoSimdLevel level) {
+    if (s_failures++ < 20)
+        fprintf(stderr, "line %d, after %zu code units (%s): %s\n", entry.line, prefix, s_simdNames[level], what);
+}
+
+// Check every kernel on 'data', which holds 'before' well-formed code points in front of the case and 'after'
+// behind it
+static void CheckBuffer(const CorpusCase &entry, const std::vector<utf8> &data, size_t prefix, size_t before,
+                        size_t after, EdoSimdLevel level) {
+    const size_t expectedError = entry.errorOffset == UTF_NO_ERROR ? UTF_NO_ERROR : prefix + entry.errorOffset;
+    const size_t expectedLength = before + entry.decodedLength + after;
+    std::vector<utf32> decoded(data.size() + 1);
+    size_t error = 0;
+
+    if (ValidateUtf8(data.data(), data.size(), &error) != (expectedError == UTF_NO_ERROR) || error != expectedError)
+        Fail(entry, "ValidateUtf8() disagrees", prefix, level);
+
+    if (DecodeUtf8(data.data(), data.size(), decoded.data(), Utf8Replace, &error) != expectedLength ||
+        error != expectedError)
+        Fail(entry, "DecodeUtf8() with Utf8Replace disagrees", prefix, level);
+
+    if (Utf32LengthOf(data.data(), data.size()) != expectedLength)
+        Fail(entry, "Utf32LengthOf() disagrees", prefix, level);
+
+    if (expectedError == UTF_NO_ERROR && CountCodePoints(data.data(), data.size()) != expectedLength)
+        Fail(entry, "CountCodePoints() disagrees", prefix, level);
+
+    bool threw = false;
+
+    try {
+        DecodeUtf8(data.data(), data.size(), decoded.data(), Utf8Throw);
+    } catch (std::invalid_argument &) {
+        threw = true;
+    }
+
+    if (threw != (expectedError != UTF_NO_ERROR))
+        Fail(entry, "DecodeUtf8() with Utf8Throw disagrees", prefix, level);
+
+    if (expectedError != UTF_NO_ERROR &&
+        DecodeUtf8(data.data(), data.size(), decoded.data(), Utf8Stop) != CountCodePoints(data.data(), expectedError))
+        Fail(entry, "DecodeUtf8() with Utf8Stop does not stop at the error", prefix, level);
+}
+
+// Each case alone, then padded with ASCII or three code unit characters so that it lands at every position of
+// the blocks the kernels work on
+static void CheckCases(EdoSimdLevel level) {
+    static const utf8 s_ascii[] = {'a'};
+    static const utf8 s_wide[] = {0xE4, 0xB8, 0xAD}; // U+4E2D
+
+    for (const CorpusCase &entry : s_cases) {
+        for (size_t prefix = 0; prefix <= EDO_CORPUS_PADDING; ++prefix) {
+            for (int wide = 0; wide < 2; ++wide) {
+                const utf8 *pad = wide ? s_wide : s_ascii;
+                const size_t padLen = wide ? sizeof(s_wide) : sizeof(s_ascii);
+                std::vector<utf8> data;
+                size_t before = 0;
+                size_t after = 0;
+
+                for (; data.size() + padLen <= prefix; ++before)
+                    data.insert(data.end(), pad, pad + padLen);
+
+                const size_t start = data.size();
+                data.insert(data.end(), entry.data.begin(), entry.data.end());
+
+                // A space ends a truncated sequence the way the end of the data does
+                for (; data.size() < start + entry.data.size() + EDO_CORPUS_PADDING - prefix; ++after)
+                    data.push_back(' ');
+
+                CheckBuffer(entry, data, start, before, after, level);
+            }
+        }
+    }
+}
+
+// Random concatenations of cases, each followed by a space so that no sequence runs into the next case
+static void CheckMixes(EdoSimdLevel level) {
+    std::mt19937 random(22);
+
+    for (size_t mix = 0; mix < EDO_CORPUS_MIXES; ++mix) {
+        CorpusCase combined;
+        combined.errorOffset = UTF_NO_ERROR;
+        combined.decodedLength = 0;
+        combined.line = 0;
+
+        for (size_t count = random() % 32; count > 0; --count) {
+            const CorpusCase &entry = s_cases[random() % s_cases.size()];
+
+            if (combined.errorOffset == UTF_NO_ERROR && entry.errorOffset != UTF_NO_ERROR)
+                combined.errorOffset = combined.data.size() + entry.errorOffset;
+
+            combined.data.insert(combined.data.end(), entry.data.begin(), entry.data.end());
+            combined.data.push_back(' ');
+            combined.decodedLength += entry.decodedLength + 1;
+        }
+
+        CheckBuffer(combined, combined.data, 0, 0, 0, level);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <corpus file>\n", argv[0]);
+        return 2;
+    }
+
+    if (!LoadCorpus(argv[1]) || s_cases.empty()) {
+        fprintf(stderr, "could not read %s\n", argv[1]);
+        return 2;
+    }
+
+    int levels = 0;
+
+    for (int level = SimdScalar; level <= SimdAvx2; ++level) {
+        SetSimdLevel((EdoSimdLevel) level);
+
+        if (GetSimdLevel() != level)
+            continue;
+
+        CheckCases((EdoSimdLevel) level);
+        CheckMixes((EdoSimdLevel) level);
+        ++levels;
+    }
+
+    if (s_failures != 0) {
+        fprintf(stderr, "EdoUtf8Corpus: %zu checks failed\n", s_failures);
+        return 1;
+    }
+
+    printf("EdoUtf8Corpus: %zu cases and %d random mixes at %d instruction set levels, all as expected\n",
+           s_cases.size(), EDO_CORPUS_MIXES, levels);
+    return 0;
+}
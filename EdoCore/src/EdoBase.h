@@ -8,15 +8,21 @@
 #ifndef EDOCORE_EDOBASE_H
 #define EDOCORE_EDOBASE_H
 
-#if (defined(_EDO_WINDOWS) || defined(_WIN32))
+// EDO_STATIC is defined for EdoCore itself and for everything linking it when it is built as a static library, in
+// which case nothing is imported or exported
+#if defined(EDO_STATIC)
+#define EDO_API
+#elif (defined(_EDO_WINDOWS) || defined(_WIN32))
 #ifdef _EXPORT_DLL
 #define EDO_API __declspec(dllexport)
 #else
 #define EDO_API __declspec(dllimport)
 #endif // _EXPORT_DLL
+#elif defined(__GNUC__) || defined(__clang__)
+// The library is compiled with hidden visibility, so only what is marked EDO_API is exported from the shared object
+#define EDO_API __attribute__((visibility("default")))
 #else
-// TODO: Linux library import / export
-#error Edo currently only supports Windows!
+#error Edo currently only supports Windows, and GCC or Clang elsewhere!
 #endif
 
 #endif // EDOCORE_EDOBASE_H
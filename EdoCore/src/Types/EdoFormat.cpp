@@ -0,0 +1,481 @@
+// =============================================================================
+// EdoFormat.cpp
+// Implements the formatting of the arguments, shared by the measuring and the writing passes
+// =============================================================================
+
+#include "EdoFormat.h"
+#include "EdoNumber.h"
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define STR_FORMAT_CHUNK 128 // Code points a sink receives at most per call, and utf8 is decoded in
+#define STR_FORMAT_PRECISE 128 // Chars a floating point number with a precision gets before going to the heap
+
+namespace Edo {
+    namespace Types {
+        namespace {
+            ///////////////////////////////////////////////
+            // Outputs
+            ///////////////////////////////////////////////
+            // The same walk over the format string measures the output, writes it into a buffer, or feeds a sink. Each
+            // output takes code points, chars (code points 0x00..0xFF), and runs of a single code point
+
+            //! Counts the code points
+            class CountingOutput {
+            public:
+                CountingOutput() : d_count(0) {}
+
+                void Put(const utf32 *, size_t len) { d_count += len; }
+
+                void PutChars(const char *, size_t len) { d_count += len; }
+
+                void Fill(utf32, size_t count) { d_count += count; }
+
+                size_t Count() const { return d_count; }
+
+            private:
+                size_t d_count;
+            };
+
+            //! Writes into a buffer of the measured size
+            class BufferOutput {
+            public:
+                explicit BufferOutput(utf32 *dest) : d_dest(dest) {}
+
+                void Put(const utf32 *data, size_t len) {
+                    memcpy(d_dest, data, len * sizeof(utf32));
+                    d_dest += len;
+                }
+
+                void PutChars(const char *chars, size_t len) {
+                    for (size_t i = 0; i < len; ++i)
+                        d_dest[i] = (utf32) (unsigned char) chars[i];
+
+                    d_dest += len;
+                }
+
+                void Fill(utf32 code_point, size_t count) {
+                    for (size_t i = 0; i < count; ++i)
+                        d_dest[i] = code_point;
+
+                    d_dest += count;
+                }
+
+            private:
+                utf32 *d_dest;
+            };
+
+            //! Collects small pieces into chunks for a sink, and hands large ones over directly
+            class SinkOutput {
+            public:
+                explicit SinkOutput(EdoFormatSink &sink) : d_sink(sink), d_used(0) {}
+
+                void Put(const utf32 *data, size_t len) {
+                    if (d_used + len > STR_FORMAT_CHUNK) {
+                        Flush();
+
+                        if (len > STR_FORMAT_CHUNK) {
+                            d_sink.Write(data, len);
+                            return;
+                        }
+                    }
+
+                    memcpy(d_chunk + d_used, data, len * sizeof(utf32));
+                    d_used += len;
+                }
+
+                void PutChars(const char *chars, size_t len) {
+                    while (len != 0) {
+                        if (d_used == STR_FORMAT_CHUNK)
+                            Flush();
+
+                        size_t count = std::min(len, (size_t) STR_FORMAT_CHUNK - d_used);
+
+                        for (size_t i = 0; i < count; ++i)
+                            d_chunk[d_used + i] = (utf32) (unsigned char) chars[i];
+
+                        d_used += count;
+                        chars += count;
+                        len -= count;
+                    }
+                }
+
+                void Fill(utf32 code_point, size_t count) {
+                    while (count != 0) {
+                        if (d_used == STR_FORMAT_CHUNK)
+                            Flush();
+
+                        size_t run = std::min(count, (size_t) STR_FORMAT_CHUNK - d_used);
+
+                        for (size_t i = 0; i < run; ++i)
+                            d_chunk[d_used + i] = code_point;
+
+                        d_used += run;
+                        count -= run;
+                    }
+                }
+
+                void Flush() {
+                    if (d_used != 0)
+                        d_sink.Write(d_chunk, d_used);
+
+                    d_used = 0;
+                }
+
+            private:
+                EdoFormatSink &d_sink;
+                utf32 d_chunk[STR_FORMAT_CHUNK];
+                size_t d_used;
+            };
+
+            ///////////////////////////////////////////////
+            // Text
+            ///////////////////////////////////////////////
+            // Write up to 'limit' code points of utf8 data, decoded in chunks that end before a lead byte, so no
+            // sequence (malformed or not) is split
+            template<typename Output>
+            void PutUtf8(Output &out, const utf8 *src, size_t len, size_t limit) {
+                utf32 decoded[STR_FORMAT_CHUNK];
+
+                while (len != 0 && limit != 0) {
+                    size_t take = std::min(len, (size_t) STR_FORMAT_CHUNK);
+
+                    while (take < len && take > STR_FORMAT_CHUNK - 4 && (src[take] & 0xC0) == 0x80)
+                        --take;
+
+                    size_t count = std::min(DecodeUtf8(src, take, decoded), limit);
+                    out.Put(decoded, count);
+                    limit -= count;
+                    src += take;
+                    len -= take;
+                }
+            }
+
+            void PutUtf8(CountingOutput &out, const utf8 *src, size_t len, size_t limit) {
+                out.Fill(0, std::min(Utf32LengthOf(src, len), limit));
+            }
+
+            // Number of code points the text argument takes, at most 'limit'
+            size_t TextLength(const EdoFormatArg &arg, size_t limit) {
+                size_t len = (arg.kind == ArgUtf8) ? Utf32LengthOf((const utf8 *) arg.text.data, arg.text.len)
+                                                      : arg.text.len;
+                return std::min(len, limit);
+            }
+
+            template<typename Output>
+            void PutText(Output &out, const EdoFormatArg &arg, size_t limit) {
+                switch (arg.kind) {
+                    case ArgCodePoints:
+                        out.Put((const utf32 *) arg.text.data, std::min(arg.text.len, limit));
+                        break;
+                    case ArgChars:
+                        out.PutChars((const char *) arg.text.data, std::min(arg.text.len, limit));
+                        break;
+                    default:
+                        PutUtf8(out, (const utf8 *) arg.text.data, arg.text.len, limit);
+                        break;
+                }
+            }
+
+            ///////////////////////////////////////////////
+            // Padding
+            ///////////////////////////////////////////////
+            // Write 'len' code points produced by 'body' in a field of the spec's width
+            template<typename Output, typename Body>
+            void PutPadded(Output &out, const EdoFormatSpec &spec, size_t len, char defaultAlign, Body body) {
+                size_t padding = (spec.width != STR_FORMAT_NONE && spec.width > len) ? spec.width - len : 0;
+                char align = spec.align ? spec.align : defaultAlign;
+                size_t before = (align == '>') ? padding : (align == '^') ? padding / 2 : 0;
+
+                out.Fill(spec.fill, before);
+                body();
+                out.Fill(spec.fill, padding - before);
+            }
+
+            ///////////////////////////////////////////////
+            // Numbers
+            ///////////////////////////////////////////////
+            // Write the digits of 'value' in the given base, return their count. 'dest' has room for 64 of them
+            size_t FormatBase(uint64_t value, unsigned base, bool upper, char *dest) {
+                const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+                char temp[64];
+                size_t len = 0;
+
+                do {
+                    temp[len++] = digits[value % base];
+                    value /= base;
+                } while (value != 0);
+
+                for (size_t i = 0; i < len; ++i)
+                    dest[i] = temp[len - 1 - i];
+
+                return len;
+            }
+
+            //! Room for a floating point number with a precision, larger ones are written into a heap buffer
+            struct PreciseText {
+                char local[STR_FORMAT_PRECISE];
+                std::vector<char> heap;
+            };
+
+            // Write 'value' with 'precision' digits after the point, without going through the C library, when the
+            // rounding is certain: value * 10^precision stays below 2^40, so the product is off by less than 2^-12,
+            // and its fraction is not that close to one half. Returns 0 otherwise
+            size_t FormatFixed(double value, size_t precision, char *dest) {
+                static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+                if (precision >= sizeof(powers) / sizeof(powers[0]) || !(value < 1e12))
+                    return 0;
+
+                const double scaled = value * powers[precision];
+
+                if (!(scaled < 1099511627776.0))
+                    return 0;
+
+                uint64_t whole = (uint64_t) scaled;
+                const double fraction = scaled - (double) whole;
+
+                if (std::fabs(fraction - 0.5) < 1.0 / 1024)
+                    return 0;
+
+                if (fraction > 0.5)
+                    ++whole;
+
+                // Leading zeros make room for the integral digit of values below one
+                char digits[STR_NUMBER_CHARS];
+                size_t len = FormatUInt64(whole, digits);
+                size_t zeros = (len <= precision) ? precision + 1 - len : 0;
+                size_t integral = zeros + len - precision;
+                size_t out = 0;
+
+                for (size_t i = 0; i < zeros + len; ++i) {
+                    if (i == integral)
+                        dest[out++] = '.';
+
+                    dest[out++] = (i < zeros) ? '0' : digits[i - zeros];
+                }
+
+                return out;
+            }
+
+            // Write a floating point number with a precision, through the C library unless it is a fixed point number
+            // FormatFixed() can take, with '.' as the decimal point whatever the locale. Returns the chars written
+            const char *FormatPrecise(double value, const EdoFormatSpec &spec, PreciseText &text, size_t &len) {
+                const size_t precision =
+                        (spec.precision == STR_FORMAT_NONE) ? 6 : std::min(spec.precision, (size_t) 1000);
+
+                if (spec.type == 'f' && (len = FormatFixed(value, precision, text.local)) != 0)
+                    return text.local;
+
+                const char format[] = {'%', '.', '*', spec.type, 0};
+                char *dest = text.local;
+                int written = snprintf(dest, STR_FORMAT_PRECISE, format, (int) precision, value);
+
+                if (written >= STR_FORMAT_PRECISE) {
+                    text.heap.resize(written + 1);
+                    dest = text.heap.data();
+                    snprintf(dest, text.heap.size(), format, (int) precision, value);
+                }
+
+                const char point = *localeconv()->decimal_point;
+
+                if (point != '.') {
+                    for (int i = 0; i < written; ++i) {
+                        if (dest[i] == point)
+                            dest[i] = '.';
+                    }
+                }
+
+                len = (size_t) written;
+                return dest;
+            }
+
+            // Write a number made of a sign, an optional prefix and digits, padded as the spec says
+            template<typename Output>
+            void PutNumber(Output &out, const EdoFormatSpec &spec, bool negative, const char *digits, size_t len,
+                           bool finite, const char *prefix = "") {
+                char sign = negative ? '-' : spec.sign;
+                const size_t prefixLen = strlen(prefix);
+                size_t total = len + prefixLen + (sign ? 1 : 0);
+
+                if (spec.zeroPad && !spec.align && finite && spec.width != STR_FORMAT_NONE && spec.width > total) {
+                    // Zeros go between the sign and prefix, and the digits
+                    if (sign)
+                        out.PutChars(&sign, 1);
+
+                    out.PutChars(prefix, prefixLen);
+                    out.Fill('0', spec.width - total);
+                    out.PutChars(digits, len);
+                    return;
+                }
+
+                PutPadded(out, spec, total, '>', [&] {
+                    if (sign)
+                        out.PutChars(&sign, 1);
+
+                    out.PutChars(prefix, prefixLen);
+                    out.PutChars(digits, len);
+                });
+            }
+
+            template<typename Output>
+            void PutInteger(Output &out, const EdoFormatSpec &spec, bool negative, uint64_t magnitude) {
+                char digits[64];
+                const char *prefix = "";
+                size_t len;
+
+                switch (spec.type) {
+                    case 'x':
+                        len = FormatBase(magnitude, 16, false, digits);
+                        prefix = "0x";
+                        break;
+                    case 'X':
+                        len = FormatBase(magnitude, 16, true, digits);
+                        prefix = "0X";
+                        break;
+                    case 'o':
+                        len = FormatBase(magnitude, 8, false, digits);
+                        prefix = magnitude != 0 ? "0" : "";
+                        break;
+                    case 'b':
+                        len = FormatBase(magnitude, 2, false, digits);
+                        prefix = "0b";
+                        break;
+                    default:
+                        len = FormatUInt64(magnitude, digits);
+                        break;
+                }
+
+                PutNumber(out, spec, negative, digits, len, true, spec.alternate ? prefix : "");
+            }
+
+            template<typename Output>
+            void PutFloatingPoint(Output &out, const EdoFormatSpec &spec, double value, bool isFloat,
+                                  PreciseText &scratch) {
+                const bool negative = std::signbit(value);
+                const bool finite = std::isfinite(value);
+                const double magnitude = negative ? -value : value;
+
+                if (spec.type == 0 && spec.precision == STR_FORMAT_NONE) {
+                    char digits[STR_NUMBER_CHARS];
+                    size_t len = isFloat ? FormatFloat((float) magnitude, digits) : FormatDouble(magnitude, digits);
+                    PutNumber(out, spec, negative, digits, len, finite);
+                    return;
+                }
+
+                // A precision without a type means significant digits, as with 'g'
+                EdoFormatSpec precise = spec;
+
+                if (precise.type == 0)
+                    precise.type = 'g';
+
+                size_t len;
+                const char *digits = FormatPrecise(magnitude, precise, scratch, len);
+                PutNumber(out, spec, negative, digits, len, finite);
+            }
+
+            ///////////////////////////////////////////////
+            // Fields
+            ///////////////////////////////////////////////
+            template<typename Output>
+            void PutField(Output &out, const EdoFormatSpec &spec, const EdoFormatArg &arg, PreciseText &scratch) {
+                if (!EdoFormatString::Accepts(arg.kind, spec))
+                    throw std::invalid_argument("Format string field does not suit the type of its argument");
+
+                switch (arg.kind) {
+                    case ArgInt:
+                        if (spec.type == 'c') {
+                            utf32 code_point = (utf32) arg.i;
+                            PutPadded(out, spec, 1, '<', [&] { out.Put(&code_point, 1); });
+                        } else {
+                            PutInteger(out, spec, arg.i < 0, arg.i < 0 ? 0 - (uint64_t) arg.i : (uint64_t) arg.i);
+                        }
+                        break;
+                    case ArgUInt:
+                        if (spec.type == 'c') {
+                            utf32 code_point = (utf32) arg.u;
+                            PutPadded(out, spec, 1, '<', [&] { out.Put(&code_point, 1); });
+                        } else {
+                            PutInteger(out, spec, false, arg.u);
+                        }
+                        break;
+                    case ArgChar:
+                        if (spec.type == 0 || spec.type == 'c') {
+                            char c = (char) arg.i;
+                            PutPadded(out, spec, 1, '<', [&] { out.PutChars(&c, 1); });
+                        } else {
+                            PutInteger(out, spec, false, (unsigned char) arg.i);
+                        }
+                        break;
+                    case ArgBool:
+                        if (spec.type == 0 || spec.type == 's') {
+                            const char *text = arg.u ? "true" : "false";
+                            size_t len = arg.u ? 4 : 5;
+                            PutPadded(out, spec, len, '<', [&] { out.PutChars(text, len); });
+                        } else {
+                            PutInteger(out, spec, false, arg.u);
+                        }
+                        break;
+                    case ArgFloat:
+                        PutFloatingPoint(out, spec, arg.f, true, scratch);
+                        break;
+                    case ArgDouble:
+                        PutFloatingPoint(out, spec, arg.d, false, scratch);
+                        break;
+                    default: {
+                        size_t limit = spec.precision;
+                        size_t len = (spec.width != STR_FORMAT_NONE) ? TextLength(arg, limit) : 0;
+                        PutPadded(out, spec, len, '<', [&] { PutText(out, arg, limit); });
+                        break;
+                    }
+                }
+            }
+
+            template<typename Output>
+            void Walk(const EdoFormatString &fmt, const EdoFormatArg *args, size_t count, Output &out) {
+                if (fmt.ArgCount() > count)
+                    throw std::invalid_argument("Format string refers to more arguments than were given");
+
+                const char *format = fmt.Data();
+                PreciseText scratch; // Only used by floating point numbers with a precision
+                size_t nextArg = 0;
+                bool manual = false;
+
+                for (size_t pos = 0; format[pos] != 0;) {
+                    EdoFormatSpec spec = {0, ' ', 0, 0, false, false, STR_FORMAT_NONE, STR_FORMAT_NONE, 0};
+                    size_t next = fmt.Next(pos, spec, nextArg, manual);
+
+                    if (spec.arg != STR_FORMAT_NONE)
+                        PutField(out, spec, args[spec.arg], scratch);
+                    else if (format[pos] == '{' || format[pos] == '}')
+                        out.PutChars(format + pos, 1); // An escaped brace
+                    else
+                        out.PutChars(format + pos, next - pos);
+
+                    pos = next;
+                }
+            }
+        }
+
+        size_t FormattedLength(const EdoFormatString &fmt, const EdoFormatArg *args, size_t count) {
+            CountingOutput out;
+            Walk(fmt, args, count, out);
+            return out.Count();
+        }
+
+        void FormatArgs(const EdoFormatString &fmt, const EdoFormatArg *args, size_t count, utf32 *dest) {
+            BufferOutput out(dest);
+            Walk(fmt, args, count, out);
+        }
+
+        void FormatArgs(const EdoFormatString &fmt, const EdoFormatArg *args, size_t count, EdoFormatSink &sink) {
+            SinkOutput out(sink);
+            Walk(fmt, args, count, out);
+            out.Flush();
+        }
+    } // Namespace Types
+} // Namespace Edo
@@ -0,0 +1,541 @@
+// =============================================================================
+// EdoFormat.h
+// Type safe formatting of messages into EdoString, with format strings checked at compile time
+// =============================================================================
+
+#ifndef EDOCORE_EDOFORMAT_H
+#define EDOCORE_EDOFORMAT_H
+
+#include "EdoString.h"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+#define STR_FORMAT_NONE ((size_t) -1) // Width or precision that was not given
+
+/*!
+ * \brief
+ * Formats like Edo::Types::Format(), but checks the format string against the types of the arguments at compile time:
+ * a malformed format string, a wrong number of arguments, or a presentation type that does not suit its argument (such
+ * as {:.3f} for an EdoString) fail the build. The format string has to be a literal, and there has to be at least one
+ * argument
+ * \example_snippet_start
+ *      EdoString msg = EDO_FORMAT("{} took {:.3f} ms", name, elapsed);
+ * \example_snippet_end
+ */
+#define EDO_FORMAT(fmt, ...)                                                                                           \
+    Edo::Types::FormatChecked<Edo::Types::EdoFormatString(fmt).Check<                                                  \
+            Edo::Types::EdoFormatKindsOf<decltype(std::make_tuple(__VA_ARGS__))>>()>(fmt, __VA_ARGS__)
+
+namespace Edo {
+    namespace Types {
+        //////////////////////////////////////////////
+        // Arguments
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * How a formatting argument is stored, and which presentation types it accepts
+         */
+        enum EdoFormatKind {
+            ArgNone, //!< No argument
+            ArgInt, //!< Signed integer, stored as int64_t
+            ArgUInt, //!< Unsigned integer, stored as uint64_t
+            ArgBool, //!< Written as "true" or "false", or as 1 and 0 with an integer presentation type
+            ArgChar, //!< A char, written as the code point 0x00..0xFF it stands for
+            ArgFloat, //!< float, written with the shortest digits that read back as a float
+            ArgDouble, //!< double or long double
+            ArgCodePoints, //!< utf32 data (EdoString, EdoStringView)
+            ArgUtf8, //!< utf8 encoded data
+            ArgChars //!< char data taken as code points 0x00..0xFF (char *, std::string), as EdoString reads it
+        };
+
+        /*!
+         * \brief
+         * A formatting argument with its type erased. Text is referenced, not copied
+         */
+        struct EdoFormatArg {
+            EdoFormatKind kind;
+
+            union {
+                int64_t i;
+                uint64_t u;
+                double d;
+                float f;
+
+                struct {
+                    const void *data;
+                    size_t len; //!< Length in code units
+                } text;
+            };
+        };
+
+        //! Maps the type of an argument to the way it is stored. Types without a mapping cannot be formatted
+        template<typename T, typename Enable = void>
+        struct EdoFormatKindOf {
+            static const EdoFormatKind value = ArgNone;
+        };
+
+        template<typename T>
+        struct EdoFormatKindOf<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+            static const EdoFormatKind value = std::is_same<T, bool>::value ? ArgBool :
+                                               std::is_same<T, char>::value ? ArgChar :
+                                               std::is_signed<T>::value ? ArgInt : ArgUInt;
+        };
+
+        template<typename T>
+        struct EdoFormatKindOf<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+            static const EdoFormatKind value = std::is_same<T, float>::value ? ArgFloat : ArgDouble;
+        };
+
+        template<> struct EdoFormatKindOf<EdoString> { static const EdoFormatKind value = ArgCodePoints; };
+        template<> struct EdoFormatKindOf<EdoStringView> { static const EdoFormatKind value = ArgCodePoints; };
+        template<> struct EdoFormatKindOf<std::string> { static const EdoFormatKind value = ArgChars; };
+        template<> struct EdoFormatKindOf<const char *> { static const EdoFormatKind value = ArgChars; };
+        template<> struct EdoFormatKindOf<char *> { static const EdoFormatKind value = ArgChars; };
+        template<> struct EdoFormatKindOf<const utf8 *> { static const EdoFormatKind value = ArgUtf8; };
+        template<> struct EdoFormatKindOf<utf8 *> { static const EdoFormatKind value = ArgUtf8; };
+
+        //! The kinds of the arguments in a std::tuple, as the EDO_FORMAT macro sees them
+        template<typename Tuple>
+        struct EdoFormatKindsOf;
+
+        template<typename... Args>
+        struct EdoFormatKindsOf<std::tuple<Args...>> {
+            static const size_t count = sizeof...(Args);
+
+            static constexpr EdoFormatKind At(size_t idx) {
+                // One extra entry keeps the array from being empty
+                const EdoFormatKind kinds[] = {EdoFormatKindOf<Args>::value..., ArgNone};
+                return kinds[idx];
+            }
+        };
+
+        template<typename T>
+        inline EdoFormatArg MakeFormatArg(const T &value) {
+            static_assert(std::is_arithmetic<T>::value, "Format() takes EdoString, EdoStringView, std::string, char *, "
+                                                        "utf8 * and arithmetic arguments");
+            EdoFormatArg arg;
+            arg.kind = EdoFormatKindOf<T>::value;
+
+            if (std::is_floating_point<T>::value) {
+                if (arg.kind == ArgFloat)
+                    arg.f = (float) value;
+                else
+                    arg.d = (double) value;
+            } else if (std::is_signed<T>::value) {
+                arg.i = (int64_t) value;
+            } else {
+                arg.u = (uint64_t) value;
+            }
+
+            return arg;
+        }
+
+        inline EdoFormatArg MakeTextArg(EdoFormatKind kind, const void *data, size_t len) {
+            EdoFormatArg arg;
+            arg.kind = kind;
+            arg.text.data = data;
+            arg.text.len = len;
+            return arg;
+        }
+
+        inline EdoFormatArg MakeFormatArg(const EdoString &str) {
+            return MakeTextArg(ArgCodePoints, str.ptr(), str.Length());
+        }
+
+        inline EdoFormatArg MakeFormatArg(const EdoStringView &view) {
+            return MakeTextArg(ArgCodePoints, view.Data(), view.Length());
+        }
+
+        inline EdoFormatArg MakeFormatArg(const std::string &std_str) {
+            return MakeTextArg(ArgChars, std_str.data(), std_str.size());
+        }
+
+        inline EdoFormatArg MakeFormatArg(const char *chars) {
+            return MakeTextArg(ArgChars, chars, strlen(chars));
+        }
+
+        inline EdoFormatArg MakeFormatArg(char *chars) {
+            return MakeFormatArg((const char *) chars);
+        }
+
+        inline EdoFormatArg MakeFormatArg(const utf8 *utf8_str) {
+            return MakeTextArg(ArgUtf8, utf8_str, strlen((const char *) utf8_str));
+        }
+
+        inline EdoFormatArg MakeFormatArg(utf8 *utf8_str) {
+            return MakeFormatArg((const utf8 *) utf8_str);
+        }
+
+        //////////////////////////////////////////////
+        // Format strings
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * The parsed form of a replacement field, {[index][:[[fill]align][sign][#][0][width][.precision][type]]}
+         */
+        struct EdoFormatSpec {
+            size_t arg; //!< Index of the argument
+            utf32 fill; //!< Code point the field is padded with
+            char align; //!< '<', '>' or '^', or 0 for the default: numbers to the right, text to the left
+            char sign; //!< '+' or ' ' to write a sign (or a space) in front of positive numbers, 0 for '-' only
+            bool alternate; //!< '#': prefix the digits with 0x, 0X, 0 or 0b for the x, X, o and b types
+            bool zeroPad; //!< Pad numbers with zeros after the sign, when no alignment is given
+            size_t width; //!< Minimum width in code points, or STR_FORMAT_NONE
+            size_t precision; //!< Digits after the point for f and e, significant digits for g, most code points of text
+            char type; //!< Presentation type, 0 for the default of the argument
+        };
+
+        /*!
+         * \brief
+         * A format string: text with replacement fields such as {}, {1} or {:>8.3f}, and {{ and }} for braces. Fields
+         * are numbered automatically or all given an index, not both
+         *
+         * The presentation types are d, x, X, o and b for integers (and chars and bools), f, e, g, E and G for floating
+         * point numbers, s for text and bools, and c to write an integer as a code point. Without a type integers are
+         * written in decimal, floating point numbers with the shortest digits that read back as the same value
+         * (see FormatDouble()), and bools as "true" or "false". A # before the width adds the prefix of the base, as in
+         * {:#x} or {:#010b}, and is only accepted with the x, X, o and b types. The prefix goes between the sign and
+         * the zeros of zero padding, and an octal zero has none.
+         *
+         * The text outside the fields is char data taken as code points 0x00..0xFF, like the EdoString constructor
+         * that takes a C-string
+         * \note
+         * The constructor parses the whole string. It is constexpr, so a malformed literal is a compile error wherever
+         * the object is a constant expression (see EDO_FORMAT), and throws std::invalid_argument otherwise
+         */
+        class EdoFormatString {
+        public:
+            /*!
+             * \brief
+             * Parses and validates a format string
+             * \param format
+             * Null terminated format string, which has to outlive this object
+             * \exception std::invalid_argument
+             * Thrown if the format string is malformed
+             */
+            constexpr EdoFormatString(const char *format) : d_format(format), d_length(0), d_argCount(0) {
+                while (format[d_length] != 0)
+                    ++d_length;
+
+                size_t nextArg = 0;
+                bool manual = false;
+
+                for (size_t pos = 0; pos < d_length;) {
+                    EdoFormatSpec spec = {0, ' ', 0, 0, false, false, STR_FORMAT_NONE, STR_FORMAT_NONE, 0};
+                    size_t next = Next(pos, spec, nextArg, manual);
+
+                    if (next != pos && spec.arg != STR_FORMAT_NONE && spec.arg + 1 > d_argCount)
+                        d_argCount = spec.arg + 1;
+
+                    pos = next;
+                }
+            }
+
+            //! Return the format string
+            constexpr const char *Data() const { return d_format; }
+
+            //! Return the number of arguments the format string refers to
+            constexpr size_t ArgCount() const { return d_argCount; }
+
+            /*!
+             * \brief
+             * Return true if the arguments described by Kinds (see EdoFormatKindsOf) suit the fields: there are as many
+             * as the fields refer to, and every field has a presentation type its argument accepts
+             */
+            template<typename Kinds>
+            constexpr bool Check() const {
+                if (Kinds::count != d_argCount)
+                    return false;
+
+                size_t nextArg = 0;
+                bool manual = false;
+
+                for (size_t pos = 0; pos < d_length;) {
+                    EdoFormatSpec spec = {0, ' ', 0, 0, false, false, STR_FORMAT_NONE, STR_FORMAT_NONE, 0};
+                    pos = Next(pos, spec, nextArg, manual);
+
+                    if (spec.arg != STR_FORMAT_NONE && !Accepts(Kinds::At(spec.arg), spec))
+                        return false;
+                }
+
+                return true;
+            }
+
+            /*!
+             * \brief
+             * Reads the piece of the format string that starts at \a pos: a run of text, an escaped brace, or a
+             * replacement field
+             * \param pos
+             * Offset of the piece in the format string
+             * \param spec
+             * Receives the parsed field. Its arg member is STR_FORMAT_NONE if the piece is text, which then ends where
+             * the returned offset starts (less the second brace of an escape)
+             * \param nextArg
+             * Index of the next automatically numbered field, updated for every field
+             * \param manual
+             * Set once a field with an index has been read
+             * \return
+             * Offset of the next piece
+             * \exception std::invalid_argument
+             * Thrown if the piece is malformed
+             */
+            constexpr size_t Next(size_t pos, EdoFormatSpec &spec, size_t &nextArg, bool &manual) const {
+                spec.arg = STR_FORMAT_NONE;
+                const char c = d_format[pos];
+
+                if (c == '}') {
+                    if (pos + 1 >= d_length || d_format[pos + 1] != '}')
+                        throw std::invalid_argument("Unmatched '}' in format string");
+
+                    return pos + 2;
+                }
+
+                if (c != '{') {
+                    while (pos < d_length && d_format[pos] != '{' && d_format[pos] != '}')
+                        ++pos;
+
+                    return pos;
+                }
+
+                if (++pos < d_length && d_format[pos] == '{')
+                    return pos + 1;
+
+                // The argument index, if any
+                if (pos < d_length && IsDigit(d_format[pos])) {
+                    if (nextArg != 0 && !manual)
+                        throw std::invalid_argument("Format string mixes automatic and manual field numbering");
+
+                    manual = true;
+                    spec.arg = ReadNumber(pos);
+                } else {
+                    if (manual)
+                        throw std::invalid_argument("Format string mixes automatic and manual field numbering");
+
+                    spec.arg = nextArg++;
+                }
+
+                if (pos < d_length && d_format[pos] == ':')
+                    pos = ReadSpec(pos + 1, spec);
+
+                if (pos >= d_length || d_format[pos] != '}')
+                    throw std::invalid_argument("Unterminated or malformed field in format string");
+
+                return pos + 1;
+            }
+
+            //! Return true if an argument of the given kind can be written as the field describes
+            static constexpr bool Accepts(EdoFormatKind kind, const EdoFormatSpec &spec) {
+                const bool isInteger = kind == ArgInt || kind == ArgUInt || kind == ArgBool || kind == ArgChar;
+                const bool isFloat = kind == ArgFloat || kind == ArgDouble;
+                const bool isText = kind == ArgCodePoints || kind == ArgUtf8 || kind == ArgChars;
+
+                // The alternate form is the prefix of a base, so only the types that write one take it
+                if (spec.alternate && spec.type != 'x' && spec.type != 'X' && spec.type != 'o' && spec.type != 'b')
+                    return false;
+
+                switch (spec.type) {
+                    case 0:
+                        break;
+                    case 'd':
+                    case 'x':
+                    case 'X':
+                    case 'o':
+                    case 'b':
+                        return isInteger && spec.precision == STR_FORMAT_NONE;
+                    case 'c':
+                        return (kind == ArgInt || kind == ArgUInt || kind == ArgChar) && !spec.sign &&
+                               !spec.zeroPad && spec.precision == STR_FORMAT_NONE;
+                    case 'f':
+                    case 'e':
+                    case 'g':
+                    case 'E':
+                    case 'G':
+                        return isFloat;
+                    case 's':
+                        return (isText || kind == ArgBool) && !spec.sign && !spec.zeroPad;
+                    default:
+                        return false;
+                }
+
+                // The default presentation: signs and zeros for numbers, a precision for text and floating point
+                if (isText || kind == ArgBool || kind == ArgChar)
+                    return !spec.sign && !spec.zeroPad && (isText || spec.precision == STR_FORMAT_NONE);
+
+                return kind != ArgNone && (isFloat || spec.precision == STR_FORMAT_NONE);
+            }
+
+        private:
+            const char *d_format; //!< The format string
+            size_t d_length; //!< Length of the format string in chars
+            size_t d_argCount; //!< Number of arguments the fields refer to
+
+            static constexpr bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+            // Read a decimal number at 'pos', moving past it
+            constexpr size_t ReadNumber(size_t &pos) const {
+                size_t value = 0;
+
+                for (; pos < d_length && IsDigit(d_format[pos]); ++pos) {
+                    if (value > 100000000)
+                        throw std::invalid_argument("Number too large in format string");
+
+                    value = value * 10 + (d_format[pos] - '0');
+                }
+
+                return value;
+            }
+
+            // Read the part of a field after the ':', up to the closing brace
+            constexpr size_t ReadSpec(size_t pos, EdoFormatSpec &spec) const {
+                // A fill code point is only there if an alignment follows it
+                if (pos + 1 < d_length && IsAlign(d_format[pos + 1]) && d_format[pos] != '{' && d_format[pos] != '}') {
+                    spec.fill = (utf32) (unsigned char) d_format[pos];
+                    spec.align = d_format[pos + 1];
+                    pos += 2;
+                } else if (pos < d_length && IsAlign(d_format[pos])) {
+                    spec.align = d_format[pos++];
+                }
+
+                if (pos < d_length && (d_format[pos] == '+' || d_format[pos] == ' '))
+                    spec.sign = d_format[pos++];
+
+                if (pos < d_length && d_format[pos] == '#') {
+                    spec.alternate = true;
+                    ++pos;
+                }
+
+                if (pos < d_length && d_format[pos] == '0') {
+                    spec.zeroPad = true;
+                    ++pos;
+                }
+
+                if (pos < d_length && IsDigit(d_format[pos]))
+                    spec.width = ReadNumber(pos);
+
+                if (pos < d_length && d_format[pos] == '.') {
+                    if (++pos >= d_length || !IsDigit(d_format[pos]))
+                        throw std::invalid_argument("Missing precision in format string");
+
+                    spec.precision = ReadNumber(pos);
+                }
+
+                if (pos < d_length && d_format[pos] != '}')
+                    spec.type = d_format[pos++];
+
+                return pos;
+            }
+
+            static constexpr bool IsAlign(char c) { return c == '<' || c == '>' || c == '^'; }
+        };
+
+        //////////////////////////////////////////////
+        // Formatting
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * Receives formatted output piece by piece, for callers that write it somewhere else than an EdoString
+         */
+        class EDO_API EdoFormatSink {
+        public:
+            virtual ~EdoFormatSink() {}
+
+            /*!
+             * \brief
+             * Called with each piece of the output, in order
+             * \param data
+             * Code points of the piece, only valid during the call
+             * \param len
+             * Number of code points in \a data
+             */
+            virtual void Write(const utf32 *data, size_t len) = 0;
+        };
+
+        /*!
+         * \brief
+         * Return the number of code points the formatted output takes
+         * \exception std::invalid_argument
+         * Thrown if a field refers to a missing argument, or has a presentation type its argument does not accept
+         */
+        EDO_API size_t FormattedLength(const EdoFormatString &fmt, const EdoFormatArg *args, size_t count);
+
+        /*!
+         * \brief
+         * Writes the formatted output to \a dest, which has room for FormattedLength() code points
+         */
+        EDO_API void FormatArgs(const EdoFormatString &fmt, const EdoFormatArg *args, size_t count, utf32 *dest);
+
+        /*!
+         * \brief
+         * Hands the formatted output to \a sink, through a small buffer
+         */
+        EDO_API void FormatArgs(const EdoFormatString &fmt, const EdoFormatArg *args, size_t count,
+                                EdoFormatSink &sink);
+
+        /*!
+         * \brief
+         * Return the text of \a fmt with its fields replaced by the arguments, see EdoFormatString. The length is
+         * measured first, so the result is allocated once, and no streams are involved
+         * \example_snippet_start
+         *      EdoString msg = Format("{} took {:.3f} ms", name, elapsed);
+         *      EdoString row = Format("{:<16}|{:>8}|{:08.2f}", label, count, ratio);
+         * \example_snippet_end
+         * \param fmt
+         * Format string
+         * \param args
+         * EdoString, EdoStringView, std::string, char * (code points 0x00..0xFF), utf8 * (decoded) or arithmetic values
+         * \return
+         * The formatted text
+         * \exception std::invalid_argument
+         * Thrown if the format string is malformed, or does not match the arguments. EDO_FORMAT turns these into
+         * compile errors
+         */
+        template<typename... Args>
+        inline EdoString Format(const EdoFormatString &fmt, const Args &... args) {
+            const EdoFormatArg packed[sizeof...(Args) + 1] = {MakeFormatArg(args)..., EdoFormatArg()};
+
+            EdoString result;
+            result.Resize(FormattedLength(fmt, packed, sizeof...(Args)));
+            FormatArgs(fmt, packed, sizeof...(Args), result.ptr());
+            return result;
+        }
+
+        /*!
+         * \brief
+         * Appends the formatted text to \a str, growing its buffer at most once. See Format()
+         * \return
+         * \a str after the append operation
+         */
+        template<typename... Args>
+        inline EdoString &FormatTo(EdoString &str, const EdoFormatString &fmt, const Args &... args) {
+            const EdoFormatArg packed[sizeof...(Args) + 1] = {MakeFormatArg(args)..., EdoFormatArg()};
+            const size_t start = str.Length();
+
+            str.Resize(start + FormattedLength(fmt, packed, sizeof...(Args)));
+            FormatArgs(fmt, packed, sizeof...(Args), str.ptr() + start);
+            return str;
+        }
+
+        /*!
+         * \brief
+         * Hands the formatted text to \a sink, without building a string. See Format()
+         */
+        template<typename... Args>
+        inline void FormatTo(EdoFormatSink &sink, const EdoFormatString &fmt, const Args &... args) {
+            const EdoFormatArg packed[sizeof...(Args) + 1] = {MakeFormatArg(args)..., EdoFormatArg()};
+            FormatArgs(fmt, packed, sizeof...(Args), sink);
+        }
+
+        // Used by EDO_FORMAT, once the format string has been checked against the arguments
+        template<bool Valid, typename... Args>
+        inline EdoString FormatChecked(const EdoFormatString &fmt, const Args &... args) {
+            static_assert(Valid, "The format string does not match the number or the types of the arguments");
+            return Format(fmt, args...);
+        }
+    } // Namespace Types
+} // Namespace Edo
+
+#endif // EDOCORE_EDOFORMAT_H
@@ -0,0 +1,122 @@
+// =============================================================================
+// EdoHash.cpp
+// Implements the byte range hash
+// =============================================================================
+
+#include "EdoHash.h"
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace Edo {
+    namespace Types {
+        ///////////////////////////////////////////////
+        // Helpers
+        ///////////////////////////////////////////////
+        // The constants and the structure of the function follow wyhash (final version 4, public domain)
+        static const uint64_t s_secret[4] = {0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL,
+                                             0x589965cc75374cc3ULL};
+
+        // Replaces a and b with the low and high half of their 128 bit product
+        static inline void Multiply(uint64_t &a, uint64_t &b) {
+#if defined(__SIZEOF_INT128__)
+            __uint128_t product = (__uint128_t) a * b;
+            a = (uint64_t) product;
+            b = (uint64_t) (product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            a = _umul128(a, b, &b);
+#else
+            uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t) a, lb = (uint32_t) b;
+            uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+            uint64_t t = rl + (rm0 << 32);
+            uint64_t carry = t < rl;
+            uint64_t lo = t + (rm1 << 32);
+            carry += lo < t;
+            a = lo;
+            b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+        }
+
+        static inline uint64_t Mix(uint64_t a, uint64_t b) {
+            Multiply(a, b);
+            return a ^ b;
+        }
+
+        // Unaligned little endian reads, memcpy compiles to a single load
+        static inline uint64_t Read64(const uint8_t *p) {
+            uint64_t v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        static inline uint64_t Read32(const uint8_t *p) {
+            uint32_t v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        // Reads one to three bytes
+        static inline uint64_t Read3(const uint8_t *p, size_t len) {
+            return ((uint64_t) p[0] << 16) | ((uint64_t) p[len >> 1] << 8) | p[len - 1];
+        }
+
+        ///////////////////////////////////////////////
+        // Hash
+        ///////////////////////////////////////////////
+        uint64_t HashBytes(const void *data, size_t len, uint64_t seed) {
+            const uint8_t *p = static_cast<const uint8_t *>(data);
+            uint64_t a, b;
+
+            seed ^= Mix(seed ^ s_secret[0], s_secret[1]);
+
+            if (len <= 16) {
+                if (len >= 4) {
+                    // Two overlapping pairs of 32 bit reads cover 4 to 16 bytes
+                    size_t step = (len >> 3) << 2;
+                    a = (Read32(p) << 32) | Read32(p + step);
+                    b = (Read32(p + len - 4) << 32) | Read32(p + len - 4 - step);
+                } else if (len > 0) {
+                    a = Read3(p, len);
+                    b = 0;
+                } else {
+                    a = b = 0;
+                }
+            } else {
+                size_t remaining = len;
+
+                if (remaining > 48) {
+                    // Three independent lanes keep the multipliers busy
+                    uint64_t seed1 = seed, seed2 = seed;
+
+                    do {
+                        seed = Mix(Read64(p) ^ s_secret[1], Read64(p + 8) ^ seed);
+                        seed1 = Mix(Read64(p + 16) ^ s_secret[2], Read64(p + 24) ^ seed1);
+                        seed2 = Mix(Read64(p + 32) ^ s_secret[3], Read64(p + 40) ^ seed2);
+                        p += 48;
+                        remaining -= 48;
+                    } while (remaining > 48);
+
+                    seed ^= seed1 ^ seed2;
+                }
+
+                while (remaining > 16) {
+                    seed = Mix(Read64(p) ^ s_secret[1], Read64(p + 8) ^ seed);
+                    p += 16;
+                    remaining -= 16;
+                }
+
+                // The last 16 bytes, overlapping what was already consumed if need be
+                a = Read64(p + remaining - 16);
+                b = Read64(p + remaining - 8);
+            }
+
+            a ^= s_secret[1];
+            b ^= seed;
+            Multiply(a, b);
+
+            return Mix(a ^ s_secret[0] ^ len, b ^ s_secret[1]);
+        }
+    } // Namespace Types
+} // Namespace Edo
@@ -0,0 +1,33 @@
+// =============================================================================
+// EdoHash.h
+// Fast non-cryptographic hashing of byte ranges, used to hash the string classes
+// =============================================================================
+
+#ifndef EDOCORE_EDOHASH_H
+#define EDOCORE_EDOHASH_H
+
+#include "EdoBase.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace Edo {
+    namespace Types {
+        /*!
+         * \brief
+         * Hashes a range of bytes with a wyhash style function: the input is consumed 16 or 48 bytes at a time, and
+         * mixed with 64 x 64 -> 128 bit multiplications. The quality is good enough for hash tables, but the function
+         * is not meant to resist attackers choosing the keys
+         * \param data
+         * Bytes to be hashed
+         * \param len
+         * Number of bytes in \a data
+         * \param seed
+         * Value mixed into the result, so different tables can use different hashes
+         * \return
+         * 64 bit hash of the data
+         */
+        EDO_API uint64_t HashBytes(const void *data, size_t len, uint64_t seed = 0);
+    } // Namespace Types
+} // Namespace Edo
+
+#endif // EDOCORE_EDOHASH_H
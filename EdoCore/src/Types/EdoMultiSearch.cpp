@@ -0,0 +1,249 @@
+// =============================================================================
+// EdoMultiSearch.cpp
+// Builds the Aho-Corasick automaton of EdoMultiSearcher
+// =============================================================================
+
+#include "EdoMultiSearch.h"
+#include <algorithm>
+#include <stdexcept>
+
+#define STR_MULTI_MAX_CLASSES 0xFFFF // Classes are stored in 16 bits, class 0 included
+
+namespace Edo {
+    namespace Types {
+        ///////////////////////////////////////////////
+        // Case folding
+        ///////////////////////////////////////////////
+        // Lower case form of a code point under simple one to one folding, or the code point itself. Covers ASCII,
+        // Latin-1, Latin Extended-A, basic Greek, basic Cyrillic and the fullwidth Latin letters, where both forms of
+        // a letter always have utf8 sequences of the same length
+        static utf32 FoldCase(utf32 cp) {
+            if (cp < 0x80)
+                return (cp >= 'A' && cp <= 'Z') ? cp + 0x20 : cp;
+
+            if (cp < 0x100)
+                return (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) ? cp + 0x20 : cp;
+
+            if (cp < 0x180) {
+                // Dotted and dotless i, kra, n preceded by apostrophe and long s have no one to one pair
+                if (cp == 0x130 || cp == 0x131 || cp == 0x138 || cp == 0x149 || cp == 0x17F)
+                    return cp;
+
+                if (cp == 0x178)
+                    return 0xFF;
+
+                // Upper case letters are on even code points, except in the two runs where they are on odd ones
+                bool oddUpper = (cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E);
+                return ((cp & 1) == (oddUpper ? 1u : 0u)) ? cp + 1 : cp;
+            }
+
+            if (cp >= 0x391 && cp <= 0x3AB && cp != 0x3A2)
+                return cp + 0x20;
+
+            if (cp == 0x3C2) // Final sigma
+                return 0x3C3;
+
+            if (cp >= 0x410 && cp <= 0x42F)
+                return cp + 0x20;
+
+            if (cp >= 0x400 && cp <= 0x40F)
+                return cp + 0x50;
+
+            if (cp >= 0xFF21 && cp <= 0xFF3A)
+                return cp + 0x20;
+
+            return cp;
+        }
+
+        // Ranges holding every code point FoldCase() changes
+        static const utf32 s_foldRanges[][2] = {{0x41,   0xDE},
+                                                {0x100,  0x17F},
+                                                {0x391,  0x3C2},
+                                                {0x400,  0x42F},
+                                                {0xFF21, 0xFF3A}};
+
+        ///////////////////////////////////////////////
+        // Construction
+        ///////////////////////////////////////////////
+        EdoMultiSearcher::EdoMultiSearcher(const EdoStringView *patterns, size_t count, EdoCaseMode mode)
+                : d_mode(mode), d_width(1), d_pages(), d_classes(256, 0) {
+            // Fold the patterns, and number their distinct code points from 1 in code point order
+            std::vector<utf32> text;
+
+            for (size_t p = 0; p < count; ++p) {
+                for (utf32 cp : patterns[p])
+                    text.push_back(mode == CaseInsensitive ? FoldCase(cp) : cp);
+            }
+
+            std::vector<utf32> symbols(text);
+            std::sort(symbols.begin(), symbols.end());
+            symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+
+            if (symbols.size() >= STR_MULTI_MAX_CLASSES)
+                throw std::length_error("Too many distinct code points in the patterns of EdoMultiSearcher");
+
+            d_width = (uint32_t) symbols.size() + 1;
+
+            auto setClass = [this](utf32 cp, uint32_t cls) {
+                if (cp >= 0x10000) {
+                    d_supplementary.push_back(std::make_pair(cp, cls));
+                    return;
+                }
+
+                if (d_pages[cp >> 8] == 0) {
+                    d_pages[cp >> 8] = (uint32_t) d_classes.size();
+                    d_classes.resize(d_classes.size() + 256, 0);
+                }
+
+                d_classes[d_pages[cp >> 8] + (cp & 0xFF)] = (uint16_t) cls;
+            };
+
+            auto classOf = [&symbols](utf32 cp) -> uint32_t {
+                std::vector<utf32>::const_iterator it = std::lower_bound(symbols.begin(), symbols.end(), cp);
+                return (it != symbols.end() && *it == cp) ? (uint32_t) (it - symbols.begin()) + 1 : 0;
+            };
+
+            for (size_t s = 0; s < symbols.size(); ++s)
+                setClass(symbols[s], (uint32_t) s + 1);
+
+            // Give the other case forms the class of their folded form. All of them are in the BMP
+            if (mode == CaseInsensitive) {
+                for (const utf32 *range : s_foldRanges) {
+                    for (utf32 cp = range[0]; cp <= range[1]; ++cp) {
+                        utf32 folded = FoldCase(cp);
+                        uint32_t cls = (folded != cp) ? classOf(folded) : 0;
+
+                        if (cls != 0)
+                            setClass(cp, cls);
+                    }
+                }
+            }
+
+            // Build the trie, with dense rows of plain state numbers, 0 (the root) standing for no child
+            std::vector<uint32_t> trie(d_width, 0);
+            d_firstPattern.assign(1, STR_MULTI_NONE);
+            d_nextPattern.assign(count, STR_MULTI_NONE);
+            d_lengths.resize(count);
+            d_utf8Lengths.resize(count);
+
+            const utf32 *folded = text.data();
+
+            for (size_t p = 0; p < count; ++p) {
+                const size_t len = patterns[p].Length();
+
+                d_lengths[p] = len;
+                d_utf8Lengths[p] = patterns[p].Utf8Length();
+
+                if (len == 0)
+                    continue;
+
+                uint32_t state = 0;
+
+                for (size_t i = 0; i < len; ++i) {
+                    uint32_t &child = trie[(size_t) state * d_width + classOf(folded[i])];
+
+                    if (child == 0) {
+                        size_t states = d_firstPattern.size();
+
+                        if ((states + 1) * d_width >= STR_MULTI_OUTPUT)
+                            throw std::length_error("The automaton of EdoMultiSearcher would be too large");
+
+                        child = (uint32_t) states;
+                        d_firstPattern.push_back(STR_MULTI_NONE);
+                        trie.resize(trie.size() + d_width, 0);
+                    }
+
+                    // The resize may have moved the row, so read the child again
+                    state = trie[(size_t) state * d_width + classOf(folded[i])];
+                }
+
+                folded += len;
+
+                // Keep the patterns ending in one state in the order they were given
+                uint32_t *link = &d_firstPattern[state];
+
+                while (*link != STR_MULTI_NONE)
+                    link = &d_nextPattern[*link];
+
+                *link = (uint32_t) p;
+            }
+
+            // Breadth first, fill in the missing transitions from the failure state, whose row is already complete,
+            // and link each state to the longest suffix state where a pattern ends
+            const size_t states = d_firstPattern.size();
+            std::vector<uint32_t> fail(states, 0);
+            std::vector<uint32_t> queue;
+            queue.reserve(states);
+            d_dictLink.assign(states, STR_MULTI_NONE);
+
+            for (uint32_t sym = 0; sym < d_width; ++sym) {
+                if (trie[sym] != 0)
+                    queue.push_back(trie[sym]);
+            }
+
+            for (size_t q = 0; q < queue.size(); ++q) {
+                const uint32_t state = queue[q];
+                uint32_t *row = &trie[(size_t) state * d_width];
+                const uint32_t *failRow = &trie[(size_t) fail[state] * d_width];
+
+                for (uint32_t sym = 0; sym < d_width; ++sym) {
+                    if (row[sym] == 0) {
+                        row[sym] = failRow[sym];
+                        continue;
+                    }
+
+                    const uint32_t child = row[sym];
+                    const uint32_t suffix = failRow[sym];
+
+                    fail[child] = suffix;
+                    d_dictLink[child] = (d_firstPattern[suffix] != STR_MULTI_NONE) ? suffix : d_dictLink[suffix];
+                    queue.push_back(child);
+                }
+            }
+
+            // Premultiply the targets, and flag those where a pattern ends
+            d_table.resize(trie.size());
+
+            for (size_t i = 0; i < trie.size(); ++i) {
+                const uint32_t target = trie[i];
+                const bool output = d_firstPattern[target] != STR_MULTI_NONE || d_dictLink[target] != STR_MULTI_NONE;
+
+                d_table[i] = target * d_width | (output ? STR_MULTI_OUTPUT : 0);
+            }
+        }
+
+        ///////////////////////////////////////////////
+        // Searching
+        ///////////////////////////////////////////////
+        uint32_t EdoMultiSearcher::SupplementarySymbol(utf32 code_point) const {
+            std::vector<std::pair<utf32, uint32_t>>::const_iterator it =
+                    std::lower_bound(d_supplementary.begin(), d_supplementary.end(), std::make_pair(code_point, 0u));
+
+            return (it != d_supplementary.end() && it->first == code_point) ? it->second : 0;
+        }
+
+        bool EdoMultiSearcher::FindFirst(EdoStringView text, EdoMultiMatch &match) const {
+            bool found = false;
+
+            FindAll(text, [&](const EdoMultiMatch &m) {
+                match = m;
+                found = true;
+                return false;
+            });
+
+            return found;
+        }
+
+        bool EdoMultiSearcher::FindFirst(const utf8 *src, size_t len, EdoMultiMatch &match) const {
+            bool found = false;
+
+            FindAll(src, len, [&](const EdoMultiMatch &m) {
+                match = m;
+                found = true;
+                return false;
+            });
+
+            return found;
+        }
+    } // Namespace Types
+} // Namespace Edo
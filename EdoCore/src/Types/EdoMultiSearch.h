@@ -0,0 +1,442 @@
+// =============================================================================
+// EdoMultiSearch.h
+// Defines an Aho-Corasick automaton which finds many patterns in utf32 or utf8 text in a single pass
+// =============================================================================
+
+#ifndef EDOCORE_EDOMULTISEARCH_H
+#define EDOCORE_EDOMULTISEARCH_H
+
+#include "EdoBase.h"
+#include "EdoStringView.h"
+#include "EdoUtf.h"
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#define STR_MULTI_NONE ((uint32_t) -1) // No pattern, or no state, in the tables of EdoMultiSearcher
+#define STR_MULTI_OUTPUT ((uint32_t) 1 << 31) // Flag on a transition whose target state ends at least one pattern
+
+namespace Edo {
+    namespace Types {
+        /*!
+         * \brief
+         * Whether EdoMultiSearcher tells upper and lower case apart
+         */
+        enum EdoCaseMode {
+            CaseSensitive, //!< Patterns match exactly
+            CaseInsensitive //!< Patterns match whatever the case of their letters, with simple one to one folding
+        };
+
+        /*!
+         * \brief
+         * A match reported by EdoMultiSearcher. Positions are in code points for utf32 text and in code units for
+         * utf8 text, counted from the start of the text (or of the stream)
+         */
+        struct EdoMultiMatch {
+            size_t pattern; //!< Index of the pattern that matched, in the order the patterns were given
+            size_t start; //!< Position of the first code point of the match
+            size_t end; //!< Position just past the last code point of the match
+        };
+
+        /*!
+         * \brief
+         * Many patterns compiled into one Aho-Corasick automaton, to find all of them in a text with a single pass
+         * over it, whatever their number. Meant for filtering log lines or chat messages against a keyword list,
+         * where one Find() per keyword per line would read every line once per keyword.
+         *
+         * The automaton is a complete DFA, so each code point of the text costs one table lookup. The code points
+         * that appear in the patterns are numbered densely (through a two level table for the BMP) and every other
+         * code point shares class 0, so a row of the table only has one entry per distinct pattern code point. The
+         * entries are premultiplied row offsets, with STR_MULTI_OUTPUT set on those leading to a state where some
+         * pattern ends. In CaseInsensitive mode both cases of a letter get the same class, so the text is never
+         * folded.
+         *
+         * Every occurrence of every pattern is reported, overlapping ones included, in the order of their end
+         * positions. utf8 text is decoded as it is searched; a malformed sequence reads as one UTF_REPLACEMENT_CHAR,
+         * the same as in an EdoString decoded from that text. Empty patterns never match.
+         *
+         * The searcher is not changed by searching, so one searcher can be used from several threads at once.
+         * \note
+         * Case folding covers ASCII, Latin-1, Latin Extended-A, Greek, Cyrillic and the fullwidth Latin letters.
+         * Both forms of each of those letters have utf8 sequences of the same length, so the start of a case
+         * insensitive match in utf8 text is exact too.
+         * \example_snippet_start
+         *      const EdoMultiSearcher keywords({EdoString("error"), EdoString("fatal"), EdoString("panic")},
+         *                                      CaseInsensitive);
+         *
+         *      for (const EdoString &line : lines)
+         *          if (keywords.Contains(line))
+         *              flagged.push_back(line);
+         * \example_snippet_end
+         */
+        class EDO_API EdoMultiSearcher {
+        public:
+            /*!
+             * \brief
+             * Compiles the automaton for the given patterns
+             * \param patterns
+             * Array of the patterns to search for. They are copied, so they need not outlive the searcher
+             * \param count
+             * Number of patterns in \a patterns
+             * \param mode
+             * Whether matches have to agree in case
+             * \exception
+             * std::length_error Thrown if the patterns hold more than 65535 distinct code points, or if the table
+             * would be too large to index
+             */
+            EdoMultiSearcher(const EdoStringView *patterns, size_t count, EdoCaseMode mode = CaseSensitive);
+
+            /*!
+             * \brief
+             * Compiles the automaton for the given patterns (see EdoMultiSearcher(const EdoStringView *, size_t,
+             * EdoCaseMode))
+             */
+            explicit EdoMultiSearcher(std::initializer_list<EdoStringView> patterns, EdoCaseMode mode = CaseSensitive)
+                    : EdoMultiSearcher(patterns.begin(), patterns.size(), mode) {}
+
+            /*!
+             * \brief
+             * Return the number of patterns the searcher was built with
+             */
+            size_t PatternCount() const { return d_lengths.size(); }
+
+            /*!
+             * \brief
+             * Return the number of states of the automaton
+             */
+            size_t StateCount() const { return d_firstPattern.size(); }
+
+            /*!
+             * \brief
+             * Return the size of the transition table in bytes
+             */
+            size_t TableBytes() const { return d_table.size() * sizeof(uint32_t); }
+
+            /*!
+             * \brief
+             * Return whether the searcher ignores case
+             */
+            EdoCaseMode CaseMode() const { return d_mode; }
+
+            //////////////////////////////////////////////
+            // Searching
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Calls \a on_match for every occurrence of every pattern in \a text
+             * \param text
+             * utf32 text to be searched
+             * \param on_match
+             * Callable taking a const EdoMultiMatch &, returning false to stop the search
+             * \return
+             * false if \a on_match stopped the search, true otherwise
+             */
+            template<typename F>
+            bool FindAll(EdoStringView text, F on_match) const {
+                uint32_t state = 0;
+                return Scan(text.Data(), text.Length(), 0, state, on_match);
+            }
+
+            /*!
+             * \brief
+             * Calls \a on_match for every occurrence of every pattern in the utf8 text \a src. Positions are in code
+             * units
+             * \param src
+             * utf8 text to be searched
+             * \param len
+             * Number of code units in \a src
+             * \param on_match
+             * Callable taking a const EdoMultiMatch &, returning false to stop the search
+             * \return
+             * false if \a on_match stopped the search, true otherwise
+             */
+            template<typename F>
+            bool FindAll(const utf8 *src, size_t len, F on_match) const {
+                uint32_t state = 0;
+                size_t used = 0;
+                return ScanUtf8(src, len, 0, state, on_match, used, false);
+            }
+
+            /*!
+             * \brief
+             * Return the match which ends first in \a text (the longest one if several end there)
+             * \return
+             * true if a pattern was found, and \a match was set
+             */
+            bool FindFirst(EdoStringView text, EdoMultiMatch &match) const;
+
+            /*!
+             * \brief
+             * Return the match which ends first in the utf8 text \a src (the longest one if several end there)
+             * \return
+             * true if a pattern was found, and \a match was set
+             */
+            bool FindFirst(const utf8 *src, size_t len, EdoMultiMatch &match) const;
+
+            /*!
+             * \brief
+             * Return true if any of the patterns occurs in \a text. The search stops at the first match
+             */
+            bool Contains(EdoStringView text) const {
+                EdoMultiMatch match;
+                return FindFirst(text, match);
+            }
+
+            /*!
+             * \brief
+             * Return true if any of the patterns occurs in the utf8 text \a src. The search stops at the first match
+             */
+            bool Contains(const utf8 *src, size_t len) const {
+                EdoMultiMatch match;
+                return FindFirst(src, len, match);
+            }
+
+            //////////////////////////////////////////////
+            // Streaming
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Searches a text that arrives in chunks, such as a log file read block by block. The stream keeps the
+             * state of the automaton between chunks, so matches that straddle a chunk boundary are found, with
+             * positions counted from the start of the stream. A utf8 sequence cut by a chunk boundary is held back
+             * until the next chunk completes it.
+             *
+             * A stream refers to its searcher, which must outlive it. Feed either utf32 or utf8 chunks to a given
+             * stream, not both, as positions count whatever units were fed.
+             * \example_snippet_start
+             *      EdoMultiSearcher::Stream stream(keywords);
+             *
+             *      while (size_t got = fread(block, 1, sizeof(block), file))
+             *          stream.Feed(block, got, [&](const EdoMultiMatch &m) { hits.push_back(m); return true; });
+             *
+             *      stream.Finish([&](const EdoMultiMatch &m) { hits.push_back(m); return true; });
+             * \example_snippet_end
+             */
+            class Stream {
+            public:
+                /*!
+                 * \brief
+                 * Starts a stream at position 0
+                 */
+                explicit Stream(const EdoMultiSearcher &searcher)
+                        : d_searcher(&searcher), d_state(0), d_position(0), d_pendingLen(0) {}
+
+                /*!
+                 * \brief
+                 * Searches the next chunk of utf32 text
+                 * \return
+                 * false if \a on_match stopped the search. The rest of the chunk is not searched then
+                 */
+                template<typename F>
+                bool Feed(EdoStringView chunk, F on_match) {
+                    bool more = d_searcher->Scan(chunk.Data(), chunk.Length(), d_position, d_state, on_match);
+                    d_position += chunk.Length();
+                    return more;
+                }
+
+                /*!
+                 * \brief
+                 * Searches the next chunk of utf8 text. A sequence cut at the end of the chunk waits for the next one
+                 * \return
+                 * false if \a on_match stopped the search. The rest of the chunk is not searched then
+                 */
+                template<typename F>
+                bool Feed(const utf8 *chunk, size_t len, F on_match) {
+                    size_t at = 0;
+
+                    // Complete a sequence left over from the previous chunk, one code unit at a time
+                    while (d_pendingLen != 0 && at < len) {
+                        d_pending[d_pendingLen++] = chunk[at++];
+
+                        utf32 cp;
+                        size_t bad;
+                        size_t size = DecodeUtf8One(d_pending, d_pendingLen, cp, bad);
+
+                        if (size == 0 && bad == d_pendingLen)
+                            continue;
+
+                        if (size == 0) {
+                            // The new code unit does not continue the sequence: what came before is malformed, and
+                            // the new code unit is read again as part of the chunk
+                            size = bad;
+                            cp = UTF_REPLACEMENT_CHAR;
+                            --at;
+                        }
+
+                        d_pendingLen = 0;
+                        d_position += size;
+
+                        if (!d_searcher->Step(d_state, cp, d_position, on_match))
+                            return false;
+                    }
+
+                    size_t used = 0;
+                    bool more = d_searcher->ScanUtf8(chunk + at, len - at, d_position, d_state, on_match, used, true);
+                    d_position += used;
+
+                    // Hold back a sequence cut by the end of the chunk
+                    while (more && at + used < len)
+                        d_pending[d_pendingLen++] = chunk[at + used++];
+
+                    return more;
+                }
+
+                /*!
+                 * \brief
+                 * Ends the stream: a utf8 sequence still waiting to be completed is read as malformed
+                 * \return
+                 * false if \a on_match stopped the search
+                 */
+                template<typename F>
+                bool Finish(F on_match) {
+                    if (d_pendingLen == 0)
+                        return true;
+
+                    d_position += d_pendingLen;
+                    d_pendingLen = 0;
+                    return d_searcher->Step(d_state, UTF_REPLACEMENT_CHAR, d_position, on_match);
+                }
+
+                /*!
+                 * \brief
+                 * Starts the stream over, at position 0
+                 */
+                void Reset() {
+                    d_state = 0;
+                    d_position = 0;
+                    d_pendingLen = 0;
+                }
+
+                /*!
+                 * \brief
+                 * Return the number of code points, or code units, fed so far, not counting a held back sequence
+                 */
+                size_t Position() const { return d_position; }
+
+            private:
+                const EdoMultiSearcher *d_searcher; //!< Automaton being run
+                uint32_t d_state; //!< Current state, as a row offset in the transition table
+                size_t d_position; //!< Units read so far
+                utf8 d_pending[4]; //!< Start of a utf8 sequence cut by the end of the last chunk
+                size_t d_pendingLen; //!< Number of code units in d_pending
+            };
+
+        private:
+            // Return the class of a code point, 0 for the code points in no pattern
+            uint32_t Symbol(utf32 code_point) const {
+                if (code_point < 0x10000)
+                    return d_classes[d_pages[code_point >> 8] + (code_point & 0xFF)];
+
+                return SupplementarySymbol(code_point);
+            }
+
+            // Class of a code point above the BMP, found by binary search
+            uint32_t SupplementarySymbol(utf32 code_point) const;
+
+            // Report the patterns ending in 'state' at position 'end'. Returns false when on_match does
+            template<typename F>
+            bool Report(uint32_t state, size_t end, bool utf8_units, F &on_match) const {
+                for (uint32_t s = state / d_width; s != STR_MULTI_NONE; s = d_dictLink[s]) {
+                    for (uint32_t p = d_firstPattern[s]; p != STR_MULTI_NONE; p = d_nextPattern[p]) {
+                        EdoMultiMatch match;
+                        match.pattern = p;
+                        match.start = end - (utf8_units ? d_utf8Lengths[p] : d_lengths[p]);
+                        match.end = end;
+
+                        if (!on_match(match))
+                            return false;
+                    }
+                }
+
+                return true;
+            }
+
+            // Move over one code point of utf8 text, which ends at 'end'
+            template<typename F>
+            bool Step(uint32_t &state, utf32 code_point, size_t end, F &on_match) const {
+                uint32_t next = d_table[state + Symbol(code_point)];
+                state = next & ~STR_MULTI_OUTPUT;
+                return (next & STR_MULTI_OUTPUT) == 0 || Report(state, end, true, on_match);
+            }
+
+            // Run the automaton over utf32 text starting at position 'base'
+            template<typename F>
+            bool Scan(const utf32 *src, size_t len, size_t base, uint32_t &state, F &on_match) const {
+                const uint32_t *table = d_table.data();
+                uint32_t at = state;
+
+                for (size_t i = 0; i < len; ++i) {
+                    uint32_t next = table[at + Symbol(src[i])];
+                    at = next & ~STR_MULTI_OUTPUT;
+
+                    if ((next & STR_MULTI_OUTPUT) && !Report(at, base + i + 1, false, on_match)) {
+                        state = at;
+                        return false;
+                    }
+                }
+
+                state = at;
+                return true;
+            }
+
+            // Run the automaton over utf8 text starting at position 'base'. 'used' receives the number of code units
+            // read: all of them, unless 'keep_tail' leaves a sequence cut by the end of the text unread
+            template<typename F>
+            bool ScanUtf8(const utf8 *src, size_t len, size_t base, uint32_t &state, F &on_match, size_t &used,
+                          bool keep_tail) const {
+                const uint32_t *table = d_table.data();
+                uint32_t at = state;
+                size_t i = 0;
+
+                while (i < len) {
+                    utf32 cp = src[i];
+                    size_t size = 1;
+
+                    if (cp >= 0x80) {
+                        size_t bad;
+                        size = DecodeUtf8One(src + i, len - i, cp, bad);
+
+                        if (size == 0) {
+                            if (keep_tail && bad == len - i && src[i] >= 0xC2 && src[i] <= 0xF4)
+                                break;
+
+                            size = bad;
+                            cp = UTF_REPLACEMENT_CHAR;
+                        }
+                    }
+
+                    i += size;
+
+                    uint32_t next = table[at + Symbol(cp)];
+                    at = next & ~STR_MULTI_OUTPUT;
+
+                    if ((next & STR_MULTI_OUTPUT) && !Report(at, base + i, true, on_match)) {
+                        state = at;
+                        used = i;
+                        return false;
+                    }
+                }
+
+                state = at;
+                used = i;
+                return true;
+            }
+
+            EdoCaseMode d_mode; //!< Whether case is ignored
+            uint32_t d_width; //!< Number of classes, the length of a row of the transition table
+            uint32_t d_pages[256]; //!< Offset in d_classes of the class table of each 256 code point page of the BMP
+            std::vector<uint16_t> d_classes; //!< Class tables of the BMP pages, after one of zeroes shared by unused pages
+            std::vector<std::pair<utf32, uint32_t>> d_supplementary; //!< Sorted classes of code points above the BMP
+            std::vector<uint32_t> d_table; //!< Transitions, d_width per state, as row offsets with STR_MULTI_OUTPUT
+            std::vector<uint32_t> d_firstPattern; //!< Per state, the first pattern ending there, or STR_MULTI_NONE
+            std::vector<uint32_t> d_dictLink; //!< Per state, the longest proper suffix state ending some pattern
+            std::vector<uint32_t> d_nextPattern; //!< Per pattern, the next one ending in the same state
+            std::vector<size_t> d_lengths; //!< Per pattern, its length in code points
+            std::vector<size_t> d_utf8Lengths; //!< Per pattern, its length in utf8 code units
+        };
+    } // Namespace Types
+} // Namespace Edo
+
+#endif // EDOCORE_EDOMULTISEARCH_H
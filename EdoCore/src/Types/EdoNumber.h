@@ -0,0 +1,265 @@
+// =============================================================================
+// EdoNumber.h
+// Allocation free formatting of numbers into caller buffers, and parsing of numbers from utf32 data
+// =============================================================================
+
+#ifndef EDOCORE_EDONUMBER_H
+#define EDOCORE_EDONUMBER_H
+
+#include "EdoBase.h"
+#include "EdoStringView.h"
+#include "EdoUtf.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#define STR_NUMBER_CHARS 32 // Room the number formatting functions may need, they do not write a null terminator
+
+namespace Edo {
+    namespace Types {
+        //////////////////////////////////////////////
+        // Formatting
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * Writes the decimal representation of a signed integer
+         * \param value
+         * Integer to be written
+         * \param dest
+         * Buffer receiving the characters, with room for at least STR_NUMBER_CHARS of them. No null is written
+         * \return
+         * Number of characters written to \a dest
+         */
+        EDO_API size_t FormatInt64(int64_t value, char *dest);
+
+        /*!
+         * \brief
+         * Writes the decimal representation of an unsigned integer, see FormatInt64()
+         */
+        EDO_API size_t FormatUInt64(uint64_t value, char *dest);
+
+        /*!
+         * \brief
+         * Writes the shortest decimal representation that reads back as exactly \a value (Grisu2, with the few values
+         * it cannot prove shortest checked by parsing shorter candidates back)
+         * \note
+         * Numbers from 1e-6 up to, but not including, 1e21 are written in fixed notation ("0.001", "3.25", "100"),
+         * the others in scientific notation ("1e+21", "2.5e-8"). Infinities and NaN are written as "inf", "-inf" and
+         * "nan"
+         * \param value
+         * Number to be written
+         * \param dest
+         * Buffer receiving the characters, with room for at least STR_NUMBER_CHARS of them. No null is written
+         * \return
+         * Number of characters written to \a dest
+         */
+        EDO_API size_t FormatDouble(double value, char *dest);
+
+        /*!
+         * \brief
+         * Writes the shortest decimal representation that reads back as exactly \a value when parsed as a float, see
+         * FormatDouble()
+         */
+        EDO_API size_t FormatFloat(float value, char *dest);
+
+        /*!
+         * \brief
+         * Writes the decimal representation of any integer or floating point value, see FormatInt64() and
+         * FormatDouble(). long double values are written with the precision of a double
+         * \example_snippet_start
+         *      char buff[STR_NUMBER_CHARS];
+         *      fwrite(buff, 1, FormatNumber(elapsed, buff), file);
+         * \example_snippet_end
+         * \return
+         * Number of characters written to \a dest
+         */
+        template<typename T>
+        inline size_t FormatNumber(T value, char *dest) {
+            static_assert(std::is_arithmetic<T>::value, "FormatNumber() takes integer and floating point values");
+
+            if (std::is_floating_point<T>::value)
+                return sizeof(T) == sizeof(float) ? FormatFloat((float) value, dest)
+                                                  : FormatDouble((double) value, dest);
+
+            return std::is_signed<T>::value ? FormatInt64((int64_t) value, dest) : FormatUInt64((uint64_t) value, dest);
+        }
+
+        /*!
+         * \brief
+         * Writes the decimal representation of any integer or floating point value as code points, see FormatNumber()
+         * \example_snippet_start
+         *      utf32 buff[STR_NUMBER_CHARS];
+         *      str.Append(EdoStringView(buff, FormatNumber(count, buff)));
+         * \example_snippet_end
+         */
+        template<typename T>
+        inline size_t FormatNumber(T value, utf32 *dest) {
+            char buff[STR_NUMBER_CHARS];
+            size_t len = FormatNumber(value, buff);
+
+            for (size_t i = 0; i < len; ++i)
+                dest[i] = (utf32) buff[i];
+
+            return len;
+        }
+
+        //////////////////////////////////////////////
+        // Parsing
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * Reads a decimal integer, made of an optional sign and at least one digit, from the start of \a src
+         * \param src
+         * utf32 data to be read
+         * \param len
+         * Number of code points in \a src
+         * \param magnitude
+         * Receives the absolute value of the integer
+         * \param negative
+         * Receives true if the integer has a minus sign
+         * \param overflow
+         * Receives true if the magnitude does not fit in 64 bits, in which case \a magnitude is meaningless
+         * \return
+         * Number of code points read, or 0 if \a src does not start with an integer
+         */
+        EDO_API size_t ScanInteger(const utf32 *src, size_t len, uint64_t &magnitude, bool &negative, bool &overflow);
+
+        /*!
+         * \brief
+         * Reads a decimal floating point number ("12", "-0.5", ".5e3", "1E-7", "inf", "nan", ...) from the start of
+         * \a src. The result is correctly rounded
+         * \note
+         * Numbers whose digits fit in 53 bits, with a power of ten of at most 22 either way, are converted directly.
+         * The others go through the Eisel-Lemire algorithm on their first 19 significant digits, and when the digits
+         * past those could change the rounding, through an exact comparison of the digits with a big integer. No
+         * long double, locale or allocation is involved
+         * \param src
+         * utf32 data to be read
+         * \param len
+         * Number of code points in \a src
+         * \param value
+         * Receives the number
+         * \param overflow
+         * Receives true if the number is too large to be represented, in which case \a value is an infinity
+         * \return
+         * Number of code points read, or 0 if \a src does not start with a number
+         */
+        EDO_API size_t ScanDouble(const utf32 *src, size_t len, double &value, bool &overflow);
+
+        /*!
+         * \brief
+         * Reads a floating point number and rounds it to a float, see ScanDouble()
+         */
+        EDO_API size_t ScanFloat(const utf32 *src, size_t len, float &value, bool &overflow);
+
+        // Read a number of type T from the start of the data. Returns the number of code points read, 0 if there is no
+        // number. 'overflow' is set when the number does not fit in T
+        template<typename T>
+        inline typename std::enable_if<std::is_integral<T>::value, size_t>::type
+        ScanNumber(const utf32 *src, size_t len, T &value, bool &overflow) {
+            uint64_t magnitude;
+            bool negative;
+            size_t used = ScanInteger(src, len, magnitude, negative, overflow);
+
+            if (used == 0 || overflow)
+                return used;
+
+            if (negative) {
+                // The magnitude of the minimum is one more than the maximum, in unsigned arithmetic
+                uint64_t limit = std::is_signed<T>::value ? (uint64_t) std::numeric_limits<T>::max() + 1 : 0;
+                overflow = magnitude > limit;
+                value = (T) (0 - magnitude);
+            } else {
+                overflow = magnitude > (uint64_t) std::numeric_limits<T>::max();
+                value = (T) magnitude;
+            }
+
+            return used;
+        }
+
+        template<typename T>
+        inline typename std::enable_if<std::is_floating_point<T>::value, size_t>::type
+        ScanNumber(const utf32 *src, size_t len, T &value, bool &overflow) {
+            if (sizeof(T) == sizeof(float)) {
+                float result;
+                size_t used = ScanFloat(src, len, result, overflow);
+                value = (T) result;
+                return used;
+            }
+
+            double result;
+            size_t used = ScanDouble(src, len, result, overflow);
+            value = (T) result;
+            return used;
+        }
+
+        /*!
+         * \brief
+         * Parses the whole of \a view as a number of type T, without exceptions
+         * \note
+         * Unlike Parse(), surrounding whitespace is not accepted
+         * \param view
+         * Code points holding the number
+         * \param value
+         * Receives the number, only written on success
+         * \return
+         * True if \a view holds a number that fits in T and nothing else
+         */
+        template<typename T>
+        inline bool TryParse(EdoStringView view, T &value) {
+            T result;
+            bool overflow;
+
+            if (ScanNumber(view.Data(), view.Length(), result, overflow) != view.Length() || view.Empty() || overflow)
+                return false;
+
+            value = result;
+            return true;
+        }
+
+        /*!
+         * \brief
+         * Parses a number of type T from the start of \a view, like std::stoi() and std::stod() do: leading whitespace
+         * is skipped, and the number may be followed by other code points
+         * \example_snippet_start
+         *      int width = Parse<int>(EdoString("1280x720"), &used);   // 1280, used is 4
+         * \example_snippet_end
+         * \param view
+         * Code points holding the number
+         * \param idx
+         * If not null, receives the index of the first code point after the number
+         * \return
+         * The number
+         * \exception
+         * std::invalid_argument Thrown if \a view does not start with a number
+         * \exception
+         * std::out_of_range Thrown if the number does not fit in T
+         */
+        template<typename T>
+        inline T Parse(EdoStringView view, size_t *idx = nullptr) {
+            size_t start = 0;
+
+            while (start < view.Length() && (view[start] == ' ' || (view[start] >= '\t' && view[start] <= '\r')))
+                ++start;
+
+            T result;
+            bool overflow;
+            size_t used = ScanNumber(view.Data() + start, view.Length() - start, result, overflow);
+
+            if (used == 0)
+                throw std::invalid_argument("No number to parse in EdoString");
+
+            if (overflow)
+                throw std::out_of_range("Number is out of range for the type parsed from EdoString");
+
+            if (idx != nullptr)
+                *idx = start + used;
+
+            return result;
+        }
+    } // Namespace Types
+} // Namespace Edo
+
+#endif // EDOCORE_EDONUMBER_H
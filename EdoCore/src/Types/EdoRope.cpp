@@ -0,0 +1,519 @@
+// =============================================================================
+// EdoRope.cpp
+// Implements the rope: balanced split and join of immutable nodes, and searches across leaves
+// =============================================================================
+
+#include "EdoRope.h"
+#include <cstring>
+#include <new>
+#include <vector>
+
+#define STR_ROPE_QUICK_WINDOW 128 // Searches for needles up to half this many code points do not allocate
+
+namespace Edo {
+    namespace Types {
+        const EdoRope::size_type EdoRope::npos = (EdoRope::size_type) (-1);
+
+        ///////////////////////////////////////////////
+        // Nodes
+        ///////////////////////////////////////////////
+        // Nodes come from the default allocator, since a snapshot can outlive any allocator scope. Leaves are followed
+        // by their code points
+        static size_t NodeBytes(size_t height, size_t length) {
+            return height ? 0 : length * sizeof(utf32);
+        }
+
+        static void *AllocateNode(size_t bytes) {
+            return EdoStringAllocator::GetDefault().Allocate(bytes);
+        }
+
+        void EdoRope::Release(Node *node) {
+            if (node == nullptr || node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+
+            if (node->height != 0) {
+                Release(node->left);
+                Release(node->right);
+            }
+
+            size_t bytes = sizeof(Node) + NodeBytes(node->height, node->length);
+            node->~Node();
+            EdoStringAllocator::GetDefault().Deallocate(node, bytes);
+        }
+
+        const EdoRope::Node *EdoRope::Locate(const Node *root, size_type idx, size_type &leafStart) {
+            size_type start = 0;
+
+            while (root->height != 0) {
+                if (idx < root->left->length) {
+                    root = root->left;
+                } else {
+                    idx -= root->left->length;
+                    start += root->left->length;
+                    root = root->right;
+                }
+            }
+
+            leafStart = start;
+            return root;
+        }
+
+        ///////////////////////////////////////////////
+        // Building, joining and splitting
+        ///////////////////////////////////////////////
+        namespace {
+            // The helpers are templated on the node type, which is private to EdoRope
+
+            // Create a leaf holding 'len1' code points from 'src1' followed by 'len2' from 'src2'
+            template<typename Node>
+            Node *NewLeaf(const utf32 *src1, size_t len1, const utf32 *src2 = nullptr, size_t len2 = 0) {
+                size_t len = len1 + len2;
+                Node *node = new(AllocateNode(sizeof(Node) + len * sizeof(utf32))) Node;
+                node->refs.store(1, std::memory_order_relaxed);
+                node->length = len;
+                node->height = 0;
+                node->left = nullptr;
+                node->right = nullptr;
+
+                utf32 *data = reinterpret_cast<utf32 *>(node + 1);
+                memcpy(data, src1, len1 * sizeof(utf32));
+
+                if (len2 != 0)
+                    memcpy(data + len1, src2, len2 * sizeof(utf32));
+
+                return node;
+            }
+
+            // Create an internal node over two trees, taking over both references
+            template<typename Node>
+            Node *NewBranch(Node *left, Node *right) {
+                Node *node = new(AllocateNode(sizeof(Node))) Node;
+                node->refs.store(1, std::memory_order_relaxed);
+                node->length = left->length + right->length;
+                node->height = 1 + std::max(left->height, right->height);
+                node->left = left;
+                node->right = right;
+                return node;
+            }
+
+            // Build a tree of 'leaves' leaves of as equal a size as possible, so sibling heights differ by one at most
+            template<typename Node>
+            Node *BuildLeaves(const utf32 *src, size_t len, size_t leaves) {
+                if (leaves == 1)
+                    return NewLeaf<Node>(src, len);
+
+                size_t leftLeaves = leaves / 2;
+                size_t leftLen = (len / leaves) * leftLeaves + std::min(leftLeaves, len % leaves);
+
+                Node *left = BuildLeaves<Node>(src, leftLen, leftLeaves);
+                return NewBranch(left, BuildLeaves<Node>(src + leftLen, len - leftLen, leaves - leftLeaves));
+            }
+
+            template<typename Node>
+            Node *Acquired(Node *node) {
+                node->refs.fetch_add(1, std::memory_order_relaxed);
+                return node;
+            }
+        }
+
+        EdoRope::Node *EdoRope::Build(const utf32 *src, size_type len) {
+            if (len == 0)
+                return nullptr;
+
+            if (len > (((size_type) -1) - sizeof(Node)) / sizeof(utf32))
+                throw std::length_error("Resulting EdoRope would be too large");
+
+            return BuildLeaves<Node>(src, len, (len + STR_ROPE_LEAF_SIZE - 1) / STR_ROPE_LEAF_SIZE);
+        }
+
+        static EdoRope::size_type Diff(EdoRope::size_type a, EdoRope::size_type b) { return a > b ? a - b : b - a; }
+
+        EdoRope::Node *EdoRope::Join(Node *left, Node *right) {
+            if (left == nullptr)
+                return right;
+
+            if (right == nullptr)
+                return left;
+
+            // Neighbouring leaves that fit in one are merged, which keeps typing from fragmenting the tree
+            if (left->height == 0 && right->height == 0 && left->length + right->length <= STR_ROPE_LEAF_SIZE) {
+                Node *node = NewLeaf<Node>(left->Data(), left->length, right->Data(), right->length);
+                Release(left);
+                Release(right);
+                return node;
+            }
+
+            if (Diff(left->height, right->height) <= 1)
+                return NewBranch(left, right);
+
+            if (left->height > right->height) {
+                // Join into the right spine of the taller tree, then restore the balance on the way back
+                Node *outer = Acquired(left->left);
+                Node *inner = Join(Acquired(left->right), right);
+                Release(left);
+
+                if (inner->height <= outer->height + 1)
+                    return NewBranch(outer, inner);
+
+                Node *result;
+
+                if (inner->right->height >= inner->left->height) {
+                    result = NewBranch(NewBranch(outer, Acquired(inner->left)), Acquired(inner->right));
+                } else {
+                    Node *middle = inner->left;
+                    result = NewBranch(NewBranch(outer, Acquired(middle->left)),
+                                       NewBranch(Acquired(middle->right), Acquired(inner->right)));
+                }
+
+                Release(inner);
+                return result;
+            }
+
+            Node *outer = Acquired(right->right);
+            Node *inner = Join(left, Acquired(right->left));
+            Release(right);
+
+            if (inner->height <= outer->height + 1)
+                return NewBranch(inner, outer);
+
+            Node *result;
+
+            if (inner->left->height >= inner->right->height) {
+                result = NewBranch(Acquired(inner->left), NewBranch(Acquired(inner->right), outer));
+            } else {
+                Node *middle = inner->right;
+                result = NewBranch(NewBranch(Acquired(inner->left), Acquired(middle->left)),
+                                   NewBranch(Acquired(middle->right), outer));
+            }
+
+            Release(inner);
+            return result;
+        }
+
+        void EdoRope::Split(Node *node, size_type idx, Node *&left, Node *&right) {
+            if (node == nullptr) {
+                left = right = nullptr;
+            } else if (idx == 0) {
+                left = nullptr;
+                right = Acquired(node);
+            } else if (idx >= node->length) {
+                left = Acquired(node);
+                right = nullptr;
+            } else if (node->height == 0) {
+                left = NewLeaf<Node>(node->Data(), idx);
+                right = NewLeaf<Node>(node->Data() + idx, node->length - idx);
+            } else if (idx < node->left->length) {
+                Node *rest;
+                Split(node->left, idx, left, rest);
+                right = Join(rest, Acquired(node->right));
+            } else {
+                Node *rest;
+                Split(node->right, idx - node->left->length, rest, right);
+                left = Join(Acquired(node->left), rest);
+            }
+        }
+
+        ///////////////////////////////////////////////
+        // Editing
+        ///////////////////////////////////////////////
+        EdoRope &EdoRope::Replace(size_type idx, size_type len, EdoStringView view) {
+            size_type length = Length();
+
+            if (idx > length)
+                throw std::out_of_range("Index is out of range for EdoRope");
+
+            if (len > length - idx)
+                len = length - idx;
+
+            if (len == 0 && view.Empty())
+                return *this;
+
+            // The new code points are copied before anything is released, so 'view' may point into this rope
+            Node *middle = Build(view.Data(), view.Length());
+            Node *left, *rest, *cut, *right;
+
+            Split(d_root, idx, left, rest);
+            Split(rest, len, cut, right);
+            Release(rest);
+            Release(cut);
+
+            Node *root = Join(Join(left, middle), right);
+            Release(d_root);
+            d_root = root;
+            return *this;
+        }
+
+        EdoRope &EdoRope::Insert(size_type idx, const EdoRope &rope) {
+            if (idx > Length())
+                throw std::out_of_range("Index is out of range for EdoRope");
+
+            if (rope.Empty())
+                return *this;
+
+            Node *middle = Acquired(rope.d_root);
+            Node *left, *right;
+
+            Split(d_root, idx, left, right);
+
+            Node *root = Join(Join(left, middle), right);
+            Release(d_root);
+            d_root = root;
+            return *this;
+        }
+
+        ///////////////////////////////////////////////
+        // Sub-ropes and flattening
+        ///////////////////////////////////////////////
+        EdoRope EdoRope::SubRope(size_type idx, size_type len) const {
+            if (idx > Length())
+                throw std::out_of_range("Index is out of range for EdoRope");
+
+            Node *left, *rest, *right;
+            EdoRope result;
+
+            Split(d_root, idx, left, rest);
+            Split(rest, len, result.d_root, right);
+            Release(left);
+            Release(rest);
+            Release(right);
+            return result;
+        }
+
+        EdoString EdoRope::Substr(size_type idx, size_type len) const {
+            size_type length = Length();
+
+            if (idx > length)
+                throw std::out_of_range("Index is out of range for EdoRope");
+
+            if (len > length - idx)
+                len = length - idx;
+
+            EdoString result;
+
+            if (len == 0)
+                return result;
+
+            result.Reserve(len);
+
+            VisitForward(d_root, 0, idx, [&](const utf32 *data, size_type count, size_type) {
+                count = std::min(count, len);
+                result.Append(EdoStringView(data, count));
+                len -= count;
+                return len != 0;
+            });
+
+            return result;
+        }
+
+        ///////////////////////////////////////////////
+        // Searching
+        ///////////////////////////////////////////////
+        namespace {
+            //! The last few code points before a leaf, kept to find matches that cross into it
+            class SearchWindow {
+            public:
+                explicit SearchWindow(size_t capacity) : d_data(d_quick), d_size(0) {
+                    if (capacity > STR_ROPE_QUICK_WINDOW) {
+                        d_heap.resize(capacity);
+                        d_data = d_heap.data();
+                    }
+                }
+
+                utf32 *Data() { return d_data; }
+
+                size_t Size() const { return d_size; }
+
+                void Append(const utf32 *src, size_t len) {
+                    memcpy(d_data + d_size, src, len * sizeof(utf32));
+                    d_size += len;
+                }
+
+                void Prepend(const utf32 *src, size_t len) {
+                    memmove(d_data + len, d_data, d_size * sizeof(utf32));
+                    memcpy(d_data, src, len * sizeof(utf32));
+                    d_size += len;
+                }
+
+                void KeepFirst(size_t len) { d_size = std::min(d_size, len); }
+
+                void KeepLast(size_t len) {
+                    if (d_size > len) {
+                        memmove(d_data, d_data + d_size - len, len * sizeof(utf32));
+                        d_size = len;
+                    }
+                }
+
+            private:
+                utf32 d_quick[STR_ROPE_QUICK_WINDOW];
+                std::vector<utf32> d_heap;
+                utf32 *d_data;
+                size_t d_size;
+            };
+        }
+
+        EdoRope::size_type EdoRope::Find(utf32 code_point, size_type idx) const {
+            size_type result = npos;
+
+            if (idx < Length()) {
+                VisitForward(d_root, 0, idx, [&](const utf32 *data, size_type len, size_type start) {
+                    size_t pos = FindCodePoint(data, len, code_point);
+
+                    if (pos == STR_NOT_FOUND)
+                        return true;
+
+                    result = start + pos;
+                    return false;
+                });
+            }
+
+            return result;
+        }
+
+        EdoRope::size_type EdoRope::RFind(utf32 code_point, size_type idx) const {
+            size_type result = npos;
+
+            if (!Empty()) {
+                VisitBackward(d_root, 0, idx < Length() ? idx + 1 : Length(),
+                              [&](const utf32 *data, size_type len, size_type start) {
+                                  size_t pos = RFindCodePoint(data, len, code_point);
+
+                                  if (pos == STR_NOT_FOUND)
+                                      return true;
+
+                                  result = start + pos;
+                                  return false;
+                              });
+            }
+
+            return result;
+        }
+
+        EdoRope::size_type EdoRope::Find(EdoStringView view, size_type idx) const {
+            if (idx >= Length())
+                return npos;
+
+            if (view.Empty())
+                return idx;
+
+            return Find(EdoStringSearcher(view.Data(), view.Length()), idx);
+        }
+
+        EdoRope::size_type EdoRope::RFind(EdoStringView view, size_type idx) const {
+            if (view.Empty())
+                return (idx < Length()) ? idx : Length();
+
+            return RFind(EdoStringSearcher(view.Data(), view.Length()), idx);
+        }
+
+        EdoRope::size_type EdoRope::Find(const EdoStringSearcher &searcher, size_type idx) const {
+            size_type length = Length();
+            size_type needleLen = searcher.Length();
+
+            if (idx >= length)
+                return npos;
+
+            if (needleLen == 0)
+                return idx;
+
+            if (needleLen > length - idx)
+                return npos;
+
+            // 'window' holds the last needleLen - 1 code points before the current leaf, starting at 'windowStart'
+            size_type keep = needleLen - 1;
+            SearchWindow window(2 * keep);
+            size_type windowStart = idx;
+            size_type result = npos;
+
+            VisitForward(d_root, 0, idx, [&](const utf32 *data, size_type len, size_type start) {
+                if (window.Size() != 0) {
+                    // Matches that start in the window and end in this leaf
+                    size_t carried = window.Size();
+                    window.Append(data, std::min(keep, len));
+
+                    size_t pos = searcher.Find(window.Data(), window.Size());
+
+                    if (pos != STR_NOT_FOUND && pos < carried) {
+                        result = windowStart + pos;
+                        return false;
+                    }
+
+                    window.KeepFirst(carried);
+                }
+
+                size_t pos = searcher.Find(data, len);
+
+                if (pos != STR_NOT_FOUND) {
+                    result = start + pos;
+                    return false;
+                }
+
+                if (keep != 0) {
+                    // Leaves shorter than the needle add to the window instead of replacing it
+                    size_type tail = std::min(keep, len);
+
+                    window.Append(data + len - tail, tail);
+                    window.KeepLast(keep);
+                    windowStart = start + len - window.Size();
+                }
+
+                return true;
+            });
+
+            return result;
+        }
+
+        EdoRope::size_type EdoRope::RFind(const EdoStringSearcher &searcher, size_type idx) const {
+            size_type length = Length();
+            size_type needleLen = searcher.Length();
+
+            if (needleLen == 0)
+                return (idx < length) ? idx : length;
+
+            if (needleLen > length)
+                return npos;
+
+            if (idx > length - needleLen)
+                idx = length - needleLen;
+
+            // 'window' holds the first needleLen - 1 code points after the current leaf
+            size_type keep = needleLen - 1;
+            SearchWindow window(2 * keep);
+            size_type result = npos;
+
+            VisitBackward(d_root, 0, idx + needleLen, [&](const utf32 *data, size_type len, size_type start) {
+                size_type head = std::min(keep, len);
+
+                if (window.Size() != 0) {
+                    // Matches that start in this leaf and end in the window. They come after any match that lies
+                    // within the leaf, so the last match of the joined code points is the answer if it crosses over
+                    window.Prepend(data + len - head, head);
+
+                    size_t pos = searcher.RFind(window.Data(), window.Size());
+
+                    if (pos != STR_NOT_FOUND && pos + needleLen > head) {
+                        result = start + len - head + pos;
+                        return false;
+                    }
+
+                    window.KeepLast(window.Size() - head);
+                }
+
+                size_t pos = searcher.RFind(data, len);
+
+                if (pos != STR_NOT_FOUND) {
+                    result = start + pos;
+                    return false;
+                }
+
+                if (keep != 0) {
+                    window.Prepend(data, head);
+                    window.KeepFirst(keep);
+                }
+
+                return true;
+            });
+
+            return result;
+        }
+    } // Namespace Types
+} // Namespace Edo
@@ -0,0 +1,498 @@
+// =============================================================================
+// EdoRope.h
+// Defines a rope of utf32 text, for large buffers that are edited in place
+// =============================================================================
+
+#ifndef EDOCORE_EDOROPE_H
+#define EDOCORE_EDOROPE_H
+
+#include "EdoString.h"
+#include <atomic>
+#include <iterator>
+
+#define STR_ROPE_LEAF_SIZE 512 // Maximum number of code points in a leaf of an EdoRope
+
+namespace Edo {
+    namespace Types {
+        /*!
+         * \brief
+         * Text container for large, frequently edited buffers such as the console history or a script being edited.
+         *
+         * The text is split into leaves of up to STR_ROPE_LEAF_SIZE code points, held by a height balanced binary
+         * tree. Insert(), Erase() and Replace() split the tree at the edit positions and join the pieces back, which
+         * copies at most a couple of leaves and O(log n) nodes instead of moving the whole tail of the buffer as
+         * EdoString does. Leaves that become small enough after an edit are merged with their neighbours.
+         *
+         * Nodes are never modified once built, and are shared through atomic reference counts. Copying a rope (or
+         * calling Snapshot()) therefore costs a single increment, and keeping the snapshot, e.g. on an undo stack,
+         * only costs the nodes that later edits replace. Snapshots can be read from other threads while the original
+         * is being edited.
+         * \note
+         * Iterators are invalidated by any modification of the rope they came from; iterate over a Snapshot() to
+         * edit while iterating
+         * \example_snippet_start
+         *      EdoRope buffer(EdoString::FromFile(...));
+         *      undo.push_back(buffer.Snapshot());
+         *      buffer.Insert(cursor, keystroke);
+         * \example_snippet_end
+         */
+        class EDO_API EdoRope {
+        private:
+            //! Node of the tree. Leaves (height 0) are followed by their code points
+            struct Node {
+                std::atomic<size_t> refs; //!< Number of ropes and parent nodes holding this node
+                size_t length; //!< Number of code points below this node
+                size_t height; //!< 0 for leaves, otherwise 1 + the height of the taller child
+                Node *left; //!< Left child, null for leaves
+                Node *right; //!< Right child, null for leaves
+
+                const utf32 *Data() const { return reinterpret_cast<const utf32 *>(this + 1); }
+            };
+
+        public:
+            /***************************************
+             * Integral types
+             ***************************************/
+            typedef utf32 value_type; //!< Basic 'code point' type (utf32)
+            typedef size_t size_type; //!< Unsigned type used for size values and indices
+
+            static const size_type npos; //!< Value used to represent 'not found' conditions and 'all code points' etc.
+
+            //! Bidirectional iterator over the code points of a rope
+            class const_iterator : public std::iterator<std::bidirectional_iterator_tag, utf32, std::ptrdiff_t,
+                    const utf32 *, const utf32 &> {
+            public:
+                const_iterator() : d_root(nullptr), d_pos(0), d_leaf(nullptr), d_leafStart(0), d_leafEnd(0) {}
+
+                const utf32 &operator*() const { return d_leaf[d_pos - d_leafStart]; }
+
+                const_iterator &operator++() {
+                    if (++d_pos >= d_leafEnd)
+                        Seek();
+
+                    return *this;
+                }
+
+                const_iterator operator++(int) {
+                    const_iterator temp = *this;
+                    ++*this;
+                    return temp;
+                }
+
+                const_iterator &operator--() {
+                    if (d_pos-- == d_leafStart)
+                        Seek();
+
+                    return *this;
+                }
+
+                const_iterator operator--(int) {
+                    const_iterator temp = *this;
+                    --*this;
+                    return temp;
+                }
+
+                bool operator==(const const_iterator &iter) const { return d_pos == iter.d_pos; }
+
+                bool operator!=(const const_iterator &iter) const { return d_pos != iter.d_pos; }
+
+                /*!
+                 * \brief
+                 * Return the index of the code point the iterator points at
+                 */
+                size_type Index() const { return d_pos; }
+
+            private:
+                friend class EdoRope;
+
+                const_iterator(const Node *root, size_type pos) : d_root(root), d_pos(pos), d_leaf(nullptr),
+                                                                  d_leafStart(0), d_leafEnd(0) {
+                    Seek();
+                }
+
+                // Find the leaf holding d_pos. The end position gets an empty range, so that stepping back seeks again
+                void Seek() {
+                    if (d_root != nullptr && d_pos < d_root->length) {
+                        const Node *leaf = Locate(d_root, d_pos, d_leafStart);
+                        d_leaf = leaf->Data();
+                        d_leafEnd = d_leafStart + leaf->length;
+                    } else {
+                        d_leaf = nullptr;
+                        d_leafStart = d_leafEnd = d_pos;
+                    }
+                }
+
+                const Node *d_root; //!< Root of the rope being iterated
+                size_type d_pos; //!< Index of the current code point
+                const utf32 *d_leaf; //!< Code points of the current leaf
+                size_type d_leafStart; //!< Index of the first code point of the current leaf
+                size_type d_leafEnd; //!< Index past the last code point of the current leaf
+            };
+
+            //////////////////////////////////////////////
+            // Construction and destruction
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Constructs an empty rope
+             */
+            EdoRope() noexcept : d_root(nullptr) {}
+
+            /*!
+             * \brief
+             * Constructs a rope holding a copy of the code points of \a view
+             */
+            explicit EdoRope(EdoStringView view) : d_root(Build(view.Data(), view.Length())) {}
+
+            /*!
+             * \brief
+             * Copy constructor - shares all nodes of \a rope, in constant time
+             */
+            EdoRope(const EdoRope &rope) noexcept : d_root(Acquire(rope.d_root)) {}
+
+            /*!
+             * \brief
+             * Move constructor - takes over the nodes of \a rope, which is left empty
+             */
+            EdoRope(EdoRope &&rope) noexcept : d_root(rope.d_root) {
+                rope.d_root = nullptr;
+            }
+
+            ~EdoRope() {
+                Release(d_root);
+            }
+
+            EdoRope &operator=(const EdoRope &rope) noexcept {
+                Node *root = Acquire(rope.d_root);
+                Release(d_root);
+                d_root = root;
+                return *this;
+            }
+
+            EdoRope &operator=(EdoRope &&rope) noexcept {
+                Swap(rope);
+                return *this;
+            }
+
+            /*!
+             * \brief
+             * Swaps the contents of this rope and \a rope
+             */
+            void Swap(EdoRope &rope) noexcept {
+                Node *temp = d_root;
+                d_root = rope.d_root;
+                rope.d_root = temp;
+            }
+
+            /*!
+             * \brief
+             * Return a copy of the rope, which shares all its nodes. Later edits of either rope do not affect the other
+             */
+            EdoRope Snapshot() const { return *this; }
+
+            //////////////////////////////////////////////
+            // Size operations
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Return the number of code points in the rope
+             */
+            size_type Length() const { return d_root ? d_root->length : 0; }
+
+            /*!
+             * \brief
+             * Return the number of code points in the rope
+             */
+            size_type Size() const { return Length(); }
+
+            /*!
+             * \brief
+             * Return true if the rope is empty
+             */
+            bool Empty() const { return d_root == nullptr; }
+
+            /*!
+             * \brief
+             * Return the height of the tree, 0 for a rope of a single leaf. Meant for diagnostics
+             */
+            size_type Height() const { return d_root ? d_root->height : 0; }
+
+            //////////////////////////////////////////////
+            // Character access
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Return the code point at the given index, in O(log n)
+             * \exception
+             * std::out_of_range Thrown if \a idx is >= Length()
+             */
+            value_type At(size_type idx) const {
+                if (Length() <= idx)
+                    throw std::out_of_range("Index is out of range for EdoRope");
+
+                size_type leafStart;
+                return Locate(d_root, idx, leafStart)->Data()[idx - leafStart];
+            }
+
+            /*!
+             * \brief
+             * Return the code point at the given index, in O(log n). The index is not checked
+             */
+            value_type operator[](size_type idx) const {
+                size_type leafStart;
+                return Locate(d_root, idx, leafStart)->Data()[idx - leafStart];
+            }
+
+            const_iterator Begin() const { return const_iterator(d_root, 0); }
+
+            const_iterator End() const { return const_iterator(d_root, Length()); }
+
+            const_iterator begin() const { return Begin(); }
+
+            const_iterator end() const { return End(); }
+
+            /*!
+             * \brief
+             * Calls \a func with an EdoStringView of each leaf, in order. This is the fastest way to read the whole
+             * rope
+             */
+            template<typename F>
+            void ForEachChunk(F func) const {
+                if (d_root != nullptr)
+                    VisitChunks(d_root, func);
+            }
+
+            //////////////////////////////////////////////
+            // Editing
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Inserts the code points of \a view at the specified position, in O(log n + view length)
+             * @param idx
+             * Index where the code points are to be inserted
+             * @param view
+             * EdoStringView object that is to be inserted. It may be a view of a flattened copy of this rope
+             * @return
+             * This rope after the insert
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this rope
+             */
+            EdoRope &Insert(size_type idx, EdoStringView view) {
+                return Replace(idx, 0, view);
+            }
+
+            /*!
+             * \brief
+             * Inserts the contents of another rope at the specified position, sharing its nodes
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this rope
+             */
+            EdoRope &Insert(size_type idx, const EdoRope &rope);
+
+            /*!
+             * \brief
+             * Appends the code points of \a view
+             */
+            EdoRope &Append(EdoStringView view) {
+                return Replace(Length(), 0, view);
+            }
+
+            /*!
+             * \brief
+             * Appends the code points of \a view
+             */
+            EdoRope &operator+=(EdoStringView view) {
+                return Append(view);
+            }
+
+            /*!
+             * \brief
+             * Removes code points from the rope, in O(log n)
+             * @param idx
+             * Index of the first code point to be removed
+             * @param len
+             * Maximum number of code points to be removed
+             * @return
+             * This rope after the erase operation
+             * \exception
+             * std::out_of_range Thrown if \a idx is not the index of a code point of this rope, as for EdoString
+             */
+            EdoRope &Erase(size_type idx, size_type len = npos) {
+                if (len != 0 && Length() <= idx)
+                    throw std::out_of_range("Index is out of range for EdoRope");
+
+                return Replace(idx, len, EdoStringView());
+            }
+
+            /*!
+             * \brief
+             * Replace code points of the rope with the code points of \a view, in O(log n + view length)
+             * @param idx
+             * Index of the first code point to be replaced
+             * @param len
+             * Maximum number of code points to be replaced (if this is 0, operation is an insert at position \a idx)
+             * @param view
+             * The EdoStringView object that is to replace the specified code points
+             * @return
+             * This rope after the replace operation
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this rope
+             */
+            EdoRope &Replace(size_type idx, size_type len, EdoStringView view);
+
+            /*!
+             * \brief
+             * Removes all code points
+             */
+            void Clear() {
+                Release(d_root);
+                d_root = nullptr;
+            }
+
+            //////////////////////////////////////////////
+            // Sub-ropes and flattening
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Returns a part of the rope as a new rope, sharing the nodes in O(log n)
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this rope
+             */
+            EdoRope SubRope(size_type idx = 0, size_type len = npos) const;
+
+            /*!
+             * \brief
+             * Copies a part of the rope into an EdoString
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this rope
+             */
+            EdoString Substr(size_type idx = 0, size_type len = npos) const;
+
+            /*!
+             * \brief
+             * Copies the whole rope into an EdoString
+             */
+            EdoString ToString() const { return Substr(); }
+
+            //////////////////////////////////////////////
+            // Searching
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Search forwards for a code point
+             * \return
+             * Index of the first occurrence of \a code_point at or after \a idx, or npos
+             */
+            size_type Find(utf32 code_point, size_type idx = 0) const;
+
+            /*!
+             * \brief
+             * Search backwards for a code point
+             * \return
+             * Index of the last occurrence of \a code_point at or before \a idx, or npos
+             */
+            size_type RFind(utf32 code_point, size_type idx = npos) const;
+
+            /*!
+             * \brief
+             * Search forwards for a sub-string, including matches that span several leaves
+             * \return
+             * Index of the first occurrence of \a view at or after \a idx, \a idx for an empty \a view, or npos
+             */
+            size_type Find(EdoStringView view, size_type idx = 0) const;
+
+            /*!
+             * \brief
+             * Search backwards for a sub-string, including matches that span several leaves
+             * \return
+             * Index of the last occurrence of \a view starting at or before \a idx, or npos
+             */
+            size_type RFind(EdoStringView view, size_type idx = npos) const;
+
+            /*!
+             * \brief
+             * Search forwards for the needle of a prepared searcher, which saves preparing it on every call when the
+             * same text is looked for repeatedly
+             * \return
+             * Index of the first occurrence at or after \a idx, \a idx for an empty needle, or npos
+             */
+            size_type Find(const EdoStringSearcher &searcher, size_type idx = 0) const;
+
+            /*!
+             * \brief
+             * Search backwards for the needle of a prepared searcher
+             * \return
+             * Index of the last occurrence starting at or before \a idx, or npos
+             */
+            size_type RFind(const EdoStringSearcher &searcher, size_type idx = npos) const;
+
+        private:
+            // Take a reference to a node (which may be null)
+            static Node *Acquire(Node *node) {
+                if (node != nullptr)
+                    node->refs.fetch_add(1, std::memory_order_relaxed);
+
+                return node;
+            }
+
+            // Drop a reference to a node (which may be null), freeing it and its children with the last one
+            static void Release(Node *node);
+
+            // Return the leaf holding code point 'idx' below 'root', and the index of its first code point
+            static const Node *Locate(const Node *root, size_type idx, size_type &leafStart);
+
+            // Build a balanced tree of leaves holding a copy of the given code points
+            static Node *Build(const utf32 *src, size_type len);
+
+            // Join two trees (taking over both references) into a balanced tree holding 'left' then 'right'
+            static Node *Join(Node *left, Node *right);
+
+            // Split the tree below 'node' (borrowed) before code point 'idx', returning new references
+            static void Split(Node *node, size_type idx, Node *&left, Node *&right);
+
+            // Call func(data, len, start) for the leaves overlapping [from, Length()), in order, the first one cut to
+            // start at 'from'. Stops when func returns false, and returns false then
+            template<typename F>
+            static bool VisitForward(const Node *node, size_type nodeStart, size_type from, F &&func) {
+                if (nodeStart + node->length <= from)
+                    return true;
+
+                if (node->height == 0) {
+                    size_type offset = from > nodeStart ? from - nodeStart : 0;
+                    return func(node->Data() + offset, node->length - offset, nodeStart + offset);
+                }
+
+                return VisitForward(node->left, nodeStart, from, func) &&
+                       VisitForward(node->right, nodeStart + node->left->length, from, func);
+            }
+
+            // Call func(data, len, start) for the leaves overlapping [0, to), last one first, the first one visited
+            // cut to end at 'to'. Stops when func returns false, and returns false then
+            template<typename F>
+            static bool VisitBackward(const Node *node, size_type nodeStart, size_type to, F &&func) {
+                if (nodeStart >= to)
+                    return true;
+
+                if (node->height == 0)
+                    return func(node->Data(), std::min(node->length, to - nodeStart), nodeStart);
+
+                return VisitBackward(node->right, nodeStart + node->left->length, to, func) &&
+                       VisitBackward(node->left, nodeStart, to, func);
+            }
+
+            template<typename F>
+            static void VisitChunks(const Node *node, F &func) {
+                if (node->height == 0) {
+                    func(EdoStringView(node->Data(), node->length));
+                } else {
+                    VisitChunks(node->left, func);
+                    VisitChunks(node->right, func);
+                }
+            }
+
+            Node *d_root; //!< Root of the tree, null for an empty rope
+        };
+    } // Namespace Types
+} // Namespace Edo
+
+#endif // EDOCORE_EDOROPE_H
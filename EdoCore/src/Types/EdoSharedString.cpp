@@ -0,0 +1,173 @@
+// =============================================================================
+// EdoSharedString.cpp
+// Implements the reference counted string
+// =============================================================================
+
+#include "EdoSharedString.h"
+#include <cstring>
+#include <new>
+#include <vector>
+
+#define STR_SHARED_QUICK_DECODE 256 // utf8 data up to this many code units is decoded on the stack
+
+namespace Edo {
+    namespace Types {
+        const EdoSharedString::size_type EdoSharedString::npos = (EdoSharedString::size_type) (-1);
+        const utf32 EdoSharedString::s_empty = 0;
+
+        ///////////////////////////////////////////////
+        // utf8 blocks
+        ///////////////////////////////////////////////
+        // The utf8 encoding lives in its own block, behind its capacity and its length
+        static utf8 *AllocateEncoded(size_t capacity) {
+            if (capacity > ((size_t) -1) - 2 * sizeof(size_t) - 1)
+                throw std::length_error("Resulting EdoSharedString would be too large");
+
+            size_t *block = static_cast<size_t *>(
+                    EdoStringAllocator::GetDefault().Allocate(2 * sizeof(size_t) + capacity + 1));
+            block[0] = capacity;
+            block[1] = capacity;
+
+            utf8 *encoded = reinterpret_cast<utf8 *>(block + 2);
+            encoded[capacity] = 0;
+            return encoded;
+        }
+
+        static void SetEncodedLength(utf8 *encoded, size_t len) {
+            reinterpret_cast<size_t *>(encoded)[-1] = len;
+            encoded[len] = 0;
+        }
+
+        static size_t EncodedLength(const utf8 *encoded) {
+            return reinterpret_cast<const size_t *>(encoded)[-1];
+        }
+
+        static void FreeEncoded(utf8 *encoded) {
+            size_t *block = reinterpret_cast<size_t *>(encoded) - 2;
+            EdoStringAllocator::GetDefault().Deallocate(block, 2 * sizeof(size_t) + block[0] + 1);
+        }
+
+        ///////////////////////////////////////////////
+        // Construction
+        ///////////////////////////////////////////////
+        EdoSharedString::EdoSharedString(EdoStringView view) : d_rep(nullptr) {
+            if (!view.Empty())
+                d_rep = Create(view.Data(), view.Length());
+        }
+
+        EdoSharedString::EdoSharedString(const utf8 *utf8_str)
+                : EdoSharedString(utf8_str, strlen(reinterpret_cast<const char *>(utf8_str))) {
+        }
+
+        EdoSharedString::EdoSharedString(const utf8 *utf8_str, size_type str_len) : d_rep(nullptr) {
+            if (str_len == 0)
+                return;
+
+            // The decoder needs room for one code point per code unit
+            utf32 quick[STR_SHARED_QUICK_DECODE];
+            std::vector<utf32> heap;
+            utf32 *decoded = quick;
+
+            if (str_len > STR_SHARED_QUICK_DECODE) {
+                heap.resize(str_len);
+                decoded = heap.data();
+            }
+
+            size_t error = UTF_NO_ERROR;
+            size_type len = DecodeUtf8(utf8_str, str_len, decoded, Utf8Replace, &error);
+
+            d_rep = Create(decoded, len);
+
+            // Well-formed input is exactly what the encoder would produce, so it becomes the shared encoding
+            if (error == UTF_NO_ERROR) {
+                utf8 *encoded = AllocateEncoded(str_len);
+                memcpy(encoded, utf8_str, str_len);
+                d_rep->encoded.store(encoded, std::memory_order_relaxed);
+            }
+        }
+
+        ///////////////////////////////////////////////
+        // utf8 and hashing
+        ///////////////////////////////////////////////
+        const utf8 *EdoSharedString::Data() const {
+            if (d_rep == nullptr)
+                return reinterpret_cast<const utf8 *>("");
+
+            utf8 *encoded = d_rep->encoded.load(std::memory_order_acquire);
+            return encoded ? encoded : BuildEncoded(d_rep);
+        }
+
+        EdoSharedString::size_type EdoSharedString::Utf8Length() const {
+            return d_rep ? EncodedLength(Data()) : 0;
+        }
+
+        EdoSharedString::size_type EdoSharedString::Hash() const {
+            if (d_rep == nullptr)
+                return (size_type) HashBytes(nullptr, 0);
+
+            size_type hash = d_rep->hash.load(std::memory_order_relaxed);
+
+            if (hash == 0) {
+                // Threads racing here compute the same value, so whichever store lands is fine
+                hash = (size_type) HashBytes(ptr(), d_rep->length * sizeof(utf32));
+                d_rep->hash.store(hash, std::memory_order_relaxed);
+            }
+
+            return hash;
+        }
+
+        ///////////////////////////////////////////////
+        // Shared blocks
+        ///////////////////////////////////////////////
+        EdoSharedString::Rep *EdoSharedString::Create(const utf32 *src, size_type len) {
+            if (len >= (((size_type) -1) - sizeof(Rep)) / sizeof(utf32))
+                throw std::length_error("Resulting EdoSharedString would be too large");
+
+            Rep *rep = new(EdoStringAllocator::GetDefault().Allocate(sizeof(Rep) + (len + 1) * sizeof(utf32))) Rep;
+            rep->refs.store(1, std::memory_order_relaxed);
+            rep->encoded.store(nullptr, std::memory_order_relaxed);
+            rep->hash.store(0, std::memory_order_relaxed);
+            rep->length = len;
+
+            utf32 *data = reinterpret_cast<utf32 *>(rep + 1);
+            memcpy(data, src, len * sizeof(utf32));
+            data[len] = 0;
+
+            return rep;
+        }
+
+        void EdoSharedString::Release(Rep *rep) {
+            if (rep->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+
+            utf8 *encoded = rep->encoded.load(std::memory_order_acquire);
+
+            if (encoded != nullptr)
+                FreeEncoded(encoded);
+
+            size_type bytes = sizeof(Rep) + (rep->length + 1) * sizeof(utf32);
+            rep->~Rep();
+            EdoStringAllocator::GetDefault().Deallocate(rep, bytes);
+        }
+
+        utf8 *EdoSharedString::BuildEncoded(Rep *rep) {
+            const utf32 *data = reinterpret_cast<const utf32 *>(rep + 1);
+            size_t len = Utf8LengthOf(data, rep->length);
+
+            // Code points the encoder has to replace can take fewer code units than were counted
+            utf8 *encoded = AllocateEncoded(len);
+            SetEncodedLength(encoded, EncodeUtf8(data, rep->length, encoded, len));
+
+            // Another thread may have been faster, in which case its encoding is used and ours is dropped
+            utf8 *expected = nullptr;
+
+            if (!rep->encoded.compare_exchange_strong(expected, encoded, std::memory_order_acq_rel,
+                                                      std::memory_order_acquire)) {
+                FreeEncoded(encoded);
+                return expected;
+            }
+
+            return encoded;
+        }
+    } // Namespace Types
+} // Namespace Edo
@@ -0,0 +1,305 @@
+// =============================================================================
+// EdoSharedString.h
+// Defines an immutable, reference counted string whose copies share one buffer and one utf8 encoding
+// =============================================================================
+
+#ifndef EDOCORE_EDOSHAREDSTRING_H
+#define EDOCORE_EDOSHAREDSTRING_H
+
+#include "EdoString.h"
+#include <atomic>
+
+namespace Edo {
+    namespace Types {
+        /*!
+         * \brief
+         * Immutable Unicode string whose copies share a single buffer. Copying or assigning one only increments an
+         * atomic reference count, so values that are handed to many objects (config entries, localised texts) are
+         * stored once no matter how many holders they have.
+         *
+         * The utf8 encoding returned by c_str() is built on first use and shared by every copy, and so is the value
+         * of Hash(). All members are const, so any number of threads may use copies of the same string, or the same
+         * EdoSharedString object, at the same time; only assigning to an object that other threads read needs outside
+         * synchronisation, as it does for a std::shared_ptr.
+         *
+         * Reading goes through EdoStringView: an EdoSharedString converts to a view, so it can be passed to the view
+         * overloads of EdoString (Assign, Append, Find, Compare, ...), and EdoString(shared) copies it back into a
+         * mutable string.
+         * \note
+         * The buffers come from EdoStringAllocator::GetDefault(), since a shared value can outlive any scope.
+         * \example_snippet_start
+         *      EdoSharedString title(EdoString(TEXT("Options")));
+         *      button.SetLabel(title); // No copy of the text
+         *      window.SetTitle(title);
+         * \example_snippet_end
+         */
+        class EDO_API EdoSharedString {
+        public:
+            /***************************************
+             * Integral types
+             ***************************************/
+            typedef utf32 value_type; //!< Basic 'code point' type (utf32)
+            typedef size_t size_type; //!< Unsigned type used for size values and indices
+            typedef const utf32 *const_iterator; //!< Iterators of a shared string are plain pointers
+
+            static const size_type npos; //!< Value used to represent 'not found' conditions and 'all code points' etc.
+
+            //////////////////////////////////////////////
+            // Construction and destruction
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Constructs an empty string. This does not allocate
+             */
+            EdoSharedString() noexcept : d_rep(nullptr) {}
+
+            /*!
+             * \brief
+             * Constructs a string holding a copy of the code points of \a view
+             */
+            explicit EdoSharedString(EdoStringView view);
+
+            /*!
+             * \brief
+             * Constructs a string holding a copy of \a str
+             */
+            explicit EdoSharedString(const EdoString &str) : EdoSharedString(str.View()) {}
+
+            /*!
+             * \brief
+             * Constructs a string from null terminated utf8 data. Well-formed data is kept as the shared encoding, so
+             * c_str() costs nothing afterwards
+             * \note
+             * Malformed sequences become UTF_REPLACEMENT_CHAR, the same way the EdoString constructor decodes them
+             */
+            explicit EdoSharedString(const utf8 *utf8_str);
+
+            /*!
+             * \brief
+             * Constructs a string from \a str_len code units of utf8 data
+             */
+            EdoSharedString(const utf8 *utf8_str, size_type str_len);
+
+            /*!
+             * \brief
+             * Copy constructor - shares the buffer of \a str
+             */
+            EdoSharedString(const EdoSharedString &str) noexcept : d_rep(str.d_rep) {
+                if (d_rep != nullptr)
+                    d_rep->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            /*!
+             * \brief
+             * Move constructor - takes over the buffer of \a str, which is left empty
+             */
+            EdoSharedString(EdoSharedString &&str) noexcept : d_rep(str.d_rep) {
+                str.d_rep = nullptr;
+            }
+
+            ~EdoSharedString() {
+                if (d_rep != nullptr)
+                    Release(d_rep);
+            }
+
+            EdoSharedString &operator=(const EdoSharedString &str) noexcept {
+                if (d_rep != str.d_rep)
+                    EdoSharedString(str).Swap(*this);
+
+                return *this;
+            }
+
+            EdoSharedString &operator=(EdoSharedString &&str) noexcept {
+                EdoSharedString(std::move(str)).Swap(*this);
+                return *this;
+            }
+
+            /*!
+             * \brief
+             * Swaps the values of this string and \a str
+             */
+            void Swap(EdoSharedString &str) noexcept {
+                Rep *temp = d_rep;
+                d_rep = str.d_rep;
+                str.d_rep = temp;
+            }
+
+            /*!
+             * \brief
+             * Copies the value into a new, mutable EdoString
+             */
+            EdoString ToString() const { return EdoString(View()); }
+
+            //////////////////////////////////////////////
+            // Size operations
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Return the number of code points in the string
+             */
+            size_type Length() const { return d_rep ? d_rep->length : 0; }
+
+            /*!
+             * \brief
+             * Return the number of code points in the string
+             */
+            size_type Size() const { return Length(); }
+
+            /*!
+             * \brief
+             * Return true if the string is empty
+             */
+            bool Empty() const { return Length() == 0; }
+
+            /*!
+             * \brief
+             * Return the number of EdoSharedString objects sharing this value, or 0 for an empty string that never
+             * allocated
+             */
+            size_type UseCount() const { return d_rep ? d_rep->refs.load(std::memory_order_relaxed) : 0; }
+
+            //////////////////////////////////////////////
+            // Character access
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Return the code point at the given index. The index is not checked
+             */
+            value_type operator[](size_type idx) const { return ptr()[idx]; }
+
+            /*!
+             * \brief
+             * Return the code point at the given index
+             * \exception
+             * std::out_of_range Thrown if \a idx is >= Length()
+             */
+            value_type At(size_type idx) const { return View().At(idx); }
+
+            /*!
+             * \brief
+             * Returns a pointer to the null terminated code points
+             */
+            const utf32 *ptr() const { return d_rep ? reinterpret_cast<const utf32 *>(d_rep + 1) : &s_empty; }
+
+            const_iterator Begin() const { return ptr(); }
+
+            const_iterator End() const { return ptr() + Length(); }
+
+            const_iterator begin() const { return Begin(); }
+
+            const_iterator end() const { return End(); }
+
+            /*!
+             * \brief
+             * Returns a view of a part of the string
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this string
+             */
+            EdoStringView View(size_type idx = 0, size_type len = npos) const {
+                return EdoStringView(ptr(), Length()).Substr(idx, len);
+            }
+
+            /*!
+             * \brief
+             * Returns a view of the whole string, so it can be passed wherever an EdoStringView is expected
+             */
+            operator EdoStringView() const { return EdoStringView(ptr(), Length()); }
+
+            //////////////////////////////////////////////
+            // utf8 and hashing
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Returns the contents as null terminated utf8 data. The encoding is built once and shared by all copies,
+             * and stays valid for as long as one of them lives
+             */
+            const char *c_str() const { return reinterpret_cast<const char *>(Data()); }
+
+            /*!
+             * \brief
+             * Returns the contents as null terminated utf8 data, see c_str()
+             */
+            const utf8 *Data() const;
+
+            /*!
+             * \brief
+             * Return the length of the utf8 encoding in code units, not including the null terminator
+             */
+            size_type Utf8Length() const;
+
+            /*!
+             * \brief
+             * Return a hash of the code points, equal to EdoString::Hash() of the same value. It is computed once and
+             * shared by all copies
+             */
+            size_type Hash() const;
+
+            //////////////////////////////////////////////
+            // Comparison and searching
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Compares this string with \a view, see EdoStringView::Compare()
+             */
+            int Compare(EdoStringView view) const { return View().Compare(view); }
+
+            bool StartsWith(EdoStringView view) const { return View().StartsWith(view); }
+
+            bool EndsWith(EdoStringView view) const { return View().EndsWith(view); }
+
+            size_type Find(utf32 code_point, size_type idx = 0) const { return View().Find(code_point, idx); }
+
+            size_type Find(EdoStringView view, size_type idx = 0) const { return View().Find(view, idx); }
+
+            size_type RFind(utf32 code_point, size_type idx = npos) const { return View().RFind(code_point, idx); }
+
+            size_type RFind(EdoStringView view, size_type idx = npos) const { return View().RFind(view, idx); }
+
+            /*!
+             * \brief
+             * Return true if both strings share the same buffer, which implies they are equal
+             */
+            bool SharesWith(const EdoSharedString &str) const { return d_rep == str.d_rep; }
+
+        private:
+            //! Header of the shared block, followed by the null terminated code points
+            struct Rep {
+                std::atomic<size_type> refs; //!< Number of EdoSharedString objects holding the block
+                std::atomic<utf8 *> encoded; //!< utf8 encoding, null until first built. Its length is stored in front of it
+                std::atomic<size_type> hash; //!< Cached Hash(), 0 while unknown
+                size_type length; //!< Number of code points
+            };
+
+            // Allocate a block holding 'len' code points, with a reference count of one
+            static Rep *Create(const utf32 *src, size_type len);
+
+            // Drop a reference to a block, freeing it with the last one
+            static void Release(Rep *rep);
+
+            // Encode a block as utf8 and publish the result
+            static utf8 *BuildEncoded(Rep *rep);
+
+            static const utf32 s_empty; //!< Data of the empty string
+
+            Rep *d_rep; //!< The shared block, null for the empty string
+        };
+
+        inline bool operator==(const EdoSharedString &str1, const EdoSharedString &str2) {
+            return str1.SharesWith(str2) || EdoStringView(str1) == EdoStringView(str2);
+        }
+
+        inline bool operator!=(const EdoSharedString &str1, const EdoSharedString &str2) { return !(str1 == str2); }
+    } // Namespace Types
+} // Namespace Edo
+
+namespace std {
+    //! Lets EdoSharedString be used as key of the unordered containers without naming a hasher
+    template<>
+    struct hash<Edo::Types::EdoSharedString> {
+        size_t operator()(const Edo::Types::EdoSharedString &str) const {
+            return str.Hash();
+        }
+    };
+} // Namespace std
+
+#endif // EDOCORE_EDOSHAREDSTRING_H
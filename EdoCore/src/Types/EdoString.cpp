@@ -28,21 +28,55 @@
  ***************************************************************************/
 #include "EdoString.h"
 #include <iostream>
+#include <new>
+#include <thread>
+
+#define STR_COMPARE_CHUNK 64 // utf8 code units compared at a time against the code points of an EdoString
+#define STR_UTF16_CHUNK 256 // utf16 code units ToUtf16() encodes at a time when wchar_t has more than 16 bits
+#define STR_REPLACE_QUICK_MATCHES 128 // Matches ReplaceAll() records on the stack before moving them to the heap
 
 namespace Edo {
     namespace Types {
         // Definition of 'no position' value
         const EdoString::size_type EdoString::npos = (EdoString::size_type) (-1);
+        const EdoStringView::size_type EdoStringView::npos;
 
         ///////////////////////////////////////////////
         // Destructor
         ///////////////////////////////////////////////
         EdoString::~EdoString() {
-            if (d_reserve > STR_QUICKBUFF_SIZE)
-                delete[] d_buffer;
+            if (d_onHeap)
+                FreeBlock(d_heap.d_buffer);
+
+            FreeUtf8Buff();
+        }
+
+        void EdoString::Release() noexcept {
+            if (d_onHeap)
+                FreeBlock(d_heap.d_buffer);
+
+            FreeUtf8Buff();
+            Init();
+        }
+
+        ///////////////////////////////////////////////
+        // Buffer management
+        ///////////////////////////////////////////////
+        void *EdoString::AllocateBlock(EdoStringAllocator &allocator, EdoString::size_type bytes) {
+            if (bytes > ((size_type) -1) - sizeof(BlockHeader))
+                throw std::length_error("Resulting EdoString would be too large");
 
-            if (d_encodedBuffLen > 0)
-                delete[] d_encodedBuff;
+            BlockHeader *header = new(allocator.Allocate(sizeof(BlockHeader) + bytes)) BlockHeader;
+            header->d_allocator = &allocator;
+            header->d_bytes = sizeof(BlockHeader) + bytes;
+            header->d_hash.store(0, std::memory_order_relaxed);
+
+            return header + 1;
+        }
+
+        void EdoString::FreeBlock(void *data) {
+            BlockHeader *header = HeaderOf(data);
+            header->d_allocator->Deallocate(header, header->d_bytes);
         }
 
         bool EdoString::Grow(EdoString::size_type new_size) {
@@ -53,18 +87,25 @@ namespace Edo {
             // Increase, as we always null-terminate the buffer
             ++new_size;
 
-            if (new_size > d_reserve) {
-                utf32 *temp = new utf32[new_size]; // TODO: Is this okay from CEGUI_NEW_ARRAY_PT()?
+            if (new_size > Reserved()) {
+                EdoStringAllocator &allocator = GetAllocator();
+
+                // Once on the heap, let the growth policy decide how much extra room to leave for later appends
+                if (d_onHeap)
+                    new_size = allocator.GrowSize(d_heap.d_reserve, new_size, MaxSize());
+
+                utf32 *temp = static_cast<utf32 *>(AllocateBlock(allocator, new_size * sizeof(utf32)));
 
-                if (d_reserve > STR_QUICKBUFF_SIZE) {
-                    memcpy(temp, d_buffer, (d_cpLength + 1) * sizeof(utf32));
-                    delete[] d_buffer;
+                if (d_onHeap) {
+                    memcpy(temp, d_heap.d_buffer, (d_cpLength + 1) * sizeof(utf32));
+                    FreeBlock(d_heap.d_buffer);
                 } else {
                     memcpy(temp, d_quickBuff, (d_cpLength + 1) * sizeof(utf32));
                 }
 
-                d_buffer = temp;
-                d_reserve = new_size;
+                d_heap.d_buffer = temp;
+                d_heap.d_reserve = new_size;
+                d_onHeap = 1;
 
                 return true;
             }
@@ -77,50 +118,449 @@ namespace Edo {
             size_type min_size = d_cpLength + 1;
 
             // Only re-allocate when not using quick-buffer, and when size can be trimmed
-            if (d_reserve > STR_QUICKBUFF_SIZE && d_reserve > min_size) {
+            if (d_onHeap && d_heap.d_reserve > min_size) {
                 // See if we can trim to quick-buffer
                 if (min_size <= STR_QUICKBUFF_SIZE) {
-                    memcpy(d_quickBuff, d_buffer, min_size * sizeof(utf32));
-                    delete[] d_buffer;
-                    d_reserve = STR_QUICKBUFF_SIZE;
+                    // The quick-buffer overlaps the heap details, so hold on to the buffer pointer before copying
+                    utf32 *temp = d_heap.d_buffer;
+                    memcpy(d_quickBuff, temp, min_size * sizeof(utf32));
+                    FreeBlock(temp);
+                    d_onHeap = 0;
+
+                    // The utf8 encoding may come from the allocator of the freed buffer, which the string no longer
+                    // depends on, so release it unless it is from the default allocator
+                    uintptr_t encoded = reinterpret_cast<uintptr_t>(d_encodedBuff.load(std::memory_order_relaxed));
+
+                    if (encoded != 0 && HeaderOf(reinterpret_cast<utf8 *>(encoded & ~STR_UTF8_TAGS))->d_allocator !=
+                                        &EdoStringAllocator::GetDefault())
+                        FreeUtf8Buff();
                 }
-                    // Re-allocate buffer
+                    // Re-allocate buffer, from the same allocator and at exactly the required size
                 else {
-                    utf32 *temp = new utf32[min_size];
-                    memcpy(temp, d_buffer, min_size * sizeof(utf32));
-                    delete[] d_buffer;
-                    d_buffer = temp;
-                    d_reserve = min_size;
+                    utf32 *temp = static_cast<utf32 *>(AllocateBlock(GetAllocator(), min_size * sizeof(utf32)));
+                    memcpy(temp, d_heap.d_buffer, min_size * sizeof(utf32));
+                    FreeBlock(d_heap.d_buffer);
+                    d_heap.d_buffer = temp;
+                    d_heap.d_reserve = min_size;
                 }
             }
         }
 
-        // Build an internal buffer with the string encoded as utf8 (remains valid until string is modified).
+        // Build the utf8 encoding of the string and publish it. Several const callers may race here on different
+        // threads: the first one publishes a new block, or claims the stale one and encodes into it again, while the
+        // others use the result. A published block is not written again until the string is modified
         utf8 *EdoString::BuildUtf8Buff() const {
+            utf8 *current = d_encodedBuff.load(std::memory_order_acquire);
+
+            for (;;) {
+                uintptr_t tags = reinterpret_cast<uintptr_t>(current) & STR_UTF8_TAGS;
+
+                if (current != nullptr && tags == 0)
+                    return current;
+
+                if (tags & STR_UTF8_BUILDING) {
+                    // Another thread is encoding into the stale block, which takes no longer than one encode
+                    std::this_thread::yield();
+                    current = d_encodedBuff.load(std::memory_order_acquire);
+                    continue;
+                }
+
+                if (current == nullptr) {
+                    utf8 *encoded = EncodeUtf8Block(nullptr);
+
+                    if (d_encodedBuff.compare_exchange_strong(current, encoded, std::memory_order_acq_rel,
+                                                              std::memory_order_acquire))
+                        return encoded;
+
+                    FreeBlock(encoded);
+                    continue;
+                }
+
+                utf8 *claimed = reinterpret_cast<utf8 *>(reinterpret_cast<uintptr_t>(current) | STR_UTF8_BUILDING);
+
+                if (!d_encodedBuff.compare_exchange_strong(current, claimed, std::memory_order_acquire,
+                                                           std::memory_order_acquire))
+                    continue;
+
+                utf8 *encoded;
+
+                try {
+                    encoded = EncodeUtf8Block(
+                            reinterpret_cast<utf8 *>(reinterpret_cast<uintptr_t>(current) & ~STR_UTF8_TAGS));
+                } catch (...) {
+                    d_encodedBuff.store(current, std::memory_order_release); // Back to stale for the next caller
+                    throw;
+                }
+
+                d_encodedBuff.store(encoded, std::memory_order_release);
+                return encoded;
+            }
+        }
+
+        utf8 *EdoString::EncodeUtf8Block(utf8 *block) const {
             size_type buffSize = EncodedSize(ptr(), d_cpLength) + 1;
 
-            if (buffSize > d_encodedBuffLen) {
-                if (d_encodedBuffLen > 0)
-                    delete[] d_encodedBuff;
+            EdoStringAllocator &allocator = EncodingAllocator();
+
+            // A stale block is only reused when it is large enough and comes from the allocator the string uses now
+            if (block == nullptr || HeaderOf(block)->d_bytes - sizeof(BlockHeader) < buffSize ||
+                HeaderOf(block)->d_allocator != &allocator) {
+                utf8 *larger = static_cast<utf8 *>(AllocateBlock(allocator, buffSize));
+
+                if (block != nullptr)
+                    FreeBlock(block);
+
+                block = larger;
+            }
+
+            // Code points the encoder has to replace can take fewer code units than were counted
+            block[d_cpLength ? Encode(ptr(), block, buffSize, d_cpLength) : 0] = (utf8) 0;
+            return block;
+        }
+
+        void EdoString::FreeUtf8Buff() {
+            uintptr_t encoded = reinterpret_cast<uintptr_t>(d_encodedBuff.load(std::memory_order_relaxed));
 
-                d_encodedBuff = new utf8[buffSize];
-                d_encodedBuffLen = buffSize;
+            if (encoded != 0) {
+                FreeBlock(reinterpret_cast<utf8 *>(encoded & ~STR_UTF8_TAGS));
+                d_encodedBuff.store(nullptr, std::memory_order_relaxed);
             }
+        }
+
+        EdoString &EdoString::AssignWide(const wchar_t *chars, EdoString::size_type num) {
+            bool grew = Grow(num);
+            SetLen(0);
+            SetLen(DecodeWide(chars, num, ptr()));
+            TrimDecodeSlack(grew);
+            return *this;
+        }
+
+        int EdoString::CompareUtf8(EdoString::size_type idx, EdoString::size_type len, const utf8 *utf8_str,
+                                   EdoString::size_type units) const {
+            utf32 decoded[STR_COMPARE_CHUNK];
+            const utf32 *pt = ptr() + idx;
+            size_type pos = 0;
+
+            while (pos < units) {
+                size_type take = std::min(units - pos, (size_type) STR_COMPARE_CHUNK);
+
+                // End the chunk before the lead of a sequence that runs past it, or the sequence would decode as
+                // malformed. Without a lead in the last three code units, no well-formed sequence runs past the chunk
+                if (pos + take < units && (utf8_str[pos + take] & 0xC0) == 0x80) {
+                    for (size_type back = 1; back <= 3 && back < take; ++back) {
+                        if ((utf8_str[pos + take - back] & 0xC0) != 0x80) {
+                            take -= back;
+                            break;
+                        }
+                    }
+                }
+
+                size_type count = DecodeUtf8(utf8_str + pos, take, decoded);
+
+                for (size_type i = 0; i < std::min(count, len); ++i) {
+                    if (pt[i] != decoded[i])
+                        return (pt[i] < decoded[i]) ? -1 : 1;
+                }
 
-            Encode(ptr(), d_encodedBuff, buffSize, d_cpLength);
+                if (count > len)
+                    return -1;
 
-            // Always add a null at the end
-            d_encodedBuff[buffSize - 1] = (utf8) 0;
-            d_encodedDatLen = buffSize;
+                pt += count;
+                len -= count;
+                pos += take;
+            }
 
-            return d_encodedBuff;
+            return (len == 0) ? 0 : 1;
+        }
+
+        ///////////////////////////////////////////////
+        // Replace every occurrence
+        ///////////////////////////////////////////////
+        namespace {
+            //! An occurrence found by ReplaceAll(), with the index of the replacement that applies to it
+            struct ReplaceMatch {
+                size_t pos;
+                size_t replacement;
+            };
+
+            //! Occurrences found by ReplaceAll() before it writes anything, kept on the stack while there are few
+            class ReplaceMatchList {
+            public:
+                ReplaceMatchList() : d_count(0) {}
+
+                void Add(size_t pos, size_t replacement) {
+                    ReplaceMatch match = {pos, replacement};
+
+                    if (d_count < STR_REPLACE_QUICK_MATCHES)
+                        d_quick[d_count] = match;
+                    else
+                        d_more.push_back(match);
+
+                    ++d_count;
+                }
+
+                const ReplaceMatch &operator[](size_t idx) const {
+                    return idx < STR_REPLACE_QUICK_MATCHES ? d_quick[idx] : d_more[idx - STR_REPLACE_QUICK_MATCHES];
+                }
+
+                size_t Size() const { return d_count; }
+
+            private:
+                ReplaceMatch d_quick[STR_REPLACE_QUICK_MATCHES];
+                std::vector<ReplaceMatch> d_more;
+                size_t d_count;
+            };
+
+            // Copy 'len' code points, allowing for an empty view whose data is null
+            inline utf32 *CopyCodePoints(utf32 *dest, const utf32 *src, size_t len) {
+                if (len != 0)
+                    memmove(dest, src, len * sizeof(utf32));
+
+                return dest + len;
+            }
+        }
+
+        EdoString &EdoString::ReplaceAll(utf32 from, utf32 to) {
+            const EdoSplitByCodePoint finder(from);
+            const EdoStringView source = *this;
+            size_type pos = finder.Find(source.Data(), source.Length());
+
+            if (pos == STR_NOT_FOUND || from == to)
+                return *this;
+
+            utf32 *data = ptr();
+
+            while (pos != STR_NOT_FOUND) {
+                data[pos++] = to;
+
+                size_type next = finder.Find(data + pos, d_cpLength - pos);
+                pos = (next == STR_NOT_FOUND) ? next : pos + next;
+            }
+
+            return *this;
+        }
+
+        EdoString &EdoString::ReplaceAll(EdoStringView from, EdoStringView to) {
+            if (from.Empty() || from.Length() > d_cpLength)
+                return *this;
+
+            // Writing in place could overwrite the patterns
+            if (Aliases(from) || Aliases(to))
+                return ReplaceAll(EdoString(from), EdoString(to));
+
+            // The split delimiters look at the first code points before calling the search kernels, which pays off
+            // for the short gaps between occurrences in usual text
+            if (from.Length() == 1)
+                return ReplaceOccurrences(EdoSplitByCodePoint(from.Front()), to);
+
+            return ReplaceOccurrences(EdoSplitBySubstring(EdoStringSearcher(from.Data(), from.Length())), to);
+        }
+
+        template<typename Delimiter>
+        EdoString &EdoString::ReplaceOccurrences(const Delimiter &from, EdoStringView to) {
+            const size_type fromLen = from.Length(), toLen = to.Length();
+            const EdoStringView source = *this;
+            size_type pos = from.Find(source.Data(), source.Length());
+
+            if (pos == STR_NOT_FOUND)
+                return *this;
+
+            // Not growing: compact the text towards the front as the occurrences are found, the write position never
+            // passes the read one
+            if (toLen <= fromLen) {
+                utf32 *data = ptr();
+                utf32 *dest = data;
+                size_type read = 0;
+
+                while (pos != STR_NOT_FOUND) {
+                    dest = CopyCodePoints(dest, data + read, pos);
+                    dest = CopyCodePoints(dest, to.Data(), toLen);
+                    read += pos + fromLen;
+                    pos = from.Find(data + read, d_cpLength - read);
+                }
+
+                dest = CopyCodePoints(dest, data + read, d_cpLength - read);
+                SetLen(dest - data);
+                return *this;
+            }
+
+            // Growing: find every occurrence first, grow once, then move the text back to front
+            ReplaceMatchList matches;
+            size_type read = 0;
+
+            while (pos != STR_NOT_FOUND) {
+                matches.Add(read + pos, 0);
+                read += pos + fromLen;
+                pos = from.Find(source.Data() + read, d_cpLength - read);
+            }
+
+            if ((MaxSize() - d_cpLength) / matches.Size() <= toLen - fromLen)
+                throw std::length_error("Resulting EdoString would be too large");
+
+            size_type newSize = d_cpLength + matches.Size() * (toLen - fromLen);
+            Grow(newSize);
+
+            utf32 *data = ptr();
+            utf32 *dest = data + newSize;
+            size_type end = d_cpLength;
+
+            for (size_type i = matches.Size(); i-- != 0;) {
+                size_type tail = end - (matches[i].pos + fromLen);
+
+                dest -= tail;
+                CopyCodePoints(dest, data + matches[i].pos + fromLen, tail);
+                dest -= toLen;
+                CopyCodePoints(dest, to.Data(), toLen);
+                end = matches[i].pos;
+            }
+
+            SetLen(newSize);
+            return *this;
+        }
+
+        EdoString &EdoString::ReplaceAll(const EdoReplacement *replacements, EdoString::size_type count) {
+            // Candidates are the positions holding the first code point of some pattern
+            EdoCodePointSet firsts;
+            bool grows = false;
+            bool aliased = false;
+
+            for (size_type r = 0; r < count; ++r) {
+                if (replacements[r].from.Empty())
+                    continue;
+
+                firsts.Insert(replacements[r].from.Front());
+                grows = grows || replacements[r].to.Length() > replacements[r].from.Length();
+                aliased = aliased || Aliases(replacements[r].from) || Aliases(replacements[r].to);
+            }
+
+            if (firsts.Empty())
+                return *this;
+
+            const EdoSplitBySet candidates(std::move(firsts));
+
+            // Find the occurrences, working out the length of the result as they come
+            const EdoStringView source = *this;
+            const utf32 *src = source.Data();
+            ReplaceMatchList matches;
+            size_type newSize = d_cpLength;
+            size_type at = 0;
+
+            while (at < d_cpLength) {
+                size_type pos = candidates.Find(src + at, d_cpLength - at);
+
+                if (pos == STR_NOT_FOUND)
+                    break;
+
+                at += pos;
+
+                size_type r = 0;
+
+                for (; r < count; ++r) {
+                    const EdoStringView &pattern = replacements[r].from;
+
+                    if (!pattern.Empty() && pattern.Length() <= d_cpLength - at &&
+                        memcmp(src + at, pattern.Data(), pattern.Length() * sizeof(utf32)) == 0)
+                        break;
+                }
+
+                if (r == count) {
+                    ++at;
+                    continue;
+                }
+
+                if (MaxSize() - newSize <= replacements[r].to.Length())
+                    throw std::length_error("Resulting EdoString would be too large");
+
+                matches.Add(at, r);
+                newSize = newSize + replacements[r].to.Length() - replacements[r].from.Length();
+                at += replacements[r].from.Length();
+            }
+
+            if (matches.Size() == 0)
+                return *this;
+
+            // The result is written front to back, either over the text itself when no replacement makes it longer
+            // (and none of the patterns lives in it), or into a new buffer from the same allocator
+            const bool inPlace = !grows && !aliased;
+            EdoString result;
+            utf32 *dest;
+
+            if (inPlace) {
+                dest = ptr();
+            } else {
+                EdoStringAllocatorScope scope(GetAllocator());
+                result.Grow(newSize);
+                dest = result.ptr();
+            }
+
+            size_type read = 0;
+
+            for (size_type i = 0; i < matches.Size(); ++i) {
+                const EdoReplacement &replacement = replacements[matches[i].replacement];
+
+                dest = CopyCodePoints(dest, src + read, matches[i].pos - read);
+                dest = CopyCodePoints(dest, replacement.to.Data(), replacement.to.Length());
+                read = matches[i].pos + replacement.from.Length();
+            }
+
+            CopyCodePoints(dest, src + read, d_cpLength - read);
+
+            if (inPlace) {
+                SetLen(newSize);
+            } else {
+                result.SetLen(newSize);
+                result.SetHashCaching(IsHashCaching());
+                Swap(result);
+            }
+
+            return *this;
+        }
+
+        ///////////////////////////////////////////////
+        // utf16 conversion
+        ///////////////////////////////////////////////
+        std::wstring EdoString::ToUtf16(bool strictConversion) const {
+            const EdoUtf16Policy policy = strictConversion ? Utf16Throw : Utf16Replace;
+            std::wstring target(Utf16Length(), L'\0');
+
+            if (target.empty())
+                return target;
+
+            // The wide string is the utf16 buffer when wchar_t has 16 bits
+            if (sizeof(wchar_t) == sizeof(utf16)) {
+                EncodeUtf16(ptr(), d_cpLength, reinterpret_cast<utf16 *>(&target[0]), target.size(), policy);
+                return target;
+            }
+
+            // Otherwise encode in chunks and widen them. The chunks stop at an error, so that the index thrown is the
+            // one in this string
+            utf16 chunk[STR_UTF16_CHUNK];
+            size_type idx = 0;
+            size_type out = 0;
+
+            while (idx < d_cpLength) {
+                size_type take = std::min(d_cpLength - idx, (size_type) STR_UTF16_CHUNK / 2);
+                size_type error;
+                size_type units = EncodeUtf16(ptr() + idx, take, chunk, STR_UTF16_CHUNK,
+                                              strictConversion ? Utf16Stop : Utf16Replace, &error);
+
+                if (strictConversion && error != UTF_NO_ERROR)
+                    throw std::invalid_argument("No utf16 form for the code point at index " + std::to_string(idx + error));
+
+                std::copy(chunk, chunk + units, &target[out]);
+                idx += take;
+                out += units;
+            }
+
+            return target;
         }
 
         ///////////////////////////////////////////////
         // Comparison operators
         ///////////////////////////////////////////////
         bool operator==(const EdoString &str1, const EdoString &str2) {
-            return str1.Compare(str2) == 0;
+            // Equality needs no ordering, so strings of different lengths are told apart without looking at the data
+            return str1.Length() == str2.Length() && memcmp(str1.ptr(), str2.ptr(), str1.Length() * sizeof(utf32)) == 0;
         }
 
         bool operator==(const EdoString &str, const std::string &std_str) {
@@ -140,7 +580,7 @@ namespace Edo {
         }
 
         bool operator!=(const EdoString &str1, const EdoString &str2) {
-            return str1.Compare(str2) != 0;
+            return !(str1 == str2);
         }
 
         bool operator!=(const EdoString &str, const std::string &std_str) {
@@ -347,6 +787,61 @@ namespace Edo {
             return temp;
         }
 
+        EdoString operator+(EdoString &&str1, const EdoString &str2) {
+            str1.Append(str2);
+            return std::move(str1);
+        }
+
+        EdoString operator+(const EdoString &str1, EdoString &&str2) {
+            str2.Insert(0, str1);
+            return std::move(str2);
+        }
+
+        EdoString operator+(EdoString &&str1, EdoString &&str2) {
+            str1.Append(std::move(str2));
+            return std::move(str1);
+        }
+
+        EdoString operator+(EdoString &&str, const std::string &std_str) {
+            str.Append(std_str);
+            return std::move(str);
+        }
+
+        EdoString operator+(const std::string &std_str, EdoString &&str) {
+            str.Insert(0, std_str);
+            return std::move(str);
+        }
+
+        EdoString operator+(EdoString &&str, const utf8 *utf8_str) {
+            str.Append(utf8_str);
+            return std::move(str);
+        }
+
+        EdoString operator+(const utf8 *utf8_str, EdoString &&str) {
+            str.Insert(0, utf8_str);
+            return std::move(str);
+        }
+
+        EdoString operator+(EdoString &&str, utf32 code_point) {
+            str.Append(1, code_point);
+            return std::move(str);
+        }
+
+        EdoString operator+(utf32 code_point, EdoString &&str) {
+            str.Insert(0, 1, code_point);
+            return std::move(str);
+        }
+
+        EdoString operator+(EdoString &&str, const char *c_str) {
+            str += c_str;
+            return std::move(str);
+        }
+
+        EdoString operator+(const char *c_str, EdoString &&str) {
+            str.Insert(0, c_str);
+            return std::move(str);
+        }
+
         ///////////////////////////////////////////////
         // Output (stream) functions
         ///////////////////////////////////////////////
@@ -357,7 +852,7 @@ namespace Edo {
         ///////////////////////////////////////////////
         // Modifying operations
         ///////////////////////////////////////////////
-        void Swap(EdoString &str1, EdoString &str2) {
+        void Swap(EdoString &str1, EdoString &str2) noexcept {
             str1.Swap(str2);
         }
     } // Namespace Types
@@ -30,20 +30,29 @@
 #define EDOCORE_EDOSTRING_H
 
 #include "EdoBase.h"
+#include "EdoHash.h"
+#include "EdoNumber.h"
+#include "EdoStringAllocator.h"
+#include "EdoStringSearch.h"
+#include "EdoStringSplit.h"
+#include "EdoStringView.h"
+#include "EdoUtf.h"
+#include <climits>
 #include <cstring>
 #include <stdexcept>
 #include <cstddef>
+#include <cstdint>
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <initializer_list>
+#include <sstream>
 
 namespace Edo {
     namespace Types {
         /***************************************
-         * Basic Types
+         * Basic Types (utf8, utf16 and utf32 are defined in EdoUtf.h)
          ***************************************/
-        typedef unsigned char utf8;
-        typedef unsigned short utf16; // Not implemented in CEGUI, Custom UTF16 implementation later
-        typedef unsigned int utf32;
-
         struct EdoByteOrderMark {
             static std::string Utf8() { return "\xEF\xBB\xBF"; }
 
@@ -56,7 +65,31 @@ namespace Edo {
             static std::string Utf32BE() { return std::string("\x00\x00\xFE\xFF", 4); }
         };
 
-#define STR_QUICKBUFF_SIZE 32
+// Number of code points (including the null terminator) held in the quick-buffer, which shares its storage with the
+// heap buffer pointer and reserve. Eight keeps labels and identifiers of up to seven code points off the heap, for a
+// sizeof(EdoString) of 48 bytes on 64-bit builds. Four would give 32 bytes, but then only three code points fit and
+// most of the corpus in EdoCoreBench allocates (1023 instead of 895 allocations to build the 1024 string layout set).
+// The utf8 cache pointer cannot move into the heap block header to make room: c_str() of a quick-buffer string
+// publishes its encoding from a const call, so the pointer needs a slot in the object that no code point uses
+#define STR_QUICKBUFF_SIZE 8
+
+// Bits of the length field, which shares a size_t with the two flag bits. MaxSize() stays below this limit
+#define STR_LENGTH_BITS (sizeof(size_t) * CHAR_BIT - 2)
+
+#define STR_DECODE_SLACK 64 // Unused code points tolerated after decoding utf8 before the buffer is trimmed
+
+#define STR_UTF8_STALE ((uintptr_t) 1) // Tag on the utf8 encoding pointer: the string changed since it was built
+#define STR_UTF8_BUILDING ((uintptr_t) 2) // Tag on the utf8 encoding pointer: a c_str() call is rebuilding it
+#define STR_UTF8_TAGS (STR_UTF8_STALE | STR_UTF8_BUILDING)
+
+        /*!
+         * \brief
+         * One substitution for EdoString::ReplaceAll(): every occurrence of \a from is replaced with \a to
+         */
+        struct EdoReplacement {
+            EdoStringView from; //!< Code points to search for. An empty view never matches
+            EdoStringView to; //!< Code points written in place of each occurrence of \a from
+        };
 
         /*!
           \brief
@@ -79,18 +112,34 @@ namespace Edo {
             static const size_type npos; //!< Value used to represent 'not found' conditions and 'all code points' etc.
 
         private:
+            friend class EdoStringBuilder; // Writes the concatenated pieces straight into the buffer
+
             /***************************************
              * Implementation data
              ***************************************/
-            size_type d_cpLength; //!< Holds length of string in code point (not including null termination)
-            size_type d_reserve; //!< Code point reserve size (currently allocated buffer size in code points)
+            size_type d_cpLength : STR_LENGTH_BITS; //!< Holds length of string in code point (not including null termination)
+            size_type d_onHeap : 1; //!< Set when the string data lives in d_heap rather than the quick-buffer
+            size_type d_hashCache : 1; //!< Set when Hash() keeps its result in the header of the heap buffer
+
+            mutable std::atomic<utf8 *> d_encodedBuff; //!< utf8 encoding published by c_str() and Data(). The low bits hold the STR_UTF8_ tags, any non-const call marks it stale
+
+            //! Every heap block (string data and utf8 encoding) starts with this header, in front of the pointer we hold
+            struct BlockHeader {
+                EdoStringAllocator *d_allocator; //!< Allocator the block was taken from
+                size_type d_bytes; //!< Size of the whole block in bytes, including this header
+                std::atomic<size_type> d_hash; //!< Cached Hash() of the string data, 0 while unknown. Unused for utf8 blocks
+            };
 
-            mutable utf8 *d_encodedBuff; //!< Holds string data encoded as utf8 (generated only by calls to c_str() and data())
-            mutable size_type d_encodedDatLen; //!< Holds length of encoded data (in case it's smaller than buffer)
-            mutable size_type d_encodedBuffLen; //!< Length of above buffer (since buffer can be bigger than the data it holds to save re-allocation)
+            //! Heap buffer details, only valid when d_onHeap is set
+            struct HeapBuffer {
+                utf32 *d_buffer; //!< Pointer to the main buffer memory
+                size_type d_reserve; //!< Code point reserve size (currently allocated buffer size in code points)
+            };
 
-            utf32 d_quickBuff[STR_QUICKBUFF_SIZE]; //!< This is a integrated 'quick' buffer to save allocations for smallish strings
-            utf32 *d_buffer; //!< Pointer to the main buffer memory. This is only valid when quick-buffer is not being used
+            union {
+                utf32 d_quickBuff[STR_QUICKBUFF_SIZE]; //!< This is a integrated 'quick' buffer to save allocations for smallish strings
+                HeapBuffer d_heap; //!< Main buffer memory, used once the string outgrows the quick-buffer
+            };
 
         public:
             /***************************************
@@ -318,9 +367,21 @@ namespace Edo {
              */
             EdoString(const EdoString &str) {
                 Init();
+                d_hashCache = str.d_hashCache;
                 Assign(str);
             }
 
+            /*!
+             * \brief
+             * Move constructor - Creates a new string by taking over the buffers of \a str
+             * @param str
+             * EdoString object whose data is moved into the newly created string. \a str is left empty
+             */
+            EdoString(EdoString &&str) noexcept {
+                Init();
+                Swap(str);
+            }
+
             /*!
              * \brief
              * Constructs a new string initialized with code points from another EdoString object
@@ -336,6 +397,20 @@ namespace Edo {
                 Assign(str, str_idx, str_num);
             }
 
+            //////////////////////////////////////////////
+            // Construction via Edo::Types::EdoStringView
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Constructs a new string holding a copy of the code points of \a view
+             * @param view
+             * EdoStringView object used to initialize the newly created string
+             */
+            explicit EdoString(EdoStringView view) {
+                Init();
+                Assign(view);
+            }
+
             //////////////////////////////////////////////
             // Construction via std::string
             //////////////////////////////////////////////
@@ -385,9 +460,8 @@ namespace Edo {
              * Pointer to a buffer containing a null-terminated Unicode string encoded as utf8 data
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are replaced with UTF_REPLACEMENT_CHAR like any other malformed sequence.
              * \exception std::length_error
              * Thrown if resulting EdoString object would be too big
              */
@@ -403,17 +477,23 @@ namespace Edo {
              * Pointer to a buffer containing a null-terminated Unicode string encoded as utf8 data
              * @param chars_len
              * Length of the provided utf8 string in code units (not code-points)
+             * @param policy
+             * What to do with malformed utf8 data (see EdoUtf8Policy)
+             * @param error_offset
+             * If not null, receives the offset of the first malformed sequence in \a utf8_str, or UTF_NO_ERROR
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are handled according to \a policy.
              * \exception std::length_error
              * Thrown if resulting EdoString object would be too big
+             * \exception std::invalid_argument
+             * Thrown if \a utf8_str is malformed and \a policy is Utf8Throw
              */
-            EdoString(const utf8 *utf8_str, size_type chars_len) {
-                Init();
-                Assign(utf8_str, chars_len);
+            EdoString(const utf8 *utf8_str, size_type chars_len, EdoUtf8Policy policy = Utf8Replace,
+                      size_type *error_offset = nullptr) : EdoString() {
+                // Delegating, so the destructor releases the buffer if decoding throws
+                Assign(utf8_str, chars_len, policy, error_offset);
             }
 
             //////////////////////////////////////////////
@@ -530,7 +610,18 @@ namespace Edo {
              * Size of the current reserve buffer. This is the maximum number of code points the EdoString could hold before
              * a buffer re-allocation would be required
              */
-            size_type Capacity() const { return d_reserve - 1; }
+            size_type Capacity() const { return Reserved() - 1; }
+
+            /*!
+             * \brief
+             * Return the allocator this EdoString takes its memory from. While the data still fits the quick-buffer this
+             * is the current allocator of the calling thread, which is the one the first heap buffer will come from
+             * @return
+             * The allocator of the heap buffer in use, or EdoStringAllocator::GetCurrent()
+             */
+            EdoStringAllocator &GetAllocator() const {
+                return d_onHeap ? *HeaderOf(d_heap.d_buffer)->d_allocator : EdoStringAllocator::GetCurrent();
+            }
 
             // Reserve internal memory for at-least 'num' code-points (characters). If num is 0, request is shrink-to-fit
             /*!
@@ -550,6 +641,60 @@ namespace Edo {
                     Grow(num);
             }
 
+            //////////////////////////////////////////////
+            // Hashing
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Return a hash of the code points of the EdoString, computed with HashBytes(). Equal strings have equal
+             * hashes, whatever their allocator or hash caching setting
+             * \note
+             * When hash caching is enabled and the data lives on the heap, the first call stores the result in the
+             * buffer and later calls return it straight away, until the string is modified
+             * @return
+             * Hash value of the string
+             */
+            size_type Hash() const {
+                if (!d_hashCache || !d_onHeap)
+                    return (size_type) HashBytes(d_onHeap ? d_heap.d_buffer : d_quickBuff, d_cpLength * sizeof(utf32));
+
+                std::atomic<size_type> &cached = HeaderOf(d_heap.d_buffer)->d_hash;
+                size_type hash = cached.load(std::memory_order_relaxed);
+
+                if (hash == 0) {
+                    hash = (size_type) HashBytes(d_heap.d_buffer, d_cpLength * sizeof(utf32));
+                    cached.store(hash, std::memory_order_relaxed);
+                }
+
+                return hash;
+            }
+
+            /*!
+             * \brief
+             * Enable or disable caching of Hash(). Worth it for long keys that are hashed many times, like the keys
+             * used to query a hash map over and over; short strings in the quick-buffer are always hashed again.
+             *
+             * The setting is copied along with the value by copy construction and assignment from another EdoString,
+             * and follows the buffers on moves and swaps. Every modification through the EdoString interface drops the
+             * cached value, which includes any non-const access to the data (ptr(), operator[], begin(), ...).
+             * \note
+             * Data must not be modified through pointers or iterators obtained before the hash was cached
+             * @param enable
+             * true to cache the hash, false to compute it on every call
+             */
+            void SetHashCaching(bool enable) {
+                if (enable && !d_hashCache && d_onHeap) // The buffer may hold a stale value from an earlier setting
+                    HeaderOf(d_heap.d_buffer)->d_hash.store(0, std::memory_order_relaxed);
+
+                d_hashCache = enable;
+            }
+
+            /*!
+             * \brief
+             * Return true if Hash() caches its result
+             */
+            bool IsHashCaching() const { return d_hashCache; }
+
             //////////////////////////////////////////////
             // Comparisons
             //////////////////////////////////////////////
@@ -606,6 +751,55 @@ namespace Edo {
                 return (val != 0) ? ((val < 0) ? -1 : 1) : (len < str_len) ? -1 : (len == str_len) ? 0 : 1;
             }
 
+            /*!
+             * \brief
+             * Compares this EdoString with the EdoStringView \a view
+             * @param view
+             * The EdoStringView object that is to be compared with this EdoString
+             * @return
+             * - 0 if the EdoString and the view are equal
+             * - <0 if this EdoString is lexicographically smaller than \a view
+             * - >0 if this EdoString is lexicographically greater than \a view
+             */
+            int Compare(EdoStringView view) const { return View().Compare(view); }
+
+            /*!
+             * \brief
+             * Compares code points from this EdoString with code points from the EdoStringView \a view
+             * @param idx
+             * Index of the first code point from this EdoString to consider
+             * @param len
+             * Maximum number of code points from this EdoString to consider
+             * @param view
+             * The EdoStringView object that is to be compared with this EdoString
+             * @param view_idx
+             * Index of the first code point from \a view to consider
+             * @param view_len
+             * Maximum number of code points from \a view to consider
+             * @return
+             * - 0 if the specified sub-strings are equal
+             * - <0 if the specified sub-strings are lexicographically smaller than \a view
+             * - >0 if the specified sub-strings are lexicographically greater than \a view
+             * \exception
+             * std::out_of_range Thrown if either \a idx or \a view_idx are invalid
+             */
+            int Compare(size_type idx, size_type len, EdoStringView view, size_type view_idx = 0,
+                        size_type view_len = npos) const {
+                return View(idx, len).Compare(view.Substr(view_idx, view_len));
+            }
+
+            /*!
+             * \brief
+             * Return true if this EdoString begins with the code points of \a view
+             */
+            bool StartsWith(EdoStringView view) const { return View().StartsWith(view); }
+
+            /*!
+             * \brief
+             * Return true if this EdoString ends with the code points of \a view
+             */
+            bool EndsWith(EdoStringView view) const { return View().EndsWith(view); }
+
             /*!
              * \brief
              * Compares this EdoString with the std::string 'std_str'
@@ -677,15 +871,14 @@ namespace Edo {
              * The buffer containing valid Unicode data encoded as utf8 that is compared with this EdoString.
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and compare as UTF_REPLACEMENT_CHAR like any other malformed sequence.
              * @return
              * - 0 if the EdoString objects are equal
              * - <0 if this EdoString is lexicographically smaller than \a str
              * - >0 if this EdoString is lexicographically greater than \a str
              */
-            int Compare(const utf8 *utf8_str) const { return Compare(0, d_cpLength, utf8_str, EncodedSize(utf8_str)); }
+            int Compare(const utf8 *utf8_str) const { return CompareUtf8(0, d_cpLength, utf8_str, UtfLength(utf8_str)); }
 
             /*!
              * \brief
@@ -700,9 +893,8 @@ namespace Edo {
              * The buffer containing valid Unicode data encoded as utf8 that is to be compared with this EdoString
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and compare as UTF_REPLACEMENT_CHAR like any other malformed sequence.
              * @return
              * - 0 if the EdoString objects are equal
              * - <0 if this EdoString is lexicographically smaller than \a str
@@ -711,7 +903,13 @@ namespace Edo {
              * std::out_of_range Thrown if \a idx is invalid
              */
             int Compare(size_type idx, size_type len, const utf8 *utf8_str) const {
-                return Compare(idx, len, utf8_str, EncodedSize(utf8_str));
+                if (d_cpLength < idx)
+                    throw std::out_of_range("Index is out of range for EdoString");
+
+                if (len == npos || idx + len > d_cpLength)
+                    len = d_cpLength - idx;
+
+                return CompareUtf8(idx, len, utf8_str, UtfLength(utf8_str));
             }
 
             /*!
@@ -901,10 +1099,17 @@ namespace Edo {
              * \note
              * The buffer returned from this function is owned by the EdoString object.
              * \note
-             * Any function that modifies the EdoString data will invalidate the buffer returned by this call.
+             * The encoding is built on the first call and returned as is by later calls, until a non-const member
+             * function is called, which invalidates the buffer returned by this call. The next call then encodes the
+             * string again, reusing the buffer when it is large enough.
+             * \note
+             * Any number of threads may call c_str() and Data() on the same EdoString at once, as long as none of them
+             * modifies it: the encoding is published atomically and never written after that.
+             * \note
+             * Data must not be modified through pointers or iterators obtained before the encoding was built
              */
             const char *c_str() const {
-                return (const char *) BuildUtf8Buff();
+                return (const char *) Data();
             }
 
             /*!
@@ -913,20 +1118,39 @@ namespace Edo {
              * @return
              * Pointer to a buffer containing the contents of the EdoString encoded utf8 data.
              * \note
-             * The buffer returned from this function is owned by the EdoString object.
-             * \note
-             * Any function that modifies the EdoString data will invalidate the buffer returned by this call.
+             * The buffer returned from this function is owned by the EdoString object, see c_str() for how long it
+             * stays valid.
              */
             const utf8 *Data() const {
+                utf8 *encoded = d_encodedBuff.load(std::memory_order_acquire);
+
+                if (encoded != nullptr && (reinterpret_cast<uintptr_t>(encoded) & STR_UTF8_TAGS) == 0)
+                    return encoded;
+
                 return BuildUtf8Buff();
             }
 
             /*!
              * \brief
              * Returns a pointer to the buffer in use.
+             * \note
+             * The pointer may be used to modify the data, so this drops the cached hash (see SetHashCaching()) and
+             * marks the utf8 encoding returned by c_str() as stale
              */
             utf32 *ptr() {
-                return (d_reserve > STR_QUICKBUFF_SIZE) ? d_buffer : d_quickBuff;
+                // Access is exclusive here, so the encoding cannot be in the middle of a rebuild
+                uintptr_t encoded = reinterpret_cast<uintptr_t>(d_encodedBuff.load(std::memory_order_relaxed));
+
+                if (encoded != 0 && (encoded & STR_UTF8_STALE) == 0)
+                    d_encodedBuff.store(reinterpret_cast<utf8 *>(encoded | STR_UTF8_STALE), std::memory_order_relaxed);
+
+                if (!d_onHeap)
+                    return d_quickBuff;
+
+                if (d_hashCache)
+                    HeaderOf(d_heap.d_buffer)->d_hash.store(0, std::memory_order_relaxed);
+
+                return d_heap.d_buffer;
             }
 
             /*!
@@ -934,7 +1158,7 @@ namespace Edo {
              * Returns a const pointer to the buffer in use
              */
             const utf32 *ptr() const {
-                return (d_reserve > STR_QUICKBUFF_SIZE) ? d_buffer : d_quickBuff;
+                return d_onHeap ? d_heap.d_buffer : d_quickBuff;
             }
 
             // copy, at most, 'len' code-points of the EdoString, beginning with code-point 'idx', into the array'buf'
@@ -1003,9 +1227,28 @@ namespace Edo {
              * This EdoString after the assignment has happened
              */
             EdoString &operator=(const EdoString &str) {
+                d_hashCache = str.d_hashCache;
                 return Assign(str);
             }
 
+            /*!
+             * \brief
+             * Move the value of EdoString \a str into this EdoString, taking over its buffers. The previous buffers of
+             * this EdoString are released
+             * @param str
+             * EdoString object whose data is to be moved. \a str is left empty
+             * @return
+             * This EdoString after the assignment has happened
+             */
+            EdoString &operator=(EdoString &&str) noexcept {
+                if (this != &str) {
+                    Swap(str);
+                    str.Release();
+                }
+
+                return *this;
+            }
+
             /*!
              * Assign a sub-string of EdoString \a str to this EdoString
              * @param str
@@ -1033,6 +1276,29 @@ namespace Edo {
                 return *this;
             }
 
+            /*!
+             * \brief
+             * Assign the code points of EdoStringView \a view to this EdoString
+             * \note
+             * \a view may be a view of this EdoString
+             * @param view
+             * EdoStringView object containing the string value to be assigned
+             * @return
+             * This EdoString after the assignment has happened
+             * \exception
+             * std::length_error Thrown if the resulting EdoString would be too large
+             */
+            EdoString &Assign(EdoStringView view) {
+                // A view of this EdoString fits the buffer, so Grow() keeps it and the data can be moved down in place
+                Grow(view.Length());
+
+                if (!view.Empty())
+                    memmove(ptr(), view.Data(), view.Length() * sizeof(utf32));
+
+                SetLen(view.Length());
+                return *this;
+            }
+
             /*!
              * \brief
              * Assign the value of std::string \a std_str to this EdoString
@@ -1091,9 +1357,8 @@ namespace Edo {
              * Assign to this EdoString the string value represented by the given null-terminated utf8 encoded data
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are replaced with UTF_REPLACEMENT_CHAR like any other malformed sequence.
              * @param utf8_str
              * Buffer containing valid null-terminated utf8 encoded data
              * @return
@@ -1110,27 +1375,52 @@ namespace Edo {
              * Assign to this EdoString the string value represented by the given null-terminated utf8 encoded data
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are replaced with UTF_REPLACEMENT_CHAR like any other malformed sequence.
+             * @param utf8_str
+             * Buffer containing valid null-terminated utf8 encoded data
+             * @return
+             * This EdoString after the assignment has happened
+             * \exception
+             * std::length_error Thrown if the resulting EdoString would be too large
+             */
+            EdoString &Assign(const utf8 *utf8_str) {
+                return Assign(utf8_str, UtfLength(utf8_str));
+            }
+
+            /*!
+             * \brief
+             * Assign to this EdoString the string value represented by the given null-terminated utf8 encoded data
+             * \note
+             * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are handled according to \a policy.
              * @param utf8_str
              * Buffer containing valid null-terminated utf8 encoded data
              * @param str_num
              * Number of code units (not code points) in the buffer pointed to by \a utf8_str
+             * @param policy
+             * What to do with malformed utf8 data (see EdoUtf8Policy). With Utf8Stop the string receives the data
+             * before the first malformed sequence
+             * @param error_offset
+             * If not null, receives the offset of the first malformed sequence in \a utf8_str, or UTF_NO_ERROR
              * @return
              * This EdoString after the assignment has happened
              * \exception
              * std::length_error Thrown if the resulting EdoString would be too large
+             * \exception
+             * std::invalid_argument Thrown if \a utf8_str is malformed and \a policy is Utf8Throw. The EdoString is
+             * left empty
              */
-            EdoString &Assign(const utf8 *utf8_str, size_type str_num) {
+            EdoString &Assign(const utf8 *utf8_str, size_type str_num, EdoUtf8Policy policy = Utf8Replace,
+                              size_type *error_offset = nullptr) {
                 if (str_num == npos)
                     throw std::length_error("Length for utf8 encoded string can not be 'npos'");
 
-                size_type encSize = EncodedSize(utf8_str, str_num);
-
-                Grow(encSize);
-                Encode(utf8_str, ptr(), d_reserve, str_num);
-                SetLen(encSize);
+                bool grew = Grow(str_num);
+                SetLen(0);
+                SetLen(DecodeUtf8(utf8_str, str_num, ptr(), policy, error_offset));
+                TrimDecodeSlack(grew);
                 return *this;
             }
 
@@ -1224,27 +1514,39 @@ namespace Edo {
                 return *this;
             }
 
-            void Swap(EdoString &str) {
+            /*!
+             * \brief
+             * Swaps the value of this EdoString with the value of \a str. No buffers are copied or re-allocated
+             * @param str
+             * EdoString object whose value is to be swapped with this EdoString
+             */
+            void Swap(EdoString &str) noexcept {
+                if (this == &str)
+                    return;
+
                 size_type tempLen = d_cpLength;
                 d_cpLength = str.d_cpLength;
                 str.d_cpLength = tempLen;
 
-                size_type tempRes = d_reserve;
-                d_reserve = str.d_reserve;
-                str.d_reserve = tempRes;
+                size_type tempHeap = d_onHeap;
+                d_onHeap = str.d_onHeap;
+                str.d_onHeap = tempHeap;
 
-                utf32 *tempBuf = d_buffer;
-                d_buffer = str.d_buffer;
-                str.d_buffer = tempBuf;
+                // The cached hash lives in the heap buffer, so the setting has to follow the buffer
+                size_type tempHash = d_hashCache;
+                d_hashCache = str.d_hashCache;
+                str.d_hashCache = tempHash;
 
-                // TODO: See if we need to swap 'quick buffer' data
-                if (tempRes <= STR_QUICKBUFF_SIZE) {
-                    utf32 tempQbf[STR_QUICKBUFF_SIZE];
+                utf8 *tempEnc = d_encodedBuff.load(std::memory_order_relaxed);
+                d_encodedBuff.store(str.d_encodedBuff.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                str.d_encodedBuff.store(tempEnc, std::memory_order_relaxed);
 
-                    memcpy(tempQbf, d_quickBuff, STR_QUICKBUFF_SIZE * sizeof(utf32));
-                    memcpy(d_quickBuff, str.d_quickBuff, STR_QUICKBUFF_SIZE * sizeof(utf32));
-                    memcpy(str.d_quickBuff, tempQbf, STR_QUICKBUFF_SIZE * sizeof(utf32));
-                }
+                // The quick-buffer and the heap details share storage, so swapping the raw bytes covers both
+                unsigned char tempBuf[sizeof(d_heap) > sizeof(d_quickBuff) ? sizeof(d_heap) : sizeof(d_quickBuff)];
+
+                memcpy(tempBuf, d_quickBuff, sizeof(tempBuf));
+                memcpy(d_quickBuff, str.d_quickBuff, sizeof(tempBuf));
+                memcpy(str.d_quickBuff, tempBuf, sizeof(tempBuf));
             }
 
             //////////////////////////////////////////////
@@ -1264,6 +1566,20 @@ namespace Edo {
                 return Append(str);
             }
 
+            /*!
+             * \brief
+             * Appends the temporary EdoString \a str, taking over its buffer when this EdoString is empty
+             * @param str
+             * EdoString object that is to be appended
+             * @return
+             * This EdoString after the append operation
+             * \exception
+             * std::length_error Thrown if the resulting EdoString would be too large
+             */
+            EdoString &operator+=(EdoString &&str) {
+                return Append(std::move(str));
+            }
+
             /*!
              * \brief
              * Appends a sub-string of the EdoString \a str
@@ -1293,6 +1609,78 @@ namespace Edo {
                 return *this;
             }
 
+            /*!
+             * \brief
+             * Appends the code points of EdoStringView \a view
+             * \note
+             * \a view may be a view of this EdoString
+             * @param view
+             * EdoStringView object that is to be appended
+             * @return
+             * This EdoString after the append operation
+             * \exception
+             * std::length_error Thrown if the resulting EdoString would be too large
+             */
+            EdoString &Append(EdoStringView view) {
+                if (Aliases(view))
+                    return Append(EdoString(view));
+
+                Grow(d_cpLength + view.Length());
+
+                if (!view.Empty())
+                    memcpy(&ptr()[d_cpLength], view.Data(), view.Length() * sizeof(utf32));
+
+                SetLen(d_cpLength + view.Length());
+                return *this;
+            }
+
+            /*!
+             * \brief
+             * Appends the code points of EdoStringView \a view
+             * @param view
+             * EdoStringView object that is to be appended
+             * @return
+             * This EdoString after the append operation
+             * \exception
+             * std::length_error Thrown if the resulting EdoString would be too large
+             */
+            EdoString &operator+=(EdoStringView view) {
+                return Append(view);
+            }
+
+            /*!
+             * \brief
+             * Appends the temporary EdoString \a str. When this EdoString is empty, or \a str has the larger buffer and
+             * room for this EdoString in front of its data, the heap buffer of \a str is taken over instead of copying.
+             * Only the buffer moves: this EdoString keeps its hash caching setting, and the buffer is never taken from
+             * an allocator other than the one of this EdoString (see GetAllocator())
+             * @param str
+             * EdoString object that is to be appended
+             * @return
+             * This EdoString after the append operation
+             * \exception
+             * std::length_error Thrown if resulting EdoString would be too large
+             */
+            EdoString &Append(EdoString &&str) {
+                if (str.d_onHeap && &str.GetAllocator() == &GetAllocator() &&
+                    (d_cpLength == 0 || (str.Reserved() > Reserved() && str.Capacity() >= d_cpLength + str.d_cpLength))) {
+                    str.Insert(0, *this);
+                    Swap(str);
+
+                    // Swap() hands over the hash caching setting with the buffer; each side keeps its own instead
+                    size_type hashCache = d_hashCache;
+                    d_hashCache = str.d_hashCache;
+                    str.d_hashCache = hashCache;
+
+                    if (d_hashCache)
+                        HeaderOf(d_heap.d_buffer)->d_hash.store(0, std::memory_order_relaxed);
+
+                    return *this;
+                }
+
+                return Append(str, 0, npos);
+            }
+
             /*!
              * \brief
              * Appends the std::string \a std_str
@@ -1355,9 +1743,8 @@ namespace Edo {
              * Buffer holding the null-terminated utf8 encoded data that is to be appended
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are replaced with UTF_REPLACEMENT_CHAR like any other malformed sequence.
              * @return
              * This EdoString after the append operation
              * \exception
@@ -1374,9 +1761,8 @@ namespace Edo {
              * Buffer holding the null-terminated utf8 encoded data that is to be appended
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are replaced with UTF_REPLACEMENT_CHAR like any other malformed sequence.
              * @return
              * This EdoString after the append operation
              * \exception
@@ -1393,26 +1779,34 @@ namespace Edo {
              * Buffer holding the utf8 encoded data that is to be appended
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are handled according to \a policy.
              * @param len
              * Number of code units (not code points) in the buffer to append
+             * @param policy
+             * What to do with malformed utf8 data (see EdoUtf8Policy). With Utf8Stop the data before the first
+             * malformed sequence is appended
+             * @param error_offset
+             * If not null, receives the offset of the first malformed sequence in \a utf8_str, or UTF_NO_ERROR
              * @return
              * This EdoString after the append operation
              * \exception
              * std::length_error Thrown if resulting EdoString would be too large, or if \a len was 'npos'
+             * \exception
+             * std::invalid_argument Thrown if \a utf8_str is malformed and \a policy is Utf8Throw. The EdoString is
+             * not changed
              */
-            EdoString &Append(const utf8 *utf8_str, size_type len) {
+            EdoString &Append(const utf8 *utf8_str, size_type len, EdoUtf8Policy policy = Utf8Replace,
+                              size_type *error_offset = nullptr) {
                 if (len == npos)
                     throw std::length_error("Length for utf8 encoded string can not be 'npos'");
 
-                size_type encSize = EncodedSize(utf8_str, len);
-                size_type newSize = d_cpLength + encSize;
+                if (MaxSize() - d_cpLength <= len)
+                    throw std::length_error("Resulting EdoString would be too large");
 
-                Grow(newSize);
-                Encode(utf8_str, &ptr()[d_cpLength], encSize, len);
-                SetLen(newSize);
+                bool grew = Grow(d_cpLength + len);
+                SetLen(d_cpLength + DecodeUtf8(utf8_str, len, &ptr()[d_cpLength], policy, error_offset));
+                TrimDecodeSlack(grew);
 
                 return *this;
             }
@@ -1583,6 +1977,40 @@ namespace Edo {
                 return *this;
             }
 
+            /*!
+             * \brief
+             * Inserts the code points of EdoStringView \a view at the specified position
+             * \note
+             * \a view may be a view of this EdoString
+             * @param idx
+             * Index where the code points are to be inserted
+             * @param view
+             * EdoStringView object that is to be inserted
+             * @return
+             * This EdoString after the insert
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this EdoString
+             * \exception
+             * std::length_error Thrown if resulting EdoString would be too large
+             */
+            EdoString &Insert(size_type idx, EdoStringView view) {
+                if (d_cpLength < idx)
+                    throw std::out_of_range("Index is out of range for EdoString");
+
+                if (Aliases(view))
+                    return Insert(idx, EdoString(view));
+
+                size_type newSize = d_cpLength + view.Length();
+                Grow(newSize);
+                memmove(&ptr()[idx + view.Length()], &ptr()[idx], (d_cpLength - idx) * sizeof(utf32));
+
+                if (!view.Empty())
+                    memcpy(&ptr()[idx], view.Data(), view.Length() * sizeof(utf32));
+
+                SetLen(newSize);
+                return *this;
+            }
+
             /*!
              * \brief
              * Inserts the given std::string object at the specified position
@@ -1657,9 +2085,8 @@ namespace Edo {
              * Buffer containing the null-terminated utf8 encoded data that is to be inserted
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are replaced with UTF_REPLACEMENT_CHAR like any other malformed sequence.
              * @return
              * This EdoString after the insert
              * \exception
@@ -1680,9 +2107,8 @@ namespace Edo {
              * Buffer containing the utf8 encoded data that is to be inserted
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are replaced with UTF_REPLACEMENT_CHAR like any other malformed sequence.
              * @param len
              * Length of the data to be inserted in utf8 code units (not code points)
              * @return
@@ -1699,13 +2125,16 @@ namespace Edo {
                 if (len == npos)
                     throw std::length_error("Length of utf8 encoded string can not be 'npos'");
 
-                size_type encSize = EncodedSize(utf8_str, len);
-                size_type newSize = d_cpLength + encSize;
+                if (MaxSize() - d_cpLength <= len)
+                    throw std::length_error("Resulting EdoString would be too large");
 
-                Grow(newSize);
-                memmove(&ptr()[idx + encSize], &ptr()[idx], (d_cpLength - idx) * sizeof(utf32));
-                Encode(utf8_str, &ptr()[idx], encSize, len);
-                SetLen(newSize);
+                // Decode past the end of the current data, then rotate the new code points into place
+                bool grew = Grow(d_cpLength + len);
+                size_type decoded = DecodeUtf8(utf8_str, len, &ptr()[d_cpLength]);
+
+                std::rotate(&ptr()[idx], &ptr()[d_cpLength], &ptr()[d_cpLength + decoded]);
+                SetLen(d_cpLength + decoded);
+                TrimDecodeSlack(grew);
 
                 return *this;
             }
@@ -2058,6 +2487,47 @@ namespace Edo {
                 return *this;
             }
 
+            /*!
+             * \brief
+             * Replace code points in the EdoString with the code points of EdoStringView \a view
+             * \note
+             * \a view may be a view of this EdoString
+             * @param idx
+             * Index of the first code point to be replaced
+             * @param len
+             * Maximum number of code points to be replaced (if this is 0, operation is an insert at position \a idx)
+             * @param view
+             * The EdoStringView object that is to replace the specified code points
+             * @return
+             * This EdoString after the replace operation
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this EdoString
+             * \exception
+             * std::length_error Thrown if resulting EdoString would be too large
+             */
+            EdoString &Replace(size_type idx, size_type len, EdoStringView view) {
+                if (d_cpLength < idx)
+                    throw std::out_of_range("Index is out of range for EdoString");
+
+                if (Aliases(view))
+                    return Replace(idx, len, EdoString(view));
+
+                if ((len + idx) > d_cpLength || len == npos)
+                    len = d_cpLength - idx;
+
+                size_type newSize = d_cpLength + view.Length() - len;
+                Grow(newSize);
+
+                if (idx + len < d_cpLength)
+                    memmove(&ptr()[idx + view.Length()], &ptr()[len + idx], (d_cpLength - idx - len) * sizeof(utf32));
+
+                if (!view.Empty())
+                    memcpy(&ptr()[idx], view.Data(), view.Length() * sizeof(utf32));
+
+                SetLen(newSize);
+                return *this;
+            }
+
             /*!
              * \brief
              * Replace code points in the EdoString with the specified std::string object
@@ -2167,9 +2637,8 @@ namespace Edo {
              * Buffer containing the null-terminated utf8 encoded data that is to replace the specified code points
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are replaced with UTF_REPLACEMENT_CHAR like any other malformed sequence.
              * @return
              * This EdoString after the replace operation
              * \exception
@@ -2194,9 +2663,8 @@ namespace Edo {
              * Buffer containing the null-terminated utf8 encoded data that is to replace the specified range of code points
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are replaced with UTF_REPLACEMENT_CHAR like any other malformed sequence.
              * @return
              * This EdoString after the replace operation
              * \exception
@@ -2217,9 +2685,8 @@ namespace Edo {
              * Buffer containing the null terminated utf8 encoded data that is to replace the specified code points
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are replaced with UTF_REPLACEMENT_CHAR like any other malformed sequence.
              * @param str_len
              * Length of the utf8 encoded data in utf8 code units (not code points)
              * @return
@@ -2239,15 +2706,18 @@ namespace Edo {
                 if (len + idx > d_cpLength || len == npos)
                     len = d_cpLength - idx;
 
-                size_type encSize = EncodedSize(utf8_str, str_len);
-                size_type newSize = d_cpLength + encSize - len;
-                Grow(newSize);
+                if (MaxSize() - d_cpLength <= str_len)
+                    throw std::length_error("Resulting EdoString would be too large");
 
-                if (idx + len < d_cpLength)
-                    memmove(&ptr()[idx + encSize], &ptr()[len + idx], (d_cpLength - idx - len) * sizeof(utf32));
+                // Decode past the end of the current data, rotate the new code points in front of the ones they
+                // replace, then close the gap
+                bool grew = Grow(d_cpLength + str_len);
+                size_type decoded = DecodeUtf8(utf8_str, str_len, &ptr()[d_cpLength]);
 
-                Encode(utf8_str, &ptr()[idx], encSize, str_len);
-                SetLen(newSize);
+                std::rotate(&ptr()[idx], &ptr()[d_cpLength], &ptr()[d_cpLength + decoded]);
+                memmove(&ptr()[idx + decoded], &ptr()[idx + decoded + len], (d_cpLength - idx - len) * sizeof(utf32));
+                SetLen(d_cpLength + decoded - len);
+                TrimDecodeSlack(grew);
                 return *this;
             }
 
@@ -2264,9 +2734,8 @@ namespace Edo {
              * Buffer containing the null-terminated utf8 encoded data that is to replace the specified range of code points
              * \note
              * A basic string literal (cast to utf8*) can be passed to this function, provided that the string is
-             * comprised only of code points 0x00 - 0x7F. The use of extended ASCII characters (with values >0x7F)
-             * would result in incorrect behaviour as the EdoString will attempt to 'decode' the data, with
-             * unpredictable results.
+             * comprised only of code points 0x00 - 0x7F. Extended ASCII characters (with values >0x7F) are not valid
+             * utf8, and are replaced with UTF_REPLACEMENT_CHAR like any other malformed sequence.
              * @param str_len
              * Length of the utf8 encoded data in utf8 code units (not code points)
              * @return
@@ -2491,6 +2960,79 @@ namespace Edo {
                 return Replace(safe_iter_dif(iter_beg, Begin()), safe_iter_dif(iter_end, iter_beg), chars, chars_len);
             }
 
+            //////////////////////////////////////////////
+            // Replace every occurrence
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Replace every occurrence of \a from with \a to
+             * \note
+             * The occurrences are found with the same kernels as Find() and overwritten in place
+             * @param from
+             * Code point to be replaced
+             * @param to
+             * Code point to write in its place
+             * @return
+             * This EdoString after the replace operation
+             */
+            EdoString &ReplaceAll(utf32 from, utf32 to);
+
+            /*!
+             * \brief
+             * Replace every occurrence of \a from with \a to, scanning from the start of the EdoString. Occurrences do
+             * not overlap: the search resumes after each one that was replaced
+             * \note
+             * The EdoString is searched once. A result no longer than the EdoString is written in place, a longer one
+             * after growing the buffer once to the final size. \a from and \a to may be views of this EdoString.
+             * \example_snippet_start
+             *      EdoString path("C:\\logs\\today.txt");
+             *      path.ReplaceAll(EdoString("\\"), EdoString("/")); // "C:/logs/today.txt"
+             * \example_snippet_end
+             * @param from
+             * Code points to be replaced. If it is empty, nothing is replaced
+             * @param to
+             * Code points to write in place of each occurrence
+             * @return
+             * This EdoString after the replace operation
+             * \exception
+             * std::length_error Thrown if the resulting EdoString would be too large
+             */
+            EdoString &ReplaceAll(EdoStringView from, EdoStringView to);
+
+            /*!
+             * \brief
+             * Replace every occurrence of several sub-strings in a single pass, which is how escaping and template
+             * expansion are done. At each position the replacements are tried in order and the first one whose
+             * \a from matches is applied, so list longer patterns before their prefixes. Text written by a
+             * replacement is never searched again
+             * \note
+             * The candidates are found by searching for the first code points of all the patterns at once. The result
+             * is built in a single buffer sized for it, or in place if no replacement makes the text longer.
+             * \example_snippet_start
+             *      const EdoString amp("&"), ampEsc("&amp;"), lt("<"), ltEsc("&lt;"), gt(">"), gtEsc("&gt;");
+             *
+             *      text.ReplaceAll({{amp, ampEsc}, {lt, ltEsc}, {gt, gtEsc}});
+             * \example_snippet_end
+             * @param replacements
+             * Array of the substitutions to perform. Entries with an empty \a from are ignored
+             * @param count
+             * Number of entries in \a replacements
+             * @return
+             * This EdoString after the replace operation
+             * \exception
+             * std::length_error Thrown if the resulting EdoString would be too large
+             */
+            EdoString &ReplaceAll(const EdoReplacement *replacements, size_type count);
+
+            /*!
+             * \brief
+             * Replace every occurrence of several sub-strings in a single pass (see ReplaceAll(const EdoReplacement *,
+             * size_type))
+             */
+            EdoString &ReplaceAll(std::initializer_list<EdoReplacement> replacements) {
+                return ReplaceAll(replacements.begin(), replacements.size());
+            }
+
             //////////////////////////////////////////////
             // Find a code point
             //////////////////////////////////////////////
@@ -2507,14 +3049,10 @@ namespace Edo {
              */
             size_type Find(utf32 code_point, size_type idx = 0) const {
                 if (idx < d_cpLength) {
-                    const utf32 *pt = &ptr()[idx];
+                    size_type pos = FindCodePoint(&ptr()[idx], d_cpLength - idx, code_point);
 
-                    while (idx < d_cpLength) {
-                        if (*pt++ == code_point)
-                            return idx;
-
-                        ++idx;
-                    }
+                    if (pos != STR_NOT_FOUND)
+                        return idx + pos;
                 }
 
                 return npos;
@@ -2532,19 +3070,15 @@ namespace Edo {
              * - npos if the code point could not be found
              */
             size_type RFind(utf32 code_point, size_type idx = npos) const {
+                if (d_cpLength == 0)
+                    return npos;
+
                 if (idx >= d_cpLength)
                     idx = d_cpLength - 1;
 
-                if (d_cpLength > 0) {
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (*pt-- == code_point)
-                            return idx;
-                    } while (idx-- != 0);
-                }
+                size_type pos = RFindCodePoint(ptr(), idx + 1, code_point);
 
-                return npos;
+                return pos == STR_NOT_FOUND ? npos : pos;
             }
 
             //////////////////////////////////////////////
@@ -2562,20 +3096,7 @@ namespace Edo {
              * - npos if the sub-string could not be found
              */
             size_type Find(const EdoString &str, size_type idx = 0) const {
-                if (str.d_cpLength == 0 && idx < d_cpLength)
-                    return idx;
-
-                if (idx < d_cpLength) {
-                    // Loop while search string could fit in the search area
-                    while (d_cpLength - idx >= str.d_cpLength) {
-                        if (0 == Compare(idx, str.d_cpLength, str))
-                            return idx;
-
-                        ++idx;
-                    }
-                }
-
-                return npos;
+                return FindIn(str.ptr(), str.d_cpLength, idx, nullptr);
             }
 
             /*!
@@ -2590,20 +3111,37 @@ namespace Edo {
              * - npos if the sub-string could not be found
              */
             size_type RFind(const EdoString &str, size_type idx = npos) const {
-                if (str.d_cpLength == 0)
-                    return (idx < d_cpLength) ? idx : d_cpLength;
-
-                if (str.d_cpLength <= d_cpLength) {
-                    if (idx > d_cpLength - str.d_cpLength)
-                        idx = d_cpLength - str.d_cpLength;
+                return RFindIn(str.ptr(), str.d_cpLength, idx, nullptr);
+            }
 
-                    do {
-                        if (0 == Compare(idx, str.d_cpLength, str))
-                            return idx;
-                    } while (idx-- != 0);
-                }
+            /*!
+             * \brief
+             * Search forwards for a sub-string
+             * \param view
+             * EdoStringView object describing the sub-string to search for
+             * \param idx
+             * Index of the code point where the search is to start
+             * \return
+             * - Index of the first occurrence of sub-string \a view travelling forwards from \a idx.
+             * - npos if the sub-string could not be found
+             */
+            size_type Find(EdoStringView view, size_type idx = 0) const {
+                return FindIn(view.Data(), view.Length(), idx, nullptr);
+            }
 
-                return npos;
+            /*!
+             * \brief
+             * Search backwards for a sub-string
+             * \param view
+             * EdoStringView object describing the sub-string to search for
+             * \param idx
+             * Index of the code point where the search is to start
+             * \return
+             * - Index of the first occurrence of sub-string \a view travelling backwards from \a idx
+             * - npos if the sub-string could not be found
+             */
+            size_type RFind(EdoStringView view, size_type idx = npos) const {
+                return RFindIn(view.Data(), view.Length(), idx, nullptr);
             }
 
             /*!
@@ -2621,22 +3159,7 @@ namespace Edo {
              * - npos if the sub-string could not be found
              */
             size_type Find(const std::string &std_str, size_type idx = 0) const {
-                std::string::size_type sze = std_str.size();
-
-                if (sze == 0 && idx < d_cpLength)
-                    return idx;
-
-                if (idx < d_cpLength) {
-                    // Loop while search string could fit in to the search area
-                    while (d_cpLength - idx >= sze) {
-                        if (0 == Compare(idx, (size_type) sze, std_str))
-                            return idx;
-
-                        ++idx;
-                    }
-                }
-
-                return npos;
+                return Find(std_str.data(), idx, std_str.size());
             }
 
             /*!
@@ -2652,22 +3175,7 @@ namespace Edo {
              * \return
              */
             size_type RFind(const std::string &std_str, size_type idx = npos) const {
-                std::string::size_type sze = std_str.size();
-
-                if (sze == 0)
-                    return (idx < d_cpLength) ? idx : d_cpLength;
-
-                if (sze <= d_cpLength) {
-                    if (idx > d_cpLength - sze)
-                        idx = d_cpLength - sze;
-
-                    do {
-                        if (0 == Compare(idx, (size_type) sze, std_str))
-                            return idx;
-                    } while (idx-- != 0);
-                }
-
-                return npos;
+                return RFind(std_str.data(), idx, std_str.size());
             }
 
             /*!
@@ -2738,22 +3246,13 @@ namespace Edo {
                 if (str_len == npos)
                     throw std::length_error("Length of utf8 encoded string can not be 'npos'");
 
-                size_type sze = EncodedSize(utf8_str, str_len);
-
-                if (sze == 0 && idx < d_cpLength)
-                    return idx;
-
-                if (idx < d_cpLength) {
-                    // Loop while search string could fit in to search area
-                    while (d_cpLength - idx >= sze) {
-                        if (0 == Compare(idx, sze, utf8_str, sze))
-                            return idx;
+                // Short needles are decoded on the stack, and only factorized if the search needs it
+                if (str_len > STR_SEARCHER_QUICK_SIZE)
+                    return Find(EdoStringSearcher(utf8_str, str_len), idx);
 
-                        ++idx;
-                    }
-                }
+                utf32 needle[STR_SEARCHER_QUICK_SIZE];
 
-                return npos;
+                return FindIn(needle, DecodeUtf8(utf8_str, str_len, needle), idx, nullptr);
             }
 
             /*!
@@ -2780,22 +3279,13 @@ namespace Edo {
                 if (str_len == npos)
                     throw std::length_error("Length for utf8 encoded string can not be 'npos'");
 
-                size_type sze = EncodedSize(utf8_str, str_len);
-
-                if (sze == 0)
-                    return (idx < d_cpLength) ? idx : d_cpLength;
-
-                if (sze <= d_cpLength) {
-                    if (idx > d_cpLength - sze)
-                        idx = d_cpLength - sze;
+                // Short needles are decoded on the stack, and only factorized if the search needs it
+                if (str_len > STR_SEARCHER_QUICK_SIZE)
+                    return RFind(EdoStringSearcher(utf8_str, str_len), idx);
 
-                    do {
-                        if (0 == Compare(idx, sze, utf8_str, sze))
-                            return idx;
-                    } while (idx-- != 0);
-                }
+                utf32 needle[STR_SEARCHER_QUICK_SIZE];
 
-                return npos;
+                return RFindIn(needle, DecodeUtf8(utf8_str, str_len, needle), idx, nullptr);
             }
 
             /*!
@@ -2851,20 +3341,15 @@ namespace Edo {
                 if (chars_len == npos)
                     throw std::length_error("Length for char array can not be 'npos'");
 
-                if (chars_len == 0 && idx < d_cpLength)
-                    return idx;
+                if (chars_len > STR_SEARCHER_QUICK_SIZE)
+                    return Find(EdoStringSearcher(chars, chars_len), idx);
 
-                if (idx < d_cpLength) {
-                    // Loop while search string could fit in to search area
-                    while (d_cpLength - idx >= chars_len) {
-                        if (0 == Compare(idx, chars_len, chars, chars_len))
-                            return idx;
+                utf32 needle[STR_SEARCHER_QUICK_SIZE];
 
-                        ++idx;
-                    }
-                }
+                for (size_type i = 0; i < chars_len; ++i)
+                    needle[i] = static_cast<utf32>(static_cast<unsigned char>(chars[i]));
 
-                return npos;
+                return FindIn(needle, chars_len, idx, nullptr);
             }
 
             /*!
@@ -2884,20 +3369,45 @@ namespace Edo {
                 if (chars_len == npos)
                     throw std::length_error("Length for char array can not be 'npos'");
 
-                if (chars_len == 0)
-                    return (idx < d_cpLength) ? idx : d_cpLength;
+                if (chars_len > STR_SEARCHER_QUICK_SIZE)
+                    return RFind(EdoStringSearcher(chars, chars_len), idx);
 
-                if (chars_len <= d_cpLength) {
-                    if (idx > d_cpLength - chars_len)
-                        idx = d_cpLength - chars_len;
+                utf32 needle[STR_SEARCHER_QUICK_SIZE];
 
-                    do {
-                        if (0 == Compare(idx, chars_len, chars, chars_len))
-                            return idx;
-                    } while (idx-- != 0);
-                }
+                for (size_type i = 0; i < chars_len; ++i)
+                    needle[i] = static_cast<utf32>(static_cast<unsigned char>(chars[i]));
 
-                return npos;
+                return RFindIn(needle, chars_len, idx, nullptr);
+            }
+
+            /*!
+             * \brief
+             * Search forwards for a sub-string prepared with an EdoStringSearcher
+             * \param searcher
+             * Searcher holding the sub-string, worth keeping around when the same sub-string is searched for often
+             * \param idx
+             * Index of the code point where the search is to start
+             * \return
+             * - Index of the first occurrence of the sub-string travelling forwards from \a idx
+             * - npos if the sub-string could not be found
+             */
+            size_type Find(const EdoStringSearcher &searcher, size_type idx = 0) const {
+                return FindIn(searcher.Needle(), searcher.Length(), idx, &searcher);
+            }
+
+            /*!
+             * \brief
+             * Search backwards for a sub-string prepared with an EdoStringSearcher
+             * \param searcher
+             * Searcher holding the sub-string
+             * \param idx
+             * Index of the code point where the search is to start
+             * \return
+             * - Index of the first occurrence of the sub-string travelling backwards from \a idx
+             * - npos if the sub-string could not be found
+             */
+            size_type RFind(const EdoStringSearcher &searcher, size_type idx = npos) const {
+                return RFindIn(searcher.Needle(), searcher.Length(), idx, &searcher);
             }
 
             //////////////////////////////////////////////
@@ -2915,16 +3425,7 @@ namespace Edo {
              * - npos if none of the code points in \a str were found
              */
             size_type FindFirstOf(const EdoString &str, size_type idx = 0) const {
-                if (idx < d_cpLength) {
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (npos != str.Find(*pt++))
-                            return idx;
-                    } while (++idx != d_cpLength);
-                }
-
-                return npos;
+                return FindInSet(EdoCodePointSet(str.ptr(), str.d_cpLength), idx, true);
             }
 
             /*!
@@ -2939,16 +3440,37 @@ namespace Edo {
              * - npos if all code points matched one of the code points in \a str
              */
             size_type FindFirstNotOf(const EdoString &str, size_type idx = 0) const {
-                if (idx < d_cpLength) {
-                    const utf32 *pt = &ptr()[idx];
+                return FindInSet(EdoCodePointSet(str.ptr(), str.d_cpLength), idx, false);
+            }
 
-                    do {
-                        if (npos == str.Find(*pt++))
-                            return idx;
-                    } while (++idx != d_cpLength);
-                }
+            /*!
+             * \brief
+             * Find the first occurrence of one of a set of code points
+             * \param view
+             * EdoStringView object describing the set of code points
+             * \param idx
+             * Index of the start point for the search
+             * \return
+             * - Index of the first occurrence of any one of the code points in \a view starting from \a idx
+             * - npos if none of the code points in \a view were found
+             */
+            size_type FindFirstOf(EdoStringView view, size_type idx = 0) const {
+                return FindInSet(EdoCodePointSet(view.Data(), view.Length()), idx, true);
+            }
 
-                return npos;
+            /*!
+             * \brief
+             * Find the first code point that is not one of a set of code points
+             * \param view
+             * EdoStringView object describing the set of code points
+             * \param idx
+             * Index of the start point for the search
+             * \return
+             * - Index of the first code point that does not match any one of the code points in \a view starting from \a idx
+             * - npos if all code points matched one of the code points in \a view
+             */
+            size_type FindFirstNotOf(EdoStringView view, size_type idx = 0) const {
+                return FindInSet(EdoCodePointSet(view.Data(), view.Length()), idx, false);
             }
 
             /*!
@@ -2966,16 +3488,7 @@ namespace Edo {
              * - npos if none of the code points in \a std_str were found
              */
             size_type FindFirstOf(const std::string &std_str, size_type idx = 0) const {
-                if (idx < d_cpLength) {
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (npos != FindCodePoint(std_str, *pt++))
-                            return idx;
-                    } while (++idx != d_cpLength);
-                }
-
-                return npos;
+                return FindInSet(EdoCodePointSet(std_str.data(), std_str.size()), idx, true);
             }
 
             /*!
@@ -2993,16 +3506,7 @@ namespace Edo {
              * - npos if all code points matched one of the code points in \a std_str
              */
             size_type FindFirstNotOf(const std::string &std_str, size_type idx = 0) const {
-                if (idx < d_cpLength) {
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (npos == FindCodePoint(std_str, *pt++))
-                            return idx;
-                    } while (++idx != d_cpLength);
-                }
-
-                return npos;
+                return FindInSet(EdoCodePointSet(std_str.data(), std_str.size()), idx, false);
             }
 
             /*!
@@ -3073,18 +3577,7 @@ namespace Edo {
                 if (str_len == npos)
                     throw std::length_error("Length for utf8 encoded string can not be 'npos'");
 
-                if (idx < d_cpLength) {
-                    size_type encSize = EncodedSize(utf8_str, str_len);
-
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (npos != FindCodePoint(utf8_str, encSize, *pt++))
-                            return idx;
-                    } while (++idx != d_cpLength);
-                }
-
-                return npos;
+                return FindInSet(EdoCodePointSet(utf8_str, str_len), idx, true);
             }
 
             /*!
@@ -3111,18 +3604,7 @@ namespace Edo {
                 if (str_len == npos)
                     throw std::length_error("Length for utf8 encoded string can not be 'npos'");
 
-                if (idx < d_cpLength) {
-                    size_type encSize = EncodedSize(utf8_str, str_len);
-
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (npos == FindCodePoint(utf8_str, encSize, *pt++))
-                            return idx;
-                    } while (++idx != d_cpLength);
-                }
-
-                return npos;
+                return FindInSet(EdoCodePointSet(utf8_str, str_len), idx, false);
             }
 
             /*!
@@ -3155,10 +3637,10 @@ namespace Edo {
              */
             size_type FindFirstNotOf(utf32 code_point, size_type idx = 0) const {
                 if (idx < d_cpLength) {
-                    do {
-                        if ((*this)[idx] != code_point)
-                            return idx;
-                    } while (idx++ < d_cpLength);
+                    size_type pos = FindNotCodePoint(&ptr()[idx], d_cpLength - idx, code_point);
+
+                    if (pos != STR_NOT_FOUND)
+                        return idx + pos;
                 }
 
                 return npos;
@@ -3217,16 +3699,7 @@ namespace Edo {
                 if (chars_len == npos)
                     throw std::length_error("Length for char array can not be 'npos'");
 
-                if (idx < d_cpLength) {
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (npos != FindCodePoint(chars, chars_len, *pt++))
-                            return idx;
-                    } while (++idx != d_cpLength);
-                }
-
-                return npos;
+                return FindInSet(EdoCodePointSet(chars, chars_len), idx, true);
             }
 
             /*!
@@ -3248,16 +3721,37 @@ namespace Edo {
                 if (chars_len == npos)
                     throw std::length_error("Length for char array can not be 'npos'");
 
-                if (idx < d_cpLength) {
-                    const utf32 *pt = &ptr()[idx];
+                return FindInSet(EdoCodePointSet(chars, chars_len), idx, false);
+            }
 
-                    do {
-                        if (npos == FindCodePoint(chars, chars_len, *pt++))
-                            return idx;
-                    } while (++idx != d_cpLength);
-                }
+            /*!
+             * \brief
+             * Find the first occurrence of one of a set of code points
+             * \param set
+             * Prebuilt set of code points, worth keeping around when the same set is searched for repeatedly
+             * \param idx
+             * Index of the start point for the search
+             * \return
+             * - Index of the first occurrence of any one of the code points in \a set starting from \a idx
+             * - npos if none of the code points in \a set were found
+             */
+            size_type FindFirstOf(const EdoCodePointSet &set, size_type idx = 0) const {
+                return FindInSet(set, idx, true);
+            }
 
-                return npos;
+            /*!
+             * \brief
+             * Find the first code point that is not one of a set of code points
+             * \param set
+             * Prebuilt set of code points
+             * \param idx
+             * Index of the start point for the search
+             * \return
+             * - Index of the first code point that is not in \a set starting from \a idx
+             * - npos if all code points are in \a set
+             */
+            size_type FindFirstNotOf(const EdoCodePointSet &set, size_type idx = 0) const {
+                return FindInSet(set, idx, false);
             }
 
             //////////////////////////////////////////////
@@ -3275,19 +3769,7 @@ namespace Edo {
              * - npos if none of the code points in \a str were found
              */
             size_type FindLastOf(const EdoString &str, size_type idx = npos) const {
-                if (d_cpLength > 0) {
-                    if (idx >= d_cpLength)
-                        idx = d_cpLength - 1;
-
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (npos != str.Find(*pt--))
-                            return idx;
-                    } while (idx-- != 0);
-                }
-
-                return npos;
+                return RFindInSet(EdoCodePointSet(str.ptr(), str.d_cpLength), idx, true);
             }
 
             /*!
@@ -3302,19 +3784,37 @@ namespace Edo {
              * - npos if all code points matched one of the code points in \a str
              */
             size_type FindLastNotOf(const EdoString &str, size_type idx = npos) const {
-                if (d_cpLength < 0) {
-                    if (idx >= d_cpLength)
-                        idx = d_cpLength - 1;
-
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (npos == str.Find(*pt--))
-                            return idx;
-                    } while (idx-- != 0);
-                }
+                return RFindInSet(EdoCodePointSet(str.ptr(), str.d_cpLength), idx, false);
+            }
 
-                return npos;
+            /*!
+             * \brief
+             * Find the last occurrence of one of a set of code points
+             * \param view
+             * EdoStringView object describing the set of code points
+             * \param idx
+             * Index of the start point for the search
+             * \return
+             * - Index of the last occurrence of any one of the code points in \a view starting from \a idx
+             * - npos if none of the code points in \a view were found
+             */
+            size_type FindLastOf(EdoStringView view, size_type idx = npos) const {
+                return RFindInSet(EdoCodePointSet(view.Data(), view.Length()), idx, true);
+            }
+
+            /*!
+             * \brief
+             * Find the last code point that is not one of a set of code points
+             * \param view
+             * EdoStringView object describing the set of code points
+             * \param idx
+             * Index of the start point for the search
+             * \return
+             * - Index of the last code point that does not match any one of the code points in \a view starting from \a idx
+             * - npos if all code points matched one of the code points in \a view
+             */
+            size_type FindLastNotOf(EdoStringView view, size_type idx = npos) const {
+                return RFindInSet(EdoCodePointSet(view.Data(), view.Length()), idx, false);
             }
 
             /*!
@@ -3332,19 +3832,7 @@ namespace Edo {
              * - npos if none of the code points in \a std_str were found
              */
             size_type FindLastOf(const std::string &std_str, size_type idx = npos) const {
-                if (d_cpLength > 0) {
-                    if (idx >= d_cpLength)
-                        idx = d_cpLength - 1;
-
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (npos != FindCodePoint(std_str, *pt--))
-                            return idx;
-                    } while (idx-- != 0);
-                }
-
-                return npos;
+                return RFindInSet(EdoCodePointSet(std_str.data(), std_str.size()), idx, true);
             }
 
             /*!
@@ -3362,19 +3850,7 @@ namespace Edo {
              * - npos if all code points matched one of the code points in \a std_str
              */
             size_type FindLastNotOf(const std::string &std_str, size_type idx = npos) const {
-                if (d_cpLength > 0) {
-                    if (idx >= d_cpLength)
-                        idx = d_cpLength - 1;
-
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (npos == FindCodePoint(std_str, *pt--))
-                            return idx;
-                    } while (idx-- != 0);
-                }
-
-                return npos;
+                return RFindInSet(EdoCodePointSet(std_str.data(), std_str.size()), idx, false);
             }
 
             /*!
@@ -3445,21 +3921,7 @@ namespace Edo {
                 if (str_len == npos)
                     throw std::length_error("Length for utf8 encoded string can not be 'npos'");
 
-                if (d_cpLength > 0) {
-                    if (idx >= d_cpLength)
-                        idx = d_cpLength - 1;
-
-                    size_type encSize = EncodedSize(utf8_str, str_len);
-
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (npos != FindCodePoint(utf8_str, encSize, *pt--))
-                            return idx;
-                    } while (idx-- != 0);
-                }
-
-                return npos;
+                return RFindInSet(EdoCodePointSet(utf8_str, str_len), idx, true);
             }
 
             /*!
@@ -3486,21 +3948,7 @@ namespace Edo {
                 if (str_len == npos)
                     throw std::length_error("Length for utf8 encoded string can not be 'npos'");
 
-                if (d_cpLength > 0) {
-                    if (idx >= d_cpLength)
-                        idx = d_cpLength - 1;
-
-                    size_type encSize = EncodedSize(utf8_str, str_len);
-
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (npos == FindCodePoint(utf8_str, encSize, *pt--))
-                            return idx;
-                    } while (idx-- != 0);
-                }
-
-                return npos;
+                return RFindInSet(EdoCodePointSet(utf8_str, str_len), idx, false);
             }
 
             /*!
@@ -3530,17 +3978,15 @@ namespace Edo {
              * - npos if all code points matched \a code_point
              */
             size_type FindLastNotOf(utf32 code_point, size_type idx = npos) const {
-                if (d_cpLength > 0) {
-                    if (idx >= d_cpLength)
-                        idx = d_cpLength - 1;
-
-                    do {
-                        if ((*this)[idx] != code_point)
-                            return idx;
-                    } while (idx-- != 0);
-                }
+                if (d_cpLength == 0)
+                    return npos;
 
-                return npos;
+                if (idx >= d_cpLength)
+                    idx = d_cpLength - 1;
+
+                size_type pos = RFindNotCodePoint(ptr(), idx + 1, code_point);
+
+                return pos == STR_NOT_FOUND ? npos : pos;
             }
 
             /*!
@@ -3594,19 +4040,7 @@ namespace Edo {
                 if (chars_len == npos)
                     throw std::length_error("Length for char array can not be 'npos'");
 
-                if (d_cpLength > 0) {
-                    if (idx >= d_cpLength)
-                        idx = d_cpLength - 1;
-
-                    const utf32 *pt = &ptr()[idx];
-
-                    do {
-                        if (npos != FindCodePoint(chars, chars_len, *pt--))
-                            return idx;
-                    } while (idx-- != 0);
-                }
-
-                return npos;
+                return RFindInSet(EdoCodePointSet(chars, chars_len), idx, true);
             }
 
             /*!
@@ -3628,19 +4062,37 @@ namespace Edo {
                 if (chars_len == npos)
                     throw std::length_error("Length for char array can not be 'npos'");
 
-                if (d_cpLength > 0) {
-                    if (idx >= d_cpLength)
-                        idx = d_cpLength - 1;
-
-                    const utf32 *pt = &ptr()[idx];
+                return RFindInSet(EdoCodePointSet(chars, chars_len), idx, false);
+            }
 
-                    do {
-                        if (npos == FindCodePoint(chars, chars_len, *pt--))
-                            return idx;
-                    } while (idx-- != 0);
-                }
+            /*!
+             * \brief
+             * Find the last occurrence of one of a set of code points
+             * \param set
+             * Prebuilt set of code points, worth keeping around when the same set is searched for repeatedly
+             * \param idx
+             * Index of the start point for the search
+             * \return
+             * - Index of the last occurrence of any one of the code points in \a set starting from \a idx
+             * - npos if none of the code points in \a set were found
+             */
+            size_type FindLastOf(const EdoCodePointSet &set, size_type idx = npos) const {
+                return RFindInSet(set, idx, true);
+            }
 
-                return npos;
+            /*!
+             * \brief
+             * Find the last code point that is not one of a set of code points
+             * \param set
+             * Prebuilt set of code points
+             * \param idx
+             * Index of the start point for the search
+             * \return
+             * - Index of the last code point that is not in \a set starting from \a idx
+             * - npos if all code points are in \a set
+             */
+            size_type FindLastNotOf(const EdoCodePointSet &set, size_type idx = npos) const {
+                return RFindInSet(set, idx, false);
             }
 
             //////////////////////////////////////////////
@@ -3665,6 +4117,128 @@ namespace Edo {
                 return EdoString(*this, idx, len);
             }
 
+            /*!
+             * \brief
+             * Returns a view of a part of this EdoString. Unlike Substr() nothing is copied or allocated
+             * \note
+             * The view is invalidated by any function that modifies the EdoString
+             * \param idx
+             * Index of the first code point for the view
+             * \param len
+             * Maximum number of code points to use for the view
+             * \return
+             * An EdoStringView object describing the specified sub-string
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this EdoString
+             */
+            EdoStringView View(size_type idx = 0, size_type len = npos) const {
+                if (d_cpLength < idx)
+                    throw std::out_of_range("Index is out of range for this EdoString");
+
+                if (len > d_cpLength - idx)
+                    len = d_cpLength - idx;
+
+                return EdoStringView(ptr() + idx, len);
+            }
+
+            /*!
+             * \brief
+             * Returns a view of the whole EdoString, so an EdoString can be passed wherever an EdoStringView is expected
+             */
+            operator EdoStringView() const {
+                return EdoStringView(ptr(), d_cpLength);
+            }
+
+            //////////////////////////////////////////////
+            // Splitting
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Returns a lazy range over the fields of the EdoString separated by \a delimiter. The fields are views,
+             * so iterating allocates nothing (see EdoSplitRange)
+             * \note
+             * The range and its fields are invalidated by any function that modifies the EdoString
+             * \param delimiter
+             * Code point separating the fields
+             * \param mode
+             * Whether the empty fields between adjacent delimiters are kept or skipped
+             * \param max_splits
+             * Maximum number of delimiters to split at. The last field holds the rest of the EdoString
+             * \example_snippet_start
+             *      EdoSplitRange<EdoSplitByCodePoint> fields = line.Split(',');
+             *
+             *      for (EdoSplitRange<EdoSplitByCodePoint>::Iterator it = fields.Begin(); it != fields.End(); ++it)
+             *          total += it->Length();
+             * \example_snippet_end
+             */
+            EdoSplitRange<EdoSplitByCodePoint> Split(utf32 delimiter, EdoSplitMode mode = SplitKeepEmpty,
+                                                     size_type max_splits = npos) const {
+                return Types::Split(*this, delimiter, mode, max_splits);
+            }
+
+            /*!
+             * \brief
+             * Returns a lazy range over the fields of the EdoString separated by any member of \a delimiters
+             * \note
+             * The range and its fields are invalidated by any function that modifies the EdoString
+             * \param delimiters
+             * Code points separating the fields. The set is searched with the same kernels as FindFirstOf()
+             * \param mode
+             * Whether the empty fields between adjacent delimiters are kept or skipped
+             * \param max_splits
+             * Maximum number of delimiters to split at. The last field holds the rest of the EdoString
+             */
+            EdoSplitRange<EdoSplitBySet> Split(EdoCodePointSet delimiters, EdoSplitMode mode = SplitKeepEmpty,
+                                               size_type max_splits = npos) const {
+                return Types::Split(*this, std::move(delimiters), mode, max_splits);
+            }
+
+            /*!
+             * \brief
+             * Returns a lazy range over the fields of the EdoString separated by the sub-string \a delimiter. An empty
+             * \a delimiter leaves the EdoString whole
+             * \note
+             * The range and its fields are invalidated by any function that modifies the EdoString
+             * \param delimiter
+             * Sub-string separating the fields
+             * \param mode
+             * Whether the empty fields between adjacent delimiters are kept or skipped
+             * \param max_splits
+             * Maximum number of delimiters to split at. The last field holds the rest of the EdoString
+             */
+            EdoSplitRange<EdoSplitBySubstring> Split(EdoStringView delimiter, EdoSplitMode mode = SplitKeepEmpty,
+                                                     size_type max_splits = npos) const {
+                return Types::Split(*this, delimiter, mode, max_splits);
+            }
+
+            /*!
+             * \brief
+             * Returns a lazy range over the fields of the EdoString separated by the needle of \a searcher
+             * \note
+             * The range and its fields are invalidated by any function that modifies the EdoString
+             */
+            EdoSplitRange<EdoSplitBySubstring> Split(EdoStringSearcher searcher, EdoSplitMode mode = SplitKeepEmpty,
+                                                     size_type max_splits = npos) const {
+                return Types::Split(*this, std::move(searcher), mode, max_splits);
+            }
+
+            /*!
+             * \brief
+             * Returns a lazy range over the tokens of the EdoString: the non-empty runs of code points for which
+             * \a is_separator returns false
+             * \note
+             * The range and its tokens are invalidated by any function that modifies the EdoString
+             * \param is_separator
+             * Callable taking a utf32 code point and returning true for the code points that separate tokens
+             * \param max_splits
+             * Maximum number of separator runs to split at. The last token holds the rest of the EdoString
+             */
+            template<typename Predicate>
+            EdoSplitRange<EdoSplitByPredicate<Predicate>> Tokenize(Predicate is_separator,
+                                                                   size_type max_splits = npos) const {
+                return Types::Tokenize(*this, std::move(is_separator), max_splits);
+            }
+
             //////////////////////////////////////////////
             // Iterator creation
             //////////////////////////////////////////////
@@ -3749,7 +4323,6 @@ namespace Edo {
             }
 
             // CUSTOM UTF16 CODE (not present in CEGUI::String)
-            // TODO: There are some missing operators and functions probably
             //////////////////////////////////////////////
             // Construction via std::wstring
             //////////////////////////////////////////////
@@ -3759,8 +4332,8 @@ namespace Edo {
              * \param w_str
              * The std::wstring object that is to be used to initialize the new EdoString object
              * \note
-             * The characters of \a w_str are taken to be unencoded data which represent Unicode code points 0x0000..0xFFFF.
-             * No translation of the provided data will occur
+             * The characters of \a w_str are utf16 where wchar_t has 16 bits and code points elsewhere. Surrogate pairs
+             * are combined into one code point, unpaired surrogates are kept as they are (see DecodeWide())
              * \exception
              * std::length_error Thrown if the resulting EdoString would be too large
              */
@@ -3778,8 +4351,8 @@ namespace Edo {
              * \brief
              * Assign a substring of std::wstring \a w_str to this EdoString
              * \note
-             * The characters of \a w_str are taken to be unencoded data which represent Unicode code points 0x0000..0xFFFF.
-             * No translation of the provided data will occur
+             * The characters of \a w_str are utf16 where wchar_t has 16 bits and code points elsewhere. Surrogate pairs
+             * are combined into one code point, unpaired surrogates are kept as they are (see DecodeWide())
              * \param w_str
              * std::wstring object containing the string value to be assigned
              * \param idx
@@ -3800,18 +4373,12 @@ namespace Edo {
                 if (num == npos || num > (size_type) w_str.size() - idx)
                     num = (size_type) w_str.size() - idx;
 
-                Grow(num);
-                SetLen(num);
-
-                while (num--)
-                    (*this)[num] = static_cast<utf32>(w_str[num + idx]);
-
-                return *this;
+                return AssignWide(w_str.data() + idx, num);
             }
 
             /*!
              * \brief
-             * Assign to this EdoString the given wide c-string
+             * Assign to this EdoString the given wide c-string, see Assign(const std::wstring &)
              * \param chars
              * Pointer to a valid C style wide string
              * \return
@@ -3820,20 +4387,96 @@ namespace Edo {
              * std::length_error Thrown if the resulting EdoString would have been too large
              */
             EdoString &Assign(const wchar_t *chars) {
-                size_t num = wcslen(chars);
+                return AssignWide(chars, wcslen(chars));
+            }
 
-                Grow(num);
-                SetLen(num);
+            //////////////////////////////////////////////
+            // utf16 conversion
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Creates an EdoString from utf16 data
+             * \param utf16_str
+             * Buffer containing the utf16 data
+             * \param str_num
+             * Number of code units in \a utf16_str
+             * \param policy
+             * What to do with unpaired surrogates (see EdoUtf16Policy). With Utf16Stop the string receives the data
+             * before the first one
+             * \param error_offset
+             * If not null, receives the offset of the first unpaired surrogate in \a utf16_str, or UTF_NO_ERROR
+             * \return
+             * The new EdoString
+             * \exception
+             * std::length_error Thrown if the resulting EdoString would be too large
+             * \exception
+             * std::invalid_argument Thrown if \a utf16_str holds an unpaired surrogate and \a policy is Utf16Throw
+             */
+            static EdoString FromUtf16(const utf16 *utf16_str, size_type str_num, EdoUtf16Policy policy = Utf16Replace,
+                                       size_type *error_offset = nullptr) {
+                EdoString str;
+                str.Assign(utf16_str, str_num, policy, error_offset);
+                return str;
+            }
 
-                while (num--)
-                    (*this)[num] = static_cast<utf32>(chars[num]);
+            /*!
+             * \brief
+             * Assign to this EdoString the code points held by the given utf16 data, see FromUtf16()
+             * \return
+             * This EdoString after the assignment has happened
+             */
+            EdoString &Assign(const utf16 *utf16_str, size_type str_num, EdoUtf16Policy policy = Utf16Replace,
+                              size_type *error_offset = nullptr) {
+                if (str_num == npos)
+                    throw std::length_error("Length for utf16 encoded string can not be 'npos'");
 
+                bool grew = Grow(str_num);
+                SetLen(0);
+                SetLen(DecodeUtf16(utf16_str, str_num, ptr(), policy, error_offset));
+                TrimDecodeSlack(grew);
                 return *this;
             }
 
             /*!
              * \brief
-             * Convert this EdoString to a UTF-16 encoded std::wstring
+             * Return the number of utf16 code units needed to encode this EdoString, with any code point that has no utf16
+             * form counted as one replacement
+             */
+            size_type Utf16Length() const {
+                return Utf16LengthOf(ptr(), d_cpLength);
+            }
+
+            /*!
+             * \brief
+             * Encode this EdoString as utf16 into a buffer supplied by the caller, such as one handed to a platform text
+             * API. No null terminator is written
+             * \example_snippet_start
+             *      std::vector<utf16> buff(str.Utf16Length());
+             *      str.ToUtf16(buff.data(), buff.size(), Utf16Replace);
+             * \example_snippet_end
+             * \param dest
+             * Buffer receiving the utf16 data
+             * \param dest_len
+             * Size of \a dest in code units, Utf16Length() is enough. Encoding stops before the first code point that
+             * does not fit completely
+             * \param policy
+             * What to do with surrogates and values above 0x10FFFF
+             * \param error_offset
+             * If not null, receives the index of the first code point with no utf16 form, or UTF_NO_ERROR
+             * \return
+             * Number of code units written to \a dest
+             * \exception
+             * std::invalid_argument Thrown if a code point has no utf16 form and \a policy is Utf16Throw
+             */
+            size_type ToUtf16(utf16 *dest, size_type dest_len, EdoUtf16Policy policy = Utf16Throw,
+                              size_type *error_offset = nullptr) const {
+                return EncodeUtf16(ptr(), d_cpLength, dest, dest_len, policy, error_offset);
+            }
+
+            /*!
+             * \brief
+             * Convert this EdoString to a UTF-16 encoded std::wstring, sized exactly. Where wchar_t has more than 16 bits
+             * each wchar_t holds one utf16 code unit
              * \param strictConversion
              * If true, illegal characters will throw an error, otherwise they are replaced
              * \return
@@ -3841,45 +4484,7 @@ namespace Edo {
              * \exception
              * std::invalid_argument Thrown if a character in the conversion is invalid
              */
-            std::wstring ToUtf16(bool strictConversion = true) const {
-                std::wstring target;
-
-                const utf32 *sourceStart = ptr();
-                const utf32 *sourceEnd = ptr() + Size();
-                const utf32 *source = sourceStart;
-
-                while (source < sourceEnd) {
-                    utf32 ch = *source++;
-
-                    // Target is a character <= 0xFFF
-                    if (ch <= 0x0000FFFF) {
-                        // UTF-16 surrogate values are illegal in UTF32. 0xFFFF or 0xFFFE are both reserved values
-                        if (ch >= 0xD800 && ch <= 0xDFFF) {
-                            if (strictConversion) {
-                                --source; // Return to illegal value itself
-                                throw std::invalid_argument("Illegal conversion between UTF32 and UTF16");
-                            } else {
-                                target.append(1, 0x0000FFFD); // Used as a replacement char
-                            }
-                        } else {
-                            target.append(1, (utf16) ch); // Normal case
-                        }
-                    } else if (ch > 0x0010FFFF) { // Max legal UTF-32 character
-                        if (strictConversion) {
-                            throw std::invalid_argument("Illegal conversion between UTF32 and UTF16");
-                        } else {
-                            target.append(1, 0x0000FFFD);
-                        }
-                    } else {
-                        // Target is a character in range 0xFFFF - 0x10FFFF
-                        ch -= 0x0010000UL; // Half base
-                        target.append(1, (utf16) ((ch >> 10) + 0xD800));
-                        target.append(1, (utf16) ((ch >> 0x3FFUL) + 0xDC00));
-                    }
-                }
-
-                return target;
-            }
+            std::wstring ToUtf16(bool strictConversion = true) const;
 
         private:
             //////////////////////////////////////////////
@@ -3892,22 +4497,58 @@ namespace Edo {
             // will never re-allocate to make size smaller. (see Trim())
             bool Grow(size_type new_size);
 
+            // Replace the contents with the code points held by wchar_t data (see DecodeWide())
+            EdoString &AssignWide(const wchar_t *chars, size_type num);
+
+            // Replace every occurrence found by 'from', one of the split delimiter types (see ReplaceAll())
+            template<typename Delimiter>
+            EdoString &ReplaceOccurrences(const Delimiter &from, EdoStringView to);
+
             // Perform re-allocation to remove wasted space.
             void Trim();
 
+            // Decoding utf8 reserves room for the worst case of one code point per code unit. When that caused a
+            // re-allocation and multi-byte data left most of the buffer unused, give the excess back
+            void TrimDecodeSlack(bool grew) {
+                size_type used = d_cpLength + 1;
+
+                if (grew && Reserved() - used > used && Reserved() - used > STR_DECODE_SLACK)
+                    Trim();
+            }
+
             // Set the length of the string, and terminate it, according to the given value (will not re-allocate, use Grow() first).
             void SetLen(size_type len) {
                 d_cpLength = len;
                 ptr()[len] = (utf32) 0;
             }
 
+            // Allocate a block of 'bytes' usable bytes from 'allocator', returning the memory after the block header
+            static void *AllocateBlock(EdoStringAllocator &allocator, size_type bytes);
+
+            // Release a block returned by AllocateBlock()
+            static void FreeBlock(void *data);
+
+            // Return the header of a block returned by AllocateBlock()
+            static BlockHeader *HeaderOf(void *data) {
+                return static_cast<BlockHeader *>(data) - 1;
+            }
+
+            // Return the allocator the utf8 encoding is taken from: that of the heap buffer, so both live as long, or the
+            // default allocator while the data is in the quick-buffer, whatever scope the caller of c_str() is in
+            EdoStringAllocator &EncodingAllocator() const {
+                return d_onHeap ? *HeaderOf(d_heap.d_buffer)->d_allocator : EdoStringAllocator::GetDefault();
+            }
+
+            // Return the size of the buffer in use, in code points (including space for the null terminator)
+            size_type Reserved() const {
+                return d_onHeap ? d_heap.d_reserve : STR_QUICKBUFF_SIZE;
+            }
+
             // Initialize EdoString object
             void Init() {
-                d_reserve = STR_QUICKBUFF_SIZE;
-                d_encodedBuff = nullptr;
-                d_encodedBuffLen = 0;
-                d_encodedDatLen = 0;
-                d_buffer = nullptr;
+                d_onHeap = 0;
+                d_hashCache = 0;
+                d_encodedBuff.store(nullptr, std::memory_order_relaxed);
                 SetLen(0);
             }
 
@@ -3919,6 +4560,11 @@ namespace Edo {
                     return true;
             }
 
+            // Return true if the view points into the buffer of this EdoString, so a re-allocation would leave it dangling
+            bool Aliases(const EdoStringView &view) const {
+                return !view.Empty() && ptr() <= view.Data() && view.Data() < ptr() + Reserved();
+            }
+
             // Compute distance between two iterators, returning a 'safe' value
             size_type safe_iter_dif(const const_iterator &iter1, const const_iterator &iter2) const {
                 return (iter1.d_ptr == 0) ? 0 : (iter1 - iter2);
@@ -3934,73 +4580,7 @@ namespace Edo {
                 if (src_len == 0)
                     src_len = UtfLength(src);
 
-                size_type destCapacity = dest_len;
-
-                // While there is data in the source buffer,
-                for (unsigned int idx = 0; idx < src_len; ++idx) {
-                    utf32 cp = src[idx];
-
-                    // Check if there is enough destination buffer to receive this encoded unit (exit loop & return if there is not)
-                    if (destCapacity < EncodedSize(cp))
-                        break;
-
-                    if (cp < 0x80) {
-                        *dest++ = (utf8) cp;
-                        --destCapacity;
-                    } else if (cp < 0x0800) {
-                        *dest++ = (utf8) ((cp >> 6) | 0xC0);
-                        *dest++ = (utf8) ((cp & 0x3F) | 0x80);
-                        destCapacity -= 2;
-                    } else if (cp < 0x10000) {
-                        *dest++ = (utf8) ((cp >> 12) | 0xE0);
-                        *dest++ = (utf8) (((cp >> 6) & 0x3F) | 0x80);
-                        *dest++ = (utf8) ((cp & 0x3F) | 0x80);
-                        destCapacity -= 3;
-                    } else {
-                        *dest++ = (utf8) ((cp >> 18) | 0xF0);
-                        *dest++ = (utf8) (((cp >> 12) & 0x3F) | 0x80);
-                        *dest++ = (utf8) (((cp >> 6) & 0x3F) | 0x80);
-                        *dest++ = (utf8) ((cp & 0x3F) | 0x80);
-                        destCapacity -= 4;
-                    }
-                }
-
-                return dest_len - destCapacity;
-            }
-
-            size_type Encode(const utf8 *src, utf32 *dest, size_type dest_len, size_type src_len = 0) const {
-                // Count length for null terminated source
-                if (src_len == 0)
-                    src_len = UtfLength(src);
-
-                size_type destCapacity = dest_len;
-
-                // While there is data in the source buffer
-                for (unsigned int idx = 0; (idx < src_len && destCapacity > 0);) {
-                    utf32 cp;
-                    utf8 cu = src[idx++];
-
-                    if (cu < 0x80)
-                        cp = (utf32) cu;
-                    else if (cu < 0xE0) {
-                        cp = ((cu & 0x1F) << 6);
-                        cp |= (src[idx++] & 0x3F);
-                    } else if (cu < 0xF0) {
-                        cp = ((cu & 0x0F) << 12);
-                        cp |= ((src[idx++] & 0x3F) << 6);
-                        cp |= (src[idx++] & 0x3F);
-                    } else {
-                        cp = ((cu & 0x07) << 18);
-                        cp |= ((src[idx++] & 0x3F) << 12);
-                        cp |= ((src[idx++] & 0x3F) << 6);
-                        cp |= (src[idx++] & 0x3F);
-                    }
-
-                    *dest++ = cp;
-                    --destCapacity;
-                }
-
-                return dest_len - destCapacity;
+                return EncodeUtf8(src, src_len, dest, dest_len);
             }
 
             // Return the number of utf8 code units required to encode the given utf32 code point
@@ -4024,60 +4604,12 @@ namespace Edo {
             // Return number of code units required to re-encode given utf32 data as utf8.
             // Len is number of code units in 'buf'
             size_type EncodedSize(const utf32 *buf, size_type len) const {
-                size_type count = 0;
-
-                while (len--)
-                    count += EncodedSize(*buf++);
-
-                return count;
-            }
-
-            // Return number of utf32 code units required to re-encode given utf8 data as utf32.
-            // Return does not include terminating null
-            size_type EncodedSize(const utf8 *buf) const {
-                return EncodedSize(buf, UtfLength(buf));
-            }
-
-            // Return number of utf32 code units required to re-encode given utf8 data as utf32.
-            // Len is number of code units in 'buf'
-            size_type EncodedSize(const utf8 *buf, size_type len) const {
-                utf8 tcp;
-                size_type count = 0;
-
-                while (len--) {
-                    tcp = *buf++;
-                    ++count;
-                    size_type size = 0;
-
-                    if (tcp < 0x80) {}
-                    else if (tcp < 0xE0) {
-                        size = 1;
-                        ++buf;
-                    } else if (tcp < 0xF0) {
-                        size = 2;
-                        buf += 2;
-                    } else {
-                        size = 3;
-                        buf += 3;
-                    }
-
-                    if (len >= size)
-                        len -= size;
-                    else
-                        break;
-                }
-
-                return count;
+                return Utf8LengthOf(buf, len);
             }
 
             // Return number of code units in a null terminated string
             size_type UtfLength(const utf8 *utf8_str) const {
-                size_type cnt = 0;
-
-                while (*utf8_str++)
-                    cnt++;
-
-                return cnt;
+                return strlen(reinterpret_cast<const char *>(utf8_str));
             }
 
             // Return number of code units in a null terminated string
@@ -4090,9 +4622,23 @@ namespace Edo {
                 return cnt;
             }
 
-            // Build an internal buffer with the string encoded as utf8 (remains valid until string is modified)
+            // Compare the 'len' code points at 'idx' with the 'units' code units of utf8 data, decoded as DecodeUtf8()
+            // does, so malformed data is never read past its end
+            int CompareUtf8(size_type idx, size_type len, const utf8 *utf8_str, size_type units) const;
+
+            // Encode the string as utf8 and publish the result, unless another thread was faster. Returns the
+            // published encoding, which remains valid until a non-const call
             utf8 *BuildUtf8Buff() const;
 
+            // Encode the string into 'block' if it is large enough, or into a new block which replaces it
+            utf8 *EncodeUtf8Block(utf8 *block) const;
+
+            // Release the utf8 encoding. Only called with exclusive access to the string
+            void FreeUtf8Buff();
+
+            // Release the heap buffer and the utf8 encoding, leaving an empty string with default settings
+            void Release() noexcept;
+
             // Compare two utf32 buffers
             int Utf32CompUtf32(const utf32 *buf1, const utf32 *buf2, size_type cp_count) const {
                 if (!cp_count)
@@ -4146,67 +4692,72 @@ namespace Edo {
                 return *--buf1 - cp;
             }
 
-            // Return index of first occurrence of 'code_point' in std::string 'str', or npos if none
-            size_type FindCodePoint(const std::string &str, utf32 code_point) const {
-                size_type idx = 0, sze = (size_type) str.size();
+            // Return index of the first occurrence of 'needle' at or after 'idx', or npos if none. Uses 'searcher' (which
+            // must hold the same needle) when given
+            size_type FindIn(const utf32 *needle, size_type len, size_type idx, const EdoStringSearcher *searcher) const {
+                if (idx >= d_cpLength)
+                    return npos;
 
-                while (idx != sze) {
-                    if (code_point == static_cast<utf32>(static_cast<unsigned char>(str[idx])))
-                        return idx;
+                if (len == 0)
+                    return idx;
 
-                    ++idx;
-                }
+                size_type pos = searcher ? searcher->Find(&ptr()[idx], d_cpLength - idx)
+                                         : FindSubstring(&ptr()[idx], d_cpLength - idx, needle, len);
 
-                return npos;
+                return pos == STR_NOT_FOUND ? npos : idx + pos;
             }
 
-            // Return index of first occurrence of 'code_point' in utf8 encoded string 'str', or npos if none.
-            // Len is in code points
-            size_type FindCodePoint(const utf8 *str, size_type len, utf32 code_point) const {
-                size_type idx = 0;
+            // Return index of the last occurrence of 'needle' starting at or before 'idx', or npos if none. Uses
+            // 'searcher' (which must hold the same needle) when given
+            size_type RFindIn(const utf32 *needle, size_type len, size_type idx, const EdoStringSearcher *searcher) const {
+                if (len == 0)
+                    return (idx < d_cpLength) ? idx : d_cpLength;
+
+                if (len > d_cpLength)
+                    return npos;
 
-                utf32 cp;
-                utf8 cu;
+                if (idx > d_cpLength - len)
+                    idx = d_cpLength - len;
 
-                while (idx != len) {
-                    cu = *str++;
+                size_type pos = searcher ? searcher->RFind(ptr(), idx + len)
+                                         : RFindSubstring(ptr(), idx + len, needle, len);
 
-                    if (cu < 0x80) {
-                        cp = (utf32) cu;
-                    } else if (cu < 0xE0) {
-                        cp = (cu & 0x1F) << 6;
-                        cp |= *str++ & 0x3F;
-                    } else if (cu < 0xF0) {
-                        cp = (cu & 0x0F) << 12;
-                        cp |= (*str++ & 0x3F) << 6;
-                        cp |= *str++ & 0x3F;
-                    } else {
-                        cp = (cu & 0x07) << 18;
-                        cp |= (*str++ & 0x3F) << 12;
-                        cp |= (*str++ & 0x3F) << 6;
-                        cp |= *str++ & 0x3F;
-                    }
+                return pos == STR_NOT_FOUND ? npos : pos;
+            }
 
-                    if (code_point == cp)
-                        return idx;
+            // Return index of the first code point at or after 'idx' that is (or with 'member' false, is not) in 'set',
+            // or npos if none
+            size_type FindInSet(const EdoCodePointSet &set, size_type idx, bool member) const {
+                if (idx < d_cpLength) {
+                    size_type pos = set.Find(&ptr()[idx], d_cpLength - idx, member);
 
-                    ++idx;
+                    if (pos != STR_NOT_FOUND)
+                        return idx + pos;
                 }
 
                 return npos;
             }
 
-            // Return index of first occurrence of 'code_point' in char array 'chars', or npos if none
-            size_type FindCodePoint(const char *chars, size_type chars_len, utf32 code_point) const {
-                for (size_type idx = 0; idx != chars_len; ++idx) {
-                    if (code_point == static_cast<utf32>(static_cast<unsigned char>(chars[idx])))
-                        return idx;
-                }
+            // Return index of the last code point at or before 'idx' that is (or with 'member' false, is not) in 'set',
+            // or npos if none
+            size_type RFindInSet(const EdoCodePointSet &set, size_type idx, bool member) const {
+                if (d_cpLength == 0)
+                    return npos;
 
-                return npos;
+                if (idx >= d_cpLength)
+                    idx = d_cpLength - 1;
+
+                size_type pos = set.RFind(ptr(), idx + 1, member);
+
+                return pos == STR_NOT_FOUND ? npos : pos;
             }
         };
 
+        // The length and flags word, the utf8 cache pointer and the quick-buffer: 48 bytes on 64-bit builds, 40 on
+        // 32-bit ones. A change to the layout or to STR_QUICKBUFF_SIZE has to update this deliberately
+        static_assert(sizeof(EdoString) == 2 * sizeof(size_t) + STR_QUICKBUFF_SIZE * sizeof(utf32),
+                      "EdoString is larger than its length word, utf8 cache pointer and quick-buffer");
+
         //////////////////////////////////////////////
         // Comparison operators
         //////////////////////////////////////////////
@@ -4591,6 +5142,168 @@ namespace Edo {
          */
         EdoString EDO_API operator+(const char *c_str, const EdoString &str);
 
+        // The overloads below take a temporary operand and build the result in its buffer, so in a chain such as
+        // a + b + c + d every step after the first appends to the same EdoString. That buffer grows geometrically (see
+        // EdoStringAllocator::GrowSize()), which makes an N term chain cost O(log N) allocations rather than one per
+        // term. Only EdoStringBuilder, which adds up the length of all the pieces first, allocates exactly once.
+
+        /*!
+         * \brief
+         * Return EdoString object that is the concatenation of the given inputs
+         * \note
+         * A chain of N concatenations re-uses the temporary at every step, for O(log N) allocations in total. Use
+         * EdoStringBuilder when a single allocation is required
+         * \param str1
+         * Temporary EdoString object describing first part of the new string. Its buffer is re-used for the result
+         * \param str2
+         * EdoString object describing the second part of the new string
+         * \return
+         * An EdoString object that is the concatenation of \a str1 and \a str2
+         * \exception
+         * std::length_error Thrown if the resulting EdoString would be too large
+         */
+        EdoString EDO_API operator+(EdoString &&str1, const EdoString &str2);
+
+        /*!
+         * \brief
+         * Return EdoString object that is the concatenation of the given inputs
+         * \param str1
+         * EdoString object describing first part of the new string
+         * \param str2
+         * Temporary EdoString object describing the second part of the new string. Its buffer is re-used for the result
+         * \return
+         * An EdoString object that is the concatenation of \a str1 and \a str2
+         * \exception
+         * std::length_error Thrown if the resulting EdoString would be too large
+         */
+        EdoString EDO_API operator+(const EdoString &str1, EdoString &&str2);
+
+        /*!
+         * \brief
+         * Return EdoString object that is the concatenation of the given inputs
+         * \param str1
+         * Temporary EdoString object describing first part of the new string. Its buffer is re-used for the result
+         * \param str2
+         * Temporary EdoString object describing the second part of the new string
+         * \return
+         * An EdoString object that is the concatenation of \a str1 and \a str2
+         * \exception
+         * std::length_error Thrown if the resulting EdoString would be too large
+         */
+        EdoString EDO_API operator+(EdoString &&str1, EdoString &&str2);
+
+        /*!
+         * \brief
+         * Return EdoString object that is the concatenation of the given inputs
+         * \param str
+         * Temporary EdoString object describing first part of the new string. Its buffer is re-used for the result
+         * \param std_str
+         * std::string object describing the second part of the new string
+         * \return
+         * An EdoString object that is the concatenation of \a str and \a std_str
+         * \exception
+         * std::length_error Thrown if the resulting EdoString would be too large
+         */
+        EdoString EDO_API operator+(EdoString &&str, const std::string &std_str);
+
+        /*!
+         * \brief
+         * Return EdoString object that is the concatenation of the given inputs
+         * \param std_str
+         * std::string object describing first part of the new string
+         * \param str
+         * Temporary EdoString object describing the second part of the new string. Its buffer is re-used for the result
+         * \return
+         * An EdoString object that is the concatenation of \a std_str and \a str
+         * \exception
+         * std::length_error Thrown if the resulting EdoString would be too large
+         */
+        EdoString EDO_API operator+(const std::string &std_str, EdoString &&str);
+
+        /*!
+         * \brief
+         * Return EdoString object that is the concatenation of the given inputs
+         * \param str
+         * Temporary EdoString object describing first part of the new string. Its buffer is re-used for the result
+         * \param utf8_str
+         * Buffer containing null-terminated utf8 encoded data describing the second part of the new string
+         * \return
+         * An EdoString object that is the concatenation of \a str and \a utf8_str
+         * \exception
+         * std::length_error Thrown if the resulting EdoString would be too large
+         */
+        EdoString EDO_API operator+(EdoString &&str, const utf8 *utf8_str);
+
+        /*!
+         * \brief
+         * Return EdoString object that is the concatenation of the given inputs
+         * \param utf8_str
+         * Buffer containing null-terminated utf8 encoded data describing first part of the new string
+         * \param str
+         * Temporary EdoString object describing the second part of the new string. Its buffer is re-used for the result
+         * \return
+         * An EdoString object that is the concatenation of \a utf8_str and \a str
+         * \exception
+         * std::length_error Thrown if the resulting EdoString would be too large
+         */
+        EdoString EDO_API operator+(const utf8 *utf8_str, EdoString &&str);
+
+        /*!
+         * \brief
+         * Return EdoString object that is the concatenation of the given inputs
+         * \param str
+         * Temporary EdoString object describing first part of the new string. Its buffer is re-used for the result
+         * \param code_point
+         * Utf32 code point describing the second part of the new string
+         * \return
+         * An EdoString object that is the concatenation of \a str and \a code_point
+         * \exception
+         * std::length_error Thrown if the resulting EdoString would be too large
+         */
+        EdoString EDO_API operator+(EdoString &&str, utf32 code_point);
+
+        /*!
+         * \brief
+         * Return EdoString object that is the concatenation of the given inputs
+         * \param code_point
+         * Utf32 code point describing first part of the new string
+         * \param str
+         * Temporary EdoString object describing the second part of the new string. Its buffer is re-used for the result
+         * \return
+         * An EdoString object that is the concatenation of \a code_point and \a str
+         * \exception
+         * std::length_error Thrown if the resulting EdoString would be too large
+         */
+        EdoString EDO_API operator+(utf32 code_point, EdoString &&str);
+
+        /*!
+         * \brief
+         * Return EdoString object that is the concatenation of the given inputs
+         * \param str
+         * Temporary EdoString object describing first part of the new string. Its buffer is re-used for the result
+         * \param c_str
+         * C-string describing the second part of the new string
+         * \return
+         * An EdoString object that is the concatenation of \a str and \a c_str
+         * \exception
+         * std::length_error Thrown if the resulting EdoString would be too large
+         */
+        EdoString EDO_API operator+(EdoString &&str, const char *c_str);
+
+        /*!
+         * \brief
+         * Return EdoString object that is the concatenation of the given inputs
+         * \param c_str
+         * C-string describing first part of the new string
+         * \param str
+         * Temporary EdoString object describing the second part of the new string. Its buffer is re-used for the result
+         * \return
+         * An EdoString object that is the concatenation of \a c_str and \a str
+         * \exception
+         * std::length_error Thrown if the resulting EdoString would be too large
+         */
+        EdoString EDO_API operator+(const char *c_str, EdoString &&str);
+
         //////////////////////////////////////////////
         // Output (stream) functions
         //////////////////////////////////////////////
@@ -4607,7 +5320,7 @@ namespace Edo {
          * \param str2
          * EdoString object who's contents are to be swapped with \a str1
          */
-        void EDO_API Swap(EdoString &str1, EdoString &str2);
+        void EDO_API Swap(EdoString &str1, EdoString &str2) noexcept;
 
         /*!
          * \brief
@@ -4625,13 +5338,70 @@ namespace Edo {
             }
         };
 
+        /*!
+         * \brief
+         * Functor that can be used as hasher in std::unordered_map with EdoString keys. Same as std::hash<EdoString>
+         */
+        struct EdoStringHash {
+            size_t operator()(const EdoString &str) const {
+                return str.Hash();
+            }
+        };
+
+        inline EdoString EdoStringView::ToString() const {
+            return EdoString(*this);
+        }
+
+        /*!
+         * \brief
+         * Return the text a std::ostream writes for \a i. The integer and floating point overloads below are used for
+         * numbers, which skip the stream
+         */
         template<class C>
         inline EdoString ToString(const C &i) {
             std::ostringstream converter;
             converter << i;
             return EdoString((utf8 *) converter.str().c_str());
         }
+
+        // Write a number straight into the new string, see FormatNumber()
+        template<typename T>
+        inline EdoString NumberToString(T value) {
+            char buff[STR_NUMBER_CHARS];
+            return EdoString(buff, FormatNumber(value, buff));
+        }
+
+        /*!
+         * \brief
+         * Return the decimal representation of \a value, without going through a stream. Floating point values are
+         * written with the shortest digits that read back as the same value, see FormatDouble()
+         */
+        inline EdoString ToString(int value) { return NumberToString(value); }
+
+        inline EdoString ToString(unsigned int value) { return NumberToString(value); }
+
+        inline EdoString ToString(long value) { return NumberToString(value); }
+
+        inline EdoString ToString(unsigned long value) { return NumberToString(value); }
+
+        inline EdoString ToString(long long value) { return NumberToString(value); }
+
+        inline EdoString ToString(unsigned long long value) { return NumberToString(value); }
+
+        inline EdoString ToString(float value) { return NumberToString(value); }
+
+        inline EdoString ToString(double value) { return NumberToString(value); }
     } // Namespace Types
 } // Namespace Edo
 
+namespace std {
+    //! Lets EdoString be used as key of the unordered containers without naming a hasher
+    template<>
+    struct hash<Edo::Types::EdoString> {
+        size_t operator()(const Edo::Types::EdoString &str) const {
+            return str.Hash();
+        }
+    };
+} // Namespace std
+
 #endif //EDOCORE_EDOSTRING_H
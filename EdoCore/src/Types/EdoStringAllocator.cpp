@@ -0,0 +1,82 @@
+// =============================================================================
+// EdoStringAllocator.cpp
+// Implements the default string allocator and the per-thread allocator selection
+// =============================================================================
+
+#include "EdoStringAllocator.h"
+#include <new>
+
+namespace Edo {
+    namespace Types {
+        // Allocator set for the calling thread, nullptr when the default is in use
+        static thread_local EdoStringAllocator *s_currentAllocator = nullptr;
+
+        ///////////////////////////////////////////////
+        // EdoStringAllocator
+        ///////////////////////////////////////////////
+        EdoStringAllocator::EdoStringAllocator(EdoStringAllocator::GrowthPolicy policy) : d_growth(policy) {
+        }
+
+        EdoStringAllocator::~EdoStringAllocator() {
+        }
+
+        size_t EdoStringAllocator::GrowSize(size_t reserve, size_t required, size_t max_size) const {
+            size_t grown = reserve;
+
+            switch (d_growth) {
+                case GrowOneAndHalf:
+                    grown = (reserve < max_size - reserve / 2) ? reserve + reserve / 2 : max_size;
+                    break;
+                case GrowDouble:
+                    grown = (reserve < max_size - reserve) ? reserve * 2 : max_size;
+                    break;
+                default:
+                    break;
+            }
+
+            return (grown > required) ? grown : required;
+        }
+
+        EdoStringAllocator &EdoStringAllocator::GetDefault() {
+            // Never destroyed, so strings with static storage duration can still release their buffers at exit
+            static EdoStringAllocator *s_default = new EdoStringHeapAllocator();
+            return *s_default;
+        }
+
+        EdoStringAllocator &EdoStringAllocator::GetCurrent() {
+            return (s_currentAllocator != nullptr) ? *s_currentAllocator : GetDefault();
+        }
+
+        EdoStringAllocator *EdoStringAllocator::Exchange(EdoStringAllocator *allocator) {
+            EdoStringAllocator *previous = s_currentAllocator;
+            s_currentAllocator = allocator;
+            return previous;
+        }
+
+        ///////////////////////////////////////////////
+        // EdoStringHeapAllocator
+        ///////////////////////////////////////////////
+        EdoStringHeapAllocator::EdoStringHeapAllocator(EdoStringAllocator::GrowthPolicy policy)
+                : EdoStringAllocator(policy) {
+        }
+
+        void *EdoStringHeapAllocator::Allocate(size_t bytes) {
+            return ::operator new(bytes);
+        }
+
+        void EdoStringHeapAllocator::Deallocate(void *ptr, size_t) {
+            ::operator delete(ptr);
+        }
+
+        ///////////////////////////////////////////////
+        // EdoStringAllocatorScope
+        ///////////////////////////////////////////////
+        EdoStringAllocatorScope::EdoStringAllocatorScope(EdoStringAllocator &allocator)
+                : d_previous(EdoStringAllocator::Exchange(&allocator)) {
+        }
+
+        EdoStringAllocatorScope::~EdoStringAllocatorScope() {
+            EdoStringAllocator::Exchange(d_previous);
+        }
+    } // Namespace Types
+} // Namespace Edo
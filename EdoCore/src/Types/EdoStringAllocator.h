@@ -0,0 +1,162 @@
+// =============================================================================
+// EdoStringAllocator.h
+// Defines the allocator interface and growth policies used for string memory
+// =============================================================================
+
+#ifndef EDOCORE_EDOSTRINGALLOCATOR_H
+#define EDOCORE_EDOSTRINGALLOCATOR_H
+
+#include "EdoBase.h"
+#include <cstddef>
+
+namespace Edo {
+    namespace Types {
+        /*!
+         * \brief
+         * Source of the heap memory used by EdoString, together with the policy deciding how much a buffer grows
+         * when it runs out of room.
+         *
+         * A string picks up the current allocator of its thread (see EdoStringAllocatorScope) when it first needs
+         * heap memory, and keeps using that allocator until the buffer is released. The allocator is remembered in
+         * front of each block, so it does not cost any space in the string object itself.
+         * \note
+         * An allocator must outlive every string that took memory from it. For per-frame or per-request arenas this
+         * means the strings have to be destroyed (or moved back to the quick-buffer) before the arena is reset.
+         */
+        class EDO_API EdoStringAllocator {
+        public:
+            /*!
+             * \brief
+             * How the reserve of a heap buffer grows when more room is needed
+             */
+            enum GrowthPolicy {
+                GrowExact, //!< Allocate exactly the requested size. Smallest footprint, but append loops are quadratic
+                GrowOneAndHalf, //!< Grow by at least 50% of the current reserve
+                GrowDouble //!< Grow by at least 100% of the current reserve
+            };
+
+            /*!
+             * \brief
+             * Constructor
+             * \param policy
+             * Growth policy for the buffers handed out by this allocator
+             */
+            explicit EdoStringAllocator(GrowthPolicy policy = GrowDouble);
+
+            /*!
+             * \brief
+             * Destructor for EdoStringAllocator objects
+             */
+            virtual ~EdoStringAllocator();
+
+            /*!
+             * \brief
+             * Allocates a block of memory suitably aligned for any fundamental type
+             * \param bytes
+             * Size of the block in bytes
+             * \return
+             * Pointer to the new block
+             * \exception
+             * std::bad_alloc Thrown if the memory could not be allocated
+             */
+            virtual void *Allocate(size_t bytes) = 0;
+
+            /*!
+             * \brief
+             * Releases a block previously returned by Allocate()
+             * \param ptr
+             * Pointer to the block
+             * \param bytes
+             * Size of the block in bytes, as it was passed to Allocate()
+             */
+            virtual void Deallocate(void *ptr, size_t bytes) = 0;
+
+            /*!
+             * \brief
+             * Return the growth policy of this allocator
+             */
+            GrowthPolicy GetGrowthPolicy() const { return d_growth; }
+
+            /*!
+             * \brief
+             * Set the growth policy of this allocator. Only affects buffers that grow from now on
+             */
+            void SetGrowthPolicy(GrowthPolicy policy) { d_growth = policy; }
+
+            /*!
+             * \brief
+             * Return the size a buffer should be re-allocated to
+             * \param reserve
+             * Current size of the buffer, in elements
+             * \param required
+             * Number of elements the buffer has to hold at least
+             * \param max_size
+             * Largest size the buffer may have
+             * \return
+             * New size of the buffer, never smaller than \a required
+             */
+            size_t GrowSize(size_t reserve, size_t required, size_t max_size) const;
+
+            /*!
+             * \brief
+             * Return the allocator used when none has been set for the calling thread. It uses the global operator new,
+             * with the GrowDouble policy
+             */
+            static EdoStringAllocator &GetDefault();
+
+            /*!
+             * \brief
+             * Return the allocator new string buffers of the calling thread are taken from
+             */
+            static EdoStringAllocator &GetCurrent();
+
+        private:
+            friend class EdoStringAllocatorScope;
+
+            GrowthPolicy d_growth; //!< Growth policy for buffers from this allocator
+
+            // Set the allocator for the calling thread, returning the previous one (nullptr means the default)
+            static EdoStringAllocator *Exchange(EdoStringAllocator *allocator);
+        };
+
+        /*!
+         * \brief
+         * EdoStringAllocator using the global operator new and delete
+         */
+        class EDO_API EdoStringHeapAllocator : public EdoStringAllocator {
+        public:
+            explicit EdoStringHeapAllocator(GrowthPolicy policy = GrowDouble);
+
+            void *Allocate(size_t bytes) override;
+
+            void Deallocate(void *ptr, size_t bytes) override;
+        };
+
+        /*!
+         * \brief
+         * Makes an allocator the current one of the calling thread for as long as the scope object lives. Scopes can
+         * be nested, the previous allocator is restored on destruction.
+         * \example_snippet_start
+         *      {
+         *          EdoStringAllocatorScope scope(frameAllocator);
+         *          EdoString label = name + TEXT(": ") + value; // Memory comes from frameAllocator
+         *      }
+         * \example_snippet_end
+         */
+        class EDO_API EdoStringAllocatorScope {
+        public:
+            explicit EdoStringAllocatorScope(EdoStringAllocator &allocator);
+
+            ~EdoStringAllocatorScope();
+
+            EdoStringAllocatorScope(const EdoStringAllocatorScope &) = delete;
+
+            EdoStringAllocatorScope &operator=(const EdoStringAllocatorScope &) = delete;
+
+        private:
+            EdoStringAllocator *d_previous; //!< Allocator to restore when the scope ends
+        };
+    } // Namespace Types
+} // Namespace Edo
+
+#endif // EDOCORE_EDOSTRINGALLOCATOR_H
@@ -0,0 +1,139 @@
+// =============================================================================
+// EdoStringBuilder.cpp
+// Implements the single allocation concatenation helper
+// =============================================================================
+
+#include "EdoStringBuilder.h"
+
+namespace Edo {
+    namespace Types {
+        EdoStringBuilder::EdoStringBuilder() : d_count(0) {
+        }
+
+        EdoStringBuilder::~EdoStringBuilder() {
+        }
+
+        EdoStringBuilder::size_type EdoStringBuilder::FormatPiece(const EdoStringBuilder::Piece &piece, char *dest) {
+            switch (piece.type) {
+                case PieceSigned:
+                    return FormatInt64(piece.signedValue, dest);
+                case PieceUnsigned:
+                    return FormatUInt64(piece.unsignedValue, dest);
+                case PieceFloat:
+                    return FormatFloat((float) piece.floatValue, dest);
+                default:
+                    return FormatDouble(piece.floatValue, dest);
+            }
+        }
+
+        EdoStringBuilder::size_type EdoStringBuilder::PieceLength(const EdoStringBuilder::Piece &piece) const {
+            char digits[STR_NUMBER_CHARS];
+
+            switch (piece.type) {
+                case PieceString:
+                    return static_cast<const EdoString *>(piece.data)->Size();
+                case PieceOwned:
+                    return d_owned[piece.len].Size();
+                case PieceSigned:
+                case PieceUnsigned:
+                case PieceFloat:
+                case PieceDouble:
+                    return FormatPiece(piece, digits);
+                case PieceUtf8:
+                    return Utf32LengthOf(static_cast<const utf8 *>(piece.data), piece.len);
+                case PieceWide:
+                    return Utf32LengthOf(static_cast<const wchar_t *>(piece.data), piece.len);
+                case PieceCodePoint:
+                    return 1;
+                default:
+                    return piece.len;
+            }
+        }
+
+        EdoStringBuilder::size_type EdoStringBuilder::Length() const {
+            size_type len = 0;
+
+            for (size_type i = 0; i < d_count; ++i)
+                len += PieceLength(PieceAt(i));
+
+            return len;
+        }
+
+        EdoString EdoStringBuilder::ToString() const {
+            EdoString result;
+            AppendTo(result);
+            return result;
+        }
+
+        EdoString &EdoStringBuilder::AppendTo(EdoString &str) const {
+            // utf8 and wchar_t pieces are decoded in a single pass, so reserve one code point per code unit for them
+            size_type room = 0;
+
+            for (size_type i = 0; i < d_count; ++i) {
+                const Piece &piece = PieceAt(i);
+                room += (piece.type == PieceUtf8 || piece.type == PieceWide) ? piece.len : PieceLength(piece);
+            }
+
+            if (str.MaxSize() - str.d_cpLength <= room)
+                throw std::length_error("Resulting EdoString would be too large");
+
+            bool grew = str.Grow(str.d_cpLength + room);
+            utf32 *start = &str.ptr()[str.d_cpLength];
+            utf32 *dest = start;
+
+            for (size_type i = 0; i < d_count; ++i) {
+                const Piece &piece = PieceAt(i);
+
+                switch (piece.type) {
+                    case PieceString:
+                    case PieceOwned: {
+                        const EdoString *source = (piece.type == PieceOwned) ? &d_owned[piece.len]
+                                                                              : static_cast<const EdoString *>(piece.data);
+                        memcpy(dest, source->ptr(), source->Size() * sizeof(utf32));
+                        dest += source->Size();
+                        break;
+                    }
+                    case PieceChars: {
+                        const unsigned char *chars = static_cast<const unsigned char *>(piece.data);
+
+                        for (size_type n = 0; n < piece.len; ++n)
+                            *dest++ = static_cast<utf32>(chars[n]);
+
+                        break;
+                    }
+                    case PieceUtf8:
+                        dest += DecodeUtf8(static_cast<const utf8 *>(piece.data), piece.len, dest);
+                        break;
+                    case PieceWide:
+                        dest += DecodeWide(static_cast<const wchar_t *>(piece.data), piece.len, dest);
+                        break;
+                    case PieceCodePoint:
+                        *dest++ = static_cast<utf32>(piece.len);
+                        break;
+                    case PieceSigned:
+                    case PieceUnsigned:
+                    case PieceFloat:
+                    case PieceDouble: {
+                        char digits[STR_NUMBER_CHARS];
+                        size_type len = FormatPiece(piece, digits);
+
+                        for (size_type n = 0; n < len; ++n)
+                            *dest++ = static_cast<utf32>(digits[n]);
+
+                        break;
+                    }
+                }
+            }
+
+            str.SetLen(str.d_cpLength + (dest - start));
+            str.TrimDecodeSlack(grew);
+            return str;
+        }
+
+        void EdoStringBuilder::Clear() {
+            d_count = 0;
+            d_morePieces.clear();
+            d_owned.clear();
+        }
+    } // Namespace Types
+} // Namespace Edo
@@ -0,0 +1,338 @@
+// =============================================================================
+// EdoStringBuilder.h
+// Defines a helper that concatenates mixed pieces into an EdoString with a single allocation
+// =============================================================================
+
+#ifndef EDOCORE_EDOSTRINGBUILDER_H
+#define EDOCORE_EDOSTRINGBUILDER_H
+
+#include "EdoString.h"
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Edo {
+    namespace Types {
+#define STR_BUILDER_QUICK_PIECES 16 // Number of pieces a builder can record before it has to allocate
+
+        /*!
+         * \brief
+         * Records the pieces of a concatenation and materialises them into an EdoString in one go. The final length is
+         * computed in a single pass over the pieces, so the result is allocated exactly once, instead of once per step
+         * as with a chain of operator+ calls.
+         *
+         * Every operand type accepted by the EdoString operator+ overloads can be appended, plus wide strings (which is
+         * what the TEXT() macro produces). Each piece is interpreted the same way the matching EdoString constructor
+         * would interpret it. operator<< writes integer and floating point values as decimal numbers (see
+         * FormatNumber()), and char types and utf32 as the code point they hold. AppendNumber() writes the digits of
+         * any arithmetic value, utf32 included.
+         * \note
+         * The builder only keeps pointers to lvalue pieces, it does not copy them. Those have to stay alive and
+         * unchanged until ToString() or AppendTo() is called. Temporary EdoString, std::string and std::wstring
+         * pieces are moved or converted into the builder instead, so they may die before it is materialised.
+         * \example_snippet_start
+         *      EdoString msg = (EdoStringBuilder() << "[" << type << "] " << message << " x" << count << '\n').ToString();
+         * \example_snippet_end
+         */
+        class EDO_API EdoStringBuilder {
+        public:
+            typedef EdoString::size_type size_type; //!< Unsigned type used for size values
+
+            /*!
+             * \brief
+             * Constructs an empty builder
+             */
+            EdoStringBuilder();
+
+            /*!
+             * \brief
+             * Destructor for EdoStringBuilder objects
+             */
+            ~EdoStringBuilder();
+
+            EdoStringBuilder(const EdoStringBuilder &) = delete;
+
+            EdoStringBuilder &operator=(const EdoStringBuilder &) = delete;
+
+            //////////////////////////////////////////////
+            // Recording pieces
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Records an EdoString piece
+             * \param str
+             * EdoString object to be appended. Its contents are read when the builder is materialised
+             * \return
+             * This builder
+             */
+            EdoStringBuilder &Append(const EdoString &str) {
+                return Record(PieceString, &str, 0);
+            }
+
+            /*!
+             * \brief
+             * Records a temporary EdoString piece, which the builder takes over
+             * \param str
+             * EdoString object to be appended. It is moved into the builder
+             * \return
+             * This builder
+             */
+            EdoStringBuilder &Append(EdoString &&str) {
+                d_owned.push_back(std::move(str));
+                return Record(PieceOwned, nullptr, d_owned.size() - 1);
+            }
+
+            /*!
+             * \brief
+             * Records a std::string piece
+             * \note
+             * The characters of \a std_str are taken to be unencoded data which represent Unicode code points 0x00..0xFF
+             * \param std_str
+             * std::string object to be appended
+             * \return
+             * This builder
+             */
+            EdoStringBuilder &Append(const std::string &std_str) {
+                return Record(PieceChars, std_str.data(), std_str.size());
+            }
+
+            /*!
+             * \brief
+             * Records a temporary std::string piece, which is converted into an EdoString held by the builder
+             */
+            EdoStringBuilder &Append(std::string &&std_str) {
+                return Append(EdoString(std_str));
+            }
+
+            /*!
+             * \brief
+             * Records a null-terminated utf8 piece
+             * \param utf8_str
+             * Buffer containing valid null-terminated utf8 encoded data
+             * \return
+             * This builder
+             */
+            EdoStringBuilder &Append(const utf8 *utf8_str) {
+                return Record(PieceUtf8, utf8_str, strlen((const char *) utf8_str));
+            }
+
+            /*!
+             * \brief
+             * Records a single code point
+             * \param code_point
+             * utf32 Unicode code point to be appended
+             * \return
+             * This builder
+             */
+            EdoStringBuilder &Append(utf32 code_point) {
+                return Record(PieceCodePoint, nullptr, code_point);
+            }
+
+            /*!
+             * \brief
+             * Records a C-string piece
+             * \note
+             * The characters of \a c_str are taken to be unencoded data which represent Unicode code points 0x00..0xFF
+             * \param c_str
+             * Pointer to a valid C style string
+             * \return
+             * This builder
+             */
+            EdoStringBuilder &Append(const char *c_str) {
+                return Record(PieceChars, c_str, strlen(c_str));
+            }
+
+            /*!
+             * \brief
+             * Records a std::wstring piece
+             * \note
+             * The characters of \a w_str are taken to be code points, with surrogate pairs combined (see DecodeWide())
+             * \param w_str
+             * std::wstring object to be appended
+             * \return
+             * This builder
+             */
+            EdoStringBuilder &Append(const std::wstring &w_str) {
+                return Record(PieceWide, w_str.data(), w_str.size());
+            }
+
+            /*!
+             * \brief
+             * Records a temporary std::wstring piece, which is converted into an EdoString held by the builder
+             */
+            EdoStringBuilder &Append(std::wstring &&w_str) {
+                return Append(EdoString(w_str));
+            }
+
+            /*!
+             * \brief
+             * Records a wide C-string piece, such as the result of the TEXT() macro
+             * \param w_chars
+             * Pointer to a valid C style wide string
+             * \return
+             * This builder
+             */
+            EdoStringBuilder &Append(const wchar_t *w_chars) {
+                return Record(PieceWide, w_chars, wcslen(w_chars));
+            }
+
+            /*!
+             * \brief
+             * Records the decimal representation of an integer or floating point value, as FormatNumber() writes it
+             * \param value
+             * Number to be appended. It is stored in the builder, and formatted when the builder is materialised
+             * \return
+             * This builder
+             */
+            template<typename T>
+            EdoStringBuilder &AppendNumber(T value) {
+                static_assert(std::is_arithmetic<T>::value, "AppendNumber() takes integer and floating point values");
+
+                Piece piece;
+                piece.len = 0;
+
+                if (std::is_floating_point<T>::value) {
+                    piece.type = sizeof(T) == sizeof(float) ? PieceFloat : PieceDouble;
+                    piece.floatValue = (double) value;
+                } else if (std::is_signed<T>::value) {
+                    piece.type = PieceSigned;
+                    piece.signedValue = (int64_t) value;
+                } else {
+                    piece.type = PieceUnsigned;
+                    piece.unsignedValue = (uint64_t) value;
+                }
+
+                return Record(piece);
+            }
+
+            /*!
+             * \brief
+             * Records a piece. Accepts the same types as Append(), temporaries included
+             */
+            template<typename T>
+            typename std::enable_if<!std::is_arithmetic<typename std::decay<T>::type>::value, EdoStringBuilder &>::type
+            operator<<(T &&piece) {
+                return Append(std::forward<T>(piece));
+            }
+
+            /*!
+             * \brief
+             * Records a number as its decimal representation, or a char type (char, wchar_t, char16_t, char32_t) or a
+             * utf32 as the code point it holds, the way operator+ appends it to an EdoString.
+             * \note
+             * utf32 is an unsigned int, so an unsigned int is recorded as a code point as well. Use AppendNumber() to
+             * record its digits instead
+             */
+            template<typename T>
+            typename std::enable_if<std::is_arithmetic<T>::value, EdoStringBuilder &>::type operator<<(T value) {
+                if (std::is_same<T, char>::value)
+                    return Append((utf32) (unsigned char) value);
+
+                if (std::is_same<T, utf32>::value || std::is_same<T, wchar_t>::value ||
+                    std::is_same<T, char16_t>::value || std::is_same<T, char32_t>::value)
+                    return Append((utf32) value);
+
+                return AppendNumber(value);
+            }
+
+            //////////////////////////////////////////////
+            // Materialising
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Return the number of code points the recorded pieces add up to
+             */
+            size_type Length() const;
+
+            /*!
+             * \brief
+             * Builds an EdoString out of the recorded pieces, with a single allocation of exactly the required size
+             * \return
+             * The concatenation of all recorded pieces
+             * \exception
+             * std::length_error Thrown if the resulting EdoString would be too large
+             */
+            EdoString ToString() const;
+
+            /*!
+             * \brief
+             * Appends the recorded pieces to \a str, growing its buffer at most once
+             * \param str
+             * EdoString object the pieces are appended to. It must not be one of the recorded pieces
+             * \return
+             * \a str after the append operation
+             * \exception
+             * std::length_error Thrown if the resulting EdoString would be too large
+             */
+            EdoString &AppendTo(EdoString &str) const;
+
+            /*!
+             * \brief
+             * Forgets all recorded pieces, so the builder can be re-used
+             */
+            void Clear();
+
+        private:
+            enum PieceType {
+                PieceString, //!< Pointer to an EdoString
+                PieceChars, //!< char data taken as code points 0x00..0xFF
+                PieceUtf8, //!< utf8 encoded data
+                PieceWide, //!< wchar_t data, decoded with DecodeWide()
+                PieceCodePoint, //!< A single code point, stored in the length field
+                PieceOwned, //!< An EdoString held in d_owned, at the index stored in the length field
+                PieceSigned, //!< A signed integer
+                PieceUnsigned, //!< An unsigned integer
+                PieceFloat, //!< A float, stored widened to a double (which is exact)
+                PieceDouble //!< A double
+            };
+
+            struct Piece {
+                PieceType type;
+                size_type len; //!< Length in code units of the data, the code point or the index in d_owned
+                union {
+                    const void *data; //!< The recorded data
+                    int64_t signedValue; //!< Value of a PieceSigned
+                    uint64_t unsignedValue; //!< Value of a PieceUnsigned
+                    double floatValue; //!< Value of a PieceFloat or PieceDouble
+                };
+            };
+
+            Piece d_quickPieces[STR_BUILDER_QUICK_PIECES]; //!< Inline storage for the common case of a few pieces
+            std::vector<Piece> d_morePieces; //!< Pieces past the inline storage
+            std::vector<EdoString> d_owned; //!< Temporaries handed to the builder, referred to by index
+            size_type d_count; //!< Total number of recorded pieces
+
+            // Add a piece to the record
+            EdoStringBuilder &Record(PieceType type, const void *data, size_type len) {
+                Piece piece;
+                piece.type = type;
+                piece.len = len;
+                piece.data = data;
+                return Record(piece);
+            }
+
+            EdoStringBuilder &Record(const Piece &piece) {
+                if (d_count < STR_BUILDER_QUICK_PIECES)
+                    d_quickPieces[d_count] = piece;
+                else
+                    d_morePieces.push_back(piece);
+
+                ++d_count;
+                return *this;
+            }
+
+            // Return the piece at the given position
+            const Piece &PieceAt(size_type idx) const {
+                return (idx < STR_BUILDER_QUICK_PIECES) ? d_quickPieces[idx] : d_morePieces[idx - STR_BUILDER_QUICK_PIECES];
+            }
+
+            // Length of a single piece in code points
+            size_type PieceLength(const Piece &piece) const;
+
+            // Write the decimal representation of a number piece to 'dest', which has room for STR_NUMBER_CHARS
+            static size_type FormatPiece(const Piece &piece, char *dest);
+        };
+    } // Namespace Types
+} // Namespace Edo
+
+#endif // EDOCORE_EDOSTRINGBUILDER_H
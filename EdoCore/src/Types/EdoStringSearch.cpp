@@ -0,0 +1,969 @@
+// =============================================================================
+// EdoStringSearch.cpp
+// Implements the scalar and vectorized search kernels, EdoCodePointSet and EdoStringSearcher
+// =============================================================================
+
+#include "EdoStringSearch.h"
+#include "../Utils/EdoCpu.h"
+#include <algorithm>
+
+#ifdef EDO_X86
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace Edo::Utils;
+
+namespace Edo {
+    namespace Types {
+        ///////////////////////////////////////////////
+        // Scalar helpers
+        ///////////////////////////////////////////////
+        // Index of the lowest set bit, bits must not be zero
+        static inline size_t LowestBit(unsigned int bits) {
+#ifdef _MSC_VER
+            unsigned long idx;
+            _BitScanForward(&idx, bits);
+            return idx;
+#else
+            return (size_t) __builtin_ctz(bits);
+#endif
+        }
+
+        // Index of the highest set bit, bits must not be zero
+        static inline size_t HighestBit(unsigned int bits) {
+#ifdef _MSC_VER
+            unsigned long idx;
+            _BitScanReverse(&idx, bits);
+            return idx;
+#else
+            return (size_t) (31 - __builtin_clz(bits));
+#endif
+        }
+
+        static inline bool IsKey(utf32 cp, const utf32 *keys, size_t count) {
+            for (size_t k = 0; k < count; ++k) {
+                if (cp == keys[k])
+                    return true;
+            }
+
+            return false;
+        }
+
+        // Index of the first code point that is one of the keys (member) or none of them (!member)
+        static inline size_t FindScalar(const utf32 *src, size_t len, const utf32 *keys, size_t count, bool member) {
+            if (count == 1) {
+                for (size_t i = 0; i < len; ++i) {
+                    if ((src[i] == keys[0]) == member)
+                        return i;
+                }
+            } else {
+                for (size_t i = 0; i < len; ++i) {
+                    if (IsKey(src[i], keys, count) == member)
+                        return i;
+                }
+            }
+
+            return STR_NOT_FOUND;
+        }
+
+        // Index of the last code point that is one of the keys (member) or none of them (!member)
+        static inline size_t RFindScalar(const utf32 *src, size_t len, const utf32 *keys, size_t count, bool member) {
+            if (count == 1) {
+                while (len-- != 0) {
+                    if ((src[len] == keys[0]) == member)
+                        return len;
+                }
+            } else {
+                while (len-- != 0) {
+                    if (IsKey(src[len], keys, count) == member)
+                        return len;
+                }
+            }
+
+            return STR_NOT_FOUND;
+        }
+
+#ifdef EDO_X86
+        ///////////////////////////////////////////////
+        // SSE2 kernels
+        ///////////////////////////////////////////////
+        // One bit per lane of v that equals one of the keys
+        EDO_TARGET_SSE2 static inline unsigned int MatchSse2(__m128i v, const __m128i *keys, size_t count) {
+            __m128i hit = _mm_cmpeq_epi32(v, keys[0]);
+
+            for (size_t k = 1; k < count; ++k)
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi32(v, keys[k]));
+
+            return (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(hit));
+        }
+
+        EDO_TARGET_SSE2 static inline unsigned int MatchSse2x4(const utf32 *src, const __m128i *keys, size_t count) {
+            return MatchSse2(_mm_loadu_si128((const __m128i *) src), keys, count) |
+                   MatchSse2(_mm_loadu_si128((const __m128i *) (src + 4)), keys, count) << 4 |
+                   MatchSse2(_mm_loadu_si128((const __m128i *) (src + 8)), keys, count) << 8 |
+                   MatchSse2(_mm_loadu_si128((const __m128i *) (src + 12)), keys, count) << 12;
+        }
+
+        EDO_TARGET_SSE2 static size_t FindSse2(const utf32 *src, size_t len, const utf32 *set, size_t count,
+                                               bool member) {
+            __m128i keys[STR_SET_SMALL_SIZE];
+
+            for (size_t k = 0; k < count; ++k)
+                keys[k] = _mm_set1_epi32((int) set[k]);
+
+            // Searching for non-members is searching for members with the lane mask inverted
+            const unsigned int flip = member ? 0 : 0xFFFF;
+
+            size_t i = 0;
+
+            for (; len - i >= 16; i += 16) {
+                unsigned int mask = MatchSse2x4(src + i, keys, count) ^ flip;
+
+                if (mask)
+                    return i + LowestBit(mask);
+            }
+
+            for (; len - i >= 4; i += 4) {
+                __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+                unsigned int mask = (MatchSse2(v, keys, count) ^ flip) & 0xF;
+
+                if (mask)
+                    return i + LowestBit(mask);
+            }
+
+            size_t rest = FindScalar(src + i, len - i, set, count, member);
+            return rest == STR_NOT_FOUND ? rest : i + rest;
+        }
+
+        EDO_TARGET_SSE2 static size_t RFindSse2(const utf32 *src, size_t len, const utf32 *set, size_t count,
+                                                bool member) {
+            __m128i keys[STR_SET_SMALL_SIZE];
+
+            for (size_t k = 0; k < count; ++k)
+                keys[k] = _mm_set1_epi32((int) set[k]);
+
+            const unsigned int flip = member ? 0 : 0xFFFF;
+
+            size_t i = len;
+
+            while (i >= 16) {
+                i -= 16;
+                unsigned int mask = MatchSse2x4(src + i, keys, count) ^ flip;
+
+                if (mask)
+                    return i + HighestBit(mask);
+            }
+
+            while (i >= 4) {
+                i -= 4;
+                __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+                unsigned int mask = (MatchSse2(v, keys, count) ^ flip) & 0xF;
+
+                if (mask)
+                    return i + HighestBit(mask);
+            }
+
+            return RFindScalar(src, i, set, count, member);
+        }
+
+        ///////////////////////////////////////////////
+        // AVX2 kernels
+        ///////////////////////////////////////////////
+        EDO_TARGET_AVX2 static inline unsigned int MatchAvx2(__m256i v, const __m256i *keys, size_t count) {
+            __m256i hit = _mm256_cmpeq_epi32(v, keys[0]);
+
+            for (size_t k = 1; k < count; ++k)
+                hit = _mm256_or_si256(hit, _mm256_cmpeq_epi32(v, keys[k]));
+
+            return (unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(hit));
+        }
+
+        EDO_TARGET_AVX2 static inline unsigned int MatchAvx2x4(const utf32 *src, const __m256i *keys, size_t count) {
+            return MatchAvx2(_mm256_loadu_si256((const __m256i *) src), keys, count) |
+                   MatchAvx2(_mm256_loadu_si256((const __m256i *) (src + 8)), keys, count) << 8 |
+                   MatchAvx2(_mm256_loadu_si256((const __m256i *) (src + 16)), keys, count) << 16 |
+                   MatchAvx2(_mm256_loadu_si256((const __m256i *) (src + 24)), keys, count) << 24;
+        }
+
+        EDO_TARGET_AVX2 static size_t FindAvx2(const utf32 *src, size_t len, const utf32 *set, size_t count,
+                                               bool member) {
+            __m256i keys[STR_SET_SMALL_SIZE];
+
+            for (size_t k = 0; k < count; ++k)
+                keys[k] = _mm256_set1_epi32((int) set[k]);
+
+            const unsigned int flip = member ? 0 : 0xFFFFFFFF;
+
+            size_t i = 0;
+
+            for (; len - i >= 32; i += 32) {
+                unsigned int mask = MatchAvx2x4(src + i, keys, count) ^ flip;
+
+                if (mask)
+                    return i + LowestBit(mask);
+            }
+
+            // The tail stays in this kernel, handing it to the SSE2 one would mix in non-VEX code with the upper
+            // halves of the registers dirty, which stalls on a number of CPUs
+            for (; len - i >= 8; i += 8) {
+                __m256i v = _mm256_loadu_si256((const __m256i *) (src + i));
+                unsigned int mask = (MatchAvx2(v, keys, count) ^ flip) & 0xFF;
+
+                if (mask)
+                    return i + LowestBit(mask);
+            }
+
+            size_t rest = FindScalar(src + i, len - i, set, count, member);
+            return rest == STR_NOT_FOUND ? rest : i + rest;
+        }
+
+        EDO_TARGET_AVX2 static size_t RFindAvx2(const utf32 *src, size_t len, const utf32 *set, size_t count,
+                                                bool member) {
+            __m256i keys[STR_SET_SMALL_SIZE];
+
+            for (size_t k = 0; k < count; ++k)
+                keys[k] = _mm256_set1_epi32((int) set[k]);
+
+            const unsigned int flip = member ? 0 : 0xFFFFFFFF;
+
+            size_t i = len;
+
+            while (i >= 32) {
+                i -= 32;
+                unsigned int mask = MatchAvx2x4(src + i, keys, count) ^ flip;
+
+                if (mask)
+                    return i + HighestBit(mask);
+            }
+
+            while (i >= 8) {
+                i -= 8;
+                __m256i v = _mm256_loadu_si256((const __m256i *) (src + i));
+                unsigned int mask = (MatchAvx2(v, keys, count) ^ flip) & 0xFF;
+
+                if (mask)
+                    return i + HighestBit(mask);
+            }
+
+            // The part left over is at the front
+            return RFindScalar(src, i, set, count, member);
+        }
+        // One bit per lane of v that is a member of the set described by the Latin-1 bitmap
+        EDO_TARGET_AVX2 static inline unsigned int MatchLatin1Avx2(__m256i v, const uint64_t *bitmap) {
+            const __m256i latin1 = _mm256_set1_epi32(0xFF);
+            const __m256i words = _mm256_set1_epi32(7);
+            const __m256i bits = _mm256_set1_epi32(31);
+
+            // Lanes above 0xFF gather some word of the bitmap, the range check clears them afterwards
+            __m256i inRange = _mm256_cmpeq_epi32(_mm256_min_epu32(v, latin1), v);
+            __m256i word = _mm256_i32gather_epi32((const int *) bitmap,
+                                                  _mm256_and_si256(_mm256_srli_epi32(v, 5), words), 4);
+            __m256i bit = _mm256_slli_epi32(_mm256_srlv_epi32(word, _mm256_and_si256(v, bits)), 31);
+
+            return (unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(bit, inRange)));
+        }
+
+        static inline bool IsLatin1Member(utf32 cp, const uint64_t *bitmap) {
+            return cp < 0x100 && ((bitmap[cp >> 6] >> (cp & 63)) & 1);
+        }
+
+        // Like FindAvx2(), for sets too large to compare against each member that lie entirely below 0x100
+        EDO_TARGET_AVX2 static size_t FindLatin1Avx2(const utf32 *src, size_t len, const uint64_t *bitmap,
+                                                     bool member) {
+            const unsigned int flip = member ? 0 : 0xFF;
+
+            size_t i = 0;
+
+            for (; len - i >= 8; i += 8) {
+                unsigned int mask = MatchLatin1Avx2(_mm256_loadu_si256((const __m256i *) (src + i)), bitmap) ^ flip;
+
+                if (mask)
+                    return i + LowestBit(mask);
+            }
+
+            for (; i < len; ++i) {
+                if (IsLatin1Member(src[i], bitmap) == member)
+                    return i;
+            }
+
+            return STR_NOT_FOUND;
+        }
+
+        EDO_TARGET_AVX2 static size_t RFindLatin1Avx2(const utf32 *src, size_t len, const uint64_t *bitmap,
+                                                      bool member) {
+            const unsigned int flip = member ? 0 : 0xFF;
+
+            size_t i = len;
+
+            while (i >= 8) {
+                i -= 8;
+                unsigned int mask = MatchLatin1Avx2(_mm256_loadu_si256((const __m256i *) (src + i)), bitmap) ^ flip;
+
+                if (mask)
+                    return i + HighestBit(mask);
+            }
+
+            while (i-- != 0) {
+                if (IsLatin1Member(src[i], bitmap) == member)
+                    return i;
+            }
+
+            return STR_NOT_FOUND;
+        }
+#endif // EDO_X86
+
+        ///////////////////////////////////////////////
+        // Dispatch
+        ///////////////////////////////////////////////
+        // Searches for the first code point that is one of up to STR_SET_SMALL_SIZE keys (or none of them)
+        static size_t FindKeys(const utf32 *src, size_t len, const utf32 *keys, size_t count, bool member) {
+#ifdef EDO_X86
+            switch (GetSimdLevel()) {
+                case SimdAvx2:
+                    return FindAvx2(src, len, keys, count, member);
+                case SimdSse41:
+                case SimdSse2:
+                    return FindSse2(src, len, keys, count, member);
+                default:
+                    break;
+            }
+#endif
+            return FindScalar(src, len, keys, count, member);
+        }
+
+        // Searches for the last code point that is one of up to STR_SET_SMALL_SIZE keys (or none of them)
+        static size_t RFindKeys(const utf32 *src, size_t len, const utf32 *keys, size_t count, bool member) {
+#ifdef EDO_X86
+            switch (GetSimdLevel()) {
+                case SimdAvx2:
+                    return RFindAvx2(src, len, keys, count, member);
+                case SimdSse41:
+                case SimdSse2:
+                    return RFindSse2(src, len, keys, count, member);
+                default:
+                    break;
+            }
+#endif
+            return RFindScalar(src, len, keys, count, member);
+        }
+
+        size_t FindCodePoint(const utf32 *src, size_t len, utf32 code_point) {
+            return FindKeys(src, len, &code_point, 1, true);
+        }
+
+        size_t RFindCodePoint(const utf32 *src, size_t len, utf32 code_point) {
+            return RFindKeys(src, len, &code_point, 1, true);
+        }
+
+        size_t FindNotCodePoint(const utf32 *src, size_t len, utf32 code_point) {
+            return FindKeys(src, len, &code_point, 1, false);
+        }
+
+        size_t RFindNotCodePoint(const utf32 *src, size_t len, utf32 code_point) {
+            return RFindKeys(src, len, &code_point, 1, false);
+        }
+
+        ///////////////////////////////////////////////
+        // EdoCodePointSet
+        ///////////////////////////////////////////////
+        EdoCodePointSet::EdoCodePointSet() : d_count(0), d_latin1() {}
+
+        EdoCodePointSet::EdoCodePointSet(const utf32 *code_points, size_t len) : EdoCodePointSet() {
+            for (size_t i = 0; i < len; ++i)
+                Insert(code_points[i]);
+        }
+
+        EdoCodePointSet::EdoCodePointSet(const char *chars, size_t chars_len) : EdoCodePointSet() {
+            for (size_t i = 0; i < chars_len; ++i)
+                Insert(static_cast<utf32>(static_cast<unsigned char>(chars[i])));
+        }
+
+        EdoCodePointSet::EdoCodePointSet(const utf8 *utf8_str, size_t str_len) : EdoCodePointSet() {
+            // Sets are usually short, so only decode through the heap when they are not
+            utf32 quick[128];
+            std::vector<utf32> decoded;
+            utf32 *buf = quick;
+
+            if (str_len > sizeof(quick) / sizeof(quick[0])) {
+                decoded.resize(str_len);
+                buf = decoded.data();
+            }
+
+            size_t count = DecodeUtf8(utf8_str, str_len, buf);
+
+            for (size_t i = 0; i < count; ++i)
+                Insert(buf[i]);
+        }
+
+        void EdoCodePointSet::Insert(utf32 code_point) {
+            if (Contains(code_point))
+                return;
+
+            if (d_count < STR_SET_SMALL_SIZE)
+                d_small[d_count] = code_point;
+
+            ++d_count;
+
+            if (code_point < 0x100) {
+                d_latin1[code_point >> 6] |= (uint64_t) 1 << (code_point & 63);
+            } else if (code_point < 0x10000) {
+                if (d_bmp.empty())
+                    d_bmp.assign(0x10000 / 64, 0);
+
+                d_bmp[code_point >> 6] |= (uint64_t) 1 << (code_point & 63);
+            } else {
+                d_supplementary.insert(std::lower_bound(d_supplementary.begin(), d_supplementary.end(), code_point),
+                                       code_point);
+            }
+        }
+
+        bool EdoCodePointSet::ContainsSupplementary(utf32 code_point) const {
+            return std::binary_search(d_supplementary.begin(), d_supplementary.end(), code_point);
+        }
+
+        size_t EdoCodePointSet::Find(const utf32 *src, size_t len, bool member) const {
+            if (d_count == 0)
+                return (member || len == 0) ? STR_NOT_FOUND : 0;
+
+            if (d_count <= STR_SET_SMALL_SIZE)
+                return FindKeys(src, len, d_small, d_count, member);
+
+#ifdef EDO_X86
+            if (d_bmp.empty() && d_supplementary.empty() && GetSimdLevel() == SimdAvx2)
+                return FindLatin1Avx2(src, len, d_latin1, member);
+#endif
+
+            for (size_t i = 0; i < len; ++i) {
+                if (Contains(src[i]) == member)
+                    return i;
+            }
+
+            return STR_NOT_FOUND;
+        }
+
+        size_t EdoCodePointSet::RFind(const utf32 *src, size_t len, bool member) const {
+            if (d_count == 0)
+                return (member || len == 0) ? STR_NOT_FOUND : len - 1;
+
+            if (d_count <= STR_SET_SMALL_SIZE)
+                return RFindKeys(src, len, d_small, d_count, member);
+
+#ifdef EDO_X86
+            if (d_bmp.empty() && d_supplementary.empty() && GetSimdLevel() == SimdAvx2)
+                return RFindLatin1Avx2(src, len, d_latin1, member);
+#endif
+
+            while (len-- != 0) {
+                if (Contains(src[len]) == member)
+                    return len;
+            }
+
+            return STR_NOT_FOUND;
+        }
+
+        ///////////////////////////////////////////////
+        // Two-Way search
+        ///////////////////////////////////////////////
+        // Views the substring search is written against. Reading both the needle and the haystack back to front turns
+        // the search for the first occurrence into one for the last
+        struct ForwardView {
+            const utf32 *data;
+            size_t len;
+
+            utf32 operator[](size_t idx) const { return data[idx]; }
+        };
+
+        struct BackwardView {
+            const utf32 *data;
+            size_t len;
+
+            utf32 operator[](size_t idx) const { return data[len - 1 - idx]; }
+        };
+
+        // Start of the maximal suffix of the needle, under the normal or the reversed order of code points. 'period'
+        // receives the period of that suffix
+        template<typename View>
+        static size_t MaximalSuffix(const View &needle, bool reversed, size_t &period) {
+            // maxSuffix is one below the start of the suffix, so it starts out at -1
+            size_t maxSuffix = (size_t) -1;
+            size_t j = 0;
+            size_t k = 1;
+            size_t p = 1;
+
+            while (j + k < needle.len) {
+                utf32 a = needle[j + k];
+                utf32 b = needle[maxSuffix + k];
+
+                if (reversed ? b < a : a < b) {
+                    // Suffix is smaller, the period is the entire prefix so far
+                    j += k;
+                    k = 1;
+                    p = j - maxSuffix;
+                } else if (a == b) {
+                    // Advance through a repetition of the current period
+                    if (k != p) {
+                        ++k;
+                    } else {
+                        j += p;
+                        k = 1;
+                    }
+                } else {
+                    // Suffix is larger, start over from the current location
+                    maxSuffix = j++;
+                    k = p = 1;
+                }
+            }
+
+            period = p;
+            return maxSuffix + 1;
+        }
+
+        template<typename View>
+        static EdoTwoWayFactorization Factorize(const View &needle) {
+            const size_t m = needle.len;
+
+            EdoTwoWayFactorization plan;
+            size_t reversedPeriod;
+            size_t reversedSuffix = MaximalSuffix(needle, true, reversedPeriod);
+
+            // The later of the two maximal suffixes gives a critical factorization
+            plan.suffix = MaximalSuffix(needle, false, plan.period);
+
+            if (reversedSuffix >= plan.suffix) {
+                plan.suffix = reversedSuffix;
+                plan.period = reversedPeriod;
+            }
+
+            plan.periodic = plan.suffix + plan.period <= m;
+
+            for (size_t i = 0; plan.periodic && i < plan.suffix; ++i)
+                plan.periodic = needle[i] == needle[i + plan.period];
+
+            // Without a period, any mismatch allows the longest shift
+            if (!plan.periodic)
+                plan.period = std::max(plan.suffix, m - plan.suffix) + 1;
+
+            return plan;
+        }
+
+        // Index of the first occurrence of the needle in the haystack at or after position j. Needs needle.len > 0
+        // and hay.len >= needle.len
+        template<typename View>
+        static size_t TwoWay(const View &hay, const View &needle, const EdoTwoWayFactorization &plan, size_t j) {
+            const size_t m = needle.len;
+            const size_t last = hay.len - m;
+
+            if (plan.periodic) {
+                // A mismatch in the left half only allows a shift by the period, so remember how much of the right
+                // half is known to match already
+                size_t memory = 0;
+
+                while (j <= last) {
+                    size_t i = std::max(plan.suffix, memory);
+
+                    while (i < m && needle[i] == hay[i + j])
+                        ++i;
+
+                    if (i < m) {
+                        j += i - plan.suffix + 1;
+                        memory = 0;
+                        continue;
+                    }
+
+                    i = plan.suffix;
+
+                    while (i > memory && needle[i - 1] == hay[i - 1 + j])
+                        --i;
+
+                    if (i <= memory)
+                        return j;
+
+                    j += plan.period;
+                    memory = m - plan.period;
+                }
+            } else {
+                while (j <= last) {
+                    size_t i = plan.suffix;
+
+                    while (i < m && needle[i] == hay[i + j])
+                        ++i;
+
+                    if (i < m) {
+                        j += i - plan.suffix + 1;
+                        continue;
+                    }
+
+                    i = plan.suffix;
+
+                    while (i > 0 && needle[i - 1] == hay[i - 1 + j])
+                        --i;
+
+                    if (i == 0)
+                        return j;
+
+                    j += plan.period;
+                }
+            }
+
+            return STR_NOT_FOUND;
+        }
+
+        ///////////////////////////////////////////////
+        // Substring prefilter
+        ///////////////////////////////////////////////
+        // Candidates are positions where both the first and the last code point of the needle match. The prefilter
+        // verifies them one by one and hands over to Two-Way once it has compared more than twice as many code points
+        // as it has passed positions, plus this slack. That keeps the worst case linear
+        static const size_t s_prefilterSlack = 256;
+
+        // Compares the inner code points of a candidate (needle_len >= 2) and adds the number compared to 'work'
+        static inline bool MatchInner(const utf32 *src, const utf32 *needle, size_t needle_len, size_t &work) {
+            size_t j = 1;
+
+            while (j < needle_len - 1 && src[j] == needle[j])
+                ++j;
+
+            work += j;
+            return j >= needle_len - 1;
+        }
+
+        // Each prefilter checks candidates from 'pos' onwards (or, searching backwards, below 'end') and returns true
+        // once the search is decided, with 'result' holding the match or STR_NOT_FOUND. It returns false when
+        // verification gets too expensive, leaving the candidates it has ruled out behind 'pos' (or from 'end' on)
+        static inline bool PrefilterScalar(const utf32 *src, size_t len, const utf32 *needle, size_t needle_len,
+                                           size_t &pos, size_t &work, size_t &result) {
+            const utf32 first = needle[0];
+            const utf32 last = needle[needle_len - 1];
+
+            for (; pos <= len - needle_len; ++pos) {
+                if (src[pos] != first || src[pos + needle_len - 1] != last)
+                    continue;
+
+                if (MatchInner(src + pos, needle, needle_len, work)) {
+                    result = pos;
+                    return true;
+                }
+
+                if (work > 2 * pos + s_prefilterSlack)
+                    return false;
+            }
+
+            result = STR_NOT_FOUND;
+            return true;
+        }
+
+        static inline bool RPrefilterScalar(const utf32 *src, size_t len, const utf32 *needle, size_t needle_len,
+                                            size_t &end, size_t &work, size_t &result) {
+            const utf32 first = needle[0];
+            const utf32 last = needle[needle_len - 1];
+            const size_t positions = len - needle_len + 1;
+
+            for (; end > 0; --end) {
+                size_t cand = end - 1;
+
+                if (src[cand] != first || src[cand + needle_len - 1] != last)
+                    continue;
+
+                if (MatchInner(src + cand, needle, needle_len, work)) {
+                    result = cand;
+                    return true;
+                }
+
+                if (work > 2 * (positions - end) + s_prefilterSlack)
+                    return false;
+            }
+
+            result = STR_NOT_FOUND;
+            return true;
+        }
+
+#ifdef EDO_X86
+        EDO_TARGET_SSE2 static bool PrefilterSse2(const utf32 *src, size_t len, const utf32 *needle,
+                                                  size_t needle_len, size_t &pos, size_t &work, size_t &result) {
+            const __m128i first = _mm_set1_epi32((int) needle[0]);
+            const __m128i last = _mm_set1_epi32((int) needle[needle_len - 1]);
+            const size_t lastPos = len - needle_len;
+
+            while (pos + 3 <= lastPos) {
+                __m128i head = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) (src + pos)), first);
+                __m128i tail = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) (src + pos + needle_len - 1)), last);
+                unsigned int mask = (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(head, tail)));
+
+                for (; mask; mask &= mask - 1) {
+                    size_t cand = pos + LowestBit(mask);
+
+                    if (MatchInner(src + cand, needle, needle_len, work)) {
+                        result = cand;
+                        return true;
+                    }
+                }
+
+                pos += 4;
+
+                if (work > 2 * pos + s_prefilterSlack)
+                    return false;
+            }
+
+            return PrefilterScalar(src, len, needle, needle_len, pos, work, result);
+        }
+
+        EDO_TARGET_SSE2 static bool RPrefilterSse2(const utf32 *src, size_t len, const utf32 *needle,
+                                                   size_t needle_len, size_t &end, size_t &work, size_t &result) {
+            const __m128i first = _mm_set1_epi32((int) needle[0]);
+            const __m128i last = _mm_set1_epi32((int) needle[needle_len - 1]);
+            const size_t positions = len - needle_len + 1;
+
+            while (end >= 4) {
+                size_t base = end - 4;
+                __m128i head = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) (src + base)), first);
+                __m128i tail = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) (src + base + needle_len - 1)), last);
+                unsigned int mask = (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(head, tail)));
+
+                while (mask) {
+                    size_t bit = HighestBit(mask);
+
+                    if (MatchInner(src + base + bit, needle, needle_len, work)) {
+                        result = base + bit;
+                        return true;
+                    }
+
+                    mask ^= 1U << bit;
+                }
+
+                end = base;
+
+                if (work > 2 * (positions - end) + s_prefilterSlack)
+                    return false;
+            }
+
+            return RPrefilterScalar(src, len, needle, needle_len, end, work, result);
+        }
+
+        EDO_TARGET_AVX2 static bool PrefilterAvx2(const utf32 *src, size_t len, const utf32 *needle,
+                                                  size_t needle_len, size_t &pos, size_t &work, size_t &result) {
+            const __m256i first = _mm256_set1_epi32((int) needle[0]);
+            const __m256i last = _mm256_set1_epi32((int) needle[needle_len - 1]);
+            const size_t lastPos = len - needle_len;
+
+            while (pos + 7 <= lastPos) {
+                __m256i head = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) (src + pos)), first);
+                __m256i tail = _mm256_cmpeq_epi32(
+                        _mm256_loadu_si256((const __m256i *) (src + pos + needle_len - 1)), last);
+                unsigned int mask = (unsigned int) _mm256_movemask_ps(
+                        _mm256_castsi256_ps(_mm256_and_si256(head, tail)));
+
+                for (; mask; mask &= mask - 1) {
+                    size_t cand = pos + LowestBit(mask);
+
+                    if (MatchInner(src + cand, needle, needle_len, work)) {
+                        result = cand;
+                        return true;
+                    }
+                }
+
+                pos += 8;
+
+                if (work > 2 * pos + s_prefilterSlack)
+                    return false;
+            }
+
+            // Scalar tail rather than the SSE2 kernel, see FindAvx2()
+            return PrefilterScalar(src, len, needle, needle_len, pos, work, result);
+        }
+
+        EDO_TARGET_AVX2 static bool RPrefilterAvx2(const utf32 *src, size_t len, const utf32 *needle,
+                                                   size_t needle_len, size_t &end, size_t &work, size_t &result) {
+            const __m256i first = _mm256_set1_epi32((int) needle[0]);
+            const __m256i last = _mm256_set1_epi32((int) needle[needle_len - 1]);
+            const size_t positions = len - needle_len + 1;
+
+            while (end >= 8) {
+                size_t base = end - 8;
+                __m256i head = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) (src + base)), first);
+                __m256i tail = _mm256_cmpeq_epi32(
+                        _mm256_loadu_si256((const __m256i *) (src + base + needle_len - 1)), last);
+                unsigned int mask = (unsigned int) _mm256_movemask_ps(
+                        _mm256_castsi256_ps(_mm256_and_si256(head, tail)));
+
+                while (mask) {
+                    size_t bit = HighestBit(mask);
+
+                    if (MatchInner(src + base + bit, needle, needle_len, work)) {
+                        result = base + bit;
+                        return true;
+                    }
+
+                    mask ^= 1U << bit;
+                }
+
+                end = base;
+
+                if (work > 2 * (positions - end) + s_prefilterSlack)
+                    return false;
+            }
+
+            return RPrefilterScalar(src, len, needle, needle_len, end, work, result);
+        }
+#endif // EDO_X86
+
+        // First occurrence of the needle. 'plan' may be null, then the factorization is only computed if Two-Way
+        // is needed
+        static size_t SearchForward(const utf32 *src, size_t len, const utf32 *needle, size_t needle_len,
+                                    const EdoTwoWayFactorization *plan) {
+            if (needle_len == 0)
+                return 0;
+
+            if (needle_len > len)
+                return STR_NOT_FOUND;
+
+            if (needle_len == 1)
+                return FindCodePoint(src, len, needle[0]);
+
+            size_t pos = 0;
+            size_t work = 0;
+            size_t result;
+            bool decided;
+
+            switch (GetSimdLevel()) {
+#ifdef EDO_X86
+                case SimdAvx2:
+                    decided = PrefilterAvx2(src, len, needle, needle_len, pos, work, result);
+                    break;
+                case SimdSse41:
+                case SimdSse2:
+                    decided = PrefilterSse2(src, len, needle, needle_len, pos, work, result);
+                    break;
+#endif
+                default:
+                    decided = PrefilterScalar(src, len, needle, needle_len, pos, work, result);
+                    break;
+            }
+
+            if (decided)
+                return result;
+
+            const ForwardView hay = {src, len};
+            const ForwardView pattern = {needle, needle_len};
+
+            return TwoWay(hay, pattern, plan ? *plan : Factorize(pattern), pos);
+        }
+
+        // Last occurrence of the needle. 'plan' is the factorization of the needle read back to front, or null
+        static size_t SearchBackward(const utf32 *src, size_t len, const utf32 *needle, size_t needle_len,
+                                     const EdoTwoWayFactorization *plan) {
+            if (needle_len == 0)
+                return len;
+
+            if (needle_len > len)
+                return STR_NOT_FOUND;
+
+            if (needle_len == 1)
+                return RFindCodePoint(src, len, needle[0]);
+
+            size_t end = len - needle_len + 1;
+            size_t work = 0;
+            size_t result;
+            bool decided;
+
+            switch (GetSimdLevel()) {
+#ifdef EDO_X86
+                case SimdAvx2:
+                    decided = RPrefilterAvx2(src, len, needle, needle_len, end, work, result);
+                    break;
+                case SimdSse41:
+                case SimdSse2:
+                    decided = RPrefilterSse2(src, len, needle, needle_len, end, work, result);
+                    break;
+#endif
+                default:
+                    decided = RPrefilterScalar(src, len, needle, needle_len, end, work, result);
+                    break;
+            }
+
+            if (decided)
+                return result;
+
+            if (end == 0)
+                return STR_NOT_FOUND;
+
+            // Positions from 'end' on are ruled out, so only the part of the haystack before that is left to search
+            const size_t prefix = end - 1 + needle_len;
+            const BackwardView hay = {src, prefix};
+            const BackwardView pattern = {needle, needle_len};
+
+            size_t found = TwoWay(hay, pattern, plan ? *plan : Factorize(pattern), 0);
+
+            return found == STR_NOT_FOUND ? found : prefix - needle_len - found;
+        }
+
+        size_t FindSubstring(const utf32 *src, size_t len, const utf32 *needle, size_t needle_len) {
+            return SearchForward(src, len, needle, needle_len, nullptr);
+        }
+
+        size_t RFindSubstring(const utf32 *src, size_t len, const utf32 *needle, size_t needle_len) {
+            return SearchBackward(src, len, needle, needle_len, nullptr);
+        }
+
+        ///////////////////////////////////////////////
+        // EdoStringSearcher
+        ///////////////////////////////////////////////
+        EdoStringSearcher::EdoStringSearcher(const utf32 *needle, size_t len) : d_len(len) {
+            if (len > STR_SEARCHER_QUICK_SIZE)
+                d_heap.assign(needle, needle + len);
+            else
+                std::copy(needle, needle + len, d_quick);
+
+            Prepare();
+        }
+
+        EdoStringSearcher::EdoStringSearcher(const char *chars, size_t chars_len) : d_len(chars_len) {
+            utf32 *buf = d_quick;
+
+            if (chars_len > STR_SEARCHER_QUICK_SIZE) {
+                d_heap.resize(chars_len);
+                buf = d_heap.data();
+            }
+
+            for (size_t i = 0; i < chars_len; ++i)
+                buf[i] = static_cast<utf32>(static_cast<unsigned char>(chars[i]));
+
+            Prepare();
+        }
+
+        EdoStringSearcher::EdoStringSearcher(const utf8 *utf8_str, size_t str_len) : d_len(0) {
+            // The decoder needs room for one code point per code unit
+            if (str_len <= STR_SEARCHER_QUICK_SIZE) {
+                d_len = DecodeUtf8(utf8_str, str_len, d_quick);
+            } else {
+                d_heap.resize(str_len);
+                d_len = DecodeUtf8(utf8_str, str_len, d_heap.data());
+
+                if (d_len <= STR_SEARCHER_QUICK_SIZE) {
+                    std::copy(d_heap.begin(), d_heap.begin() + d_len, d_quick);
+                    std::vector<utf32>().swap(d_heap);
+                } else {
+                    d_heap.resize(d_len);
+                }
+            }
+
+            Prepare();
+        }
+
+        void EdoStringSearcher::Prepare() {
+            d_forward = Factorize(ForwardView{Needle(), d_len});
+            d_backward = Factorize(BackwardView{Needle(), d_len});
+        }
+
+        size_t EdoStringSearcher::Find(const utf32 *src, size_t len) const {
+            return SearchForward(src, len, Needle(), d_len, &d_forward);
+        }
+
+        size_t EdoStringSearcher::RFind(const utf32 *src, size_t len) const {
+            return SearchBackward(src, len, Needle(), d_len, &d_backward);
+        }
+    } // Namespace Types
+} // Namespace Edo
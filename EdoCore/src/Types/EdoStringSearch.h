@@ -0,0 +1,327 @@
+// =============================================================================
+// EdoStringSearch.h
+// Vectorized search kernels over utf32 data, used by the Find family of the string classes
+// =============================================================================
+
+#ifndef EDOCORE_EDOSTRINGSEARCH_H
+#define EDOCORE_EDOSTRINGSEARCH_H
+
+#include "EdoBase.h"
+#include "EdoUtf.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define STR_NOT_FOUND ((size_t) -1) // Index returned by the search kernels when nothing matched
+#define STR_SET_SMALL_SIZE 8 // Sets with up to this many code points are searched by comparing against each of them
+
+namespace Edo {
+    namespace Types {
+        //////////////////////////////////////////////
+        // Single code point search
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * Return the index of the first occurrence of \a code_point in \a src, with SSE2 / AVX2 kernels selected at
+         * runtime
+         * \param src
+         * utf32 data to be searched
+         * \param len
+         * Number of code points in \a src
+         * \param code_point
+         * Code point to search for
+         * \return
+         * Index of the first match, or STR_NOT_FOUND
+         */
+        EDO_API size_t FindCodePoint(const utf32 *src, size_t len, utf32 code_point);
+
+        /*!
+         * \brief
+         * Return the index of the last occurrence of \a code_point in \a src
+         * \param src
+         * utf32 data to be searched
+         * \param len
+         * Number of code points in \a src
+         * \param code_point
+         * Code point to search for
+         * \return
+         * Index of the last match, or STR_NOT_FOUND
+         */
+        EDO_API size_t RFindCodePoint(const utf32 *src, size_t len, utf32 code_point);
+
+        /*!
+         * \brief
+         * Return the index of the first code point in \a src that is not \a code_point
+         * \return
+         * Index of the first mismatch, or STR_NOT_FOUND if every code point equals \a code_point
+         */
+        EDO_API size_t FindNotCodePoint(const utf32 *src, size_t len, utf32 code_point);
+
+        /*!
+         * \brief
+         * Return the index of the last code point in \a src that is not \a code_point
+         * \return
+         * Index of the last mismatch, or STR_NOT_FOUND if every code point equals \a code_point
+         */
+        EDO_API size_t RFindNotCodePoint(const utf32 *src, size_t len, utf32 code_point);
+
+        //////////////////////////////////////////////
+        // Code point sets
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * Set of code points with constant time membership tests, used by the FindFirstOf / FindLastOf family.
+         *
+         * Code points up to 0xFF live in an inline bitmap, the rest of the BMP in a bitmap that is only allocated once
+         * such a code point is added, and code points above the BMP in a sorted table. Sets of up to
+         * STR_SET_SMALL_SIZE code points are also kept as a plain list, which the search kernels compare against
+         * with vector instructions instead of looking each code point up. Larger sets that lie entirely below 0x100
+         * are looked up eight code points at a time with AVX2 gathers from the inline bitmap.
+         *
+         * Building a set costs a pass over its members, so when the same set is searched for repeatedly it pays to
+         * build it once and use the EdoString overloads that take an EdoCodePointSet.
+         */
+        class EDO_API EdoCodePointSet {
+        public:
+            /*!
+             * \brief
+             * Constructs an empty set
+             */
+            EdoCodePointSet();
+
+            /*!
+             * \brief
+             * Constructs a set holding the given code points
+             * \param code_points
+             * utf32 code points to be added
+             * \param len
+             * Number of code points in \a code_points
+             */
+            EdoCodePointSet(const utf32 *code_points, size_t len);
+
+            /*!
+             * \brief
+             * Constructs a set holding the given chars
+             * \note
+             * The chars are taken to be unencoded data which represent Unicode code points 0x00..0xFF
+             * \param chars
+             * Char array holding the code points to be added
+             * \param chars_len
+             * Number of chars in \a chars
+             */
+            EdoCodePointSet(const char *chars, size_t chars_len);
+
+            /*!
+             * \brief
+             * Constructs a set holding the code points of the given utf8 data
+             * \note
+             * Malformed sequences add UTF_REPLACEMENT_CHAR, the same way the EdoString constructor decodes them
+             * \param utf8_str
+             * utf8 encoded code points to be added
+             * \param str_len
+             * Length of \a utf8_str in code units
+             */
+            EdoCodePointSet(const utf8 *utf8_str, size_t str_len);
+
+            /*!
+             * \brief
+             * Adds a code point to the set
+             */
+            void Insert(utf32 code_point);
+
+            /*!
+             * \brief
+             * Return true if \a code_point is a member of the set
+             */
+            bool Contains(utf32 code_point) const {
+                if (code_point < 0x100)
+                    return (d_latin1[code_point >> 6] >> (code_point & 63)) & 1;
+
+                if (code_point < 0x10000)
+                    return !d_bmp.empty() && ((d_bmp[code_point >> 6] >> (code_point & 63)) & 1);
+
+                return ContainsSupplementary(code_point);
+            }
+
+            /*!
+             * \brief
+             * Return the number of distinct code points in the set
+             */
+            size_t Size() const { return d_count; }
+
+            /*!
+             * \brief
+             * Return true if the set has no members
+             */
+            bool Empty() const { return d_count == 0; }
+
+            /*!
+             * \brief
+             * Return the index of the first code point in \a src that is a member of the set (\a member true) or that
+             * is not (\a member false)
+             * \param src
+             * utf32 data to be searched
+             * \param len
+             * Number of code points in \a src
+             * \param member
+             * Whether to search for members or non-members of the set
+             * \return
+             * Index of the first match, or STR_NOT_FOUND
+             */
+            size_t Find(const utf32 *src, size_t len, bool member = true) const;
+
+            /*!
+             * \brief
+             * Return the index of the last code point in \a src that is a member of the set (\a member true) or that
+             * is not (\a member false)
+             * \return
+             * Index of the last match, or STR_NOT_FOUND
+             */
+            size_t RFind(const utf32 *src, size_t len, bool member = true) const;
+
+        private:
+            bool ContainsSupplementary(utf32 code_point) const;
+
+            utf32 d_small[STR_SET_SMALL_SIZE]; //!< The members, in insertion order, while there are few enough of them
+            size_t d_count; //!< Number of distinct members
+            uint64_t d_latin1[4]; //!< Bitmap of the members up to 0xFF
+            std::vector<uint64_t> d_bmp; //!< Bitmap of the whole BMP, empty until a member above 0xFF is added
+            std::vector<utf32> d_supplementary; //!< Sorted members above the BMP
+        };
+
+        //////////////////////////////////////////////
+        // Substring search
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * Critical factorization of a needle, which the Two-Way search needs (see Crochemore and Perrin, "Two-way
+         * string-matching")
+         */
+        struct EdoTwoWayFactorization {
+            size_t suffix; //!< Start of the right half of the needle
+            size_t period; //!< Period of the right half, or the shift used when the needle is not periodic
+            bool periodic; //!< True if the left half repeats within the right half with the same period
+        };
+
+        /*!
+         * \brief
+         * Return the index of the first occurrence of \a needle in \a src.
+         *
+         * Candidate positions are found with SSE2 / AVX2 compares of the first and last code points of the needle,
+         * and verified one by one. When verification keeps failing (on repetitive text) the search switches to the
+         * Two-Way algorithm, so the worst case stays linear and nothing is allocated
+         * \param src
+         * utf32 data to be searched
+         * \param len
+         * Number of code points in \a src
+         * \param needle
+         * utf32 data to search for
+         * \param needle_len
+         * Number of code points in \a needle
+         * \return
+         * Index of the first match, 0 for an empty needle, or STR_NOT_FOUND
+         */
+        EDO_API size_t FindSubstring(const utf32 *src, size_t len, const utf32 *needle, size_t needle_len);
+
+        /*!
+         * \brief
+         * Return the index of the last occurrence of \a needle in \a src, searched for like FindSubstring() but from
+         * the end
+         * \return
+         * Index of the last match, \a len for an empty needle, or STR_NOT_FOUND
+         */
+        EDO_API size_t RFindSubstring(const utf32 *src, size_t len, const utf32 *needle, size_t needle_len);
+
+#define STR_SEARCHER_QUICK_SIZE 16 // Needles up to this many code points are stored inside EdoStringSearcher
+
+        /*!
+         * \brief
+         * A needle prepared for searching many haystacks. It keeps its own copy of the needle together with the
+         * forward and backward Two-Way factorizations, so searches with it skip that setup.
+         *
+         * Searches only read the searcher, so one searcher can be used from several threads at once.
+         * \example_snippet_start
+         *      EdoStringSearcher searcher("ERROR", 5);
+         *
+         *      for (const EdoString &line : lines)
+         *          if (line.Find(searcher) != EdoString::npos)
+         *              ++errors;
+         * \example_snippet_end
+         */
+        class EDO_API EdoStringSearcher {
+        public:
+            /*!
+             * \brief
+             * Prepares a utf32 needle
+             * \param needle
+             * utf32 data to search for
+             * \param len
+             * Number of code points in \a needle
+             */
+            EdoStringSearcher(const utf32 *needle, size_t len);
+
+            /*!
+             * \brief
+             * Prepares a needle given as chars
+             * \note
+             * The chars are taken to be unencoded data which represent Unicode code points 0x00..0xFF
+             * \param chars
+             * Char array to search for
+             * \param chars_len
+             * Number of chars in \a chars
+             */
+            EdoStringSearcher(const char *chars, size_t chars_len);
+
+            /*!
+             * \brief
+             * Prepares a needle given as utf8 data
+             * \note
+             * Malformed sequences become UTF_REPLACEMENT_CHAR, the same way the EdoString constructor decodes them
+             * \param utf8_str
+             * utf8 data to search for
+             * \param str_len
+             * Length of \a utf8_str in code units
+             */
+            EdoStringSearcher(const utf8 *utf8_str, size_t str_len);
+
+            /*!
+             * \brief
+             * Return the needle as utf32 code points
+             */
+            const utf32 *Needle() const { return d_len <= STR_SEARCHER_QUICK_SIZE ? d_quick : d_heap.data(); }
+
+            /*!
+             * \brief
+             * Return the number of code points in the needle
+             */
+            size_t Length() const { return d_len; }
+
+            /*!
+             * \brief
+             * Return the index of the first occurrence of the needle in \a src
+             * \return
+             * Index of the first match, 0 for an empty needle, or STR_NOT_FOUND
+             */
+            size_t Find(const utf32 *src, size_t len) const;
+
+            /*!
+             * \brief
+             * Return the index of the last occurrence of the needle in \a src
+             * \return
+             * Index of the last match, \a len for an empty needle, or STR_NOT_FOUND
+             */
+            size_t RFind(const utf32 *src, size_t len) const;
+
+        private:
+            void Prepare();
+
+            utf32 d_quick[STR_SEARCHER_QUICK_SIZE]; //!< The needle, when it is short enough
+            std::vector<utf32> d_heap; //!< The needle, when it is not
+            size_t d_len; //!< Number of code points in the needle
+            EdoTwoWayFactorization d_forward; //!< Factorization of the needle
+            EdoTwoWayFactorization d_backward; //!< Factorization of the needle read back to front
+        };
+    } // Namespace Types
+} // Namespace Edo
+
+#endif // EDOCORE_EDOSTRINGSEARCH_H
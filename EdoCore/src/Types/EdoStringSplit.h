@@ -0,0 +1,409 @@
+// =============================================================================
+// EdoStringSplit.h
+// Defines lazy Split / Tokenize ranges which yield the fields of a string as views, without allocating
+// =============================================================================
+
+#ifndef EDOCORE_EDOSTRINGSPLIT_H
+#define EDOCORE_EDOSTRINGSPLIT_H
+
+#include "EdoBase.h"
+#include "EdoStringSearch.h"
+#include "EdoStringView.h"
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#define STR_SPLIT_PROBE_SIZE 8 // Code points checked one by one before a search is handed to the vector kernels
+
+namespace Edo {
+    namespace Types {
+        /*!
+         * \brief
+         * What Split() does with the empty fields found between two adjacent delimiters, or before the first or after
+         * the last one
+         */
+        enum EdoSplitMode {
+            SplitKeepEmpty, //!< Yield them, so "a,,b" gives "a", "" and "b"
+            SplitSkipEmpty //!< Drop them, so "a,,b" gives "a" and "b" and runs of delimiters act as one
+        };
+
+        //////////////////////////////////////////////
+        // Delimiters
+        //////////////////////////////////////////////
+        // Fields are usually short, so the single code point and set delimiters check the first STR_SPLIT_PROBE_SIZE
+        // code points themselves and only then call the vector kernels, whose setup costs more than such a field.
+        // Each delimiter type has the same three members, which is all EdoSplitRange asks of them:
+        //  - Find(src, len) returns the index of the first delimiter in src, or STR_NOT_FOUND
+        //  - Length() returns the number of code points a delimiter found by Find() takes up
+        //  - Skip(src, len) returns the number of code points taken up by the delimiters at the start of src
+
+        //! Fields separated by a single code point
+        class EdoSplitByCodePoint {
+        public:
+            explicit EdoSplitByCodePoint(utf32 code_point) : d_codePoint(code_point) {}
+
+            size_t Find(const utf32 *src, size_t len) const {
+                size_t probe = len < STR_SPLIT_PROBE_SIZE ? len : STR_SPLIT_PROBE_SIZE;
+
+                for (size_t i = 0; i < probe; ++i)
+                    if (src[i] == d_codePoint)
+                        return i;
+
+                size_t pos = FindCodePoint(src + probe, len - probe, d_codePoint);
+                return pos == STR_NOT_FOUND ? pos : probe + pos;
+            }
+
+            size_t Length() const { return 1; }
+
+            size_t Skip(const utf32 *src, size_t len) const {
+                size_t probe = len < STR_SPLIT_PROBE_SIZE ? len : STR_SPLIT_PROBE_SIZE;
+
+                for (size_t i = 0; i < probe; ++i)
+                    if (src[i] != d_codePoint)
+                        return i;
+
+                size_t pos = FindNotCodePoint(src + probe, len - probe, d_codePoint);
+                return pos == STR_NOT_FOUND ? len : probe + pos;
+            }
+
+        private:
+            utf32 d_codePoint; //!< The delimiter
+        };
+
+        //! Fields separated by any member of a code point set
+        class EdoSplitBySet {
+        public:
+            explicit EdoSplitBySet(EdoCodePointSet set) : d_set(std::move(set)) {}
+
+            size_t Find(const utf32 *src, size_t len) const {
+                size_t probe = len < STR_SPLIT_PROBE_SIZE ? len : STR_SPLIT_PROBE_SIZE;
+
+                for (size_t i = 0; i < probe; ++i)
+                    if (d_set.Contains(src[i]))
+                        return i;
+
+                size_t pos = d_set.Find(src + probe, len - probe, true);
+                return pos == STR_NOT_FOUND ? pos : probe + pos;
+            }
+
+            size_t Length() const { return 1; }
+
+            size_t Skip(const utf32 *src, size_t len) const {
+                size_t probe = len < STR_SPLIT_PROBE_SIZE ? len : STR_SPLIT_PROBE_SIZE;
+
+                for (size_t i = 0; i < probe; ++i)
+                    if (!d_set.Contains(src[i]))
+                        return i;
+
+                size_t pos = d_set.Find(src + probe, len - probe, false);
+                return pos == STR_NOT_FOUND ? len : probe + pos;
+            }
+
+        private:
+            EdoCodePointSet d_set; //!< The delimiters
+        };
+
+        //! Fields separated by a sub-string. An empty sub-string never matches, so the whole source is one field
+        class EdoSplitBySubstring {
+        public:
+            explicit EdoSplitBySubstring(EdoStringSearcher searcher) : d_searcher(std::move(searcher)) {}
+
+            size_t Find(const utf32 *src, size_t len) const {
+                return d_searcher.Length() == 0 ? STR_NOT_FOUND : d_searcher.Find(src, len);
+            }
+
+            size_t Length() const { return d_searcher.Length(); }
+
+            size_t Skip(const utf32 *src, size_t len) const {
+                const size_t needleLen = d_searcher.Length();
+                size_t pos = 0;
+
+                if (needleLen == 0)
+                    return 0;
+
+                while (len - pos >= needleLen && memcmp(src + pos, d_searcher.Needle(), needleLen * sizeof(utf32)) == 0)
+                    pos += needleLen;
+
+                return pos;
+            }
+
+        private:
+            EdoStringSearcher d_searcher; //!< The delimiter, prepared once for all the searches of the range
+        };
+
+        //! Fields separated by the code points for which a predicate returns true
+        template<typename Predicate>
+        class EdoSplitByPredicate {
+        public:
+            explicit EdoSplitByPredicate(Predicate predicate) : d_predicate(std::move(predicate)) {}
+
+            size_t Find(const utf32 *src, size_t len) const {
+                for (size_t i = 0; i < len; ++i)
+                    if (d_predicate(src[i]))
+                        return i;
+
+                return STR_NOT_FOUND;
+            }
+
+            size_t Length() const { return 1; }
+
+            size_t Skip(const utf32 *src, size_t len) const {
+                size_t pos = 0;
+
+                while (pos < len && d_predicate(src[pos]))
+                    ++pos;
+
+                return pos;
+            }
+
+        private:
+            Predicate d_predicate; //!< Return true for the code points that separate fields
+        };
+
+        //////////////////////////////////////////////
+        // Split range
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * Lazy range over the fields of a string, as returned by Split() and Tokenize(). Each field is an
+         * EdoStringView into the source, found only when the iterator is advanced to it, so iterating never
+         * allocates whatever the number of fields.
+         *
+         * Without a limit on the number of splits, a source holding n delimiters yields n + 1 fields in
+         * SplitKeepEmpty mode, which makes an empty source yield one empty field. With a limit of \a max_splits,
+         * the field after the last split taken runs to the end of the source, delimiters included. In SplitSkipEmpty
+         * mode the delimiters in front of that last field are dropped and do not count as splits.
+         * \note
+         * The fields are views of the source, which must outlive them just as for any EdoStringView. The range
+         * holds the delimiter, so building it may allocate (a code point set above 0xFF, or a sub-string longer than
+         * STR_SEARCHER_QUICK_SIZE) but iterating it does not.
+         * \example_snippet_start
+         *      for (EdoStringView field : line.Split(',', SplitSkipEmpty))
+         *          Handle(field);
+         * \example_snippet_end
+         */
+        template<typename Delimiter>
+        class EdoSplitRange {
+        public:
+            typedef size_t size_type; //!< Unsigned type used for size values
+
+            /*!
+             * \brief
+             * Forward iterator over the fields of a range. It points into the range, which must outlive it
+             */
+            class Iterator {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef EdoStringView value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const EdoStringView *pointer;
+                typedef const EdoStringView &reference;
+
+                /*!
+                 * \brief
+                 * Constructs the past-the-end iterator
+                 */
+                Iterator() : d_range(nullptr), d_next(nullptr), d_end(nullptr), d_splits(0), d_last(false) {}
+
+                reference operator*() const { return d_field; }
+
+                pointer operator->() const { return &d_field; }
+
+                Iterator &operator++() {
+                    Advance();
+                    return *this;
+                }
+
+                Iterator operator++(int) {
+                    Iterator temp = *this;
+                    Advance();
+                    return temp;
+                }
+
+                bool operator==(const Iterator &iter) const {
+                    return d_range == iter.d_range && d_next == iter.d_next && d_last == iter.d_last &&
+                           d_field.Data() == iter.d_field.Data();
+                }
+
+                bool operator!=(const Iterator &iter) const { return !(*this == iter); }
+
+            private:
+                friend class EdoSplitRange;
+
+                explicit Iterator(const EdoSplitRange *range)
+                        : d_range(range), d_next(range->d_source.Data()),
+                          d_end(range->d_source.Data() + range->d_source.Length()), d_splits(0), d_last(false) {
+                    Advance();
+                }
+
+                // Moves to the next field, or to past-the-end once the source is used up
+                void Advance() {
+                    if (!d_range || d_last) {
+                        *this = Iterator();
+                        return;
+                    }
+
+                    const Delimiter &delimiter = d_range->d_delimiter;
+                    size_t rest = d_end - d_next;
+
+                    if (d_range->d_mode == SplitSkipEmpty) {
+                        size_t skip = delimiter.Skip(d_next, rest);
+
+                        if (skip == rest) {
+                            *this = Iterator();
+                            return;
+                        }
+
+                        d_next += skip;
+                        rest -= skip;
+                    }
+
+                    size_t pos = (d_splits < d_range->d_maxSplits) ? delimiter.Find(d_next, rest) : STR_NOT_FOUND;
+
+                    if (pos == STR_NOT_FOUND) {
+                        // Last field. It is flagged rather than marked by clearing d_next, which is already null for
+                        // a default constructed source, and that source still has its one empty field
+                        d_field = EdoStringView(d_next, rest);
+                        d_next = d_end;
+                        d_last = true;
+                        return;
+                    }
+
+                    d_field = EdoStringView(d_next, pos);
+                    d_next += pos + delimiter.Length();
+                    ++d_splits;
+                }
+
+                const EdoSplitRange *d_range; //!< Range iterated, or nullptr past-the-end
+                const utf32 *d_next; //!< Start of what follows the current field
+                const utf32 *d_end; //!< End of the source
+                size_type d_splits; //!< Number of delimiters found so far
+                bool d_last; //!< Set once the current field is the last one
+                EdoStringView d_field; //!< The current field
+            };
+
+            typedef Iterator const_iterator; //!< Fields cannot be modified through the range
+
+            /*!
+             * \brief
+             * Constructs a range over the fields of \a source
+             * \param source
+             * Code points to be split
+             * \param delimiter
+             * What separates the fields
+             * \param mode
+             * Whether empty fields are kept or skipped
+             * \param max_splits
+             * Maximum number of delimiters to split at, EdoStringView::npos for no limit
+             */
+            EdoSplitRange(EdoStringView source, Delimiter delimiter, EdoSplitMode mode, size_type max_splits)
+                    : d_source(source), d_delimiter(std::move(delimiter)), d_mode(mode), d_maxSplits(max_splits) {}
+
+            Iterator Begin() const { return Iterator(this); }
+
+            Iterator End() const { return Iterator(); }
+
+            // Lower case versions, for range based for loops and the standard algorithms
+            Iterator begin() const { return Begin(); }
+
+            Iterator end() const { return End(); }
+
+            /*!
+             * \brief
+             * Return the number of fields, by iterating over them
+             */
+            size_type Count() const {
+                size_type count = 0;
+
+                for (Iterator iter = Begin(); iter != End(); ++iter)
+                    ++count;
+
+                return count;
+            }
+
+        private:
+            EdoStringView d_source; //!< The code points being split
+            Delimiter d_delimiter; //!< What separates the fields
+            EdoSplitMode d_mode; //!< Whether empty fields are kept or skipped
+            size_type d_maxSplits; //!< Maximum number of delimiters to split at
+        };
+
+        //////////////////////////////////////////////
+        // Split / Tokenize
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * Return a lazy range over the fields of \a source separated by \a delimiter
+         * \param max_splits
+         * Maximum number of delimiters to split at. The last field holds the rest of the source
+         */
+        inline EdoSplitRange<EdoSplitByCodePoint> Split(EdoStringView source, utf32 delimiter,
+                                                        EdoSplitMode mode = SplitKeepEmpty,
+                                                        size_t max_splits = EdoStringView::npos) {
+            return EdoSplitRange<EdoSplitByCodePoint>(source, EdoSplitByCodePoint(delimiter), mode, max_splits);
+        }
+
+        /*!
+         * \brief
+         * Return a lazy range over the fields of \a source separated by any member of \a delimiters
+         * \param max_splits
+         * Maximum number of delimiters to split at. The last field holds the rest of the source
+         */
+        inline EdoSplitRange<EdoSplitBySet> Split(EdoStringView source, EdoCodePointSet delimiters,
+                                                  EdoSplitMode mode = SplitKeepEmpty,
+                                                  size_t max_splits = EdoStringView::npos) {
+            return EdoSplitRange<EdoSplitBySet>(source, EdoSplitBySet(std::move(delimiters)), mode, max_splits);
+        }
+
+        /*!
+         * \brief
+         * Return a lazy range over the fields of \a source separated by the sub-string \a delimiter. An empty
+         * \a delimiter leaves the source whole
+         * \param max_splits
+         * Maximum number of delimiters to split at. The last field holds the rest of the source
+         */
+        inline EdoSplitRange<EdoSplitBySubstring> Split(EdoStringView source, EdoStringView delimiter,
+                                                        EdoSplitMode mode = SplitKeepEmpty,
+                                                        size_t max_splits = EdoStringView::npos) {
+            return EdoSplitRange<EdoSplitBySubstring>(
+                    source, EdoSplitBySubstring(EdoStringSearcher(delimiter.Data(), delimiter.Length())), mode,
+                    max_splits);
+        }
+
+        /*!
+         * \brief
+         * Return a lazy range over the fields of \a source separated by the needle of \a searcher
+         * \param max_splits
+         * Maximum number of delimiters to split at. The last field holds the rest of the source
+         */
+        inline EdoSplitRange<EdoSplitBySubstring> Split(EdoStringView source, EdoStringSearcher searcher,
+                                                        EdoSplitMode mode = SplitKeepEmpty,
+                                                        size_t max_splits = EdoStringView::npos) {
+            return EdoSplitRange<EdoSplitBySubstring>(source, EdoSplitBySubstring(std::move(searcher)), mode,
+                                                      max_splits);
+        }
+
+        /*!
+         * \brief
+         * Return a lazy range over the tokens of \a source: the non-empty runs of code points for which
+         * \a is_separator returns false
+         * \param is_separator
+         * Callable taking a utf32 code point and returning true for the code points that separate tokens
+         * \param max_splits
+         * Maximum number of separator runs to split at. The last token holds the rest of the source
+         * \example_snippet_start
+         *      for (EdoStringView word : Tokenize(text, [](utf32 cp) { return cp == ' ' || cp == '\t'; }))
+         *          ++words;
+         * \example_snippet_end
+         */
+        template<typename Predicate>
+        EdoSplitRange<EdoSplitByPredicate<Predicate>> Tokenize(EdoStringView source, Predicate is_separator,
+                                                               size_t max_splits = EdoStringView::npos) {
+            return EdoSplitRange<EdoSplitByPredicate<Predicate>>(
+                    source, EdoSplitByPredicate<Predicate>(std::move(is_separator)), SplitSkipEmpty, max_splits);
+        }
+    } // Namespace Types
+} // Namespace Edo
+
+#endif // EDOCORE_EDOSTRINGSPLIT_H
@@ -0,0 +1,345 @@
+// =============================================================================
+// EdoStringTable.cpp
+// Implements the string intern table
+// =============================================================================
+
+#include "EdoStringTable.h"
+#include <new>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define STR_TABLE_QUICK_DECODE 64 // utf8 strings up to this many code units are decoded on the stack for lookups
+
+namespace Edo {
+    namespace Types {
+        ///////////////////////////////////////////////
+        // Helpers
+        ///////////////////////////////////////////////
+        static inline size_t HighestBit(uint32_t bits) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanReverse(&index, bits);
+            return index;
+#else
+            return 31 - __builtin_clz(bits);
+#endif
+        }
+
+        // Number of entries in a chunk
+        static inline size_t ChunkSize(size_t chunk) {
+            return (size_t) 1 << (STR_TABLE_CHUNK_BITS + chunk);
+        }
+
+        // Slot value of an id, tagged with the bits of the hash that do not pick the slot
+        static inline uint64_t SlotOf(uint64_t hash, uint32_t id) {
+            return (hash & 0xFFFFFFFF00000000ULL) | ((uint64_t) id + 1);
+        }
+
+        // Calls 'func' with the code points of a utf8 string, decoded on the stack when it is short
+        template<typename F>
+        static auto WithCodePoints(const utf8 *utf8_str, size_t str_len, F func) -> decltype(func(nullptr, 0)) {
+            if (str_len <= STR_TABLE_QUICK_DECODE) {
+                utf32 decoded[STR_TABLE_QUICK_DECODE];
+                size_t len = DecodeUtf8(utf8_str, str_len, decoded);
+                return func(decoded, len);
+            }
+
+            EdoString decoded(utf8_str, str_len);
+            return func(decoded.ptr(), decoded.Length());
+        }
+
+        ///////////////////////////////////////////////
+        // EdoStringId
+        ///////////////////////////////////////////////
+        EdoStringId::EdoStringId(const EdoString &str) : d_value(EdoStringTable::Global().Intern(str).d_value) {
+        }
+
+        EdoStringId::EdoStringId(const utf8 *utf8_str)
+                : d_value(EdoStringTable::Global().Intern(utf8_str, strlen((const char *) utf8_str)).d_value) {
+        }
+
+        const EdoString &EdoStringId::String() const {
+            return EdoStringTable::Global().String(*this);
+        }
+
+        const utf8 *EdoStringId::c_str() const {
+            return EdoStringTable::Global().Utf8(*this);
+        }
+
+        ///////////////////////////////////////////////
+        // EdoStringTable
+        ///////////////////////////////////////////////
+        EdoStringTable::EdoStringTable() : d_count(0), d_textBytes(0) {
+            for (size_t chunk = 0; chunk < STR_TABLE_CHUNK_COUNT; ++chunk)
+                d_chunks[chunk].store(nullptr, std::memory_order_relaxed);
+
+            d_index.store(nullptr, std::memory_order_relaxed);
+            Rehash(STR_TABLE_INITIAL_SLOTS);
+
+            // Id 0 is the empty string, which is what a default constructed EdoStringId stands for
+            InternLocked(nullptr, 0, HashBytes(nullptr, 0));
+        }
+
+        EdoStringTable::~EdoStringTable() {
+            size_t count = d_count.load(std::memory_order_relaxed);
+
+            for (size_t chunk = 0; chunk < STR_TABLE_CHUNK_COUNT; ++chunk) {
+                Entry *entries = d_chunks[chunk].load(std::memory_order_relaxed);
+
+                if (entries == nullptr)
+                    break;
+
+                size_t used = count < ChunkSize(chunk) ? count : ChunkSize(chunk);
+
+                for (size_t i = 0; i < used; ++i) {
+                    delete[] entries[i].encoded;
+                    entries[i].~Entry();
+                }
+
+                ::operator delete(entries);
+                count -= used;
+            }
+
+            d_retired.push_back(d_index.load(std::memory_order_relaxed));
+
+            for (Index *index : d_retired) {
+                delete[] index->slots;
+                delete index;
+            }
+        }
+
+        EdoStringTable &EdoStringTable::Global() {
+            // Never destroyed, so ids and strings can still be resolved by objects destroyed at exit
+            static EdoStringTable *s_global = new EdoStringTable();
+            return *s_global;
+        }
+
+        EdoStringId EdoStringTable::Intern(const EdoString &str) {
+            EdoStringId id;
+
+            if (Find(str, id))
+                return id;
+
+            std::lock_guard<std::mutex> lock(d_mutex);
+            return EdoStringId::FromValue(InternLocked(str.ptr(), str.Length(),
+                                                       HashBytes(str.ptr(), str.Length() * sizeof(utf32))));
+        }
+
+        EdoStringId EdoStringTable::Intern(const utf8 *utf8_str, size_t str_len) {
+            return WithCodePoints(utf8_str, str_len, [this](const utf32 *str, size_t len) {
+                uint64_t hash = HashBytes(str, len * sizeof(utf32));
+                uint32_t id;
+
+                if (FindIn(d_index.load(std::memory_order_acquire), str, len, hash, id))
+                    return EdoStringId::FromValue(id);
+
+                std::lock_guard<std::mutex> lock(d_mutex);
+                return EdoStringId::FromValue(InternLocked(str, len, hash));
+            });
+        }
+
+        void EdoStringTable::InternAll(const EdoString *strs, size_t count, EdoStringId *ids) {
+            std::lock_guard<std::mutex> lock(d_mutex);
+
+            Rehash((d_count.load(std::memory_order_relaxed) + count) * 2);
+
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t id = InternLocked(strs[i].ptr(), strs[i].Length(),
+                                           HashBytes(strs[i].ptr(), strs[i].Length() * sizeof(utf32)));
+
+                if (ids != nullptr)
+                    ids[i] = EdoStringId::FromValue(id);
+            }
+        }
+
+        void EdoStringTable::InternAll(const utf8 *const *utf8_strs, size_t count, EdoStringId *ids) {
+            std::lock_guard<std::mutex> lock(d_mutex);
+
+            Rehash((d_count.load(std::memory_order_relaxed) + count) * 2);
+
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t id = WithCodePoints(utf8_strs[i], strlen((const char *) utf8_strs[i]),
+                                             [this](const utf32 *str, size_t len) {
+                                                 return InternLocked(str, len, HashBytes(str, len * sizeof(utf32)));
+                                             });
+
+                if (ids != nullptr)
+                    ids[i] = EdoStringId::FromValue(id);
+            }
+        }
+
+        bool EdoStringTable::Find(const EdoString &str, EdoStringId &id) const {
+            uint32_t value;
+
+            if (!FindIn(d_index.load(std::memory_order_acquire), str.ptr(), str.Length(),
+                        HashBytes(str.ptr(), str.Length() * sizeof(utf32)), value))
+                return false;
+
+            id = EdoStringId::FromValue(value);
+            return true;
+        }
+
+        bool EdoStringTable::Find(const utf8 *utf8_str, size_t str_len, EdoStringId &id) const {
+            return WithCodePoints(utf8_str, str_len, [this, &id](const utf32 *str, size_t len) {
+                uint32_t value;
+
+                if (!FindIn(d_index.load(std::memory_order_acquire), str, len, HashBytes(str, len * sizeof(utf32)),
+                            value))
+                    return false;
+
+                id = EdoStringId::FromValue(value);
+                return true;
+            });
+        }
+
+        EdoStringTableStats EdoStringTable::Stats() const {
+            std::lock_guard<std::mutex> lock(d_mutex);
+            EdoStringTableStats stats;
+
+            stats.count = d_count.load(std::memory_order_relaxed);
+            stats.textBytes = d_textBytes;
+            stats.entryBytes = 0;
+            stats.indexBytes = 0;
+
+            for (size_t chunk = 0; chunk < STR_TABLE_CHUNK_COUNT; ++chunk)
+                if (d_chunks[chunk].load(std::memory_order_relaxed) != nullptr)
+                    stats.entryBytes += ChunkSize(chunk) * sizeof(Entry);
+
+            const Index *current = d_index.load(std::memory_order_relaxed);
+            stats.indexBytes = sizeof(Index) + (current->mask + 1) * sizeof(uint64_t);
+
+            for (const Index *index : d_retired)
+                stats.indexBytes += sizeof(Index) + (index->mask + 1) * sizeof(uint64_t);
+
+            return stats;
+        }
+
+        void EdoStringTable::Locate(uint32_t id, size_t &chunk, size_t &offset) {
+            // Chunk c starts at entry (2^c - 1) * 2^STR_TABLE_CHUNK_BITS
+            chunk = HighestBit((id >> STR_TABLE_CHUNK_BITS) + 1);
+            offset = id - ((((size_t) 1 << chunk) - 1) << STR_TABLE_CHUNK_BITS);
+        }
+
+        bool EdoStringTable::FindIn(const Index *index, const utf32 *str, size_t len, uint64_t hash,
+                                    uint32_t &id) const {
+            const uint64_t tag = hash & 0xFFFFFFFF00000000ULL;
+
+            // The index is never more than half full, so the probe always ends on an empty slot
+            for (size_t pos = (size_t) hash & index->mask;; pos = (pos + 1) & index->mask) {
+                uint64_t slot = index->slots[pos].load(std::memory_order_acquire);
+
+                if (slot == 0)
+                    return false;
+
+                if ((slot & 0xFFFFFFFF00000000ULL) != tag)
+                    continue;
+
+                const EdoString &text = EntryOf((uint32_t) slot - 1).text;
+
+                if (text.Length() == len && memcmp(text.ptr(), str, len * sizeof(utf32)) == 0) {
+                    id = (uint32_t) slot - 1;
+                    return true;
+                }
+            }
+        }
+
+        uint32_t EdoStringTable::InternLocked(const utf32 *str, size_t len, uint64_t hash) {
+            uint32_t id = d_count.load(std::memory_order_relaxed);
+
+            // Another thread may have added the string since our lock free lookup
+            if (id != 0 && FindIn(d_index.load(std::memory_order_relaxed), str, len, hash, id))
+                return id;
+
+            if (id == 0xFFFFFFFFU)
+                throw std::length_error("Too many strings in the EdoStringTable");
+
+            Index *index = d_index.load(std::memory_order_relaxed);
+
+            if ((size_t) (id + 1) * 2 > index->mask + 1) {
+                Rehash((index->mask + 1) * 2);
+                index = d_index.load(std::memory_order_relaxed);
+            }
+
+            size_t chunk, offset;
+            Locate(id, chunk, offset);
+
+            Entry *entries = d_chunks[chunk].load(std::memory_order_relaxed);
+
+            if (entries == nullptr) {
+                entries = static_cast<Entry *>(::operator new(ChunkSize(chunk) * sizeof(Entry)));
+                d_chunks[chunk].store(entries, std::memory_order_release);
+            }
+
+            // The copies must outlive any allocator the calling thread may be using
+            EdoStringAllocatorScope scope(EdoStringAllocator::GetDefault());
+
+            Entry *entry = new(&entries[offset]) Entry();
+            entry->hash = hash;
+            entry->encodedLength = Utf8LengthOf(str, len);
+            entry->encoded = new utf8[entry->encodedLength + 1];
+            entry->encoded[EncodeUtf8(str, len, entry->encoded, entry->encodedLength)] = 0;
+
+            try {
+                entry->text.Resize(len);
+            } catch (...) {
+                delete[] entry->encoded;
+                entry->~Entry();
+                throw;
+            }
+
+            if (len != 0)
+                memcpy(entry->text.ptr(), str, len * sizeof(utf32));
+
+            d_textBytes += entry->encodedLength + 1;
+
+            if (len >= STR_QUICKBUFF_SIZE)
+                d_textBytes += (entry->text.Capacity() + 1) * sizeof(utf32);
+
+            // Publish the entry before the slot pointing to it
+            d_count.store(id + 1, std::memory_order_release);
+
+            size_t pos = (size_t) hash & index->mask;
+
+            while (index->slots[pos].load(std::memory_order_relaxed) != 0)
+                pos = (pos + 1) & index->mask;
+
+            index->slots[pos].store(SlotOf(hash, id), std::memory_order_release);
+
+            return id;
+        }
+
+        void EdoStringTable::Rehash(size_t slots) {
+            Index *current = d_index.load(std::memory_order_relaxed);
+            size_t size = STR_TABLE_INITIAL_SLOTS;
+
+            while (size < slots)
+                size *= 2;
+
+            if (current != nullptr && size <= current->mask + 1)
+                return;
+
+            Index *index = new Index;
+            index->mask = size - 1;
+            index->slots = new std::atomic<uint64_t>[size]();
+
+            uint32_t count = d_count.load(std::memory_order_relaxed);
+
+            for (uint32_t id = 0; id < count; ++id) {
+                uint64_t hash = EntryOf(id).hash;
+                size_t pos = (size_t) hash & index->mask;
+
+                while (index->slots[pos].load(std::memory_order_relaxed) != 0)
+                    pos = (pos + 1) & index->mask;
+
+                index->slots[pos].store(SlotOf(hash, id), std::memory_order_relaxed);
+            }
+
+            d_index.store(index, std::memory_order_release);
+
+            if (current != nullptr)
+                d_retired.push_back(current);
+        }
+    } // Namespace Types
+} // Namespace Edo
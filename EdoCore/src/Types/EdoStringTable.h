@@ -0,0 +1,313 @@
+// =============================================================================
+// EdoStringTable.h
+// Defines the string intern table and the compact ids it hands out for engine identifiers
+// =============================================================================
+
+#ifndef EDOCORE_EDOSTRINGTABLE_H
+#define EDOCORE_EDOSTRINGTABLE_H
+
+#include "EdoString.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#define STR_TABLE_CHUNK_BITS 10 // The first entry chunk holds 2^STR_TABLE_CHUNK_BITS entries, each next one twice as many
+#define STR_TABLE_CHUNK_COUNT 23 // Enough chunks for every 32 bit id
+#define STR_TABLE_INITIAL_SLOTS 1024 // Slots in the hash index of a new table, kept at most half full
+
+namespace Edo {
+    namespace Types {
+        class EdoStringTable;
+
+        /*!
+         * \brief
+         * Compact handle of a string interned in the global EdoStringTable. Two ids are equal exactly when their
+         * strings are, so names that are compared over and over (asset names, log types, config keys) can be compared
+         * in a single instruction instead of code point by code point.
+         *
+         * The default constructed id stands for the empty string. Ids are only meaningful within the process that
+         * handed them out, and their order is the order in which the strings were interned, not alphabetical.
+         * \example_snippet_start
+         *      static const EdoStringId s_warn(TEXT("Warn"));
+         *
+         *      if (EdoStringId(type) == s_warn)
+         *          ++warnings;
+         * \example_snippet_end
+         */
+        class EDO_API EdoStringId {
+        public:
+            /*!
+             * \brief
+             * Constructs the id of the empty string
+             */
+            EdoStringId() : d_value(0) {}
+
+            /*!
+             * \brief
+             * Interns \a str in the global table and constructs its id
+             * @param str
+             * EdoString object to be interned
+             */
+            explicit EdoStringId(const EdoString &str);
+
+            /*!
+             * \brief
+             * Interns the null terminated utf8 string \a utf8_str in the global table and constructs its id
+             * @param utf8_str
+             * Pointer to a buffer containing a null-terminated Unicode string encoded as utf8 data
+             */
+            explicit EdoStringId(const utf8 *utf8_str);
+
+            /*!
+             * \brief
+             * Constructs an id from a value returned by Value(), e.g. one stored in a file written by the same process
+             */
+            static EdoStringId FromValue(uint32_t value) {
+                EdoStringId id;
+                id.d_value = value;
+                return id;
+            }
+
+            /*!
+             * \brief
+             * Return the numeric value of the id
+             */
+            uint32_t Value() const { return d_value; }
+
+            /*!
+             * \brief
+             * Return true if this is the id of the empty string
+             */
+            bool Empty() const { return d_value == 0; }
+
+            /*!
+             * \brief
+             * Return the interned string, as stored in the global table. The reference stays valid for the lifetime
+             * of the table
+             */
+            const EdoString &String() const;
+
+            /*!
+             * \brief
+             * Return the interned string encoded as null terminated utf8 data. Unlike EdoString::c_str() this does not
+             * encode anything, the table keeps the utf8 form next to the EdoString
+             */
+            const utf8 *c_str() const;
+
+            bool operator==(const EdoStringId &id) const { return d_value == id.d_value; }
+
+            bool operator!=(const EdoStringId &id) const { return d_value != id.d_value; }
+
+            bool operator<(const EdoStringId &id) const { return d_value < id.d_value; }
+
+            bool operator>(const EdoStringId &id) const { return d_value > id.d_value; }
+
+            bool operator<=(const EdoStringId &id) const { return d_value <= id.d_value; }
+
+            bool operator>=(const EdoStringId &id) const { return d_value >= id.d_value; }
+
+        private:
+            uint32_t d_value; //!< Index of the string in its table
+        };
+
+        /*!
+         * \brief
+         * Memory used by an EdoStringTable, in bytes
+         */
+        struct EdoStringTableStats {
+            size_t count; //!< Number of interned strings, including the empty string
+            size_t textBytes; //!< Heap memory of the utf32 and utf8 copies of the strings
+            size_t entryBytes; //!< Memory of the entry chunks, including entries not used yet
+            size_t indexBytes; //!< Memory of the hash index, including the outgrown ones kept for concurrent readers
+
+            /*!
+             * \brief
+             * Return the sum of all the above
+             */
+            size_t TotalBytes() const { return textBytes + entryBytes + indexBytes; }
+        };
+
+        /*!
+         * \brief
+         * Thread-safe table mapping strings to EdoStringId values.
+         *
+         * Lookups of strings that are already interned take no lock: the hash index is an open addressed array of
+         * atomic slots, which writers fill while holding a mutex. When the index outgrows half its size it is rebuilt
+         * at twice the size, and the old one is kept until the table is destroyed so readers still walking it never
+         * touch freed memory. Entries live in chunks that are never moved, so turning an id back into its string is
+         * an array access and the returned references stay valid.
+         *
+         * Strings are never removed. Their copies are allocated from EdoStringAllocator::GetDefault(), whatever the
+         * allocator of the calling thread is.
+         */
+        class EDO_API EdoStringTable {
+        public:
+            /*!
+             * \brief
+             * Constructs a table holding only the empty string, with id 0
+             */
+            EdoStringTable();
+
+            ~EdoStringTable();
+
+            EdoStringTable(const EdoStringTable &) = delete;
+
+            EdoStringTable &operator=(const EdoStringTable &) = delete;
+
+            /*!
+             * \brief
+             * Return the table used by EdoStringId
+             */
+            static EdoStringTable &Global();
+
+            /*!
+             * \brief
+             * Return the id of \a str, adding it to the table if needed
+             * \exception std::length_error
+             * Thrown if the table already holds 2^32 - 1 strings
+             */
+            EdoStringId Intern(const EdoString &str);
+
+            /*!
+             * \brief
+             * Return the id of the given utf8 string, adding it to the table if needed
+             * \note
+             * Malformed sequences become UTF_REPLACEMENT_CHAR, the same way the EdoString constructor decodes them
+             * @param utf8_str
+             * utf8 data to be interned
+             * @param str_len
+             * Length of \a utf8_str in code units
+             */
+            EdoStringId Intern(const utf8 *utf8_str, size_t str_len);
+
+            /*!
+             * \brief
+             * Interns many strings under a single lock, e.g. the names known at startup. This costs less than interning
+             * them one by one and leaves the index sized for all of them
+             * @param strs
+             * Array of \a count EdoString objects to be interned
+             * @param count
+             * Number of strings in \a strs
+             * @param ids
+             * If not null, array receiving the \a count ids
+             */
+            void InternAll(const EdoString *strs, size_t count, EdoStringId *ids = nullptr);
+
+            /*!
+             * \brief
+             * Interns many null terminated utf8 strings under a single lock
+             * @param utf8_strs
+             * Array of \a count pointers to null terminated utf8 data
+             * @param count
+             * Number of strings in \a utf8_strs
+             * @param ids
+             * If not null, array receiving the \a count ids
+             */
+            void InternAll(const utf8 *const *utf8_strs, size_t count, EdoStringId *ids = nullptr);
+
+            /*!
+             * \brief
+             * Look \a str up without adding it. Takes no lock
+             * @param str
+             * EdoString object to search for
+             * @param id
+             * Receives the id of \a str when it is found
+             * @return
+             * true if \a str is interned
+             */
+            bool Find(const EdoString &str, EdoStringId &id) const;
+
+            /*!
+             * \brief
+             * Look the given utf8 string up without adding it. Takes no lock
+             * @return
+             * true if the string is interned
+             */
+            bool Find(const utf8 *utf8_str, size_t str_len, EdoStringId &id) const;
+
+            /*!
+             * \brief
+             * Return the string of an id handed out by this table
+             */
+            const EdoString &String(EdoStringId id) const { return EntryOf(id.Value()).text; }
+
+            /*!
+             * \brief
+             * Return the string of an id handed out by this table, as null terminated utf8 data
+             */
+            const utf8 *Utf8(EdoStringId id) const { return EntryOf(id.Value()).encoded; }
+
+            /*!
+             * \brief
+             * Return the length in utf8 code units of the string of an id handed out by this table
+             */
+            size_t Utf8Length(EdoStringId id) const { return EntryOf(id.Value()).encodedLength; }
+
+            /*!
+             * \brief
+             * Return the number of interned strings, including the empty string
+             */
+            size_t Size() const { return d_count.load(std::memory_order_acquire); }
+
+            /*!
+             * \brief
+             * Return the memory used by the table
+             */
+            EdoStringTableStats Stats() const;
+
+        private:
+            //! An interned string
+            struct Entry {
+                EdoString text; //!< The string
+                utf8 *encoded; //!< The string encoded as null terminated utf8
+                size_t encodedLength; //!< Length of encoded, in code units
+                uint64_t hash; //!< HashBytes() of the code points
+            };
+
+            //! Open addressed hash index. A slot holds the high half of the hash and the id + 1, or 0 when empty
+            struct Index {
+                size_t mask; //!< Number of slots - 1
+                std::atomic<uint64_t> *slots; //!< The slots
+            };
+
+            // Return the entry of an id handed out by this table
+            const Entry &EntryOf(uint32_t id) const {
+                size_t chunk, offset;
+                Locate(id, chunk, offset);
+                return d_chunks[chunk].load(std::memory_order_acquire)[offset];
+            }
+
+            // Return the chunk holding an id, and its position in the chunk
+            static void Locate(uint32_t id, size_t &chunk, size_t &offset);
+
+            // Lock free lookup of a string given as code points
+            bool FindIn(const Index *index, const utf32 *str, size_t len, uint64_t hash, uint32_t &id) const;
+
+            // Find or add a string, with the mutex held
+            uint32_t InternLocked(const utf32 *str, size_t len, uint64_t hash);
+
+            // Replace the index with one of at least 'slots' slots, with the mutex held
+            void Rehash(size_t slots);
+
+            std::atomic<Index *> d_index; //!< The current hash index
+            std::atomic<Entry *> d_chunks[STR_TABLE_CHUNK_COUNT]; //!< Entry chunks, allocated as the table grows
+            std::atomic<uint32_t> d_count; //!< Number of entries in use
+            mutable std::mutex d_mutex; //!< Held by writers
+            std::vector<Index *> d_retired; //!< Outgrown indices, kept for readers that may still be walking them
+            size_t d_textBytes; //!< Heap memory of the string copies
+        };
+    } // Namespace Types
+} // Namespace Edo
+
+namespace std {
+    //! Lets EdoStringId be used as key of the unordered containers without naming a hasher
+    template<>
+    struct hash<Edo::Types::EdoStringId> {
+        size_t operator()(const Edo::Types::EdoStringId &id) const {
+            return std::hash<uint32_t>()(id.Value());
+        }
+    };
+} // Namespace std
+
+#endif // EDOCORE_EDOSTRINGTABLE_H
@@ -0,0 +1,515 @@
+// =============================================================================
+// EdoStringView.h
+// Defines a non-owning view over utf32 data, to slice and search strings without allocating
+// =============================================================================
+
+#ifndef EDOCORE_EDOSTRINGVIEW_H
+#define EDOCORE_EDOSTRINGVIEW_H
+
+#include "EdoBase.h"
+#include "EdoHash.h"
+#include "EdoStringSearch.h"
+#include "EdoUtf.h"
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+
+namespace Edo {
+    namespace Types {
+        class EdoString;
+
+        /*!
+         * \brief
+         * Read-only view of a range of utf32 code points, holding only a pointer and a length. Taking a Substr() of a
+         * view, searching it or comparing it never allocates, which makes it the type of choice for tokenizing and
+         * parsing. An EdoString converts to a view of its whole data, and EdoString::View() returns a view of a part
+         * of it.
+         *
+         * Indices, lengths and the results of the Find family follow EdoString.
+         * \note
+         * A view does not own its data. It is invalidated by anything that invalidates pointers into the viewed
+         * EdoString (modifying it, or destroying it), so views of temporaries must not outlive the expression
+         * \example_snippet_start
+         *      EdoStringView rest = line;
+         *
+         *      for (size_t pos = rest.Find(','); pos != EdoStringView::npos; pos = rest.Find(',')) {
+         *          fields.push_back(rest.Substr(0, pos)); // No allocation
+         *          rest.RemovePrefix(pos + 1);
+         *      }
+         * \example_snippet_end
+         */
+        class EDO_API EdoStringView {
+        public:
+            /***************************************
+             * Integral types
+             ***************************************/
+            typedef utf32 value_type; //!< Basic 'code point' type (utf32)
+            typedef size_t size_type; //!< Unsigned type used for size values and indices
+            typedef std::ptrdiff_t difference_type; //!< Signed type used for differences
+            typedef const utf32 &const_reference; //!< Type used for constant utf32 code point references
+            typedef const utf32 *const_pointer; //!< Type used for constant utf32 code point pointers
+            typedef const utf32 *const_iterator; //!< Iterators of a view are plain pointers
+            typedef std::reverse_iterator<const_iterator> const_reverse_iterator; //!< Reverse iterator of a view
+
+            static const size_type npos = (size_type) -1; //!< Value used to represent 'not found' conditions and 'all code points' etc.
+
+            //////////////////////////////////////////////
+            // Construction
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Constructs an empty view
+             */
+            EdoStringView() : d_data(nullptr), d_length(0) {}
+
+            /*!
+             * \brief
+             * Constructs a view of \a len code points starting at \a data
+             */
+            EdoStringView(const utf32 *data, size_type len) : d_data(data), d_length(len) {}
+
+            /*!
+             * \brief
+             * Constructs a view of the null terminated utf32 data \a data
+             */
+            explicit EdoStringView(const utf32 *data) : d_data(data), d_length(0) {
+                while (data[d_length] != 0)
+                    ++d_length;
+            }
+
+            /*!
+             * \brief
+             * Copies the viewed code points into a new EdoString
+             */
+            inline EdoString ToString() const;
+
+            //////////////////////////////////////////////
+            // Size operations
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Return the number of code points in the view
+             */
+            size_type Size() const { return d_length; }
+
+            /*!
+             * \brief
+             * Return the number of code points in the view
+             */
+            size_type Length() const { return d_length; }
+
+            /*!
+             * \brief
+             * Return true if the view has no code points
+             */
+            bool Empty() const { return d_length == 0; }
+
+            //////////////////////////////////////////////
+            // Character access
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Return the code point at the given index. The index is not checked
+             */
+            value_type operator[](size_type idx) const { return d_data[idx]; }
+
+            /*!
+             * \brief
+             * Return the code point at the given index
+             * \exception
+             * std::out_of_range Thrown if \a idx is >= Length()
+             */
+            value_type At(size_type idx) const {
+                if (d_length <= idx)
+                    throw std::out_of_range("Index is out of range for EdoStringView");
+
+                return d_data[idx];
+            }
+
+            /*!
+             * \brief
+             * Return the first code point. The view must not be empty
+             */
+            value_type Front() const { return d_data[0]; }
+
+            /*!
+             * \brief
+             * Return the last code point. The view must not be empty
+             */
+            value_type Back() const { return d_data[d_length - 1]; }
+
+            /*!
+             * \brief
+             * Return a pointer to the viewed code points. They are not null terminated
+             */
+            const utf32 *Data() const { return d_data; }
+
+            //////////////////////////////////////////////
+            // Iterators
+            //////////////////////////////////////////////
+            const_iterator Begin() const { return d_data; }
+
+            const_iterator End() const { return d_data + d_length; }
+
+            const_reverse_iterator RBegin() const { return const_reverse_iterator(End()); }
+
+            const_reverse_iterator REnd() const { return const_reverse_iterator(Begin()); }
+
+            // Lower case versions, for range based for loops and the standard algorithms
+            const_iterator begin() const { return Begin(); }
+
+            const_iterator end() const { return End(); }
+
+            //////////////////////////////////////////////
+            // Slicing
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Return a view of a part of this view
+             * \param idx
+             * Index of the first code point of the sub-view
+             * \param len
+             * Maximum number of code points in the sub-view
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this view
+             */
+            EdoStringView Substr(size_type idx = 0, size_type len = npos) const {
+                if (d_length < idx)
+                    throw std::out_of_range("Index is out of range for EdoStringView");
+
+                if (len > d_length - idx)
+                    len = d_length - idx;
+
+                return EdoStringView(d_data + idx, len);
+            }
+
+            /*!
+             * \brief
+             * Drop the first \a num code points from the view (all of them if \a num is larger than Length())
+             */
+            void RemovePrefix(size_type num) {
+                if (num > d_length)
+                    num = d_length;
+
+                d_data += num;
+                d_length -= num;
+            }
+
+            /*!
+             * \brief
+             * Drop the last \a num code points from the view (all of them if \a num is larger than Length())
+             */
+            void RemoveSuffix(size_type num) {
+                d_length -= (num > d_length) ? d_length : num;
+            }
+
+            //////////////////////////////////////////////
+            // Comparisons
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Compares this view with \a view, code point by code point
+             * @return
+             * - 0 if the views are equal
+             * - <0 if this view is lexicographically smaller than \a view
+             * - >0 if this view is lexicographically greater than \a view
+             */
+            int Compare(EdoStringView view) const {
+                size_type len = d_length < view.d_length ? d_length : view.d_length;
+
+                for (size_type i = 0; i < len; ++i)
+                    if (d_data[i] != view.d_data[i])
+                        return d_data[i] < view.d_data[i] ? -1 : 1;
+
+                return (d_length < view.d_length) ? -1 : (d_length == view.d_length) ? 0 : 1;
+            }
+
+            /*!
+             * \brief
+             * Compares a part of this view with a part of \a view
+             * \exception
+             * std::out_of_range Thrown if \a idx or \a view_idx is invalid
+             */
+            int Compare(size_type idx, size_type len, EdoStringView view, size_type view_idx = 0,
+                        size_type view_len = npos) const {
+                return Substr(idx, len).Compare(view.Substr(view_idx, view_len));
+            }
+
+            /*!
+             * \brief
+             * Return true if the view begins with \a view
+             */
+            bool StartsWith(EdoStringView view) const {
+                return view.d_length <= d_length && Equal(d_data, view.d_data, view.d_length);
+            }
+
+            /*!
+             * \brief
+             * Return true if the view ends with \a view
+             */
+            bool EndsWith(EdoStringView view) const {
+                return view.d_length <= d_length && Equal(d_data + d_length - view.d_length, view.d_data, view.d_length);
+            }
+
+            //////////////////////////////////////////////
+            // Searching
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Search forwards for a code point
+             * \return
+             * Index of the first occurrence of \a code_point at or after \a idx, or npos
+             */
+            size_type Find(utf32 code_point, size_type idx = 0) const {
+                if (idx >= d_length)
+                    return npos;
+
+                size_type pos = FindCodePoint(d_data + idx, d_length - idx, code_point);
+                return pos == STR_NOT_FOUND ? npos : idx + pos;
+            }
+
+            /*!
+             * \brief
+             * Search backwards for a code point
+             * \return
+             * Index of the last occurrence of \a code_point at or before \a idx, or npos
+             */
+            size_type RFind(utf32 code_point, size_type idx = npos) const {
+                if (d_length == 0)
+                    return npos;
+
+                if (idx >= d_length)
+                    idx = d_length - 1;
+
+                size_type pos = RFindCodePoint(d_data, idx + 1, code_point);
+                return pos == STR_NOT_FOUND ? npos : pos;
+            }
+
+            /*!
+             * \brief
+             * Search forwards for a sub-string
+             * \return
+             * Index of the first occurrence of \a view at or after \a idx, or npos
+             */
+            size_type Find(EdoStringView view, size_type idx = 0) const {
+                if (idx >= d_length)
+                    return npos;
+
+                if (view.d_length == 0)
+                    return idx;
+
+                size_type pos = FindSubstring(d_data + idx, d_length - idx, view.d_data, view.d_length);
+                return pos == STR_NOT_FOUND ? npos : idx + pos;
+            }
+
+            /*!
+             * \brief
+             * Search forwards for the needle of \a searcher
+             * \return
+             * Index of the first occurrence of the needle at or after \a idx, or npos
+             */
+            size_type Find(const EdoStringSearcher &searcher, size_type idx = 0) const {
+                if (idx >= d_length)
+                    return npos;
+
+                size_type pos = searcher.Find(d_data + idx, d_length - idx);
+                return pos == STR_NOT_FOUND ? npos : idx + pos;
+            }
+
+            /*!
+             * \brief
+             * Search backwards for a sub-string
+             * \return
+             * Index of the last occurrence of \a view starting at or before \a idx, or npos
+             */
+            size_type RFind(EdoStringView view, size_type idx = npos) const {
+                if (view.d_length == 0)
+                    return (idx < d_length) ? idx : d_length;
+
+                if (view.d_length > d_length)
+                    return npos;
+
+                if (idx > d_length - view.d_length)
+                    idx = d_length - view.d_length;
+
+                size_type pos = RFindSubstring(d_data, idx + view.d_length, view.d_data, view.d_length);
+                return pos == STR_NOT_FOUND ? npos : pos;
+            }
+
+            /*!
+             * \brief
+             * Search backwards for the needle of \a searcher
+             * \return
+             * Index of the last occurrence of the needle starting at or before \a idx, or npos
+             */
+            size_type RFind(const EdoStringSearcher &searcher, size_type idx = npos) const {
+                size_type len = searcher.Length();
+
+                if (len == 0)
+                    return (idx < d_length) ? idx : d_length;
+
+                if (len > d_length)
+                    return npos;
+
+                if (idx > d_length - len)
+                    idx = d_length - len;
+
+                size_type pos = searcher.RFind(d_data, idx + len);
+                return pos == STR_NOT_FOUND ? npos : pos;
+            }
+
+            /*!
+             * \brief
+             * Return true if the view contains \a view
+             */
+            bool Contains(EdoStringView view) const { return Find(view) != npos; }
+
+            /*!
+             * \brief
+             * Find the first code point at or after \a idx that is one of the code points of \a view
+             */
+            size_type FindFirstOf(EdoStringView view, size_type idx = 0) const {
+                return FindFirstOf(EdoCodePointSet(view.d_data, view.d_length), idx);
+            }
+
+            /*!
+             * \brief
+             * Find the first code point at or after \a idx that is a member of \a set
+             */
+            size_type FindFirstOf(const EdoCodePointSet &set, size_type idx = 0) const {
+                return FindInSet(set, idx, true);
+            }
+
+            /*!
+             * \brief
+             * Find the first code point at or after \a idx that is not one of the code points of \a view
+             */
+            size_type FindFirstNotOf(EdoStringView view, size_type idx = 0) const {
+                return FindFirstNotOf(EdoCodePointSet(view.d_data, view.d_length), idx);
+            }
+
+            /*!
+             * \brief
+             * Find the first code point at or after \a idx that is not a member of \a set
+             */
+            size_type FindFirstNotOf(const EdoCodePointSet &set, size_type idx = 0) const {
+                return FindInSet(set, idx, false);
+            }
+
+            /*!
+             * \brief
+             * Find the last code point at or before \a idx that is one of the code points of \a view
+             */
+            size_type FindLastOf(EdoStringView view, size_type idx = npos) const {
+                return FindLastOf(EdoCodePointSet(view.d_data, view.d_length), idx);
+            }
+
+            /*!
+             * \brief
+             * Find the last code point at or before \a idx that is a member of \a set
+             */
+            size_type FindLastOf(const EdoCodePointSet &set, size_type idx = npos) const {
+                return RFindInSet(set, idx, true);
+            }
+
+            /*!
+             * \brief
+             * Find the last code point at or before \a idx that is not one of the code points of \a view
+             */
+            size_type FindLastNotOf(EdoStringView view, size_type idx = npos) const {
+                return FindLastNotOf(EdoCodePointSet(view.d_data, view.d_length), idx);
+            }
+
+            /*!
+             * \brief
+             * Find the last code point at or before \a idx that is not a member of \a set
+             */
+            size_type FindLastNotOf(const EdoCodePointSet &set, size_type idx = npos) const {
+                return RFindInSet(set, idx, false);
+            }
+
+            //////////////////////////////////////////////
+            // Hashing and encoding
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Return a hash of the viewed code points. It equals EdoString::Hash() of a string holding them
+             */
+            size_type Hash() const { return (size_type) HashBytes(d_data, d_length * sizeof(utf32)); }
+
+            /*!
+             * \brief
+             * Return the number of utf8 code units needed to encode the view
+             */
+            size_type Utf8Length() const { return Utf8LengthOf(d_data, d_length); }
+
+            /*!
+             * \brief
+             * Encodes the view as utf8 into \a dest, which must hold at least Utf8Length() code units. No null
+             * terminator is written
+             * \return
+             * Number of code units written
+             */
+            size_type EncodeTo(utf8 *dest, size_type dest_len) const { return EncodeUtf8(d_data, d_length, dest, dest_len); }
+
+        private:
+            static bool Equal(const utf32 *a, const utf32 *b, size_type len) {
+                return len == 0 || memcmp(a, b, len * sizeof(utf32)) == 0;
+            }
+
+            size_type FindInSet(const EdoCodePointSet &set, size_type idx, bool member) const {
+                if (idx >= d_length)
+                    return npos;
+
+                size_type pos = set.Find(d_data + idx, d_length - idx, member);
+                return pos == STR_NOT_FOUND ? npos : idx + pos;
+            }
+
+            size_type RFindInSet(const EdoCodePointSet &set, size_type idx, bool member) const {
+                if (d_length == 0)
+                    return npos;
+
+                if (idx >= d_length)
+                    idx = d_length - 1;
+
+                size_type pos = set.RFind(d_data, idx + 1, member);
+                return pos == STR_NOT_FOUND ? npos : pos;
+            }
+
+            const utf32 *d_data; //!< First viewed code point
+            size_type d_length; //!< Number of viewed code points
+        };
+
+        //////////////////////////////////////////////
+        // Comparison operators
+        //////////////////////////////////////////////
+        inline bool operator==(EdoStringView view1, EdoStringView view2) {
+            return view1.Length() == view2.Length() &&
+                   (view1.Empty() || memcmp(view1.Data(), view2.Data(), view1.Length() * sizeof(utf32)) == 0);
+        }
+
+        inline bool operator!=(EdoStringView view1, EdoStringView view2) { return !(view1 == view2); }
+
+        inline bool operator<(EdoStringView view1, EdoStringView view2) { return view1.Compare(view2) < 0; }
+
+        inline bool operator>(EdoStringView view1, EdoStringView view2) { return view1.Compare(view2) > 0; }
+
+        inline bool operator<=(EdoStringView view1, EdoStringView view2) { return view1.Compare(view2) <= 0; }
+
+        inline bool operator>=(EdoStringView view1, EdoStringView view2) { return view1.Compare(view2) >= 0; }
+    } // Namespace Types
+} // Namespace Edo
+
+namespace std {
+    //! Hashes views the same way std::hash<EdoString> hashes strings
+    template<>
+    struct hash<Edo::Types::EdoStringView> {
+        size_t operator()(const Edo::Types::EdoStringView &view) const {
+            return view.Hash();
+        }
+    };
+} // Namespace std
+
+#endif // EDOCORE_EDOSTRINGVIEW_H
@@ -0,0 +1,1588 @@
+// =============================================================================
+// EdoUtf.cpp
+// Implements the scalar and vectorized Unicode transcoding kernels
+// =============================================================================
+
+#include "EdoUtf.h"
+#include "../Utils/EdoCpu.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#ifdef EDO_X86
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace Edo::Utils;
+
+namespace Edo {
+    namespace Types {
+        ///////////////////////////////////////////////
+        // Scalar helpers
+        ///////////////////////////////////////////////
+        // Number of utf8 code units used for the given code point
+        static inline size_t Utf8SequenceSize(utf32 cp) {
+            return (cp < 0x80) ? 1 : (cp < 0x0800) ? 2 : (cp < 0x10000) ? 3 : 4;
+        }
+
+        // Encode a single code point, 'dest' must have room for it. Returns the number of code units written
+        static inline size_t EncodeUtf8One(utf32 cp, utf8 *dest) {
+            if (cp < 0x80) {
+                dest[0] = (utf8) cp;
+                return 1;
+            } else if (cp < 0x0800) {
+                dest[0] = (utf8) ((cp >> 6) | 0xC0);
+                dest[1] = (utf8) ((cp & 0x3F) | 0x80);
+                return 2;
+            } else if (cp < 0x10000) {
+                dest[0] = (utf8) ((cp >> 12) | 0xE0);
+                dest[1] = (utf8) (((cp >> 6) & 0x3F) | 0x80);
+                dest[2] = (utf8) ((cp & 0x3F) | 0x80);
+                return 3;
+            } else {
+                dest[0] = (utf8) ((cp >> 18) | 0xF0);
+                dest[1] = (utf8) (((cp >> 12) & 0x3F) | 0x80);
+                dest[2] = (utf8) (((cp >> 6) & 0x3F) | 0x80);
+                dest[3] = (utf8) ((cp & 0x3F) | 0x80);
+                return 4;
+            }
+        }
+
+        // Encode src[idx, end) one code point at a time, advancing 'out'. Returns the index it stopped at, which is
+        // before 'end' when the destination ran out of room
+        static inline size_t EncodeUtf8Range(const utf32 *src, size_t idx, size_t end, utf8 *dest, size_t dest_len,
+                                             size_t &out) {
+            // Skip the per code point room checks when even the worst case fits
+            if ((dest_len - out) / 4 >= end - idx) {
+                for (; idx < end; ++idx)
+                    out += EncodeUtf8One(src[idx], dest + out);
+
+                return idx;
+            }
+
+            for (; idx < end; ++idx) {
+                utf32 cp = src[idx];
+
+                if (dest_len - out < Utf8SequenceSize(cp))
+                    break;
+
+                out += EncodeUtf8One(cp, dest + out);
+            }
+
+            return idx;
+        }
+
+        static size_t Utf8LengthOfScalar(const utf32 *src, size_t len) {
+            size_t count = 0;
+
+            for (size_t i = 0; i < len; ++i)
+                count += Utf8SequenceSize(src[i]);
+
+            return count;
+        }
+
+        // Deal with the malformed sequence at 'idx' according to 'policy'. Returns false when decoding has to stop
+        static bool Utf8Malformed(size_t idx, EdoUtf8Policy policy, size_t *error_offset) {
+            if (error_offset && *error_offset == UTF_NO_ERROR)
+                *error_offset = idx;
+
+            if (policy == Utf8Throw)
+                throw std::invalid_argument("Malformed utf8 sequence at code unit " + std::to_string(idx));
+
+            return policy == Utf8Replace;
+        }
+
+        // Decode the sequences starting in src[idx, end) (the last one may run up to 'len'), advancing 'idx' and
+        // 'out'. Returns false when decoding stopped on malformed data
+        static bool DecodeUtf8Range(const utf8 *src, size_t &idx, size_t end, size_t len, utf32 *dest, size_t &out,
+                                    EdoUtf8Policy policy, size_t *error_offset) {
+            // Work on copies, the stores through 'dest' would otherwise force the references back to memory
+            size_t i = idx;
+            size_t o = out;
+            bool more = true;
+
+            while (i < end) {
+                if (src[i] < 0x80) {
+                    dest[o++] = src[i++];
+                    continue;
+                }
+
+                utf32 cp;
+                size_t bad;
+                size_t size = DecodeUtf8One(src + i, len - i, cp, bad);
+
+                if (size != 0) {
+                    dest[o++] = cp;
+                    i += size;
+                } else if (Utf8Malformed(i, policy, error_offset)) {
+                    dest[o++] = UTF_REPLACEMENT_CHAR;
+                    i += bad;
+                } else {
+                    more = false;
+                    break;
+                }
+            }
+
+            idx = i;
+            out = o;
+            return more;
+        }
+
+        // Count the code points DecodeUtf8Range() would produce with the Utf8Replace policy, advancing 'idx'
+        static size_t Utf32LengthOfRange(const utf8 *src, size_t &idx, size_t end, size_t len) {
+            size_t count = 0;
+
+            while (idx < end) {
+                utf32 cp;
+                size_t bad;
+                size_t size = (src[idx] < 0x80) ? 1 : DecodeUtf8One(src + idx, len - idx, cp, bad);
+
+                idx += (size != 0) ? size : bad;
+                ++count;
+            }
+
+            return count;
+        }
+
+        // Validate the sequences starting in src[idx, end) (the last one may run up to 'len'), advancing 'idx'. Returns
+        // false with 'idx' on the first malformed sequence
+        static bool ValidateUtf8Range(const utf8 *src, size_t &idx, size_t end, size_t len) {
+            while (idx < end) {
+                utf32 cp;
+                size_t bad;
+                size_t size = (src[idx] < 0x80) ? 1 : DecodeUtf8One(src + idx, len - idx, cp, bad);
+
+                if (size == 0)
+                    return false;
+
+                idx += size;
+            }
+
+            return true;
+        }
+
+        // Return the start of the sequence holding src[idx], for a position reached by the block validator, which has
+        // found everything before it well-formed
+        static size_t Utf8SequenceStart(const utf8 *src, size_t idx) {
+            for (size_t back = 0; back < 4 && idx > 0; ++back) {
+                if ((src[--idx] & 0xC0) != 0x80)
+                    return idx;
+            }
+
+            return idx;
+        }
+
+        static size_t CountCodePointsScalar(const utf8 *src, size_t len) {
+            size_t count = 0;
+
+            for (size_t i = 0; i < len; ++i)
+                count += (src[i] & 0xC0) != 0x80;
+
+            return count;
+        }
+
+        // Deal with the code point or code unit at 'idx' that has no utf16 form, according to 'policy'. Returns false
+        // when the conversion has to stop
+        static bool Utf16Malformed(size_t idx, EdoUtf16Policy policy, size_t *error_offset, const char *what) {
+            if (error_offset && *error_offset == UTF_NO_ERROR)
+                *error_offset = idx;
+
+            if (policy == Utf16Throw)
+                throw std::invalid_argument(what + std::to_string(idx));
+
+            return policy != Utf16Stop;
+        }
+
+        // Encode the code points in src[idx, end), advancing 'idx' and 'out'. Returns false when encoding stopped,
+        // on a code point with no utf16 form or on a full 'dest'
+        static bool EncodeUtf16Range(const utf32 *src, size_t &idx, size_t end, utf16 *dest, size_t dest_len,
+                                     size_t &out, EdoUtf16Policy policy, size_t *error_offset) {
+            size_t i = idx;
+            size_t o = out;
+            bool more = true;
+
+            for (; i < end; ++i) {
+                utf32 cp = src[i];
+
+                if (cp >= 0x10000 && cp <= 0x10FFFF) {
+                    if (dest_len - o < 2) {
+                        more = false;
+                        break;
+                    }
+
+                    cp -= 0x10000;
+                    dest[o++] = (utf16) (0xD800 + (cp >> 10));
+                    dest[o++] = (utf16) (0xDC00 + (cp & 0x3FF));
+                    continue;
+                }
+
+                if (o == dest_len) {
+                    more = false;
+                    break;
+                }
+
+                if ((cp & 0xFFFFF800) == 0xD800 || cp > 0x10FFFF) {
+                    if (!Utf16Malformed(i, policy, error_offset, "No utf16 form for the code point at index ")) {
+                        more = false;
+                        break;
+                    }
+
+                    if (policy != Utf16Keep || cp > 0x10FFFF)
+                        cp = UTF_REPLACEMENT_CHAR;
+                }
+
+                dest[o++] = (utf16) cp;
+            }
+
+            idx = i;
+            out = o;
+            return more;
+        }
+
+        static size_t Utf16LengthOfScalar(const utf32 *src, size_t len) {
+            size_t count = len;
+
+            for (size_t i = 0; i < len; ++i)
+                count += (src[i] - 0x10000) < 0x100000;
+
+            return count;
+        }
+
+        // Decode the code units starting in src[idx, end) (a surrogate pair may run up to 'len'), advancing 'idx' and
+        // 'out'. Returns false when decoding stopped on an unpaired surrogate
+        static bool DecodeUtf16Range(const utf16 *src, size_t &idx, size_t end, size_t len, utf32 *dest, size_t &out,
+                                     EdoUtf16Policy policy, size_t *error_offset) {
+            size_t i = idx;
+            size_t o = out;
+            bool more = true;
+
+            while (i < end) {
+                utf32 unit = src[i];
+
+                if ((unit & 0xF800) != 0xD800) {
+                    dest[o++] = unit;
+                    ++i;
+                } else if (unit < 0xDC00 && len - i >= 2 && (src[i + 1] & 0xFC00) == 0xDC00) {
+                    dest[o++] = 0x10000 + ((unit - 0xD800) << 10) + (src[i + 1] - 0xDC00);
+                    i += 2;
+                } else if (Utf16Malformed(i, policy, error_offset, "Unpaired utf16 surrogate at code unit ")) {
+                    dest[o++] = (policy == Utf16Keep) ? unit : UTF_REPLACEMENT_CHAR;
+                    ++i;
+                } else {
+                    more = false;
+                    break;
+                }
+            }
+
+            idx = i;
+            out = o;
+            return more;
+        }
+
+        // Count the surrogate pairs starting in src[idx, end) (the last one may run up to 'len'), advancing 'idx'
+        static size_t CountSurrogatePairs(const utf16 *src, size_t &idx, size_t end, size_t len) {
+            size_t pairs = 0;
+
+            while (idx < end) {
+                if ((src[idx] & 0xFC00) == 0xD800 && len - idx >= 2 && (src[idx + 1] & 0xFC00) == 0xDC00) {
+                    ++pairs;
+                    idx += 2;
+                } else {
+                    ++idx;
+                }
+            }
+
+            return pairs;
+        }
+
+        // Index of the lowest set bit, bits must not be zero
+        static inline size_t LowestBit(unsigned int bits) {
+#ifdef _MSC_VER
+            unsigned long idx;
+            _BitScanForward(&idx, bits);
+            return idx;
+#else
+            return (size_t) __builtin_ctz(bits);
+#endif
+        }
+
+        static inline size_t PopCount(unsigned int bits) {
+            bits = bits - ((bits >> 1) & 0x55555555);
+            bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+            return (((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+        }
+
+#ifdef EDO_X86
+        // Number of vector iterations between two flushes of the 32 bit lane counters (each adds at most 3 per lane)
+        static const size_t s_lengthFlushInterval = 1 << 24;
+
+        // Shuffles that compact four code points, encoded as one to three bytes at the bottom of their 32 bit lanes,
+        // into a contiguous utf8 sequence. Indexed by the 'more than one byte' lane mask, plus the 'three bytes' lane
+        // mask shifted up by four
+        struct Utf8PackTable {
+            alignas(16) utf8 shuffle[256][16];
+            utf8 length[256];
+
+            Utf8PackTable() {
+                for (int idx = 0; idx < 256; ++idx) {
+                    int pos = 0;
+
+                    for (int lane = 0; lane < 4; ++lane) {
+                        int bytes = 1 + ((idx >> lane) & 1) + ((idx >> (lane + 4)) & 1);
+
+                        for (int b = 0; b < bytes; ++b)
+                            shuffle[idx][pos++] = (utf8) (lane * 4 + b);
+                    }
+
+                    length[idx] = (utf8) pos;
+
+                    // Zero the unused tail (pshufb writes 0 for indices with the top bit set)
+                    while (pos < 16)
+                        shuffle[idx][pos++] = 0x80;
+                }
+            }
+        };
+
+        static const Utf8PackTable &GetUtf8PackTable() {
+            static const Utf8PackTable s_table;
+            return s_table;
+        }
+
+        // Number of code units covered by the lead byte mask that selects an unpack table entry
+        static const int s_unpackWindow = 13;
+
+        // Shuffles that spread up to four sequences of one to three code units over 32 bit lanes, last code unit in
+        // the lowest byte. The step for the next code units is looked up by the mask of lead (non-continuation) bytes
+        // in the next 13 code units. A sequence is only taken when the lead byte of the one after it is inside the
+        // window, so the mask tells its length
+        struct Utf8UnpackTable {
+            static const int s_entries = 1 + 3 + 9 + 27 + 81; // Every combination of up to four lengths
+
+            alignas(16) utf8 shuffle[s_entries][16];
+
+            // Shuffle entry in the low byte, then the code units consumed (0 if the first sequence can not be
+            // unpacked) and the code points produced, four bits each. Packed so each step needs a single lookup
+            unsigned short steps[1 << s_unpackWindow];
+
+            Utf8UnpackTable() {
+                // Entry for each list of lengths, keyed by the lengths as base 4 digits
+                int ids[256];
+                int entries = 0;
+
+                for (int &id : ids)
+                    id = -1;
+
+                for (int mask = 0; mask < (1 << s_unpackWindow); ++mask) {
+                    int lengths[4];
+                    int count = 0;
+                    int key = 0;
+                    int pos = 0;
+
+                    while (count < 4) {
+                        int next = pos + 1;
+
+                        while (next < s_unpackWindow && !(mask & (1 << next)))
+                            ++next;
+
+                        if (next >= s_unpackWindow || next - pos > 3)
+                            break;
+
+                        lengths[count] = next - pos;
+                        key = key * 4 + lengths[count];
+                        ++count;
+                        pos = next;
+                    }
+
+                    if (ids[key] < 0) {
+                        int start = 0;
+                        ids[key] = entries++;
+
+                        for (int b = 0; b < 16; ++b)
+                            shuffle[ids[key]][b] = 0x80;
+
+                        for (int lane = 0; lane < count; ++lane) {
+                            for (int b = 0; b < lengths[lane]; ++b)
+                                shuffle[ids[key]][lane * 4 + b] = (utf8) (start + lengths[lane] - 1 - b);
+
+                            start += lengths[lane];
+                        }
+                    }
+
+                    steps[mask] = (unsigned short) (ids[key] | (pos << 8) | (count << 12));
+                }
+            }
+        };
+
+        static const Utf8UnpackTable &GetUtf8UnpackTable() {
+            static const Utf8UnpackTable s_table;
+            return s_table;
+        }
+
+        // Shuffles that gather the 16 bit values at the lead positions of eight code units, indexed by the lead mask
+        struct Utf8CompactTable {
+            alignas(16) utf8 shuffle[256][16];
+            utf8 count[256];
+
+            Utf8CompactTable() {
+                for (int mask = 0; mask < 256; ++mask) {
+                    int pos = 0;
+
+                    for (int lane = 0; lane < 8; ++lane) {
+                        if (mask & (1 << lane)) {
+                            shuffle[mask][pos++] = (utf8) (lane * 2);
+                            shuffle[mask][pos++] = (utf8) (lane * 2 + 1);
+                        }
+                    }
+
+                    count[mask] = (utf8) (pos / 2);
+
+                    while (pos < 16)
+                        shuffle[mask][pos++] = 0x80;
+                }
+            }
+        };
+
+        static const Utf8CompactTable &GetUtf8CompactTable() {
+            static const Utf8CompactTable s_table;
+            return s_table;
+        }
+
+        // Both tables used by the SSSE3 decoder
+        struct Utf8DecodeTables {
+            const Utf8UnpackTable &unpack;
+            const Utf8CompactTable &compact;
+        };
+
+        ///////////////////////////////////////////////
+        // SSE2 kernels
+        ///////////////////////////////////////////////
+        EDO_TARGET_SSE2 static size_t Utf8LengthOfSse2(const utf32 *src, size_t len) {
+            // Signed compares only, so flip the sign bit of both sides to compare as unsigned
+            const __m128i bias = _mm_set1_epi32((int) 0x80000000);
+            const __m128i above1 = _mm_set1_epi32((int) (0x7F ^ 0x80000000));
+            const __m128i above2 = _mm_set1_epi32((int) (0x7FF ^ 0x80000000));
+            const __m128i above3 = _mm_set1_epi32((int) (0xFFFF ^ 0x80000000));
+
+            size_t count = len;
+            size_t i = 0;
+
+            while (len - i >= 4) {
+                size_t blocks = (len - i) / 4;
+
+                if (blocks > s_lengthFlushInterval)
+                    blocks = s_lengthFlushInterval;
+
+                __m128i acc = _mm_setzero_si128();
+
+                for (size_t end = i + blocks * 4; i < end; i += 4) {
+                    __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (src + i)), bias);
+
+                    // Each compare yields -1 per lane that needs one more code unit
+                    acc = _mm_sub_epi32(acc, _mm_cmpgt_epi32(v, above1));
+                    acc = _mm_sub_epi32(acc, _mm_cmpgt_epi32(v, above2));
+                    acc = _mm_sub_epi32(acc, _mm_cmpgt_epi32(v, above3));
+                }
+
+                unsigned int lanes[4];
+                _mm_storeu_si128((__m128i *) lanes, acc);
+                count += (size_t) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+            }
+
+            return count + Utf8LengthOfScalar(src + i, len - i) - (len - i);
+        }
+
+        EDO_TARGET_SSE2 static size_t EncodeUtf8Sse2(const utf32 *src, size_t len, utf8 *dest, size_t dest_len) {
+            const __m128i nonAscii = _mm_set1_epi32((int) 0xFFFFFF80);
+            const __m128i zero = _mm_setzero_si128();
+
+            size_t i = 0;
+            size_t out = 0;
+
+            while (len - i >= 16 && dest_len - out >= 16) {
+                __m128i a = _mm_loadu_si128((const __m128i *) (src + i));
+                __m128i b = _mm_loadu_si128((const __m128i *) (src + i + 4));
+                __m128i c = _mm_loadu_si128((const __m128i *) (src + i + 8));
+                __m128i d = _mm_loadu_si128((const __m128i *) (src + i + 12));
+                __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(any, nonAscii), zero)) == 0xFFFF) {
+                    // All ASCII, narrow 16 code points to 16 bytes (the values are small enough for the saturating packs)
+                    __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+                    _mm_storeu_si128((__m128i *) (dest + out), bytes);
+                    i += 16;
+                    out += 16;
+                } else if (EncodeUtf8Range(src, i, i + 16, dest, dest_len, out) == i + 16) {
+                    i += 16;
+                } else {
+                    return out;
+                }
+            }
+
+            EncodeUtf8Range(src, i, len, dest, dest_len, out);
+            return out;
+        }
+
+        // Widen 16 ASCII code units
+        EDO_TARGET_SSE2 static inline void WidenAscii16(__m128i in, utf32 *dest) {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i low = _mm_unpacklo_epi8(in, zero);
+            __m128i high = _mm_unpackhi_epi8(in, zero);
+
+            _mm_storeu_si128((__m128i *) dest, _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128((__m128i *) (dest + 4), _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128((__m128i *) (dest + 8), _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128((__m128i *) (dest + 12), _mm_unpackhi_epi16(high, zero));
+        }
+
+        // The decode kernels start at src[idx] (on a sequence boundary) and leave 'idx' / 'out' where they stopped,
+        // the scalar decoder finishes the tail. They return false when decoding stopped on malformed data
+        EDO_TARGET_SSE2 static bool DecodeUtf8Sse2(const utf8 *src, size_t len, size_t &idx, utf32 *dest, size_t &out,
+                                                   EdoUtf8Policy policy, size_t *error_offset) {
+            while (len - idx >= 16) {
+                __m128i in = _mm_loadu_si128((const __m128i *) (src + idx));
+
+                if (_mm_movemask_epi8(in) == 0) {
+                    WidenAscii16(in, dest + out);
+                    idx += 16;
+                    out += 16;
+                } else if (!DecodeUtf8Range(src, idx, idx + 16, len, dest, out, policy, error_offset)) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        EDO_TARGET_SSE2 static size_t Utf32LengthOfSse2(const utf8 *src, size_t len, size_t &idx) {
+            size_t count = 0;
+
+            while (len - idx >= 16) {
+                __m128i in = _mm_loadu_si128((const __m128i *) (src + idx));
+
+                if (_mm_movemask_epi8(in) == 0) {
+                    idx += 16;
+                    count += 16;
+                } else {
+                    count += Utf32LengthOfRange(src, idx, idx + 16, len);
+                }
+            }
+
+            return count;
+        }
+
+        EDO_TARGET_SSE2 static size_t CountCodePointsSse2(const utf8 *src, size_t len, size_t &idx) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i lastContinuation = _mm_set1_epi8(-65);
+            size_t count = 0;
+
+            while (len - idx >= 16) {
+                // The 8 bit lane counters are summed before they can overflow
+                size_t blocks = std::min((len - idx) / 16, (size_t) 255);
+                __m128i acc = _mm_setzero_si128();
+
+                for (size_t end = idx + blocks * 16; idx < end; idx += 16) {
+                    __m128i in = _mm_loadu_si128((const __m128i *) (src + idx));
+                    acc = _mm_sub_epi8(acc, _mm_cmpgt_epi8(in, lastContinuation));
+                }
+
+                __m128i sums = _mm_sad_epu8(acc, zero);
+                count += (size_t) _mm_cvtsi128_si32(sums) + (size_t) _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+            }
+
+            return count;
+        }
+
+        EDO_TARGET_SSE2 static size_t Utf16LengthOfSse2(const utf32 *src, size_t len) {
+            const __m128i bias = _mm_set1_epi32((int) 0x80000000);
+            const __m128i belowPlane1 = _mm_set1_epi32((int) (0xFFFF ^ 0x80000000));
+            const __m128i aboveMax = _mm_set1_epi32((int) (0x10FFFF ^ 0x80000000));
+
+            size_t count = len;
+            size_t i = 0;
+
+            while (len - i >= 4) {
+                size_t blocks = (len - i) / 4;
+
+                if (blocks > s_lengthFlushInterval)
+                    blocks = s_lengthFlushInterval;
+
+                __m128i acc = _mm_setzero_si128();
+
+                for (size_t end = i + blocks * 4; i < end; i += 4) {
+                    __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (src + i)), bias);
+
+                    // One more code unit for 0x10000..0x10FFFF
+                    acc = _mm_sub_epi32(acc, _mm_cmpgt_epi32(v, belowPlane1));
+                    acc = _mm_add_epi32(acc, _mm_cmpgt_epi32(v, aboveMax));
+                }
+
+                unsigned int lanes[4];
+                _mm_storeu_si128((__m128i *) lanes, acc);
+
+                for (int lane = 0; lane < 4; ++lane)
+                    count += lanes[lane];
+            }
+
+            return count + Utf16LengthOfScalar(src + i, len - i) - (len - i);
+        }
+
+        // All ones in the 32 bit lanes of 'v' holding BMP code points that are not surrogates
+        EDO_TARGET_SSE2 static inline __m128i Utf16SingleUnits(__m128i v) {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i bmp = _mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32((int) 0xFFFF0000)), zero);
+            __m128i surrogate = _mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32((int) 0xFFFFF800)),
+                                                _mm_set1_epi32(0xD800));
+
+            return _mm_andnot_si128(surrogate, bmp);
+        }
+
+        // Narrow the 32 bit lanes to their low 16 bits, packs_epi32 saturates so they are sign extended first
+        EDO_TARGET_SSE2 static inline __m128i NarrowUtf16(__m128i a, __m128i b) {
+            return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+        }
+
+        // Blocks are narrowed as a whole up to the first code point that does not fit in one code unit, which alone
+        // goes through the scalar encoder, so a few code points outside the BMP do not slow the whole text down
+        EDO_TARGET_SSE2 static bool EncodeUtf16Sse2(const utf32 *src, size_t len, size_t &idx, utf16 *dest,
+                                                    size_t dest_len, size_t &out, EdoUtf16Policy policy,
+                                                    size_t *error_offset) {
+            while (len - idx >= 8 && dest_len - out >= 8) {
+                __m128i a = _mm_loadu_si128((const __m128i *) (src + idx));
+                __m128i b = _mm_loadu_si128((const __m128i *) (src + idx + 4));
+
+                // Two bits per code point, in order
+                unsigned int single = (unsigned int) _mm_movemask_epi8(_mm_packs_epi32(Utf16SingleUnits(a),
+                                                                                       Utf16SingleUnits(b)));
+                _mm_storeu_si128((__m128i *) (dest + out), NarrowUtf16(a, b));
+
+                if (single == 0xFFFF) {
+                    idx += 8;
+                    out += 8;
+                    continue;
+                }
+
+                size_t run = LowestBit(~single) / 2;
+                idx += run;
+                out += run;
+
+                if (!EncodeUtf16Range(src, idx, idx + 1, dest, dest_len, out, policy, error_offset))
+                    return false;
+            }
+
+            return true;
+        }
+
+        // All ones in the 16 bit lanes of 'v' holding surrogates
+        EDO_TARGET_SSE2 static inline __m128i Utf16Surrogates(__m128i v) {
+            return _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16((short) 0xF800)), _mm_set1_epi16((short) 0xD800));
+        }
+
+        // Like the encoder, blocks are widened as a whole up to the first surrogate, which alone goes through the
+        // scalar decoder
+        EDO_TARGET_SSE2 static bool DecodeUtf16Sse2(const utf16 *src, size_t len, size_t &idx, utf32 *dest,
+                                                    size_t &out, EdoUtf16Policy policy, size_t *error_offset) {
+            const __m128i zero = _mm_setzero_si128();
+
+            while (len - idx >= 8) {
+                __m128i v = _mm_loadu_si128((const __m128i *) (src + idx));
+                unsigned int surrogates = (unsigned int) _mm_movemask_epi8(Utf16Surrogates(v));
+
+                _mm_storeu_si128((__m128i *) (dest + out), _mm_unpacklo_epi16(v, zero));
+                _mm_storeu_si128((__m128i *) (dest + out + 4), _mm_unpackhi_epi16(v, zero));
+
+                if (surrogates == 0) {
+                    idx += 8;
+                    out += 8;
+                    continue;
+                }
+
+                size_t run = LowestBit(surrogates) / 2;
+                idx += run;
+                out += run;
+
+                if (!DecodeUtf16Range(src, idx, idx + 1, len, dest, out, policy, error_offset))
+                    return false;
+            }
+
+            return true;
+        }
+
+        EDO_TARGET_SSE2 static size_t CountSurrogatePairsSse2(const utf16 *src, size_t len, size_t &idx) {
+            size_t pairs = 0;
+
+            while (len - idx >= 8) {
+                if (_mm_movemask_epi8(Utf16Surrogates(_mm_loadu_si128((const __m128i *) (src + idx)))) == 0)
+                    idx += 8;
+                else
+                    pairs += CountSurrogatePairs(src, idx, idx + 8, len);
+            }
+
+            return pairs;
+        }
+
+        ///////////////////////////////////////////////
+        // SSSE3 / SSE4.1 kernels
+        ///////////////////////////////////////////////
+        // Encode four code points, 'dest' needs room for 16 bytes. Returns the number of bytes that make up the result
+        EDO_TARGET_SSSE3 static inline size_t EncodeUtf8Group4(const utf32 *src, utf8 *dest, const Utf8PackTable &table) {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i v = _mm_loadu_si128((const __m128i *) src);
+
+            // Code points outside the BMP (or invalid ones) take the scalar path
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32((int) 0xFFFF0000)), zero)) != 0xFFFF) {
+                size_t out = 0;
+
+                for (int n = 0; n < 4; ++n)
+                    out += EncodeUtf8One(src[n], dest + out);
+
+                return out;
+            }
+
+            // Build every possible encoding in each lane, then pick the right one per lane
+            __m128i low6 = _mm_or_si128(_mm_and_si128(v, _mm_set1_epi32(0x3F)), _mm_set1_epi32(0x80));
+            __m128i mid6 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 6), _mm_set1_epi32(0x3F)), _mm_set1_epi32(0x80));
+            __m128i two = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(v, 6), _mm_set1_epi32(0xC0)), _mm_slli_epi32(low6, 8));
+            __m128i three = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(v, 12), _mm_set1_epi32(0xE0)),
+                                         _mm_or_si128(_mm_slli_epi32(mid6, 8), _mm_slli_epi32(low6, 16)));
+
+            __m128i isTwo = _mm_cmpgt_epi32(v, _mm_set1_epi32(0x7F));
+            __m128i isThree = _mm_cmpgt_epi32(v, _mm_set1_epi32(0x7FF));
+
+            __m128i lanes = _mm_or_si128(_mm_andnot_si128(isTwo, v), _mm_and_si128(isTwo, two));
+            lanes = _mm_or_si128(_mm_andnot_si128(isThree, lanes), _mm_and_si128(isThree, three));
+
+            int idx = _mm_movemask_ps(_mm_castsi128_ps(isTwo)) | (_mm_movemask_ps(_mm_castsi128_ps(isThree)) << 4);
+            __m128i packed = _mm_shuffle_epi8(lanes, _mm_load_si128((const __m128i *) table.shuffle[idx]));
+            _mm_storeu_si128((__m128i *) dest, packed);
+
+            return table.length[idx];
+        }
+
+        EDO_TARGET_SSSE3 static size_t EncodeUtf8Ssse3(const utf32 *src, size_t len, utf8 *dest, size_t dest_len) {
+            const Utf8PackTable &table = GetUtf8PackTable();
+            const __m128i nonAscii = _mm_set1_epi32((int) 0xFFFFFF80);
+            const __m128i zero = _mm_setzero_si128();
+
+            size_t i = 0;
+            size_t out = 0;
+
+            // 64 bytes of room covers the worst case of a block (16 code points of four bytes each)
+            while (len - i >= 16 && dest_len - out >= 64) {
+                __m128i a = _mm_loadu_si128((const __m128i *) (src + i));
+                __m128i b = _mm_loadu_si128((const __m128i *) (src + i + 4));
+                __m128i c = _mm_loadu_si128((const __m128i *) (src + i + 8));
+                __m128i d = _mm_loadu_si128((const __m128i *) (src + i + 12));
+                __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(any, nonAscii), zero)) == 0xFFFF) {
+                    __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+                    _mm_storeu_si128((__m128i *) (dest + out), bytes);
+                    out += 16;
+                } else {
+                    for (int group = 0; group < 16; group += 4)
+                        out += EncodeUtf8Group4(src + i + group, dest + out, table);
+                }
+
+                i += 16;
+            }
+
+            EncodeUtf8Range(src, i, len, dest, dest_len, out);
+            return out;
+        }
+
+        // Return the mask of lead (non-continuation) code units
+        EDO_TARGET_SSE2 static inline unsigned int Utf8Leads(__m128i in) {
+            return (unsigned int) _mm_movemask_epi8(_mm_cmpgt_epi8(in, _mm_set1_epi8(-65)));
+        }
+
+        // The lookup tables of the Keiser & Lemire utf8 validation: each one maps a nibble (high or low nibble of the
+        // first code unit of a pair, high nibble of the second) to the error classes it takes part in
+        struct Utf8ErrorTables {
+            __m128i byte1High;
+            __m128i byte1Low;
+            __m128i byte2High;
+        };
+
+        EDO_TARGET_SSE2 static inline Utf8ErrorTables GetUtf8ErrorTables() {
+            // Error classes, each table sets the classes its nibble takes part in. A pair of code units is an error
+            // when all three tables agree on a class
+            const int tooShort = 1 << 0; // Lead not followed by a continuation
+            const int tooLong = 1 << 1; // ASCII followed by a continuation
+            const int overlong3 = 1 << 2; // 11100000 100_____
+            const int tooLarge = 1 << 3; // Above 0x10FFFF
+            const int surrogate = 1 << 4; // 11101101 101_____
+            const int overlong2 = 1 << 5; // 1100000_ 10______
+            const int tooLarge1000 = 1 << 6; // Above 0x10FFFF with 1000____ as second code unit
+            const int overlong4 = 1 << 6; // 11110000 1000____
+            const int twoConts = 1 << 7; // Continuation followed by continuation
+            const int carry = tooShort | tooLong | twoConts;
+
+            Utf8ErrorTables tables;
+
+            tables.byte1High = _mm_setr_epi8(
+                    tooLong, tooLong, tooLong, tooLong, tooLong, tooLong, tooLong, tooLong,
+                    twoConts, twoConts, twoConts, twoConts,
+                    tooShort | overlong2,
+                    tooShort,
+                    tooShort | overlong3 | surrogate,
+                    tooShort | tooLarge | tooLarge1000 | overlong4);
+            tables.byte1Low = _mm_setr_epi8(
+                    carry | overlong3 | overlong2 | overlong4,
+                    carry | overlong2,
+                    carry,
+                    carry,
+                    carry | tooLarge,
+                    carry | tooLarge | tooLarge1000,
+                    carry | tooLarge | tooLarge1000,
+                    carry | tooLarge | tooLarge1000,
+                    carry | tooLarge | tooLarge1000,
+                    carry | tooLarge | tooLarge1000,
+                    carry | tooLarge | tooLarge1000,
+                    carry | tooLarge | tooLarge1000,
+                    carry | tooLarge | tooLarge1000,
+                    carry | tooLarge | tooLarge1000 | surrogate,
+                    carry | tooLarge | tooLarge1000,
+                    carry | tooLarge | tooLarge1000);
+            tables.byte2High = _mm_setr_epi8(
+                    tooShort, tooShort, tooShort, tooShort, tooShort, tooShort, tooShort, tooShort,
+                    tooLong | overlong2 | twoConts | overlong3 | tooLarge1000 | overlong4,
+                    tooLong | overlong2 | twoConts | overlong3 | tooLarge,
+                    tooLong | overlong2 | twoConts | surrogate | tooLarge,
+                    tooLong | overlong2 | twoConts | surrogate | tooLarge,
+                    tooShort, tooShort, tooShort, tooShort);
+
+            return tables;
+        }
+
+        // Return the error classes found in 'in', given the 16 code units before it (Keiser & Lemire lookup
+        // algorithm). All zero for well-formed data, apart from sequences that run past the end of 'in'
+        EDO_TARGET_SSSE3 static inline __m128i Utf8Errors(__m128i in, __m128i prev) {
+            const Utf8ErrorTables tables = GetUtf8ErrorTables();
+            const __m128i nibble = _mm_set1_epi8(0x0F);
+            __m128i prev1 = _mm_alignr_epi8(in, prev, 15);
+            __m128i prev2 = _mm_alignr_epi8(in, prev, 14);
+            __m128i prev3 = _mm_alignr_epi8(in, prev, 13);
+
+            __m128i special = _mm_and_si128(
+                    _mm_and_si128(_mm_shuffle_epi8(tables.byte1High, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                                  _mm_shuffle_epi8(tables.byte1Low, _mm_and_si128(prev1, nibble))),
+                    _mm_shuffle_epi8(tables.byte2High, _mm_and_si128(_mm_srli_epi16(in, 4), nibble)));
+
+            // Third and fourth code units of a sequence have to be continuations (the tables flag them as twoConts)
+            __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8((char) (0xE0 - 0x80)));
+            __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8((char) (0xF0 - 0x80)));
+            __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char) 0x80));
+
+            return _mm_xor_si128(must23, special);
+        }
+
+        // Validate the 32 code units in 'first' and 'second', starting on a sequence boundary. Sequences that run
+        // past the block are not errors, instead 'usable' receives the number of code units before the first of them.
+        // 'leads' receives the mask of lead code units
+        EDO_TARGET_SSSE3 static inline bool ValidateUtf8Block(__m128i first, __m128i second, unsigned int &leads,
+                                                              size_t &usable) {
+            const __m128i zero = _mm_setzero_si128();
+
+            // The block starts on a boundary, so whatever came before behaves like ASCII
+            __m128i errors = _mm_or_si128(Utf8Errors(first, zero), Utf8Errors(second, first));
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(errors, zero)) != 0xFFFF)
+                return false;
+
+            leads = Utf8Leads(first) | (Utf8Leads(second) << 16);
+
+            // Leads in the last three code units that need more code units than the block has left
+            const __m128i lastLimits = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                     (char) 0xEF, (char) 0xDF, (char) 0xBF);
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(second, lastLimits), zero)) == 0xFFFF) {
+                usable = 32;
+            } else {
+                // Stop at the last lead, everything before it is complete
+                usable = 31;
+
+                while (!(leads & (1U << usable)))
+                    --usable;
+            }
+
+            return true;
+        }
+
+        // Unpack the validated sequences in the 'usable' code units at src[idx], four code points at a time. 'src'
+        // needs to be readable 16 code units past every position before the end
+        EDO_TARGET_SSSE3 static inline void UnpackUtf8(const utf8 *src, size_t &idx, size_t usable, unsigned int leads,
+                                                       utf32 *dest, size_t &out, const Utf8UnpackTable &table) {
+            const __m128i keep = _mm_set1_epi32(0x000F3F7F);
+            size_t offset = 0;
+
+            while (offset < usable) {
+                // Bits past the block read as continuations, so no sequence is taken whose end is not known
+                unsigned int step = table.steps[(leads >> offset) & ((1 << s_unpackWindow) - 1)];
+                size_t consumed = (step >> 8) & 0x0F;
+
+                if (consumed == 0 || offset + consumed > usable)
+                    break;
+
+                // Lanes hold [last, middle, lead] code units. Masking with 0x7F / 0x3F / 0x0F strips the markers of
+                // every sequence length (a two unit lead has bit 5 clear, ASCII sits in the lowest byte)
+                __m128i in = _mm_loadu_si128((const __m128i *) (src + idx + offset));
+                __m128i shuffle = _mm_load_si128((const __m128i *) table.shuffle[step & 0xFF]);
+                __m128i lanes = _mm_and_si128(_mm_shuffle_epi8(in, shuffle), keep);
+                __m128i cps = _mm_or_si128(_mm_and_si128(lanes, _mm_set1_epi32(0x7F)),
+                                           _mm_or_si128(_mm_and_si128(_mm_srli_epi32(lanes, 2), _mm_set1_epi32(0x0FC0)),
+                                                        _mm_and_si128(_mm_srli_epi32(lanes, 4), _mm_set1_epi32(0xF000))));
+
+                _mm_storeu_si128((__m128i *) (dest + out), cps);
+                out += step >> 12;
+                offset += consumed;
+            }
+
+            idx += offset;
+        }
+
+        // Decode the 'usable' validated code units at src[idx], which only hold sequences of one or two code units
+        // (Latin, Greek, Cyrillic, Hebrew, Arabic...). Every lead is combined with the code unit after it, then the
+        // values at the lead positions are gathered, eight code units at a time. 'src' needs to be readable 33 code
+        // units past 'idx'
+        EDO_TARGET_SSSE3 static inline void DecodeUtf8Short(const utf8 *src, size_t &idx, size_t usable,
+                                                            unsigned int leads, utf32 *dest, size_t &out,
+                                                            const Utf8CompactTable &table) {
+            const __m128i zero = _mm_setzero_si128();
+
+            // A lead at the very end belongs to the next block
+            if (usable < 32)
+                leads &= (1U << usable) - 1;
+
+            for (int half = 0; half < 32; half += 16) {
+                __m128i units = _mm_loadu_si128((const __m128i *) (src + idx + half));
+                __m128i nexts = _mm_loadu_si128((const __m128i *) (src + idx + half + 1));
+
+                for (int part = 0; part < 2; ++part) {
+                    __m128i unit = part ? _mm_unpackhi_epi8(units, zero) : _mm_unpacklo_epi8(units, zero);
+                    __m128i next = part ? _mm_unpackhi_epi8(nexts, zero) : _mm_unpacklo_epi8(nexts, zero);
+
+                    __m128i isTwo = _mm_cmpgt_epi16(unit, _mm_set1_epi16(0xBF));
+                    __m128i two = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(unit, _mm_set1_epi16(0x1F)), 6),
+                                               _mm_and_si128(next, _mm_set1_epi16(0x3F)));
+                    __m128i values = _mm_or_si128(_mm_andnot_si128(isTwo, unit), _mm_and_si128(isTwo, two));
+
+                    unsigned int mask = (leads >> (half + part * 8)) & 0xFF;
+                    __m128i packed = _mm_shuffle_epi8(values, _mm_load_si128((const __m128i *) table.shuffle[mask]));
+
+                    _mm_storeu_si128((__m128i *) (dest + out), _mm_unpacklo_epi16(packed, zero));
+                    _mm_storeu_si128((__m128i *) (dest + out + 4), _mm_unpackhi_epi16(packed, zero));
+                    out += table.count[mask];
+                }
+            }
+
+            idx += usable;
+        }
+
+        // Decode one block of 32 code units at src[idx], which needs at least 48 readable code units
+        EDO_TARGET_SSSE3 static inline bool DecodeUtf8Block(const utf8 *src, size_t len, size_t &idx, utf32 *dest,
+                                                            size_t &out, EdoUtf8Policy policy, size_t *error_offset,
+                                                            const Utf8DecodeTables &tables) {
+            __m128i first = _mm_loadu_si128((const __m128i *) (src + idx));
+            __m128i second = _mm_loadu_si128((const __m128i *) (src + idx + 16));
+
+            if (_mm_movemask_epi8(_mm_or_si128(first, second)) == 0) {
+                WidenAscii16(first, dest + out);
+                WidenAscii16(second, dest + out + 16);
+                idx += 32;
+                out += 32;
+                return true;
+            }
+
+            unsigned int leads;
+            size_t usable;
+
+            // Malformed data somewhere in the block, let the scalar decoder apply the policy
+            if (!ValidateUtf8Block(first, second, leads, usable))
+                return DecodeUtf8Range(src, idx, idx + 16, len, dest, out, policy, error_offset);
+
+            // No leads of three or four code unit sequences
+            const __m128i twoUnitMax = _mm_set1_epi8((char) 0xDF);
+            __m128i longLeads = _mm_or_si128(_mm_subs_epu8(first, twoUnitMax), _mm_subs_epu8(second, twoUnitMax));
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(longLeads, _mm_setzero_si128())) == 0xFFFF) {
+                DecodeUtf8Short(src, idx, usable, leads, dest, out, tables.compact);
+                return true;
+            }
+
+            size_t start = idx;
+            UnpackUtf8(src, idx, usable, leads, dest, out, tables.unpack);
+
+            // Four code unit sequences are not in the table
+            if (idx == start)
+                return DecodeUtf8Range(src, idx, idx + 1, len, dest, out, policy, error_offset);
+
+            return true;
+        }
+
+        EDO_TARGET_SSSE3 static bool DecodeUtf8Ssse3(const utf8 *src, size_t len, size_t &idx, utf32 *dest,
+                                                     size_t &out, EdoUtf8Policy policy, size_t *error_offset) {
+            const Utf8DecodeTables tables = {GetUtf8UnpackTable(), GetUtf8CompactTable()};
+
+            while (len - idx >= 48) {
+                if (!DecodeUtf8Block(src, len, idx, dest, out, policy, error_offset, tables))
+                    return false;
+            }
+
+            return true;
+        }
+
+        // Validate whole groups of 64 code units, each block of 16 checked against the one before it. Returns false on
+        // the first group holding an error, with 'idx' at its start
+        EDO_TARGET_SSSE3 static bool ValidateUtf8Ssse3(const utf8 *src, size_t len, size_t &idx) {
+            // Leads in the last three code units of a block that need more code units than the block has left
+            const __m128i lastLimits = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                     (char) 0xEF, (char) 0xDF, (char) 0xBF);
+            const __m128i zero = _mm_setzero_si128();
+            __m128i prev = zero;
+
+            while (len - idx >= 64) {
+                __m128i a = _mm_loadu_si128((const __m128i *) (src + idx));
+                __m128i b = _mm_loadu_si128((const __m128i *) (src + idx + 16));
+                __m128i c = _mm_loadu_si128((const __m128i *) (src + idx + 32));
+                __m128i d = _mm_loadu_si128((const __m128i *) (src + idx + 48));
+                __m128i errors;
+
+                // Runs of ASCII only have to complete the sequence the group before them ended on
+                if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) == 0)
+                    errors = _mm_subs_epu8(prev, lastLimits);
+                else
+                    errors = _mm_or_si128(_mm_or_si128(Utf8Errors(a, prev), Utf8Errors(b, a)),
+                                          _mm_or_si128(Utf8Errors(c, b), Utf8Errors(d, c)));
+
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(errors, zero)) != 0xFFFF)
+                    return false;
+
+                prev = d;
+                idx += 64;
+            }
+
+            return true;
+        }
+
+        EDO_TARGET_SSSE3 static size_t Utf32LengthOfSsse3(const utf8 *src, size_t len, size_t &idx) {
+            size_t count = 0;
+
+            while (len - idx >= 32) {
+                __m128i first = _mm_loadu_si128((const __m128i *) (src + idx));
+                __m128i second = _mm_loadu_si128((const __m128i *) (src + idx + 16));
+                unsigned int leads;
+                size_t usable;
+
+                if (_mm_movemask_epi8(_mm_or_si128(first, second)) == 0) {
+                    idx += 32;
+                    count += 32;
+                } else if (ValidateUtf8Block(first, second, leads, usable)) {
+                    // Well-formed, so every lead byte starts one code point
+                    count += PopCount(usable == 32 ? leads : leads & ((1U << usable) - 1));
+                    idx += usable;
+                } else {
+                    count += Utf32LengthOfRange(src, idx, idx + 16, len);
+                }
+            }
+
+            return count;
+        }
+
+        ///////////////////////////////////////////////
+        // AVX2 kernels
+        ///////////////////////////////////////////////
+        EDO_TARGET_AVX2 static size_t Utf8LengthOfAvx2(const utf32 *src, size_t len) {
+            const __m256i bias = _mm256_set1_epi32((int) 0x80000000);
+            const __m256i above1 = _mm256_set1_epi32((int) (0x7F ^ 0x80000000));
+            const __m256i above2 = _mm256_set1_epi32((int) (0x7FF ^ 0x80000000));
+            const __m256i above3 = _mm256_set1_epi32((int) (0xFFFF ^ 0x80000000));
+
+            size_t count = len;
+            size_t i = 0;
+
+            while (len - i >= 8) {
+                size_t blocks = (len - i) / 8;
+
+                if (blocks > s_lengthFlushInterval)
+                    blocks = s_lengthFlushInterval;
+
+                __m256i acc = _mm256_setzero_si256();
+
+                for (size_t end = i + blocks * 8; i < end; i += 8) {
+                    __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (src + i)), bias);
+
+                    acc = _mm256_sub_epi32(acc, _mm256_cmpgt_epi32(v, above1));
+                    acc = _mm256_sub_epi32(acc, _mm256_cmpgt_epi32(v, above2));
+                    acc = _mm256_sub_epi32(acc, _mm256_cmpgt_epi32(v, above3));
+                }
+
+                unsigned int lanes[8];
+                _mm256_storeu_si256((__m256i *) lanes, acc);
+
+                for (int lane = 0; lane < 8; ++lane)
+                    count += lanes[lane];
+            }
+
+            return count + Utf8LengthOfScalar(src + i, len - i) - (len - i);
+        }
+
+        EDO_TARGET_AVX2 static size_t EncodeUtf8Avx2(const utf32 *src, size_t len, utf8 *dest, size_t dest_len) {
+            const __m256i nonAscii = _mm256_set1_epi32((int) 0xFFFFFF80);
+            // The packs work per 128 bit lane, this puts the resulting dwords back in source order
+            const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+            const Utf8PackTable &table = GetUtf8PackTable();
+
+            size_t i = 0;
+            size_t out = 0;
+
+            while (len - i >= 32 && dest_len - out >= 128) {
+                __m256i a = _mm256_loadu_si256((const __m256i *) (src + i));
+                __m256i b = _mm256_loadu_si256((const __m256i *) (src + i + 8));
+                __m256i c = _mm256_loadu_si256((const __m256i *) (src + i + 16));
+                __m256i d = _mm256_loadu_si256((const __m256i *) (src + i + 24));
+                __m256i any = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+
+                if (_mm256_testz_si256(any, nonAscii)) {
+                    __m256i bytes = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+                    _mm256_storeu_si256((__m256i *) (dest + out), _mm256_permutevar8x32_epi32(bytes, order));
+                    out += 32;
+                } else {
+                    for (int group = 0; group < 32; group += 4)
+                        out += EncodeUtf8Group4(src + i + group, dest + out, table);
+                }
+
+                i += 32;
+            }
+
+            // Finish the tail with the narrower kernel
+            return out + EncodeUtf8Ssse3(src + i, len - i, dest + out, dest_len - out);
+        }
+
+        EDO_TARGET_AVX2 static bool DecodeUtf8Avx2(const utf8 *src, size_t len, size_t &idx, utf32 *dest,
+                                                   size_t &out, EdoUtf8Policy policy, size_t *error_offset) {
+            const Utf8DecodeTables tables = {GetUtf8UnpackTable(), GetUtf8CompactTable()};
+
+            while (len - idx >= 48) {
+                __m256i in = _mm256_loadu_si256((const __m256i *) (src + idx));
+
+                if (_mm256_movemask_epi8(in) == 0) {
+                    // Widen 32 ASCII code units
+                    __m128i low = _mm256_castsi256_si128(in);
+                    __m128i high = _mm256_extracti128_si256(in, 1);
+
+                    _mm256_storeu_si256((__m256i *) (dest + out), _mm256_cvtepu8_epi32(low));
+                    _mm256_storeu_si256((__m256i *) (dest + out + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(low, 8)));
+                    _mm256_storeu_si256((__m256i *) (dest + out + 16), _mm256_cvtepu8_epi32(high));
+                    _mm256_storeu_si256((__m256i *) (dest + out + 24), _mm256_cvtepu8_epi32(_mm_srli_si128(high, 8)));
+                    idx += 32;
+                    out += 32;
+                } else if (!DecodeUtf8Block(src, len, idx, dest, out, policy, error_offset, tables)) {
+                    return false;
+                }
+            }
+
+            // Finish the tail with the narrower kernel
+            return DecodeUtf8Ssse3(src, len, idx, dest, out, policy, error_offset);
+        }
+
+        // Utf8Errors() over 32 code units, given the 32 before them
+        EDO_TARGET_AVX2 static inline __m256i Utf8ErrorsAvx2(__m256i in, __m256i prev, const Utf8ErrorTables &tables) {
+            const __m256i nibble = _mm256_set1_epi8(0x0F);
+            const __m256i byte1High = _mm256_broadcastsi128_si256(tables.byte1High);
+            const __m256i byte1Low = _mm256_broadcastsi128_si256(tables.byte1Low);
+            const __m256i byte2High = _mm256_broadcastsi128_si256(tables.byte2High);
+
+            // alignr works per 128 bit lane, so shift from the high lane of 'prev' and the low lane of 'in'
+            __m256i before = _mm256_permute2x128_si256(prev, in, 0x21);
+            __m256i prev1 = _mm256_alignr_epi8(in, before, 15);
+            __m256i prev2 = _mm256_alignr_epi8(in, before, 14);
+            __m256i prev3 = _mm256_alignr_epi8(in, before, 13);
+
+            __m256i special = _mm256_and_si256(
+                    _mm256_and_si256(_mm256_shuffle_epi8(byte1High, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                                     _mm256_shuffle_epi8(byte1Low, _mm256_and_si256(prev1, nibble))),
+                    _mm256_shuffle_epi8(byte2High, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble)));
+
+            __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char) (0xE0 - 0x80)));
+            __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char) (0xF0 - 0x80)));
+            __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char) 0x80));
+
+            return _mm256_xor_si256(must23, special);
+        }
+
+        EDO_TARGET_AVX2 static bool ValidateUtf8Avx2(const utf8 *src, size_t len, size_t &idx) {
+            const Utf8ErrorTables tables = GetUtf8ErrorTables();
+            const __m256i lastLimits = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                        (char) 0xEF, (char) 0xDF, (char) 0xBF);
+            __m256i prev = _mm256_setzero_si256();
+
+            while (len - idx >= 64) {
+                __m256i a = _mm256_loadu_si256((const __m256i *) (src + idx));
+                __m256i b = _mm256_loadu_si256((const __m256i *) (src + idx + 32));
+                __m256i errors;
+
+                if (_mm256_movemask_epi8(_mm256_or_si256(a, b)) == 0)
+                    errors = _mm256_subs_epu8(prev, lastLimits);
+                else
+                    errors = _mm256_or_si256(Utf8ErrorsAvx2(a, prev, tables), Utf8ErrorsAvx2(b, a, tables));
+
+                if (!_mm256_testz_si256(errors, errors))
+                    return false;
+
+                prev = b;
+                idx += 64;
+            }
+
+            return true;
+        }
+
+        EDO_TARGET_AVX2 static size_t CountCodePointsAvx2(const utf8 *src, size_t len, size_t &idx) {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i lastContinuation = _mm256_set1_epi8(-65);
+            size_t count = 0;
+
+            while (len - idx >= 32) {
+                size_t blocks = std::min((len - idx) / 32, (size_t) 255);
+                __m256i acc = _mm256_setzero_si256();
+
+                for (size_t end = idx + blocks * 32; idx < end; idx += 32) {
+                    __m256i in = _mm256_loadu_si256((const __m256i *) (src + idx));
+                    acc = _mm256_sub_epi8(acc, _mm256_cmpgt_epi8(in, lastContinuation));
+                }
+
+                uint64_t sums[4];
+                _mm256_storeu_si256((__m256i *) sums, _mm256_sad_epu8(acc, zero));
+                count += (size_t) (sums[0] + sums[1] + sums[2] + sums[3]);
+            }
+
+            // Finish the tail with the narrower kernel
+            return count + CountCodePointsSse2(src, len, idx);
+        }
+
+        EDO_TARGET_AVX2 static bool EncodeUtf16Avx2(const utf32 *src, size_t len, size_t &idx, utf16 *dest,
+                                                    size_t dest_len, size_t &out, EdoUtf16Policy policy,
+                                                    size_t *error_offset) {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i high = _mm256_set1_epi32((int) 0xFFFF0000);
+            const __m256i surrogateBits = _mm256_set1_epi32((int) 0xFFFFF800);
+            const __m256i surrogate = _mm256_set1_epi32(0xD800);
+
+            while (len - idx >= 16 && dest_len - out >= 16) {
+                __m256i a = _mm256_loadu_si256((const __m256i *) (src + idx));
+                __m256i b = _mm256_loadu_si256((const __m256i *) (src + idx + 8));
+
+                // BMP code points that are not surrogates
+                __m256i singleA = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(a, surrogateBits), surrogate),
+                                                      _mm256_cmpeq_epi32(_mm256_and_si256(a, high), zero));
+                __m256i singleB = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(b, surrogateBits), surrogate),
+                                                      _mm256_cmpeq_epi32(_mm256_and_si256(b, high), zero));
+
+                // The packs work per 128 bit lane, the permutes put the quadwords back in source order
+                __m256i narrow = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_slli_epi32(a, 16), 16),
+                                                    _mm256_srai_epi32(_mm256_slli_epi32(b, 16), 16));
+                unsigned int single = (unsigned int) _mm256_movemask_epi8(
+                        _mm256_permute4x64_epi64(_mm256_packs_epi32(singleA, singleB), 0xD8));
+
+                _mm256_storeu_si256((__m256i *) (dest + out), _mm256_permute4x64_epi64(narrow, 0xD8));
+
+                if (single == 0xFFFFFFFF) {
+                    idx += 16;
+                    out += 16;
+                    continue;
+                }
+
+                size_t run = LowestBit(~single) / 2;
+                idx += run;
+                out += run;
+
+                if (!EncodeUtf16Range(src, idx, idx + 1, dest, dest_len, out, policy, error_offset))
+                    return false;
+            }
+
+            // Finish the tail with the narrower kernel
+            return EncodeUtf16Sse2(src, len, idx, dest, dest_len, out, policy, error_offset);
+        }
+
+        EDO_TARGET_AVX2 static bool DecodeUtf16Avx2(const utf16 *src, size_t len, size_t &idx, utf32 *dest,
+                                                    size_t &out, EdoUtf16Policy policy, size_t *error_offset) {
+            const __m256i surrogateBits = _mm256_set1_epi16((short) 0xF800);
+            const __m256i surrogate = _mm256_set1_epi16((short) 0xD800);
+
+            while (len - idx >= 16) {
+                __m256i v = _mm256_loadu_si256((const __m256i *) (src + idx));
+                unsigned int surrogates = (unsigned int) _mm256_movemask_epi8(
+                        _mm256_cmpeq_epi16(_mm256_and_si256(v, surrogateBits), surrogate));
+
+                _mm256_storeu_si256((__m256i *) (dest + out), _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v)));
+                _mm256_storeu_si256((__m256i *) (dest + out + 8), _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1)));
+
+                if (surrogates == 0) {
+                    idx += 16;
+                    out += 16;
+                    continue;
+                }
+
+                size_t run = LowestBit(surrogates) / 2;
+                idx += run;
+                out += run;
+
+                if (!DecodeUtf16Range(src, idx, idx + 1, len, dest, out, policy, error_offset))
+                    return false;
+            }
+
+            // Finish the tail with the narrower kernel
+            return DecodeUtf16Sse2(src, len, idx, dest, out, policy, error_offset);
+        }
+#endif // EDO_X86
+
+        ///////////////////////////////////////////////
+        // Dispatch
+        ///////////////////////////////////////////////
+        size_t Utf8LengthOf(const utf32 *src, size_t len) {
+#ifdef EDO_X86
+            switch (GetSimdLevel()) {
+                case SimdAvx2:
+                    return Utf8LengthOfAvx2(src, len);
+                case SimdSse41:
+                case SimdSse2:
+                    return Utf8LengthOfSse2(src, len);
+                default:
+                    break;
+            }
+#endif
+            return Utf8LengthOfScalar(src, len);
+        }
+
+        size_t EncodeUtf8(const utf32 *src, size_t len, utf8 *dest, size_t dest_len) {
+#ifdef EDO_X86
+            switch (GetSimdLevel()) {
+                case SimdAvx2:
+                    return EncodeUtf8Avx2(src, len, dest, dest_len);
+                case SimdSse41:
+                    return EncodeUtf8Ssse3(src, len, dest, dest_len);
+                case SimdSse2:
+                    return EncodeUtf8Sse2(src, len, dest, dest_len);
+                default:
+                    break;
+            }
+#endif
+            size_t out = 0;
+            EncodeUtf8Range(src, 0, len, dest, dest_len, out);
+            return out;
+        }
+
+        size_t Utf32LengthOf(const utf8 *src, size_t len) {
+            size_t idx = 0;
+            size_t count = 0;
+
+#ifdef EDO_X86
+            switch (GetSimdLevel()) {
+                case SimdAvx2:
+                case SimdSse41:
+                    count = Utf32LengthOfSsse3(src, len, idx);
+                    break;
+                case SimdSse2:
+                    count = Utf32LengthOfSse2(src, len, idx);
+                    break;
+                default:
+                    break;
+            }
+#endif
+            return count + Utf32LengthOfRange(src, idx, len, len);
+        }
+
+        size_t DecodeUtf8(const utf8 *src, size_t len, utf32 *dest, EdoUtf8Policy policy, size_t *error_offset) {
+            size_t idx = 0;
+            size_t out = 0;
+            bool more = true;
+
+            if (error_offset)
+                *error_offset = UTF_NO_ERROR;
+
+#ifdef EDO_X86
+            switch (GetSimdLevel()) {
+                case SimdAvx2:
+                    more = DecodeUtf8Avx2(src, len, idx, dest, out, policy, error_offset);
+                    break;
+                case SimdSse41:
+                    more = DecodeUtf8Ssse3(src, len, idx, dest, out, policy, error_offset);
+                    break;
+                case SimdSse2:
+                    more = DecodeUtf8Sse2(src, len, idx, dest, out, policy, error_offset);
+                    break;
+                default:
+                    break;
+            }
+#endif
+            if (more)
+                DecodeUtf8Range(src, idx, len, len, dest, out, policy, error_offset);
+
+            return out;
+        }
+
+        bool ValidateUtf8(const utf8 *src, size_t len, size_t *error_offset) {
+            size_t idx = 0;
+
+            if (error_offset)
+                *error_offset = UTF_NO_ERROR;
+
+#ifdef EDO_X86
+            if (GetSimdLevel() >= SimdSse41) {
+                if (GetSimdLevel() == SimdAvx2)
+                    ValidateUtf8Avx2(src, len, idx);
+                else
+                    ValidateUtf8Ssse3(src, len, idx);
+
+                // Find the exact offset, or finish the tail, from the start of the sequence the blocks stopped in
+                idx = Utf8SequenceStart(src, idx);
+            }
+#endif
+            if (ValidateUtf8Range(src, idx, len, len))
+                return true;
+
+            if (error_offset)
+                *error_offset = idx;
+
+            return false;
+        }
+
+        size_t CountCodePoints(const utf8 *src, size_t len) {
+            size_t idx = 0;
+            size_t count = 0;
+
+#ifdef EDO_X86
+            switch (GetSimdLevel()) {
+                case SimdAvx2:
+                    count = CountCodePointsAvx2(src, len, idx);
+                    break;
+                case SimdSse41:
+                case SimdSse2:
+                    count = CountCodePointsSse2(src, len, idx);
+                    break;
+                default:
+                    break;
+            }
+#endif
+            return count + CountCodePointsScalar(src + idx, len - idx);
+        }
+
+        size_t Utf16LengthOf(const utf32 *src, size_t len) {
+#ifdef EDO_X86
+            if (GetSimdLevel() != SimdScalar)
+                return Utf16LengthOfSse2(src, len);
+#endif
+            return Utf16LengthOfScalar(src, len);
+        }
+
+        size_t EncodeUtf16(const utf32 *src, size_t len, utf16 *dest, size_t dest_len, EdoUtf16Policy policy,
+                           size_t *error_offset) {
+            size_t idx = 0;
+            size_t out = 0;
+            bool more = true;
+
+            if (error_offset)
+                *error_offset = UTF_NO_ERROR;
+
+#ifdef EDO_X86
+            switch (GetSimdLevel()) {
+                case SimdAvx2:
+                    more = EncodeUtf16Avx2(src, len, idx, dest, dest_len, out, policy, error_offset);
+                    break;
+                case SimdSse41:
+                case SimdSse2:
+                    more = EncodeUtf16Sse2(src, len, idx, dest, dest_len, out, policy, error_offset);
+                    break;
+                default:
+                    break;
+            }
+#endif
+            if (more)
+                EncodeUtf16Range(src, idx, len, dest, dest_len, out, policy, error_offset);
+
+            return out;
+        }
+
+        size_t Utf32LengthOf(const utf16 *src, size_t len) {
+            size_t idx = 0;
+            size_t pairs = 0;
+
+#ifdef EDO_X86
+            if (GetSimdLevel() != SimdScalar)
+                pairs = CountSurrogatePairsSse2(src, len, idx);
+#endif
+            pairs += CountSurrogatePairs(src, idx, len, len);
+            return len - pairs;
+        }
+
+        size_t DecodeUtf16(const utf16 *src, size_t len, utf32 *dest, EdoUtf16Policy policy, size_t *error_offset) {
+            size_t idx = 0;
+            size_t out = 0;
+            bool more = true;
+
+            if (error_offset)
+                *error_offset = UTF_NO_ERROR;
+
+#ifdef EDO_X86
+            switch (GetSimdLevel()) {
+                case SimdAvx2:
+                    more = DecodeUtf16Avx2(src, len, idx, dest, out, policy, error_offset);
+                    break;
+                case SimdSse41:
+                case SimdSse2:
+                    more = DecodeUtf16Sse2(src, len, idx, dest, out, policy, error_offset);
+                    break;
+                default:
+                    break;
+            }
+#endif
+            if (more)
+                DecodeUtf16Range(src, idx, len, len, dest, out, policy, error_offset);
+
+            return out;
+        }
+
+        size_t Utf32LengthOf(const wchar_t *src, size_t len) {
+            if (sizeof(wchar_t) == sizeof(utf16))
+                return Utf32LengthOf(reinterpret_cast<const utf16 *>(src), len);
+
+            size_t pairs = 0;
+
+            for (size_t i = 0; i + 1 < len; ++i) {
+                if (((utf32) src[i] & 0xFFFFFC00) == 0xD800 && ((utf32) src[i + 1] & 0xFFFFFC00) == 0xDC00) {
+                    ++pairs;
+                    ++i;
+                }
+            }
+
+            return len - pairs;
+        }
+
+        size_t DecodeWide(const wchar_t *src, size_t len, utf32 *dest) {
+            if (sizeof(wchar_t) == sizeof(utf16))
+                return DecodeUtf16(reinterpret_cast<const utf16 *>(src), len, dest, Utf16Keep);
+
+            // Already code points, only pairs left over from utf16 data need combining
+            size_t out = 0;
+
+            for (size_t i = 0; i < len; ++i) {
+                utf32 unit = (utf32) src[i];
+
+                if ((unit & 0xFFFFFC00) == 0xD800 && len - i >= 2 && ((utf32) src[i + 1] & 0xFFFFFC00) == 0xDC00) {
+                    unit = 0x10000 + ((unit - 0xD800) << 10) + ((utf32) src[i + 1] - 0xDC00);
+                    ++i;
+                }
+
+                dest[out++] = unit;
+            }
+
+            return out;
+        }
+    } // Namespace Types
+} // Namespace Edo
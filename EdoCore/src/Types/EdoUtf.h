@@ -0,0 +1,325 @@
+// =============================================================================
+// EdoUtf.h
+// Unicode transcoding kernels shared by the string classes
+// =============================================================================
+
+#ifndef EDOCORE_EDOUTF_H
+#define EDOCORE_EDOUTF_H
+
+#include "EdoBase.h"
+#include <cstddef>
+
+#define UTF_REPLACEMENT_CHAR 0xFFFD // Code point substituted for malformed input
+#define UTF_NO_ERROR ((size_t) -1) // Error offset reported when the input was well-formed
+
+namespace Edo {
+    namespace Types {
+        /***************************************
+         * Basic Types
+         ***************************************/
+        typedef unsigned char utf8;
+        typedef unsigned short utf16; // Not in CEGUI, see the utf16 transcoders below
+        typedef unsigned int utf32;
+
+        //////////////////////////////////////////////
+        // utf32 -> utf8
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * Return the number of utf8 code units needed to encode the given utf32 data
+         * \note
+         * Vectorized (SSE2 / AVX2, selected at runtime). Like the encoder, values of 0x10000 and above are counted as
+         * four code units without further validation
+         * \param src
+         * utf32 data to be measured
+         * \param len
+         * Number of code points in \a src
+         * \return
+         * Number of utf8 code units, not including a null terminator
+         */
+        EDO_API size_t Utf8LengthOf(const utf32 *src, size_t len);
+
+        /*!
+         * \brief
+         * Encodes utf32 data as utf8, with SSE2 / SSSE3 / AVX2 kernels selected at runtime. Blocks of ASCII are narrowed
+         * directly, BMP code points are encoded four at a time through a shuffle table, and code points outside the BMP
+         * one at a time
+         * \param src
+         * utf32 data to be encoded
+         * \param len
+         * Number of code points in \a src
+         * \param dest
+         * Buffer receiving the utf8 data. No null terminator is written, and the bytes past the returned count (up to
+         * \a dest_len) may be used as scratch space
+         * \param dest_len
+         * Size of \a dest in code units. Encoding stops before the first code point that does not fit completely
+         * \return
+         * Number of code units written to \a dest
+         */
+        EDO_API size_t EncodeUtf8(const utf32 *src, size_t len, utf8 *dest, size_t dest_len);
+
+        //////////////////////////////////////////////
+        // utf8 -> utf32
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * What the decoder does with malformed utf8 (truncated or overlong sequences, stray continuation bytes,
+         * surrogates, values above 0x10FFFF)
+         */
+        enum EdoUtf8Policy {
+            Utf8Replace, //!< Replace each maximal malformed subpart with UTF_REPLACEMENT_CHAR, as recommended by Unicode
+            Utf8Throw, //!< Throw std::invalid_argument
+            Utf8Stop //!< Stop decoding before the malformed sequence
+        };
+
+        /*!
+         * \brief
+         * Return the number of code points DecodeUtf8() produces for the given utf8 data with the Utf8Replace policy.
+         * For well-formed data this is the number of code points it holds
+         * \param src
+         * utf8 data to be measured
+         * \param len
+         * Number of code units in \a src
+         */
+        EDO_API size_t Utf32LengthOf(const utf8 *src, size_t len);
+
+        /*!
+         * \brief
+         * Decodes and validates utf8 data in a single pass, with SSE2 / SSSE3 / AVX2 kernels selected at runtime.
+         * Blocks of ASCII are widened directly, other blocks are validated 16 code units at a time and expanded
+         * through a shuffle table. Malformed data, and sequences of four code units, go through the scalar decoder
+         * \param src
+         * utf8 data to be decoded
+         * \param len
+         * Number of code units in \a src
+         * \param dest
+         * Buffer receiving the code points. It must have room for \a len code points (the worst case), no null
+         * terminator is written, and the room past the returned count may be used as scratch space
+         * \param policy
+         * What to do with malformed data
+         * \param error_offset
+         * If not null, receives the offset (in code units) of the first malformed sequence, or UTF_NO_ERROR
+         * \return
+         * Number of code points written to \a dest
+         * \exception std::invalid_argument
+         * Thrown if \a src is malformed and \a policy is Utf8Throw
+         */
+        EDO_API size_t DecodeUtf8(const utf8 *src, size_t len, utf32 *dest, EdoUtf8Policy policy = Utf8Replace,
+                                  size_t *error_offset = nullptr);
+
+        /*!
+         * \brief
+         * Decodes the single utf8 sequence at the start of \a src, the scalar step behind DecodeUtf8(). Lets callers
+         * that walk utf8 data themselves decode it the same way
+         * \param src
+         * utf8 data, starting with the sequence to be decoded
+         * \param avail
+         * Number of code units in \a src, at least 1
+         * \param cp
+         * Receives the code point when the sequence is well-formed
+         * \param bad
+         * Receives the length of the maximal malformed subpart (at least 1) when the sequence is malformed. The
+         * subpart is what DecodeUtf8() replaces with one UTF_REPLACEMENT_CHAR. If it runs to the end of \a src with
+         * a valid lead, the sequence is only truncated and may still be completed by more data
+         * \return
+         * Length of the sequence in code units, or 0 if it is malformed
+         */
+        inline size_t DecodeUtf8One(const utf8 *src, size_t avail, utf32 &cp, size_t &bad) {
+            utf8 lead = src[0];
+
+            if (lead < 0x80) {
+                cp = lead;
+                return 1;
+            }
+
+            // Continuation bytes, overlong two byte leads, and leads for values above 0x10FFFF
+            if (lead < 0xC2 || lead > 0xF4) {
+                bad = 1;
+                return 0;
+            }
+
+            // Range of the second code unit, narrower than 0x80 - 0xBF for the leads that could otherwise produce
+            // overlong forms, surrogates or values above 0x10FFFF
+            utf8 low = 0x80;
+            utf8 high = 0xBF;
+            size_t size;
+
+            if (lead < 0xE0) {
+                size = 2;
+                cp = lead & 0x1F;
+            } else if (lead < 0xF0) {
+                size = 3;
+                cp = lead & 0x0F;
+
+                if (lead == 0xE0)
+                    low = 0xA0;
+                else if (lead == 0xED)
+                    high = 0x9F;
+            } else {
+                size = 4;
+                cp = lead & 0x07;
+
+                if (lead == 0xF0)
+                    low = 0x90;
+                else if (lead == 0xF4)
+                    high = 0x8F;
+            }
+
+            for (size_t n = 1; n < size; ++n) {
+                if (n >= avail || src[n] < low || src[n] > high) {
+                    bad = n;
+                    return 0;
+                }
+
+                cp = (cp << 6) | (src[n] & 0x3F);
+                low = 0x80;
+                high = 0xBF;
+            }
+
+            return size;
+        }
+
+        //////////////////////////////////////////////
+        // utf8 validation and counting
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * Checks that the given data is well-formed utf8, e.g. a file or network payload before it is trusted, with
+         * SSSE3 / AVX2 kernels selected at runtime. Data is checked 64 code units at a time without being decoded, and
+         * runs of ASCII are skipped
+         * \param src
+         * utf8 data to be checked
+         * \param len
+         * Number of code units in \a src
+         * \param error_offset
+         * If not null, receives the offset (in code units) of the first malformed sequence, or UTF_NO_ERROR
+         * \return
+         * True if \a src is well-formed, the same data DecodeUtf8() decodes without replacing anything
+         */
+        EDO_API bool ValidateUtf8(const utf8 *src, size_t len, size_t *error_offset = nullptr);
+
+        /*!
+         * \brief
+         * Return the number of code points in well-formed utf8 data, counted as the code units that are not
+         * continuations (SSE2 / AVX2, selected at runtime)
+         * \note
+         * Malformed data is not detected. Use ValidateUtf8() first for untrusted data, or Utf32LengthOf(), which
+         * counts the code points DecodeUtf8() produces whatever the data holds
+         * \param src
+         * utf8 data to be counted
+         * \param len
+         * Number of code units in \a src
+         */
+        EDO_API size_t CountCodePoints(const utf8 *src, size_t len);
+
+        //////////////////////////////////////////////
+        // utf32 <-> utf16
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * What the utf16 transcoders do with data that has no utf16 form: unpaired surrogates in either direction,
+         * and values above 0x10FFFF in utf32 data
+         */
+        enum EdoUtf16Policy {
+            Utf16Replace, //!< Replace each offending code unit or code point with UTF_REPLACEMENT_CHAR
+            Utf16Throw, //!< Throw std::invalid_argument
+            Utf16Stop, //!< Stop before the offending code unit or code point
+            Utf16Keep //!< Pass unpaired surrogates through unchanged, so any utf16 data round trips. Values above
+                      //!< 0x10FFFF are replaced
+        };
+
+        /*!
+         * \brief
+         * Return the number of utf16 code units EncodeUtf16() produces for the given utf32 data with the Utf16Replace
+         * or Utf16Keep policy: two for each code point 0x10000..0x10FFFF, one for any other value
+         * \note
+         * Vectorized (SSE2 / AVX2, selected at runtime)
+         * \param src
+         * utf32 data to be measured
+         * \param len
+         * Number of code points in \a src
+         */
+        EDO_API size_t Utf16LengthOf(const utf32 *src, size_t len);
+
+        /*!
+         * \brief
+         * Encodes utf32 data as utf16, with SSE2 / AVX2 kernels selected at runtime. Blocks of BMP code points are
+         * narrowed directly, blocks holding other values go through the scalar encoder
+         * \param src
+         * utf32 data to be encoded
+         * \param len
+         * Number of code points in \a src
+         * \param dest
+         * Buffer receiving the utf16 data. No null terminator is written
+         * \param dest_len
+         * Size of \a dest in code units. Encoding stops before the first code point that does not fit completely
+         * \param policy
+         * What to do with surrogates and values above 0x10FFFF
+         * \param error_offset
+         * If not null, receives the index of the first code point with no utf16 form, or UTF_NO_ERROR
+         * \return
+         * Number of code units written to \a dest
+         * \exception std::invalid_argument
+         * Thrown if \a src holds a code point with no utf16 form and \a policy is Utf16Throw
+         */
+        EDO_API size_t EncodeUtf16(const utf32 *src, size_t len, utf16 *dest, size_t dest_len,
+                                   EdoUtf16Policy policy = Utf16Replace, size_t *error_offset = nullptr);
+
+        /*!
+         * \brief
+         * Return the number of code points DecodeUtf16() produces for the given utf16 data, which is the number of
+         * code units less the number of surrogate pairs
+         * \param src
+         * utf16 data to be measured
+         * \param len
+         * Number of code units in \a src
+         */
+        EDO_API size_t Utf32LengthOf(const utf16 *src, size_t len);
+
+        /*!
+         * \brief
+         * Decodes utf16 data, with SSE2 / AVX2 kernels selected at runtime. Blocks without surrogates are widened
+         * directly, the others go through the scalar decoder, which combines surrogate pairs
+         * \param src
+         * utf16 data to be decoded
+         * \param len
+         * Number of code units in \a src
+         * \param dest
+         * Buffer receiving the code points. It must have room for \a len code points (the worst case), no null
+         * terminator is written
+         * \param policy
+         * What to do with unpaired surrogates
+         * \param error_offset
+         * If not null, receives the offset (in code units) of the first unpaired surrogate, or UTF_NO_ERROR
+         * \return
+         * Number of code points written to \a dest
+         * \exception std::invalid_argument
+         * Thrown if \a src holds an unpaired surrogate and \a policy is Utf16Throw
+         */
+        EDO_API size_t DecodeUtf16(const utf16 *src, size_t len, utf32 *dest, EdoUtf16Policy policy = Utf16Replace,
+                                   size_t *error_offset = nullptr);
+
+        /*!
+         * \brief
+         * Return the number of code points DecodeWide() produces for the given wchar_t data
+         */
+        EDO_API size_t Utf32LengthOf(const wchar_t *src, size_t len);
+
+        /*!
+         * \brief
+         * Decodes wchar_t data, which is utf16 on Windows and utf32 elsewhere. Surrogate pairs are combined either way,
+         * unpaired surrogates are kept as they are (see Utf16Keep)
+         * \param src
+         * wchar_t data to be decoded
+         * \param len
+         * Number of wchar_t in \a src
+         * \param dest
+         * Buffer receiving the code points, with room for \a len of them. No null terminator is written
+         * \return
+         * Number of code points written to \a dest
+         */
+        EDO_API size_t DecodeWide(const wchar_t *src, size_t len, utf32 *dest);
+    } // Namespace Types
+} // Namespace Edo
+
+#endif // EDOCORE_EDOUTF_H
@@ -0,0 +1,500 @@
+// =============================================================================
+// EdoUtf8String.cpp
+// Implements the utf8 storage and code point index of EdoUtf8String
+// =============================================================================
+
+#include "EdoUtf8String.h"
+#include <iostream>
+
+namespace Edo {
+    namespace Types {
+        // Definition of 'no position' value
+        const EdoUtf8String::size_type EdoUtf8String::npos = (EdoUtf8String::size_type) (-1);
+
+        // Copy utf8 data into 'dest', replacing each maximal malformed subpart with the encoding of
+        // UTF_REPLACEMENT_CHAR, the same substitution DecodeUtf8() makes under Utf8Replace
+        static void RepairUtf8(const utf8 *src, size_t len, std::string &dest) {
+            dest.clear();
+            dest.reserve(len + 2);
+
+            for (size_t i = 0; i < len;) {
+                utf32 cp;
+                size_t bad;
+                size_t size = DecodeUtf8One(src + i, len - i, cp, bad);
+
+                if (size == 0) {
+                    dest.append("\xEF\xBF\xBD", 3);
+                    i += bad;
+                } else {
+                    dest.append((const char *) src + i, size);
+                    i += size;
+                }
+            }
+        }
+
+        ///////////////////////////////////////////////
+        // Destructor
+        ///////////////////////////////////////////////
+        EdoUtf8String::~EdoUtf8String() {
+            if (d_reserve > STR_UTF8_QUICKBUFF_SIZE)
+                delete[] d_buffer;
+
+            delete[] d_index;
+        }
+
+        ///////////////////////////////////////////////
+        // Buffer management
+        ///////////////////////////////////////////////
+        bool EdoUtf8String::Grow(EdoUtf8String::size_type new_size) {
+            // Check if too big
+            if (MaxSize() <= new_size)
+                throw std::length_error("Resulting EdoUtf8String would be too large");
+
+            // Increase, as we always null-terminate the buffer
+            ++new_size;
+
+            if (new_size > d_reserve) {
+                utf8 *temp = new utf8[new_size];
+
+                memcpy(temp, ptr(), d_byteLength + 1);
+
+                if (d_reserve > STR_UTF8_QUICKBUFF_SIZE)
+                    delete[] d_buffer;
+
+                d_buffer = temp;
+                d_reserve = new_size;
+
+                return true;
+            }
+
+            return false;
+        }
+
+        void EdoUtf8String::Trim() {
+            size_type min_size = d_byteLength + 1;
+
+            // Only re-allocate when not using quick-buffer, and when size can be trimmed
+            if (d_reserve > STR_UTF8_QUICKBUFF_SIZE && d_reserve > min_size) {
+                // See if we can trim to quick-buffer
+                if (min_size <= STR_UTF8_QUICKBUFF_SIZE) {
+                    memcpy(d_quickBuff, d_buffer, min_size);
+                    delete[] d_buffer;
+                    d_reserve = STR_UTF8_QUICKBUFF_SIZE;
+                } else {
+                    utf8 *temp = new utf8[min_size];
+                    memcpy(temp, d_buffer, min_size);
+                    delete[] d_buffer;
+                    d_buffer = temp;
+                    d_reserve = min_size;
+                }
+            }
+        }
+
+        void EdoUtf8String::Splice(EdoUtf8String::size_type cp_idx, EdoUtf8String::size_type byte_idx,
+                                   EdoUtf8String::size_type byte_len, const utf8 *src,
+                                   EdoUtf8String::size_type src_len) {
+            if (MaxSize() - (d_byteLength - byte_len) <= src_len)
+                throw std::length_error("Resulting EdoUtf8String would be too large");
+
+            // Every step through the buffer trusts lead bytes, so malformed data is repaired before it gets in
+            std::string temp;
+
+            if (!ValidateUtf8(src, src_len)) {
+                RepairUtf8(src, src_len, temp);
+                src = (const utf8 *) temp.data();
+                src_len = (size_type) temp.size();
+
+                if (MaxSize() - (d_byteLength - byte_len) <= src_len)
+                    throw std::length_error("Resulting EdoUtf8String would be too large");
+            } else if (src >= ptr() && src < ptr() + d_reserve) {
+                // The source lives inside our own buffer (e.g. str.Append(str)), which Grow() could free
+                temp.assign((const char *) src, src_len);
+                src = (const utf8 *) temp.data();
+            }
+
+            bool prefixAscii = IsAscii();
+            size_type newLen = d_byteLength - byte_len + src_len;
+
+            Grow(newLen);
+            memmove(&ptr()[byte_idx + src_len], &ptr()[byte_idx + byte_len], d_byteLength - byte_idx - byte_len);
+            memcpy(&ptr()[byte_idx], src, src_len);
+            SetLen(newLen);
+
+            // Entries before the edit are still valid, unless we never built them because the data was ASCII
+            Reindex(prefixAscii ? 0 : cp_idx);
+        }
+
+        void EdoUtf8String::Reindex(EdoUtf8String::size_type cp_idx) {
+            // Start from the last index entry that precedes the edit (d_cpLength still holds the old length here)
+            size_type entry = (cp_idx == 0) ? 0 : std::min(cp_idx, d_cpLength - 1) / STR_UTF8_INDEX_STRIDE;
+            size_type cp = entry * STR_UTF8_INDEX_STRIDE;
+            size_type byte = (entry == 0) ? 0 : d_index[entry];
+
+            // Count code points (every byte that is not a continuation byte) after the unchanged prefix
+            const utf8 *buf = ptr();
+            size_type count = cp;
+
+            for (size_type i = byte; i < d_byteLength; ++i)
+                count += (buf[i] & 0xC0) != 0x80;
+
+            d_cpLength = count;
+
+            // The data is well-formed, so it only holds ASCII when every byte is a code point of its own. Pure ASCII
+            // data does not need an index
+            d_ascii = (count == d_byteLength);
+
+            if (d_ascii)
+                return;
+
+            size_type entries = (d_cpLength + STR_UTF8_INDEX_STRIDE - 1) / STR_UTF8_INDEX_STRIDE;
+
+            if (entries > d_indexReserve) {
+                size_type *temp = new size_type[entries];
+
+                if (d_index != nullptr)
+                    memcpy(temp, d_index, (entry + 1) * sizeof(size_type));
+
+                delete[] d_index;
+                d_index = temp;
+                d_indexReserve = entries;
+            }
+
+            d_index[entry] = byte;
+
+            const utf8 *p = buf + byte;
+            const utf8 *end = buf + d_byteLength;
+
+            while (p < end) {
+                for (size_type n = 0; n < STR_UTF8_INDEX_STRIDE && p < end; ++n)
+                    p += SequenceLength(*p);
+
+                if (p < end)
+                    d_index[++entry] = (size_type) (p - buf);
+            }
+        }
+
+        ///////////////////////////////////////////////
+        // Index lookups
+        ///////////////////////////////////////////////
+        EdoUtf8String::size_type EdoUtf8String::ByteOffset(EdoUtf8String::size_type idx) const {
+            if (idx >= d_cpLength)
+                return d_byteLength;
+
+            if (IsAscii())
+                return idx;
+
+            const utf8 *buf = ptr();
+            const utf8 *p = buf + d_index[idx / STR_UTF8_INDEX_STRIDE];
+
+            for (size_type n = idx % STR_UTF8_INDEX_STRIDE; n != 0; --n)
+                p += SequenceLength(*p);
+
+            return (size_type) (p - buf);
+        }
+
+        EdoUtf8String::size_type EdoUtf8String::CodePointIndex(EdoUtf8String::size_type byte_idx) const {
+            if (byte_idx >= d_byteLength)
+                return d_cpLength;
+
+            if (IsAscii())
+                return byte_idx;
+
+            size_type entries = (d_cpLength + STR_UTF8_INDEX_STRIDE - 1) / STR_UTF8_INDEX_STRIDE;
+            size_type entry = (size_type) (std::upper_bound(d_index, d_index + entries, byte_idx) - d_index) - 1;
+            size_type cp = entry * STR_UTF8_INDEX_STRIDE;
+
+            const utf8 *buf = ptr();
+
+            for (size_type i = d_index[entry]; i < byte_idx; ++i)
+                cp += (buf[i] & 0xC0) != 0x80;
+
+            return cp;
+        }
+
+        ///////////////////////////////////////////////
+        // Comparison
+        ///////////////////////////////////////////////
+        int EdoUtf8String::Compare(const utf8 *utf8_str, EdoUtf8String::size_type str_len) const {
+            size_type len = (d_byteLength < str_len) ? d_byteLength : str_len;
+            int val = (len == 0) ? 0 : memcmp(ptr(), utf8_str, len);
+
+            return (val != 0) ? ((val < 0) ? -1 : 1) : (d_byteLength < str_len) ? -1 : (d_byteLength == str_len) ? 0
+                                                                                                                 : 1;
+        }
+
+        ///////////////////////////////////////////////
+        // Assignment and modification
+        ///////////////////////////////////////////////
+        EdoUtf8String &EdoUtf8String::Assign(const EdoUtf8String &str, EdoUtf8String::size_type str_idx,
+                                             EdoUtf8String::size_type str_num) {
+            if (str.d_cpLength < str_idx)
+                throw std::out_of_range("Index was out of range for EdoUtf8String");
+
+            if (str_num == npos || str_num > str.d_cpLength - str_idx)
+                str_num = str.d_cpLength - str_idx;
+
+            size_type begin = str.ByteOffset(str_idx);
+            size_type end = str.ByteOffset(str_idx + str_num);
+
+            return Replace(0, npos, str.Data() + begin, end - begin);
+        }
+
+        EdoUtf8String &EdoUtf8String::Assign(const EdoString &str) {
+            size_type len = str.Utf8StreamLen();
+
+            Grow(len);
+            str.Copy(ptr());
+            SetLen(len);
+
+            // Surrogates and values above 0x10FFFF in an EdoString encode to malformed utf8, so replace each of them
+            // with one UTF_REPLACEMENT_CHAR
+            if (!ValidateUtf8(ptr(), len)) {
+                std::string valid;
+                utf8 encoded[4];
+
+                for (EdoString::const_iterator iter = str.Begin(); iter != str.End(); ++iter) {
+                    utf32 cp = *iter;
+                    bool bad = (cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF;
+                    valid.append((const char *) encoded, EncodeAt(bad ? UTF_REPLACEMENT_CHAR : cp, encoded));
+                }
+
+                Clear();
+                return Replace(0, 0, (const utf8 *) valid.data(), (size_type) valid.size());
+            }
+
+            Reindex(0);
+
+            return *this;
+        }
+
+        void EdoUtf8String::Swap(EdoUtf8String &str) {
+            std::swap(d_cpLength, str.d_cpLength);
+            std::swap(d_byteLength, str.d_byteLength);
+            std::swap(d_reserve, str.d_reserve);
+            std::swap(d_index, str.d_index);
+            std::swap(d_indexReserve, str.d_indexReserve);
+            std::swap(d_ascii, str.d_ascii);
+            std::swap(d_buffer, str.d_buffer);
+
+            utf8 tempQbf[STR_UTF8_QUICKBUFF_SIZE];
+
+            memcpy(tempQbf, d_quickBuff, STR_UTF8_QUICKBUFF_SIZE);
+            memcpy(d_quickBuff, str.d_quickBuff, STR_UTF8_QUICKBUFF_SIZE);
+            memcpy(str.d_quickBuff, tempQbf, STR_UTF8_QUICKBUFF_SIZE);
+        }
+
+        EdoUtf8String &EdoUtf8String::Replace(EdoUtf8String::size_type idx, EdoUtf8String::size_type len,
+                                              const utf8 *utf8_str, EdoUtf8String::size_type str_len) {
+            if (d_cpLength < idx)
+                throw std::out_of_range("Index is out of range for EdoUtf8String");
+
+            if (str_len == npos)
+                throw std::length_error("Length for utf8 encoded string can not be 'npos'");
+
+            if (len == npos || len > d_cpLength - idx)
+                len = d_cpLength - idx;
+
+            size_type begin = ByteOffset(idx);
+            size_type end = ByteOffset(idx + len);
+
+            Splice(idx, begin, end - begin, utf8_str, str_len);
+            return *this;
+        }
+
+        EdoUtf8String &EdoUtf8String::Replace(EdoUtf8String::size_type idx, EdoUtf8String::size_type len,
+                                              EdoUtf8String::size_type num, utf32 code_point) {
+            if (num == npos)
+                throw std::length_error("Code point count can not be 'npos'");
+
+            utf8 encoded[4];
+            size_type encLen = EncodeAt(code_point, encoded);
+
+            std::string temp;
+            temp.reserve(num * encLen);
+
+            while (num--)
+                temp.append((const char *) encoded, encLen);
+
+            return Replace(idx, len, (const utf8 *) temp.data(), (size_type) temp.size());
+        }
+
+        ///////////////////////////////////////////////
+        // Searching
+        ///////////////////////////////////////////////
+        EdoUtf8String::size_type EdoUtf8String::FindBytes(const utf8 *needle, EdoUtf8String::size_type needle_len,
+                                                          EdoUtf8String::size_type from) const {
+            if (needle_len > d_byteLength || from > d_byteLength - needle_len)
+                return npos;
+
+            const utf8 *buf = ptr();
+            size_type last = d_byteLength - needle_len;
+
+            // utf8 is self-synchronizing, so a byte match of valid data always starts on a code point boundary
+            while (from <= last) {
+                const void *hit = memchr(buf + from, needle[0], last - from + 1);
+
+                if (hit == nullptr)
+                    return npos;
+
+                from = (size_type) ((const utf8 *) hit - buf);
+
+                if (memcmp(buf + from + 1, needle + 1, needle_len - 1) == 0)
+                    return from;
+
+                ++from;
+            }
+
+            return npos;
+        }
+
+        EdoUtf8String::size_type EdoUtf8String::RFindBytes(const utf8 *needle, EdoUtf8String::size_type needle_len,
+                                                           EdoUtf8String::size_type from) const {
+            if (needle_len > d_byteLength)
+                return npos;
+
+            if (from > d_byteLength - needle_len)
+                from = d_byteLength - needle_len;
+
+            const utf8 *buf = ptr();
+
+            do {
+                if (buf[from] == needle[0] && memcmp(buf + from + 1, needle + 1, needle_len - 1) == 0)
+                    return from;
+            } while (from-- != 0);
+
+            return npos;
+        }
+
+        EdoUtf8String::size_type EdoUtf8String::Find(utf32 code_point, EdoUtf8String::size_type idx) const {
+            if (idx >= d_cpLength)
+                return npos;
+
+            utf8 encoded[4];
+            size_type byte = FindBytes(encoded, EncodeAt(code_point, encoded), ByteOffset(idx));
+
+            return (byte == npos) ? npos : CodePointIndex(byte);
+        }
+
+        EdoUtf8String::size_type EdoUtf8String::RFind(utf32 code_point, EdoUtf8String::size_type idx) const {
+            if (d_cpLength == 0)
+                return npos;
+
+            if (idx >= d_cpLength)
+                idx = d_cpLength - 1;
+
+            utf8 encoded[4];
+            size_type byte = RFindBytes(encoded, EncodeAt(code_point, encoded), ByteOffset(idx));
+
+            return (byte == npos) ? npos : CodePointIndex(byte);
+        }
+
+        EdoUtf8String::size_type EdoUtf8String::Find(const utf8 *utf8_str, EdoUtf8String::size_type idx,
+                                                     EdoUtf8String::size_type str_len) const {
+            if (str_len == npos)
+                throw std::length_error("Length of utf8 encoded string can not be 'npos'");
+
+            if (idx >= d_cpLength)
+                return npos;
+
+            if (str_len == 0)
+                return idx;
+
+            size_type byte = FindBytes(utf8_str, str_len, ByteOffset(idx));
+
+            return (byte == npos) ? npos : CodePointIndex(byte);
+        }
+
+        EdoUtf8String::size_type EdoUtf8String::RFind(const utf8 *utf8_str, EdoUtf8String::size_type idx,
+                                                      EdoUtf8String::size_type str_len) const {
+            if (str_len == npos)
+                throw std::length_error("Length for utf8 encoded string can not be 'npos'");
+
+            if (str_len == 0)
+                return (idx < d_cpLength) ? idx : d_cpLength;
+
+            size_type byte = RFindBytes(utf8_str, str_len, ByteOffset(idx));
+
+            return (byte == npos) ? npos : CodePointIndex(byte);
+        }
+
+        ///////////////////////////////////////////////
+        // utf8 helpers
+        ///////////////////////////////////////////////
+        EdoUtf8String::size_type EdoUtf8String::EncodeAt(utf32 code_point, utf8 *dest) {
+            if (code_point < 0x80) {
+                dest[0] = (utf8) code_point;
+                return 1;
+            } else if (code_point < 0x0800) {
+                dest[0] = (utf8) ((code_point >> 6) | 0xC0);
+                dest[1] = (utf8) ((code_point & 0x3F) | 0x80);
+                return 2;
+            } else if (code_point < 0x10000) {
+                dest[0] = (utf8) ((code_point >> 12) | 0xE0);
+                dest[1] = (utf8) (((code_point >> 6) & 0x3F) | 0x80);
+                dest[2] = (utf8) ((code_point & 0x3F) | 0x80);
+                return 3;
+            }
+
+            dest[0] = (utf8) ((code_point >> 18) | 0xF0);
+            dest[1] = (utf8) (((code_point >> 12) & 0x3F) | 0x80);
+            dest[2] = (utf8) (((code_point >> 6) & 0x3F) | 0x80);
+            dest[3] = (utf8) ((code_point & 0x3F) | 0x80);
+            return 4;
+        }
+
+        ///////////////////////////////////////////////
+        // Comparison operators
+        ///////////////////////////////////////////////
+        bool operator==(const EdoUtf8String &str1, const EdoUtf8String &str2) {
+            return str1.ByteSize() == str2.ByteSize() && str1.Compare(str2) == 0;
+        }
+
+        bool operator==(const EdoUtf8String &str, const char *c_str) {
+            return str.Compare(c_str) == 0;
+        }
+
+        bool operator!=(const EdoUtf8String &str1, const EdoUtf8String &str2) {
+            return !(str1 == str2);
+        }
+
+        bool operator!=(const EdoUtf8String &str, const char *c_str) {
+            return str.Compare(c_str) != 0;
+        }
+
+        bool operator<(const EdoUtf8String &str1, const EdoUtf8String &str2) {
+            return str1.Compare(str2) < 0;
+        }
+
+        bool operator>(const EdoUtf8String &str1, const EdoUtf8String &str2) {
+            return str1.Compare(str2) > 0;
+        }
+
+        ///////////////////////////////////////////////
+        // Concatenation operator functions
+        ///////////////////////////////////////////////
+        EdoUtf8String operator+(const EdoUtf8String &str1, const EdoUtf8String &str2) {
+            EdoUtf8String temp(str1);
+            temp.Append(str2);
+            return temp;
+        }
+
+        EdoUtf8String operator+(const EdoUtf8String &str, const char *c_str) {
+            EdoUtf8String temp(str);
+            temp.Append(c_str);
+            return temp;
+        }
+
+        EdoUtf8String operator+(const char *c_str, const EdoUtf8String &str) {
+            EdoUtf8String temp(c_str);
+            temp.Append(str);
+            return temp;
+        }
+
+        ///////////////////////////////////////////////
+        // Output (stream) functions
+        ///////////////////////////////////////////////
+        std::ostream &operator<<(std::ostream &s, const EdoUtf8String &str) {
+            return s << str.c_str();
+        }
+    } // Namespace Types
+} // Namespace Edo
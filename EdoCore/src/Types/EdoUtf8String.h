@@ -0,0 +1,887 @@
+// =============================================================================
+// EdoUtf8String.h
+// Defines a string class that keeps UTF-8 as its canonical storage
+// =============================================================================
+
+#ifndef EDOCORE_EDOUTF8STRING_H
+#define EDOCORE_EDOUTF8STRING_H
+
+#include "EdoString.h"
+
+namespace Edo {
+    namespace Types {
+#define STR_UTF8_QUICKBUFF_SIZE 32 // In bytes, including the null terminator
+#define STR_UTF8_INDEX_STRIDE 64 // Number of code points between two entries of the code point index
+
+        /*!
+         * \brief
+         * Unicode string class which stores its contents as utf8 encoded data. This is a sibling of EdoString for
+         * mostly-ASCII text (UI labels, log lines, config values) where EdoString's utf32 storage costs four times the
+         * memory and every call to c_str() has to re-encode the data.
+         *
+         * Indices and lengths are in code points, as they are for EdoString. To keep random access cheap the class
+         * maintains a sparse index holding the byte offset of every STR_UTF8_INDEX_STRIDE-th code point. Pure ASCII
+         * strings need no index at all since byte and code point offsets are the same.
+         * \note
+         * Unlike EdoString, char arrays and std::string objects passed to this class are taken to be utf8 encoded data,
+         * not Latin-1 code points. Malformed input is repaired as it is stored, each maximal malformed subpart becoming
+         * one UTF_REPLACEMENT_CHAR (the Utf8Replace policy), so the buffer only ever holds well-formed utf8.
+         */
+        class EDO_API EdoUtf8String {
+        public:
+            /***************************************
+             * Integral types
+             ***************************************/
+            typedef utf32 value_type; //!< Basic 'code point' type returned by EdoUtf8String (utf32)
+            typedef size_t size_type; //!< Unsigned type used for size values and indices
+            typedef std::ptrdiff_t difference_type; //!< Signed type used for differences
+
+            static const size_type npos; //!< Value used to represent 'not found' conditions and 'all code points' etc.
+
+        private:
+            /***************************************
+             * Implementation data
+             ***************************************/
+            size_type d_cpLength; //!< Length of the string in code points (not including null termination)
+            size_type d_byteLength; //!< Length of the string in utf8 code units (not including null termination)
+            size_type d_reserve; //!< Byte reserve size (currently allocated buffer size in bytes)
+
+            size_type *d_index; //!< Byte offset of every STR_UTF8_INDEX_STRIDE-th code point (unused for ASCII data)
+            size_type d_indexReserve; //!< Number of entries allocated for d_index
+            bool d_ascii; //!< True when every code point is in 0x00 - 0x7F (so d_index is unused)
+
+            utf8 d_quickBuff[STR_UTF8_QUICKBUFF_SIZE]; //!< Integrated 'quick' buffer to save allocations for small strings
+            utf8 *d_buffer; //!< Pointer to the main buffer memory. Only valid when the quick-buffer is not being used
+
+        public:
+            /***************************************
+             * Iterator classes
+             ***************************************/
+            //! Bidirectional const iterator over the code points of an EdoUtf8String
+            class const_iterator : public std::iterator<std::bidirectional_iterator_tag, utf32, difference_type,
+                    const utf32 *, utf32> {
+            public:
+                const utf8 *d_ptr;
+
+                const_iterator() : d_ptr(nullptr) {}
+
+                explicit const_iterator(const utf8 *const ptr) : d_ptr(ptr) {}
+
+                utf32 operator*() const { return DecodeAt(d_ptr); }
+
+                const_iterator &operator++() {
+                    d_ptr += SequenceLength(*d_ptr);
+                    return *this;
+                }
+
+                const_iterator operator++(int) {
+                    const_iterator temp = *this;
+                    ++*this;
+                    return temp;
+                }
+
+                const_iterator &operator--() {
+                    do {
+                        --d_ptr;
+                    } while ((*d_ptr & 0xC0) == 0x80);
+
+                    return *this;
+                }
+
+                const_iterator operator--(int) {
+                    const_iterator temp = *this;
+                    --*this;
+                    return temp;
+                }
+
+                friend bool operator==(const const_iterator &lhs, const const_iterator &rhs) {
+                    return lhs.d_ptr == rhs.d_ptr;
+                }
+
+                friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs) {
+                    return lhs.d_ptr != rhs.d_ptr;
+                }
+            };
+
+            /*!
+             * \brief
+             * Constant reverse iterator class for EdoUtf8String objects
+             */
+            typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+        public:
+            //////////////////////////////////////////////
+            // Construction and destruction
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Constructs an empty string
+             */
+            EdoUtf8String() { Init(); }
+
+            /*!
+             * \brief
+             * Destructor for EdoUtf8String objects
+             */
+            ~EdoUtf8String();
+
+            /*!
+             * \brief
+             * Copy constructor - Creates a new string with the same value as \a str
+             * \param str
+             * EdoUtf8String object used to initialize the newly created string
+             */
+            EdoUtf8String(const EdoUtf8String &str) {
+                Init();
+                Assign(str);
+            }
+
+            /*!
+             * \brief
+             * Constructs a new string initialized with code points from another EdoUtf8String object
+             * \param str
+             * EdoUtf8String object used to initialize the newly created string
+             * \param str_idx
+             * Starting code point of \a str to be used when initializing the new string
+             * \param str_num
+             * Maximum number of code points from \a str that are to be assigned to the new string
+             * \exception
+             * std::out_of_range Thrown if \a str_idx is invalid for \a str
+             */
+            EdoUtf8String(const EdoUtf8String &str, size_type str_idx, size_type str_num = npos) {
+                Init();
+                Assign(str, str_idx, str_num);
+            }
+
+            /*!
+             * \brief
+             * Constructs a new string from the utf8 encoded contents of the std::string \a std_str
+             * \param std_str
+             * The std::string holding utf8 encoded data
+             */
+            EdoUtf8String(const std::string &std_str) {
+                Init();
+                Assign(std_str);
+            }
+
+            /*!
+             * \brief
+             * Constructs a new string from the given null-terminated utf8 encoded buffer
+             * \param utf8_str
+             * Pointer to a buffer containing a null-terminated Unicode string encoded as utf8 data
+             */
+            EdoUtf8String(const utf8 *utf8_str) {
+                Init();
+                Assign(utf8_str);
+            }
+
+            /*!
+             * \brief
+             * Constructs a new string from the given utf8 encoded buffer
+             * \param utf8_str
+             * Pointer to a buffer containing Unicode data encoded as utf8
+             * \param str_len
+             * Length of the buffer in utf8 code units (not code points)
+             */
+            EdoUtf8String(const utf8 *utf8_str, size_type str_len) {
+                Init();
+                Assign(utf8_str, str_len);
+            }
+
+            /*!
+             * \brief
+             * Constructs a new string from the given null-terminated c-string, which is taken to be utf8 encoded
+             * \param cstr
+             * Pointer to a c-string
+             */
+            EdoUtf8String(const char *cstr) {
+                Init();
+                Assign(cstr);
+            }
+
+            /*!
+             * \brief
+             * Constructs a new string from the given char array, which is taken to be utf8 encoded
+             * \param chars
+             * Char array
+             * \param chars_len
+             * Number of chars from the array to be used
+             */
+            EdoUtf8String(const char *chars, size_type chars_len) {
+                Init();
+                Assign(chars, chars_len);
+            }
+
+            /*!
+             * \brief
+             * Constructs a new string holding \a num copies of the given code point
+             * \param num
+             * The number of times \a code_point is to be put into the new string
+             * \param code_point
+             * The Unicode code point to be used when initializing the string
+             */
+            EdoUtf8String(size_type num, utf32 code_point) {
+                Init();
+                Assign(num, code_point);
+            }
+
+            /*!
+             * \brief
+             * Constructs a new string from the contents of an EdoString object
+             * \param str
+             * EdoString object used to initialize the newly created string
+             */
+            explicit EdoUtf8String(const EdoString &str) {
+                Init();
+                Assign(str);
+            }
+
+            //////////////////////////////////////////////
+            // Size operations
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Returns the size of the string in code points
+             */
+            size_type Size() const { return d_cpLength; }
+
+            /*!
+             * \brief
+             * Returns the size of the string in code points
+             */
+            size_type Length() const { return d_cpLength; }
+
+            /*!
+             * \brief
+             * Returns the size of the string in utf8 code units (bytes), not including the null terminator
+             */
+            size_type ByteSize() const { return d_byteLength; }
+
+            /*!
+             * \brief
+             * Returns true if the string is empty
+             */
+            bool Empty() const { return d_cpLength == 0; }
+
+            /*!
+             * \brief
+             * Returns true if the string only holds code points 0x00 - 0x7F, in which case code point and byte
+             * offsets are identical
+             */
+            bool IsAscii() const { return d_ascii; }
+
+            /*!
+             * \brief
+             * Returns the maximum size of an EdoUtf8String in bytes
+             */
+            size_type MaxSize() const { return ((size_type) -1) / 2; }
+
+            /*!
+             * \brief
+             * Return the number of bytes the string could hold before a re-allocation would be required
+             */
+            size_type Capacity() const { return d_reserve - 1; }
+
+            /*!
+             * \brief
+             * Reserve internal memory for at least \a num bytes. If \a num is 0, the request is shrink-to-fit
+             * \exception
+             * std::length_error Thrown if resulting string would be too big
+             */
+            void Reserve(size_type num = 0) {
+                if (num == 0)
+                    Trim();
+                else
+                    Grow(num);
+            }
+
+            //////////////////////////////////////////////
+            // Comparisons
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Compares this string with the string \a str. Comparing utf8 data byte-wise yields the same ordering as
+             * comparing code points.
+             * \return
+             * - 0 if the strings are equal
+             * - <0 if this string is lexicographically smaller than \a str
+             * - >0 if this string is lexicographically greater than \a str
+             */
+            int Compare(const EdoUtf8String &str) const { return Compare(str.Data(), str.d_byteLength); }
+
+            /*!
+             * \brief
+             * Compares this string with the null-terminated utf8 encoded c-string \a cstr
+             */
+            int Compare(const char *cstr) const { return Compare((const utf8 *) cstr, strlen(cstr)); }
+
+            /*!
+             * \brief
+             * Compares this string with \a str_len bytes of utf8 encoded data
+             * \param utf8_str
+             * Buffer containing utf8 encoded data
+             * \param str_len
+             * Length of the buffer in utf8 code units (not code points)
+             */
+            int Compare(const utf8 *utf8_str, size_type str_len) const;
+
+            //////////////////////////////////////////////
+            // Character access
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Returns the code point at the given index
+             * \param idx
+             * Zero based index of the code point to be returned
+             * \note
+             * Code points can not be written through this operator since their encoded length may differ. Use Replace()
+             * instead.
+             */
+            value_type operator[](size_type idx) const { return DecodeAt(&ptr()[ByteOffset(idx)]); }
+
+            /*!
+             * \brief
+             * Returns the code point at the given index
+             * \exception
+             * std::out_of_range Thrown if \a idx is >= Length()
+             */
+            value_type At(size_type idx) const {
+                if (d_cpLength <= idx)
+                    throw std::out_of_range("Index is out of range for EdoUtf8String");
+
+                return (*this)[idx];
+            }
+
+            //////////////////////////////////////////////
+            // C-Strings and arrays
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Returns contents of the string as a null terminated string of utf8 encoded data. This is the native
+             * storage of the string, so no encoding takes place.
+             * \note
+             * Any function that modifies the string data will invalidate the buffer returned by this call.
+             */
+            const char *c_str() const { return (const char *) ptr(); }
+
+            /*!
+             * \brief
+             * Returns contents of the string as null terminated utf8 encoded data.
+             * \note
+             * Any function that modifies the string data will invalidate the buffer returned by this call.
+             */
+            const utf8 *Data() const { return ptr(); }
+
+            /*!
+             * \brief
+             * Returns the byte offset of the code point at index \a idx. \a idx may equal Length(), in which case
+             * ByteSize() is returned.
+             */
+            size_type ByteOffset(size_type idx) const;
+
+            /*!
+             * \brief
+             * Returns the index of the code point starting at byte offset \a byte_idx
+             */
+            size_type CodePointIndex(size_type byte_idx) const;
+
+            //////////////////////////////////////////////
+            // Assignment Functions
+            //////////////////////////////////////////////
+            EdoUtf8String &operator=(const EdoUtf8String &str) { return Assign(str); }
+
+            EdoUtf8String &operator=(const std::string &std_str) { return Assign(std_str); }
+
+            EdoUtf8String &operator=(const utf8 *utf8_str) { return Assign(utf8_str); }
+
+            EdoUtf8String &operator=(const char *cstr) { return Assign(cstr); }
+
+            EdoUtf8String &operator=(utf32 code_point) { return Assign(1, code_point); }
+
+            /*!
+             * \brief
+             * Assign a sub-string of \a str to this string
+             * \param str
+             * String object containing the data to be assigned
+             * \param str_idx
+             * Index of the first code point in \a str that is to be assigned
+             * \param str_num
+             * Maximum number of code points from \a str that are to be assigned
+             * \exception
+             * std::out_of_range Thrown if \a str_idx is invalid for \a str
+             */
+            EdoUtf8String &Assign(const EdoUtf8String &str, size_type str_idx = 0, size_type str_num = npos);
+
+            /*!
+             * \brief
+             * Assign the utf8 encoded contents of the std::string \a std_str to this string
+             */
+            EdoUtf8String &Assign(const std::string &std_str) {
+                return Assign((const utf8 *) std_str.data(), (size_type) std_str.size());
+            }
+
+            /*!
+             * \brief
+             * Assign the null-terminated utf8 encoded data \a utf8_str to this string
+             */
+            EdoUtf8String &Assign(const utf8 *utf8_str) { return Assign(utf8_str, strlen((const char *) utf8_str)); }
+
+            /*!
+             * \brief
+             * Assign \a str_len bytes of utf8 encoded data to this string
+             * \exception
+             * std::length_error Thrown if \a str_len is 'npos' or the string would be too large
+             */
+            EdoUtf8String &Assign(const utf8 *utf8_str, size_type str_len) {
+                return Replace(0, npos, utf8_str, str_len);
+            }
+
+            /*!
+             * \brief
+             * Assign the null-terminated utf8 encoded c-string \a cstr to this string
+             */
+            EdoUtf8String &Assign(const char *cstr) { return Assign((const utf8 *) cstr, strlen(cstr)); }
+
+            /*!
+             * \brief
+             * Assign \a chars_len chars of utf8 encoded data to this string
+             */
+            EdoUtf8String &Assign(const char *chars, size_type chars_len) {
+                return Assign((const utf8 *) chars, chars_len);
+            }
+
+            /*!
+             * \brief
+             * Assigns the code point \a code_point repeatedly to this string
+             * \exception
+             * std::length_error Thrown if \a num was 'npos'
+             */
+            EdoUtf8String &Assign(size_type num, utf32 code_point) {
+                return Replace(0, npos, num, code_point);
+            }
+
+            /*!
+             * \brief
+             * Assign the contents of an EdoString object to this string
+             */
+            EdoUtf8String &Assign(const EdoString &str);
+
+            /*!
+             * \brief
+             * Swap the contents of this string with \a str
+             */
+            void Swap(EdoUtf8String &str);
+
+            //////////////////////////////////////////////
+            // Appending Functions
+            //////////////////////////////////////////////
+            EdoUtf8String &operator+=(const EdoUtf8String &str) { return Append(str); }
+
+            EdoUtf8String &operator+=(const std::string &std_str) { return Append(std_str); }
+
+            EdoUtf8String &operator+=(const utf8 *utf8_str) { return Append(utf8_str); }
+
+            EdoUtf8String &operator+=(const char *cstr) { return Append(cstr); }
+
+            EdoUtf8String &operator+=(utf32 code_point) { return Append(1, code_point); }
+
+            /*!
+             * \brief
+             * Appends the string \a str
+             */
+            EdoUtf8String &Append(const EdoUtf8String &str) {
+                return Insert(d_cpLength, str.Data(), str.d_byteLength);
+            }
+
+            /*!
+             * \brief
+             * Appends the utf8 encoded contents of the std::string \a std_str
+             */
+            EdoUtf8String &Append(const std::string &std_str) {
+                return Insert(d_cpLength, (const utf8 *) std_str.data(), (size_type) std_str.size());
+            }
+
+            /*!
+             * \brief
+             * Appends the null-terminated utf8 encoded data \a utf8_str
+             */
+            EdoUtf8String &Append(const utf8 *utf8_str) {
+                return Insert(d_cpLength, utf8_str, strlen((const char *) utf8_str));
+            }
+
+            /*!
+             * \brief
+             * Appends \a str_len bytes of utf8 encoded data
+             */
+            EdoUtf8String &Append(const utf8 *utf8_str, size_type str_len) {
+                return Insert(d_cpLength, utf8_str, str_len);
+            }
+
+            /*!
+             * \brief
+             * Appends the null-terminated utf8 encoded c-string \a cstr
+             */
+            EdoUtf8String &Append(const char *cstr) {
+                return Insert(d_cpLength, (const utf8 *) cstr, strlen(cstr));
+            }
+
+            /*!
+             * \brief
+             * Appends \a num copies of the code point \a code_point
+             */
+            EdoUtf8String &Append(size_type num, utf32 code_point) {
+                return Insert(d_cpLength, num, code_point);
+            }
+
+            /*!
+             * \brief
+             * Appends a single code point to the string
+             */
+            void PushBack(utf32 code_point) { Append(1, code_point); }
+
+            //////////////////////////////////////////////
+            // Insertion Functions
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Inserts the string \a str at code point index \a idx
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this string
+             */
+            EdoUtf8String &Insert(size_type idx, const EdoUtf8String &str) {
+                return Insert(idx, str.Data(), str.d_byteLength);
+            }
+
+            /*!
+             * \brief
+             * Inserts \a str_len bytes of utf8 encoded data at code point index \a idx
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this string
+             * \exception
+             * std::length_error Thrown if \a str_len is 'npos' or the string would be too large
+             */
+            EdoUtf8String &Insert(size_type idx, const utf8 *utf8_str, size_type str_len) {
+                return Replace(idx, 0, utf8_str, str_len);
+            }
+
+            /*!
+             * \brief
+             * Inserts \a num copies of the code point \a code_point at code point index \a idx
+             */
+            EdoUtf8String &Insert(size_type idx, size_type num, utf32 code_point) {
+                return Replace(idx, 0, num, code_point);
+            }
+
+            //////////////////////////////////////////////
+            // Erasing characters
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Removes all data from the string
+             */
+            void Clear() {
+                SetLen(0);
+                d_cpLength = 0;
+                d_ascii = true;
+                Trim();
+            }
+
+            /*!
+             * \brief
+             * Erase a range of code points
+             * \param idx
+             * Index of the first code point to be removed
+             * \param len
+             * Maximum number of code points to be removed
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this string
+             */
+            EdoUtf8String &Erase(size_type idx, size_type len = npos) {
+                if (len == 0)
+                    return *this;
+
+                if (d_cpLength <= idx)
+                    throw std::out_of_range("Index is out of range for EdoUtf8String");
+
+                return Replace(idx, len, (const utf8 *) "", 0);
+            }
+
+            //////////////////////////////////////////////
+            // Replacing Characters
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Replace code points in the string with the string \a str
+             * \param idx
+             * Index of the first code point to be replaced
+             * \param len
+             * Maximum number of code points to be replaced (if this is 0, the operation is an insert)
+             */
+            EdoUtf8String &Replace(size_type idx, size_type len, const EdoUtf8String &str) {
+                return Replace(idx, len, str.Data(), str.d_byteLength);
+            }
+
+            /*!
+             * \brief
+             * Replace code points in the string with \a str_len bytes of utf8 encoded data
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this string
+             * \exception
+             * std::length_error Thrown if \a str_len is 'npos' or the string would be too large
+             */
+            EdoUtf8String &Replace(size_type idx, size_type len, const utf8 *utf8_str, size_type str_len);
+
+            /*!
+             * \brief
+             * Replace code points in the string with \a num copies of the code point \a code_point
+             * \exception
+             * std::length_error Thrown if \a num is 'npos' or the string would be too large
+             */
+            EdoUtf8String &Replace(size_type idx, size_type len, size_type num, utf32 code_point);
+
+            //////////////////////////////////////////////
+            // Searching
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Search forwards for a given code point
+             * \return
+             * Index of the first occurrence of \a code_point at or after \a idx, or npos if none
+             */
+            size_type Find(utf32 code_point, size_type idx = 0) const;
+
+            /*!
+             * \brief
+             * Search backwards for a given code point
+             * \return
+             * Index of the last occurrence of \a code_point at or before \a idx, or npos if none
+             */
+            size_type RFind(utf32 code_point, size_type idx = npos) const;
+
+            /*!
+             * \brief
+             * Search forwards for a sub-string
+             * \return
+             * Index of the first occurrence of \a str at or after \a idx, or npos if none
+             */
+            size_type Find(const EdoUtf8String &str, size_type idx = 0) const {
+                return Find(str.Data(), idx, str.d_byteLength);
+            }
+
+            /*!
+             * \brief
+             * Search forwards for the null-terminated utf8 encoded c-string \a cstr
+             */
+            size_type Find(const char *cstr, size_type idx = 0) const {
+                return Find((const utf8 *) cstr, idx, strlen(cstr));
+            }
+
+            /*!
+             * \brief
+             * Search forwards for \a str_len bytes of utf8 encoded data
+             */
+            size_type Find(const utf8 *utf8_str, size_type idx, size_type str_len) const;
+
+            /*!
+             * \brief
+             * Search backwards for a sub-string
+             * \return
+             * Index of the last occurrence of \a str starting at or before \a idx, or npos if none
+             */
+            size_type RFind(const EdoUtf8String &str, size_type idx = npos) const {
+                return RFind(str.Data(), idx, str.d_byteLength);
+            }
+
+            /*!
+             * \brief
+             * Search backwards for the null-terminated utf8 encoded c-string \a cstr
+             */
+            size_type RFind(const char *cstr, size_type idx = npos) const {
+                return RFind((const utf8 *) cstr, idx, strlen(cstr));
+            }
+
+            /*!
+             * \brief
+             * Search backwards for \a str_len bytes of utf8 encoded data
+             */
+            size_type RFind(const utf8 *utf8_str, size_type idx, size_type str_len) const;
+
+            //////////////////////////////////////////////
+            // Substring and conversion
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Returns a substring of this string
+             * \exception
+             * std::out_of_range Thrown if \a idx is invalid for this string
+             */
+            EdoUtf8String Substr(size_type idx = 0, size_type len = npos) const {
+                return EdoUtf8String(*this, idx, len);
+            }
+
+            /*!
+             * \brief
+             * Returns the contents of this string as an EdoString object
+             */
+            EdoString ToEdoString() const { return EdoString(Data(), d_byteLength); }
+
+            //////////////////////////////////////////////
+            // Iterator creation
+            //////////////////////////////////////////////
+            const_iterator Begin() const { return const_iterator(ptr()); }
+
+            const_iterator End() const { return const_iterator(ptr() + d_byteLength); }
+
+            const_reverse_iterator RBegin() const { return const_reverse_iterator(End()); }
+
+            const_reverse_iterator REnd() const { return const_reverse_iterator(Begin()); }
+
+            //////////////////////////////////////////////
+            // utf8 helpers
+            //////////////////////////////////////////////
+            /*!
+             * \brief
+             * Returns the number of bytes of the utf8 sequence started by the lead byte \a lead
+             */
+            static size_type SequenceLength(utf8 lead) {
+                return (lead < 0x80) ? 1 : (lead < 0xE0) ? 2 : (lead < 0xF0) ? 3 : 4;
+            }
+
+            /*!
+             * \brief
+             * Decodes the utf8 sequence starting at \a src
+             */
+            static utf32 DecodeAt(const utf8 *src) {
+                utf8 cu = src[0];
+
+                if (cu < 0x80)
+                    return cu;
+                else if (cu < 0xE0)
+                    return ((cu & 0x1F) << 6) | (src[1] & 0x3F);
+                else if (cu < 0xF0)
+                    return ((cu & 0x0F) << 12) | ((src[1] & 0x3F) << 6) | (src[2] & 0x3F);
+
+                return ((cu & 0x07) << 18) | ((src[1] & 0x3F) << 12) | ((src[2] & 0x3F) << 6) | (src[3] & 0x3F);
+            }
+
+            /*!
+             * \brief
+             * Encodes \a code_point as utf8 into \a dest, which must hold at least 4 bytes
+             * \return
+             * Number of bytes written
+             */
+            static size_type EncodeAt(utf32 code_point, utf8 *dest);
+
+        private:
+            //////////////////////////////////////////////
+            // Implementation Functions
+            //////////////////////////////////////////////
+            // Initialize EdoUtf8String object
+            void Init() {
+                d_reserve = STR_UTF8_QUICKBUFF_SIZE;
+                d_buffer = nullptr;
+                d_index = nullptr;
+                d_indexReserve = 0;
+                d_cpLength = 0;
+                d_ascii = true;
+                SetLen(0);
+            }
+
+            utf8 *ptr() { return (d_reserve > STR_UTF8_QUICKBUFF_SIZE) ? d_buffer : d_quickBuff; }
+
+            const utf8 *ptr() const { return (d_reserve > STR_UTF8_QUICKBUFF_SIZE) ? d_buffer : d_quickBuff; }
+
+            // Set the byte length of the string and terminate it (will not re-allocate, use Grow() first)
+            void SetLen(size_type len) {
+                d_byteLength = len;
+                ptr()[len] = (utf8) 0;
+            }
+
+            // Change size of allocated buffer so it is at least 'new_size' bytes. Never shrinks (see Trim())
+            bool Grow(size_type new_size);
+
+            // Perform re-allocation to remove wasted space
+            void Trim();
+
+            // Replace 'byte_len' bytes at 'byte_idx' with 'src_len' bytes from 'src', repairing them if malformed.
+            // 'cp_idx' is the code point index of 'byte_idx', used to keep the unchanged part of the code point index
+            void Splice(size_type cp_idx, size_type byte_idx, size_type byte_len, const utf8 *src, size_type src_len);
+
+            // Recount code points and rebuild the code point index starting from code point 'cp_idx'
+            void Reindex(size_type cp_idx);
+
+            // Return the byte offset of the first occurrence of 'needle' at or after byte 'from', or npos
+            size_type FindBytes(const utf8 *needle, size_type needle_len, size_type from) const;
+
+            // Return the byte offset of the last occurrence of 'needle' starting at or before byte 'from', or npos
+            size_type RFindBytes(const utf8 *needle, size_type needle_len, size_type from) const;
+        };
+
+        //////////////////////////////////////////////
+        // Comparison operators
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * Return true if EdoUtf8String \a str1 is equal to EdoUtf8String \a str2
+         */
+        bool EDO_API operator==(const EdoUtf8String &str1, const EdoUtf8String &str2);
+
+        /*!
+         * \brief
+         * Return true if EdoUtf8String \a str is equal to utf8 encoded c-string \a c_str
+         */
+        bool EDO_API operator==(const EdoUtf8String &str, const char *c_str);
+
+        /*!
+         * \brief
+         * Return true if EdoUtf8String \a str1 is not equal to EdoUtf8String \a str2
+         */
+        bool EDO_API operator!=(const EdoUtf8String &str1, const EdoUtf8String &str2);
+
+        /*!
+         * \brief
+         * Return true if EdoUtf8String \a str is not equal to utf8 encoded c-string \a c_str
+         */
+        bool EDO_API operator!=(const EdoUtf8String &str, const char *c_str);
+
+        /*!
+         * \brief
+         * Return true if EdoUtf8String \a str1 is lexicographically less than EdoUtf8String \a str2
+         */
+        bool EDO_API operator<(const EdoUtf8String &str1, const EdoUtf8String &str2);
+
+        /*!
+         * \brief
+         * Return true if EdoUtf8String \a str1 is lexicographically greater than EdoUtf8String \a str2
+         */
+        bool EDO_API operator>(const EdoUtf8String &str1, const EdoUtf8String &str2);
+
+        //////////////////////////////////////////////
+        // Concatenation operator functions
+        //////////////////////////////////////////////
+        /*!
+         * \brief
+         * Return EdoUtf8String object that is the concatenation of \a str1 and \a str2
+         */
+        EdoUtf8String EDO_API operator+(const EdoUtf8String &str1, const EdoUtf8String &str2);
+
+        /*!
+         * \brief
+         * Return EdoUtf8String object that is the concatenation of \a str and the utf8 encoded c-string \a c_str
+         */
+        EdoUtf8String EDO_API operator+(const EdoUtf8String &str, const char *c_str);
+
+        /*!
+         * \brief
+         * Return EdoUtf8String object that is the concatenation of the utf8 encoded c-string \a c_str and \a str
+         */
+        EdoUtf8String EDO_API operator+(const char *c_str, const EdoUtf8String &str);
+
+        //////////////////////////////////////////////
+        // Output (stream) functions
+        //////////////////////////////////////////////
+        EDO_API std::ostream &operator<<(std::ostream &s, const EdoUtf8String &str);
+    } // Namespace Types
+} // Namespace Edo
+
+#endif // EDOCORE_EDOUTF8STRING_H
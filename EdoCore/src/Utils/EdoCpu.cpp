@@ -0,0 +1,87 @@
+// =============================================================================
+// EdoCpu.cpp
+// Implements the CPU feature detection
+// =============================================================================
+
+#include "EdoCpu.h"
+#include <atomic>
+
+#if defined(EDO_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace Edo {
+    namespace Utils {
+        // Selected level, -1 until the first call to GetSimdLevel()
+        static std::atomic<int> s_simdLevel(-1);
+
+        static EdoCpuFeatures DetectCpuFeatures() {
+            EdoCpuFeatures features = {false, false, false, false};
+
+#if defined(EDO_X86) && defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            int maxLeaf = info[0];
+
+            __cpuid(info, 1);
+            features.sse2 = (info[3] & (1 << 26)) != 0;
+            features.ssse3 = (info[2] & (1 << 9)) != 0;
+            features.sse41 = (info[2] & (1 << 19)) != 0;
+
+            // AVX state has to be enabled by the OS (OSXSAVE + XCR0 bits 1 and 2) before AVX2 can be used
+            bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+
+            if (osAvx && maxLeaf >= 7) {
+                __cpuidex(info, 7, 0);
+                features.avx2 = (info[1] & (1 << 5)) != 0;
+            }
+#elif defined(EDO_X86)
+            // The builtins also check that the OS saves the AVX registers
+            __builtin_cpu_init();
+            features.sse2 = __builtin_cpu_supports("sse2") != 0;
+            features.ssse3 = __builtin_cpu_supports("ssse3") != 0;
+            features.sse41 = __builtin_cpu_supports("sse4.1") != 0;
+            features.avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+
+            return features;
+        }
+
+        // Return the highest level the CPU supports, not higher than 'level'
+        static EdoSimdLevel ClampSimdLevel(EdoSimdLevel level) {
+            const EdoCpuFeatures &features = GetCpuFeatures();
+
+            if (level >= SimdAvx2 && features.avx2)
+                return SimdAvx2;
+
+            if (level >= SimdSse41 && features.ssse3 && features.sse41)
+                return SimdSse41;
+
+            if (level >= SimdSse2 && features.sse2)
+                return SimdSse2;
+
+            return SimdScalar;
+        }
+
+        const EdoCpuFeatures &GetCpuFeatures() {
+            static const EdoCpuFeatures s_features = DetectCpuFeatures();
+            return s_features;
+        }
+
+        EdoSimdLevel GetSimdLevel() {
+            int level = s_simdLevel.load(std::memory_order_relaxed);
+
+            if (level < 0) {
+                level = ClampSimdLevel(SimdAvx2);
+                s_simdLevel.store(level, std::memory_order_relaxed);
+            }
+
+            return static_cast<EdoSimdLevel>(level);
+        }
+
+        void SetSimdLevel(EdoSimdLevel level) {
+            s_simdLevel.store(ClampSimdLevel(level), std::memory_order_relaxed);
+        }
+    } // Namespace Utils
+} // Namespace Edo
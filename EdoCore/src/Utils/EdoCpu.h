@@ -0,0 +1,78 @@
+// =============================================================================
+// EdoCpu.h
+// Runtime detection of the instruction sets available for the vectorized code paths
+// =============================================================================
+
+#ifndef EDOCORE_EDOCPU_H
+#define EDOCORE_EDOCPU_H
+
+#include "EdoBase.h"
+
+// x86 builds carry SSE2 / AVX2 kernels and pick one at runtime, other targets only build the scalar versions
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define EDO_X86 1
+#endif
+
+// Functions using instructions above the compiler baseline have to be marked on GCC and Clang. MSVC allows the
+// intrinsics anywhere, so there the macros are empty
+#if defined(EDO_X86) && (defined(__GNUC__) || defined(__clang__))
+#define EDO_TARGET_SSE2 __attribute__((target("sse2")))
+#define EDO_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define EDO_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define EDO_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define EDO_TARGET_SSE2
+#define EDO_TARGET_SSSE3
+#define EDO_TARGET_SSE41
+#define EDO_TARGET_AVX2
+#endif
+
+namespace Edo {
+    namespace Utils {
+        /*!
+         * \brief
+         * Instruction set levels the vectorized kernels are written for, in increasing order
+         */
+        enum EdoSimdLevel {
+            SimdScalar = 0, //!< Plain C++, always available
+            SimdSse2, //!< SSE2 (baseline on x86-64)
+            SimdSse41, //!< SSSE3 and SSE4.1
+            SimdAvx2 //!< AVX2
+        };
+
+        /*!
+         * \brief
+         * Instruction set extensions supported by the CPU and the operating system
+         */
+        struct EdoCpuFeatures {
+            bool sse2;
+            bool ssse3;
+            bool sse41;
+            bool avx2; //!< Only set when the operating system also saves the AVX registers
+        };
+
+        /*!
+         * \brief
+         * Return the features of the CPU the process runs on. Detected once, on first use
+         */
+        EDO_API const EdoCpuFeatures &GetCpuFeatures();
+
+        /*!
+         * \brief
+         * Return the instruction set level the vectorized kernels use. This is the highest level the CPU supports,
+         * unless it was lowered with SetSimdLevel()
+         */
+        EDO_API EdoSimdLevel GetSimdLevel();
+
+        /*!
+         * \brief
+         * Select the instruction set level the vectorized kernels use, e.g. to compare them in benchmarks or to rule
+         * out a kernel while debugging. Levels the CPU does not support are lowered to the highest supported one
+         * \param level
+         * Requested level
+         */
+        EDO_API void SetSimdLevel(EdoSimdLevel level);
+    } // Namespace Utils
+} // Namespace Edo
+
+#endif // EDOCORE_EDOCPU_H
@@ -6,6 +6,7 @@
 // =============================================================================
 
 #include "EdoTextLog.h"
+#include "../Types/EdoStringBuilder.h"
 
 using namespace Edo::Types;
 using namespace Edo::Utils;
@@ -81,19 +82,24 @@ const long EdoTextLog::GetTruncLength() const {
 void EdoTextLog::Write(const Edo::Types::EdoString &logString, const Edo::Types::EdoString &type,
                        const Edo::Types::EdoString &file, int line) {
     // Write the formatted log string to log
-    EdoString logMessage(logString);
-    if (logMessage.Size() > m_truncate) {
-        logMessage = logMessage.Substr(0, m_truncate) + TEXT(" ... (the logger data omitted the rest of the data here) ...");
+    EdoString truncated;
+    const EdoString *logMessage = &logString;
+    if (logString.Size() > m_truncate) {
+        truncated = logString.Substr(0, m_truncate) + TEXT(" ... (the logger data omitted the rest of the data here) ...");
+        logMessage = &truncated;
     }
 
     std::fstream ss(m_logFile.c_str(), std::ios::out | std::ios::app);
-    EdoString msg;
+
+    // Gather the pieces first, so the message is allocated once at its final size
+    EdoStringBuilder builder;
 
     if (m_timestamp) {
-        msg += GetDateTimeString() + TEXT(" ");
+        builder << GetDateTimeString() << TEXT(" ");
     }
 
-    msg += TEXT("[") + type + TEXT("] ") + logMessage + TEXT(" >> ") + file + TEXT(":") + ToString(line);
+    builder << TEXT("[") << type << TEXT("] ") << *logMessage << TEXT(" >> ") << file << TEXT(":") << line;
+    EdoString msg = builder.ToString();
 
     if (ss.is_open()) {
         ss << msg << std::endl; // Write to .txt file